@@ -11,34 +11,707 @@
  *
  **************************************************************************/
 
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include "auxi.h"
 
+/* Global variables. */
+char *progname = "dt";
+char *mem_tag_names[NUM_MEM_TAGS] = {
+  "misc", "dataset", "dictionaries", "tree", "split", "pruning"
+};
+
+/* Context of whatever runs outside of the calls of the library, such as
+   the programs themselves: errors end the program. */
+static DTCONTEXT default_context = {
+  .alloc = malloc,
+  .realloc = realloc,
+  .free = free,
+  .lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+/* Context of the call running on this thread, NULL for the default
+   one. */
+static __thread DTCONTEXT *current_context = NULL;
+
+/* Every block handed out by getmem_tag() is preceded by this header,
+   which records its size, tag and context for freemem() and regetmem(),
+   and links it into the blocks of its context, so that ReleaseContext()
+   can release what a failed call left behind.  Its size keeps the block
+   aligned like a malloc() block. */
+typedef union memheader {
+  struct {
+    size_t bytes;
+    int tag;
+    DTCONTEXT *context;
+    union memheader *prev, *next;
+  } info;
+  long double align;
+} MEMHEADER;
+
+/* Arguments of StartThread(). */
+typedef struct threadstart {
+  DTCONTEXT *context;
+  void *(*start)(void *);
+  void *arg;
+} THREADSTART;
+
+/* -------------------------------------------------------------------------
+ 
+   Set up a context as the default one: memory from malloc(), no memory
+   cap, no limit on threads, and errors printed on stderr.
+ 
+  ------------------------------------------------------------------------- */
+
+void InitContext(DTCONTEXT *context)
+{
+  bzero(context, sizeof(DTCONTEXT));
+  context->alloc = malloc;
+  context->realloc = realloc;
+  context->free = free;
+  pthread_mutex_init(&context->lock, NULL);
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Release all the memory a context still holds, such as what a call left
+   behind when it failed.  The context may not be used again.
+ 
+  ------------------------------------------------------------------------- */
+
+void ReleaseContext(DTCONTEXT *context)
+{
+  MEMHEADER *header, *next;
+
+  for (header = context->blocks; header != NULL; header = next) {
+    next = header->info.next;
+    context->free(header);
+  }
+  context->blocks = NULL;
+  pthread_mutex_destroy(&context->lock);
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Return the context of this thread, and make "context" (NULL for the
+   default one) the context of this thread, returning the one it replaces.
+ 
+  ------------------------------------------------------------------------- */
+
+DTCONTEXT *CurrentContext(void)
+{
+  return (current_context != NULL) ? current_context : &default_context;
+}
+
+DTCONTEXT *SetContext(DTCONTEXT *context)
+{
+  DTCONTEXT *outer = current_context;
+
+  current_context = context;
+  return outer;
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Start a call of the library with "context" on this thread: the errors
+   of the call will return to "recover", which the caller has just
+   prepared with setjmp() (see DT_ENTER() in libdt.c).  Returns the
+   context the call replaces, to be given back to LeaveContext().
+ 
+  ------------------------------------------------------------------------- */
+
+DTCONTEXT *EnterContext(DTCONTEXT *context, jmp_buf *recover)
+{
+  DTCONTEXT *outer = current_context;
+
+  pthread_mutex_lock(&context->lock);
+  context->recover = recover;
+  context->owner = pthread_self();
+  context->status = DT_OK;
+  context->message[0] = '\0';
+  pthread_mutex_unlock(&context->lock);
+  current_context = context;
+
+  return outer;
+}
+
+/* .........................................................................
+ 
+   Print the current and peak bytes and the allocations of every tag of a
+   context.
+ 
+   ......................................................................... */
+
+static void PrintContextMemStats(FILE *fptr, DTCONTEXT *context)
+{
+  int tag;
+
+  fprintf(fptr, "%-14s %14s %14s %12s\n", "memory", "current", "peak",
+	  "allocations");
+  for (tag = 0; tag < NUM_MEM_TAGS; tag++)
+    fprintf(fptr, "%-14s %14ld %14ld %12ld\n", mem_tag_names[tag],
+	    context->mem_stats[tag].current, context->mem_stats[tag].peak,
+	    context->mem_stats[tag].count);
+  fprintf(fptr, "%-14s %14ld %14ld %12ld\n", "total",
+	  context->mem_total.current, context->mem_total.peak,
+	  context->mem_total.count);
+}
+
+/* .........................................................................
+ 
+   Hand the error of a context to its callback, or print it on stderr,
+   with the memory in use if it ran out of memory.
+ 
+   ......................................................................... */
+
+static void ReportError(DTCONTEXT *context)
+{
+  if (context->error != NULL) {
+    context->error(context->error_arg, context->status, context->message);
+    return;
+  }
+  fprintf(stderr, "%s: %s\n",
+	  (context->name != NULL) ? context->name : progname,
+	  context->message);
+  if (context->status == DT_ENOMEM)
+    PrintContextMemStats(stderr, context);
+}
+
+/* -------------------------------------------------------------------------
+ 
+   End a call started by EnterContext(), reporting its error if it had
+   one, and return its status.  A call that failed first releases what it
+   still held besides memory (see PushCleanup()), once all its threads
+   have stopped.
+ 
+  ------------------------------------------------------------------------- */
+
+int LeaveContext(DTCONTEXT *context, DTCONTEXT *outer)
+{
+  CLEANUP *cleanup, *next;
+
+  context->recover = NULL;
+  current_context = outer;
+  if (context->status != DT_OK) {
+    pthread_mutex_lock(&context->lock);
+    cleanup = context->cleanups;
+    context->cleanups = NULL;
+    pthread_mutex_unlock(&context->lock);
+    for (; cleanup != NULL; cleanup = next) {
+      next = cleanup->next;
+      cleanup->release(cleanup->arg);
+      context->free(cleanup);
+    }
+    ReportError(context);
+  }
+
+  return context->status;
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Fail with an error of the given status (see DT_OK), and a message made
+   from "format" like printf() does, followed by the description of errno
+   for DT_ESYS.  In a call of the library, the call returns the status
+   (or, on a thread the call started, the thread ends, and the call
+   returns once it has waited for it, see CheckContext()).  Outside of
+   calls, the error is printed and the program exits.
+ 
+  ------------------------------------------------------------------------- */
+
+void RaiseError(int status, char *format, ...)
+{
+  DTCONTEXT *context = CurrentContext();
+  char message[DT_MESSAGE_SIZE];
+  int len, sys_errno = errno;
+  va_list args;
+
+  va_start(args, format);
+  len = vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+  if (status == DT_ESYS && len >= 0 && len < (int) sizeof(message))
+    snprintf(message + len, sizeof(message) - len, ": %s",
+	     strerror(sys_errno));
+
+  /* Only the first error of a call is kept. */
+  pthread_mutex_lock(&context->lock);
+  if (context->status == DT_OK) {
+    context->status = status;
+    strcpy(context->message, message);
+  }
+  pthread_mutex_unlock(&context->lock);
+
+  if (context->recover == NULL) {
+    ReportError(context);
+    exit(1);
+  }
+  if (pthread_equal(context->owner, pthread_self()))
+    longjmp(*context->recover, 1);
+  pthread_exit(NULL);
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Fail with the error of a thread of the running call, if one failed.
+   Called after waiting for the threads; on a thread the call started,
+   the thread ends, as it does when it fails itself.
+ 
+  ------------------------------------------------------------------------- */
+
+void CheckContext(void)
+{
+  DTCONTEXT *context = CurrentContext();
+
+  if (context->status == DT_OK || context->recover == NULL)
+    return;
+  if (pthread_equal(context->owner, pthread_self()))
+    longjmp(*context->recover, 1);
+  pthread_exit(NULL);
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Have "release" called with "arg" if the running call fails, to release
+   something the call holds besides its memory, such as a file.  The
+   thread holding it calls PopCleanup() with the result when it releases
+   it itself.  Threads of the call that may still use what is released
+   must have been waited for before the call fails (see CheckContext()).
+   The entry is not accounted to the memory cap; if there is no memory
+   for it, "arg" is released at once, and the call fails.
+ 
+  ------------------------------------------------------------------------- */
+
+CLEANUP *PushCleanup(void (*release)(void *arg), void *arg)
+{
+  DTCONTEXT *context = CurrentContext();
+  CLEANUP *cleanup;
+
+  if ((cleanup = (CLEANUP *) context->alloc(sizeof(CLEANUP))) == NULL) {
+    release(arg);
+    RaiseError(DT_ENOMEM, "memory request for %ld bytes failed",
+	       (long) sizeof(CLEANUP));
+  }
+  cleanup->release = release;
+  cleanup->arg = arg;
+  pthread_mutex_lock(&context->lock);
+  cleanup->next = context->cleanups;
+  context->cleanups = cleanup;
+  pthread_mutex_unlock(&context->lock);
+
+  return cleanup;
+}
+
+void PopCleanup(CLEANUP *cleanup)
+{
+  DTCONTEXT *context = CurrentContext();
+  CLEANUP **link;
+
+  pthread_mutex_lock(&context->lock);
+  for (link = &context->cleanups; *link != cleanup; link = &(*link)->next)
+    ;
+  *link = cleanup->next;
+  pthread_mutex_unlock(&context->lock);
+  context->free(cleanup);
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Release function of PushCleanup() for a file opened with fopen().
+ 
+  ------------------------------------------------------------------------- */
+
+void CloseFileCleanup(void *fptr)
+{
+  fclose((FILE *) fptr);
+}
+
+/* .........................................................................
+ 
+   Run the start function of a thread in the context of its creator.
+ 
+   ......................................................................... */
+
+static void *StartThread(void *arg)
+{
+  THREADSTART thread_start = *(THREADSTART *) arg;
+
+  current_context = thread_start.context;
+  CurrentContext()->free(arg);
+  return thread_start.start(thread_start.arg);
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Create a thread like pthread_create() does, which allocates and fails
+   in the context of this one.  Returns 0, or an errno value; it does not
+   fail itself, so that the caller can wait for the threads it has
+   already started before failing.
+ 
+  ------------------------------------------------------------------------- */
+
+int CreateThread(pthread_t *thread, void *(*start)(void *), void *arg)
+{
+  DTCONTEXT *context = CurrentContext();
+  THREADSTART *thread_start;
+  int err;
+
+  thread_start = (THREADSTART *) context->alloc(sizeof(THREADSTART));
+  if (thread_start == NULL)
+    return ENOMEM;
+  thread_start->context = current_context;
+  thread_start->start = start;
+  thread_start->arg = arg;
+  if ((err = pthread_create(thread, NULL, StartThread, thread_start)) != 0)
+    context->free(thread_start);
+
+  return err;
+}
+
+/* .........................................................................
+ 
+   Link a block into, or unlink it from, the blocks of its context.  The
+   lock of the context is held.
+ 
+   ......................................................................... */
+
+static void LinkBlock(DTCONTEXT *context, MEMHEADER *header)
+{
+  header->info.prev = NULL;
+  header->info.next = context->blocks;
+  if (context->blocks != NULL)
+    context->blocks->info.prev = header;
+  context->blocks = header;
+}
+
+static void UnlinkBlock(DTCONTEXT *context, MEMHEADER *header)
+{
+  if (header->info.prev != NULL)
+    header->info.prev->info.next = header->info.next;
+  else
+    context->blocks = header->info.next;
+  if (header->info.next != NULL)
+    header->info.next->info.prev = header->info.prev;
+}
+
 /* -------------------------------------------------------------------------
  
-   Memory allocator.  Exits program if there is not enough memory.
+   Account for "bytes" more (or, if negative, fewer) bytes of a tag, in
+   "blocks" new blocks, unless this goes over the memory cap of the
+   context.  Returns 0 if it does, 1 otherwise.  The lock of the context
+   is held.
  
   ------------------------------------------------------------------------- */
 
+static int MemAccount(DTCONTEXT *context, int tag, long bytes, int blocks)
+{
+  MEMSTATS *stats = context->mem_stats + tag, *total = &context->mem_total;
+
+  if (bytes > 0 && context->mem_cap > 0 &&
+      total->current + bytes > context->mem_cap)
+    return 0;
+  stats->current += bytes;
+  stats->peak = MAX(stats->peak, stats->current);
+  total->current += bytes;
+  total->peak = MAX(total->peak, total->current);
+  stats->count += blocks;
+  total->count += blocks;
+
+  return 1;
+}
+
+/* .........................................................................
+ 
+   Fail because a request for "bytes" bytes of a tag would go over the
+   memory cap.
+ 
+   ......................................................................... */
+
+static void MemCapError(DTCONTEXT *context, long bytes, int tag)
+{
+  RaiseError(DT_ENOMEM, "memory cap of %ld bytes exceeded by a request "
+	     "for %ld bytes (%s)", context->mem_cap, bytes,
+	     mem_tag_names[tag]);
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Memory allocator.  Fails if there is not enough memory, or if the
+   memory cap would be exceeded.  The memory comes from the context of
+   the thread, is accounted to "tag" (MEM_MISC for getmem()) and must be
+   released with freemem().
+ 
+  ------------------------------------------------------------------------- */
+
+void *getmem_tag(size_t bytes, int tag)
+{
+  DTCONTEXT *context = CurrentContext();
+  MEMHEADER *header;
+  int within_cap;
+
+  if ((header = (MEMHEADER *) context->alloc(sizeof(MEMHEADER) + bytes)) ==
+      (MEMHEADER *) NULL)
+    RaiseError(DT_ENOMEM, "memory request for %ld bytes failed",
+	       (long) bytes);
+  header->info.bytes = bytes;
+  header->info.tag = tag;
+  header->info.context = context;
+  pthread_mutex_lock(&context->lock);
+  if ((within_cap = MemAccount(context, tag, (long) bytes, 1)))
+    LinkBlock(context, header);
+  pthread_mutex_unlock(&context->lock);
+  if (!within_cap) {
+    context->free(header);
+    MemCapError(context, (long) bytes, tag);
+  }
+
+  return header + 1;
+}
+
 void *getmem(size_t bytes)
 {
-  void *ptr;
+  return getmem_tag(bytes, MEM_MISC);
+}
 
-  if ((ptr = malloc(bytes)) == (void *) NULL)
-    USER_ERROR1("memory request for %d bytes failed\n", bytes);
+/* -------------------------------------------------------------------------
+ 
+   Change the size of a block from getmem_tag(), keeping its tag and
+   context.
+ 
+  ------------------------------------------------------------------------- */
 
-  return ptr;
+void *regetmem(void *ptr, size_t bytes)
+{
+  DTCONTEXT *context;
+  MEMHEADER *header, *new_header;
+  long delta;
+  int tag;
+
+  if (ptr == NULL)
+    return getmem(bytes);
+  header = (MEMHEADER *) ptr - 1;
+  context = header->info.context;
+  tag = header->info.tag;
+  delta = (long) bytes - (long) header->info.bytes;
+
+  /* The block is out of the list while it may move. */
+  pthread_mutex_lock(&context->lock);
+  if (!MemAccount(context, tag, delta, 0)) {
+    pthread_mutex_unlock(&context->lock);
+    MemCapError(context, delta, tag);
+  }
+  UnlinkBlock(context, header);
+  pthread_mutex_unlock(&context->lock);
+  new_header = (MEMHEADER *)
+    context->realloc(header, sizeof(MEMHEADER) + bytes);
+  pthread_mutex_lock(&context->lock);
+  if (new_header == NULL) {
+    MemAccount(context, tag, -delta, 0);
+    LinkBlock(context, header);
+  } else {
+    new_header->info.bytes = bytes;
+    LinkBlock(context, new_header);
+  }
+  pthread_mutex_unlock(&context->lock);
+  if (new_header == NULL)
+    RaiseError(DT_ENOMEM, "memory request for %ld bytes failed",
+	       (long) bytes);
+
+  return new_header + 1;
 }
 
 /* -------------------------------------------------------------------------
  
-   Generate a random number in the interval [a, b).  Gets seed from current
-   time the first time it is called.
+   Release a block from getmem_tag(); NULL is ignored.
+ 
+  ------------------------------------------------------------------------- */
+
+void freemem(void *ptr)
+{
+  DTCONTEXT *context;
+  MEMHEADER *header;
+
+  if (ptr == NULL)
+    return;
+  header = (MEMHEADER *) ptr - 1;
+  context = header->info.context;
+  pthread_mutex_lock(&context->lock);
+  MemAccount(context, header->info.tag, -(long) header->info.bytes, 0);
+  UnlinkBlock(context, header);
+  pthread_mutex_unlock(&context->lock);
+  context->free(header);
+}
+
+/* Bytes of the elements of a column, padded (see DT_COLUMN_ALIGN). */
+#define COLUMN_BYTES(num_elems, width)					\
+  ((MAX((size_t) (num_elems) * (width), 1) + DT_COLUMN_ALIGN - 1) /	\
+   DT_COLUMN_ALIGN * DT_COLUMN_ALIGN)
+
+/* Offset of the header of a column in a block at "block", for the
+   elements to be aligned. */
+#define COLUMN_OFFSET(block)						\
+  ((int) ((DT_COLUMN_ALIGN - ((size_t) (block) + sizeof(COLUMNHEADER)) %	\
+	   DT_COLUMN_ALIGN) % DT_COLUMN_ALIGN))
+
+/* -------------------------------------------------------------------------
+ 
+   Allocate a column of "num_elems" elements of "width" bytes each, after a
+   header recording the width (see COLUMN_WIDTH()).  The elements are
+   aligned and padded to DT_COLUMN_ALIGN bytes.  Release it with
+   freecolumn().
+ 
+  ------------------------------------------------------------------------- */
+
+void *getcolumn_tag(size_t num_elems, int width, int tag)
+{
+  COLUMNHEADER *header;
+  char *block;
+  int offset;
+
+  block = (char *) getmem_tag(sizeof(COLUMNHEADER) + DT_COLUMN_ALIGN - 1 +
+			      COLUMN_BYTES(num_elems, width), tag);
+  offset = COLUMN_OFFSET(block);
+  header = (COLUMNHEADER *) (block + offset);
+  header->num_elems = num_elems;
+  header->width = width;
+  header->offset = offset;
+  header->type = '\0';
+
+  return header + 1;
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Change the number of elements of a column from getcolumn_tag(), keeping
+   its header and tag.
+ 
+  ------------------------------------------------------------------------- */
+
+void *regetcolumn(void *column, size_t num_elems)
+{
+  COLUMNHEADER *header = (COLUMNHEADER *) column - 1;
+  size_t bytes = COLUMN_BYTES(num_elems, header->width);
+  size_t old_bytes = COLUMN_BYTES(header->num_elems, header->width);
+  int old_offset = header->offset, offset;
+  char *block;
+
+  block = (char *) regetmem((char *) header - old_offset,
+			    sizeof(COLUMNHEADER) + DT_COLUMN_ALIGN - 1 +
+			    bytes);
+
+  /* The block may have moved to an address aligned otherwise. */
+  offset = COLUMN_OFFSET(block);
+  if (offset != old_offset)
+    memmove(block + offset, block + old_offset,
+	    sizeof(COLUMNHEADER) + MIN(bytes, old_bytes));
+  header = (COLUMNHEADER *) (block + offset);
+  header->num_elems = num_elems;
+  header->offset = offset;
+
+  return header + 1;
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Release a column from getcolumn_tag(); NULL is ignored.
+ 
+  ------------------------------------------------------------------------- */
+
+void freecolumn(void *column)
+{
+  COLUMNHEADER *header;
+
+  if (column == NULL)
+    return;
+  header = (COLUMNHEADER *) column - 1;
+  freemem((char *) header - header->offset);
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Print the current and peak bytes and the allocations of every tag of
+   the context of this thread.
+ 
+  ------------------------------------------------------------------------- */
+
+void PrintMemStats(FILE *fptr)
+{
+  PrintContextMemStats(fptr, CurrentContext());
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Generate a random number in the interval [a, b) with the generator of
+   the context of this thread, which is seeded with SeedRandom(), or with
+   1 as random() is if it was not.
 
   ------------------------------------------------------------------------- */
 
 double uniform(double a, double b)
 {
-  return (a == b) ? 0.0 : ((double) random()) / RAND_MAX * (b - a) + a;
+  DTCONTEXT *context = CurrentContext();
+  int32_t val;
+
+  if (a == b)
+    return 0.0;
+  if (!context->random_seeded)
+    SeedRandom(1);
+  random_r(&context->random, &val);
+  return ((double) val) / RAND_MAX * (b - a) + a;
+}
+
+/* -------------------------------------------------------------------------
+ 
+   Seed the generator of the context of this thread.  The numbers are
+   those random() gives after srandom() with the same seed.
+
+  ------------------------------------------------------------------------- */
+
+void SeedRandom(unsigned int seed)
+{
+  DTCONTEXT *context = CurrentContext();
+
+  bzero(&context->random, sizeof(context->random));
+  initstate_r(seed, (char *) context->random_state,
+	      sizeof(context->random_state), &context->random);
+  context->random_seeded = 1;
+}
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary function, a wrapper around strdup() really that fails if
+   there's not enough memory.  The copy comes from getmem_tag() and is
+   accounted as dictionary memory, as the names of attributes and values
+   are the only strings duplicated.
+
+   ---------------------------------------------------------------------- */
+
+char *my_strdup(char *s)
+{
+  char *ptr;
+
+  ptr = getmem_tag(strlen(s) + 1, MEM_DICT);
+  strcpy(ptr, s);
+
+  return ptr;
+}
+
+/* ----------------------------------------------------------------------
+
+   Same as my_strdup() inly the number of characters to dplicate is
+   specified.  The actual string allocated has length "n"+1.
+
+   ---------------------------------------------------------------------- */
+
+char *my_strndup(char *s, int n)
+{
+  char *ptr;
+
+  ptr = getmem_tag(n + 1, MEM_DICT);
+  strncpy(ptr, s, n);
+  ptr[n] = '\0';
+  return ptr;
 }
 
 /***************************************************************************/
@@ -16,55 +16,55 @@
 #include <sys/time.h>
 #include <unistd.h>
 #include <math.h>
+#include <pthread.h>
+#include <setjmp.h>
 
 #ifndef AUX_H
 #define AUX_H 1
 
 /* Global variables. */
-extern char *progname;  /* Should be defined by all programs who call this
-			   library, and should contain the program name. */
-
-#define SYS_ERROR1(format, arg)					\
-{								\
-  char tmp_buf[256];						\
-  sprintf(tmp_buf, "%s: %s:%d %s(): " format,			\
-	  progname, __FILE__, __LINE__, __FUNCTION__, arg);	\
-  perror(tmp_buf);						\
-  exit(1);							\
+extern char *progname;  /* Name that errors are reported under, unless the
+			   context has one (see DTCONTEXT); programs set
+			   it to their own name. */
+
+/* Status of a call of the library (see libdt.h). */
+#define DT_OK     0
+#define DT_EUSER  1             /* Bad input or arguments. */
+#define DT_ESYS   2             /* A system call failed. */
+#define DT_ENOMEM 3             /* Out of memory, or over the memory cap. */
+
+/* Errors.  An error ends the call of the library it happens in, which
+   returns its status (see RaiseError()), or the program if it happens
+   outside of any. */
+#define SYS_ERROR1(format, arg)						\
+{									\
+  RaiseError(DT_ESYS, "%s:%d %s(): " format,				\
+	     __FILE__, __LINE__, __FUNCTION__, arg);			\
 }
 #define SYS_ERROR2(format, arg1, arg2)					\
 {									\
-  char tmp_buf[256];							\
-  sprintf(tmp_buf, "%s: %s:%d %s(): " format,				\
-	  progname, __FILE__, __LINE__, __FUNCTION__, arg1, arg2);	\
-  perror(tmp_buf);							\
-  exit(1);								\
+  RaiseError(DT_ESYS, "%s:%d %s(): " format,				\
+	     __FILE__, __LINE__, __FUNCTION__, arg1, arg2);		\
 }
-#define SYS_ERROR3(format, arg1, arg2, arg3)				 \
-{									 \
-  char tmp_buf[256];							 \
-  sprintf(tmp_buf, "%s: %s:%d %s(): " format,				 \
-	  progname, __FILE__, __LINE__, __FUNCTION__, arg1, arg2, arg3); \
-  perror(tmp_buf);							 \
-  exit(1);								 \
+#define SYS_ERROR3(format, arg1, arg2, arg3)				\
+{									\
+  RaiseError(DT_ESYS, "%s:%d %s(): " format,				\
+	     __FILE__, __LINE__, __FUNCTION__, arg1, arg2, arg3);	\
 }
-#define USER_ERROR1(format, arg)				\
-{								\
-  fprintf(stderr, "%s: %s:%d %s(): " format "\n",		\
-	  progname, __FILE__, __LINE__, __FUNCTION__, arg);	\
-  exit(1);							\
+#define USER_ERROR1(format, arg)					\
+{									\
+  RaiseError(DT_EUSER, "%s:%d %s(): " format,				\
+	     __FILE__, __LINE__, __FUNCTION__, arg);			\
 }
 #define USER_ERROR2(format, arg1, arg2)					\
 {									\
-  fprintf(stderr, "%s: %s:%d %s(): " format "\n",			\
-	  progname, __FILE__, __LINE__, __FUNCTION__, arg1, arg2);	\
-  exit(1);								\
+  RaiseError(DT_EUSER, "%s:%d %s(): " format,				\
+	     __FILE__, __LINE__, __FUNCTION__, arg1, arg2);		\
 }
-#define USER_ERROR3(format, arg1, arg2, arg3)				 \
-{									 \
-  fprintf(stderr, "%s: %s:%d %s(): " format "\n",			 \
-	  progname, __FILE__, __LINE__, __FUNCTION__, arg1, arg2, arg3); \
-  exit(1);								 \
+#define USER_ERROR3(format, arg1, arg2, arg3)				\
+{									\
+  RaiseError(DT_EUSER, "%s:%d %s(): " format,				\
+	     __FILE__, __LINE__, __FUNCTION__, arg1, arg2, arg3);	\
 }
 #ifndef SQUARE
 #define SQUARE(x) ((x) * (x))
@@ -88,12 +88,135 @@ extern char *progname;  /* Should be defined by all programs who call this
 #define EPSILON 0.005
 #endif
 
+/* Subsystems that memory is accounted to, see getmem_tag(). */
+#define MEM_MISC     0
+#define MEM_DATASET  1          /* Attribute columns and example sets. */
+#define MEM_DICT     2          /* Names of attributes and values. */
+#define MEM_TREE     3          /* Tree nodes and models. */
+#define MEM_SPLIT    4          /* Scratch space of the split search. */
+#define MEM_PRUNE    5          /* Scratch space of pruning. */
+#define NUM_MEM_TAGS 6
+
+/* Memory accounted to one tag. */
+typedef struct memstats {
+  long current;                 /* Bytes allocated and not yet released. */
+  long peak;                    /* Largest value of "current". */
+  long count;                   /* Number of allocations. */
+} MEMSTATS;
+
+/* Columns (see getcolumn_tag()) start at a multiple of DT_COLUMN_ALIGN
+   bytes and are padded to one, so that a loop over a column may load
+   whole vectors, or whole words of a bit array, up to its end. */
+#ifndef DT_COLUMN_ALIGN
+#define DT_COLUMN_ALIGN 64
+#endif
+
+/* Every column of a data set is preceded by this header, which describes
+   its elements (see getcolumn_tag() and ssv.h). */
+typedef struct columnheader {
+  long num_elems;               /* Elements there is room for. */
+  int width;                    /* Bytes of an element. */
+  int offset;                   /* Of the header in its block of memory. */
+  char type;                    /* Type of the attribute ('b', 'd' or
+				   'c'), or 0 if not a data set's. */
+} COLUMNHEADER;
+
+#define COLUMN_WIDTH(column) (((COLUMNHEADER *) (column))[-1].width)
+#define COLUMN_TYPE(column)  (((COLUMNHEADER *) (column))[-1].type)
+#define COLUMN_ELEMS(column) (((COLUMNHEADER *) (column))[-1].num_elems)
+
+/* Something a call holds besides its memory, such as an open file or a
+   thread it started, to be released if the call fails (see
+   PushCleanup()). */
+typedef struct cleanup {
+  void (*release)(void *arg);
+  void *arg;
+  struct cleanup *next;
+} CLEANUP;
+
+#define DT_MESSAGE_SIZE 1024
+#define DT_RANDOM_STATE 128     /* Bytes of state of the generator, as
+				   srandom() has. */
+
+/* Everything a call of the library works with besides its arguments: the
+   allocator its memory comes from and the accounting of that memory, its
+   random number generator, the number of threads it may use and what
+   becomes of its errors.  Calls with different contexts share nothing and
+   may run at once on different threads; a context serves one call at a
+   time.  Initialize one with DTInitContext() and set the public fields
+   after. */
+typedef struct dtcontext {
+  char *name;                   /* Errors are reported as "name: error" on
+				   stderr, if "error" is NULL. */
+  void (*error)(void *arg, int status, char *message);
+  void *error_arg;              /* First argument of "error". */
+  void *(*alloc)(size_t);       /* malloc(), realloc() and free() of all */
+  void *(*realloc)(void *, size_t); /* the memory of the context. */
+  void (*free)(void *);
+  long mem_cap;                 /* If positive, fail as soon as more bytes
+				   than this would be allocated. */
+  int num_threads;              /* Most threads a call may run at once, or
+				   0 for no limit. */
+
+  /* Private to auxi.c. */
+  MEMSTATS mem_stats[NUM_MEM_TAGS];
+  MEMSTATS mem_total;           /* All tags together. */
+  pthread_mutex_t lock;         /* Of the accounting, "blocks" and
+				   "status", since several threads of a call
+				   may allocate at once (see ReadTPT()). */
+  union memheader *blocks;      /* Blocks not yet released. */
+  struct random_data random;
+  int random_state[DT_RANDOM_STATE / sizeof(int)];
+  int random_seeded;
+  jmp_buf *recover;             /* Where the call running returns to on an
+				   error, or NULL outside of calls. */
+  pthread_t owner;              /* Thread of the call running. */
+  CLEANUP *cleanups;            /* What it holds besides memory, the last
+				   pushed first. */
+  int status;                   /* Of the call running. */
+  char message[DT_MESSAGE_SIZE]; /* Of its first error. */
+} DTCONTEXT;
+
+/* Start a call in "context": the rest of the calling function runs in the
+   context, and returns the status of the call as soon as an error
+   happens.  Every function that uses it returns with DT_LEAVE(). */
+#define DT_ENTER(context)						\
+  jmp_buf recover;							\
+  DTCONTEXT *outer = EnterContext((context), &recover);			\
+  if (setjmp(recover) != 0)						\
+    return LeaveContext((context), outer);
+
+#define DT_LEAVE(context) return LeaveContext((context), outer)
+
 /* Global variables. */
-extern int random_seed;
+extern char *mem_tag_names[NUM_MEM_TAGS];
 
 /* Declarations. */
 void *getmem(size_t bytes);
+void *getmem_tag(size_t bytes, int tag);
+void *regetmem(void *ptr, size_t bytes);
+void freemem(void *ptr);
+void *getcolumn_tag(size_t num_elems, int width, int tag);
+void *regetcolumn(void *column, size_t num_elems);
+void freecolumn(void *column);
+void PrintMemStats(FILE *fptr);
 double uniform(double a, double b);
+void SeedRandom(unsigned int seed);
+char *my_strdup(char *s);
+char *my_strndup(char *s, int n);
+void InitContext(DTCONTEXT *context);
+void ReleaseContext(DTCONTEXT *context);
+DTCONTEXT *CurrentContext(void);
+DTCONTEXT *SetContext(DTCONTEXT *context);
+DTCONTEXT *EnterContext(DTCONTEXT *context, jmp_buf *recover);
+int LeaveContext(DTCONTEXT *context, DTCONTEXT *outer);
+void RaiseError(int status, char *format, ...)
+  __attribute__ ((noreturn, format (printf, 2, 3)));
+void CheckContext(void);
+CLEANUP *PushCleanup(void (*release)(void *arg), void *arg);
+void PopCleanup(CLEANUP *cleanup);
+void CloseFileCleanup(void *fptr);
+int CreateThread(pthread_t *thread, void *(*start)(void *), void *arg);
 
 #endif // AUX_H
 /**************************************************************************/
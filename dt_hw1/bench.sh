@@ -0,0 +1,64 @@
+#!/bin/sh
+###########################################################################
+#
+# bench.sh
+#
+# Benchmark suite: generates synthetic data sets of increasing size with
+# gen-ssv, runs "dt --profile -tpt" on each of them, and writes the time
+# of every phase to a CSV file, one line per (rows, threads) pair.
+#
+# Settings (environment variables, see also "make bench"):
+#   BENCH_SIZES    training set sizes in rows
+#                  (default "10000 100000 1000000 10000000")
+#   BENCH_THREADS  thread counts, exported to dt as DT_THREADS
+#                  (default "1")
+#   BENCH_OUT      CSV file to write (default bench.csv)
+#   BENCH_GEN      extra arguments to gen-ssv (default "-b 4 -d 4 -c 4")
+#   BENCH_ARGS     extra arguments to dt, e.g. "-grow level -depth 12"
+#   BENCH_DIR      directory for the generated data (default $TMPDIR or /tmp)
+#
+# The prune and test sets have a quarter of the rows of the training set.
+# All three are drawn from the same concept (gen-ssv -rs), with different
+# rows (-s).
+#
+###########################################################################
+
+BENCH_SIZES=${BENCH_SIZES:-"10000 100000 1000000 10000000"}
+BENCH_THREADS=${BENCH_THREADS:-"1"}
+BENCH_OUT=${BENCH_OUT:-bench.csv}
+BENCH_GEN=${BENCH_GEN:-"-b 4 -d 4 -c 4"}
+BENCH_ARGS=${BENCH_ARGS:-""}
+BENCH_DIR=${BENCH_DIR:-${TMPDIR:-/tmp}}
+
+dir=`mktemp -d "$BENCH_DIR/dt-bench.XXXXXX"` || exit 1
+trap 'rm -rf "$dir"' 0 1 2 15
+
+# Print the wall-clock seconds of phase $1 in the JSON record $2.
+phase() {
+    echo "$2" | sed -n "s/.*\"$1\": {\"wall\": \([0-9.]*\).*/\1/p"
+}
+
+echo "rows,threads,load,partition,train,split,prune,stats,predict,total,peak_rss_kb" > "$BENCH_OUT"
+
+for rows in $BENCH_SIZES; do
+    small=`expr $rows / 4`
+    echo "Generating $rows rows..." >&2
+    ./gen-ssv -n $rows $BENCH_GEN -rs 1 -s 1 -o "$dir/train.ssv" || exit 1
+    ./gen-ssv -n $small $BENCH_GEN -rs 1 -s 2 -o "$dir/prune.ssv" || exit 1
+    ./gen-ssv -n $small $BENCH_GEN -rs 1 -s 3 -o "$dir/test.ssv" || exit 1
+
+    for threads in $BENCH_THREADS; do
+	echo "Running dt on $rows rows, $threads thread(s)..." >&2
+	start=`date +%s.%N`
+	DT_THREADS=$threads ./dt --profile $BENCH_ARGS \
+	    -tpt "$dir/train.ssv" "$dir/prune.ssv" "$dir/test.ssv" \
+	    > /dev/null 2> "$dir/profile.json" || exit 1
+	end=`date +%s.%N`
+	run=`grep '"scope": "run"' "$dir/profile.json"`
+	rss=`echo "$run" | sed -n 's/.*"peak_rss_kb": \([0-9]*\).*/\1/p'`
+	total=`echo "$start $end" | awk '{ printf "%.6f", $2 - $1 }'`
+	echo "$rows,$threads,`phase parse "$run"`,`phase partition "$run"`,`phase grow "$run"`,`phase split "$run"`,`phase prune "$run"`,`phase stats "$run"`,`phase predict "$run"`,$total,$rss" >> "$BENCH_OUT"
+    done
+done
+
+echo "Results written to $BENCH_OUT" >&2
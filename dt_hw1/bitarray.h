@@ -20,18 +20,24 @@
 #define uchar unsigned char
 #endif // uchar
 
-/* Create a bit array. */
+/* Sizes and offsets of bit arrays are in bits, and may be beyond 2^31
+   (sizes are computed in size_t, loops run over long indices). */
+
+/* Bytes of a bit array of "size" bits. */
+#define BITARRAY_BYTES(size) (((size_t) (size)) / 8 + 1)
+
+/* Create a bit array, accounted to a memory tag (see auxi.h).  Release it
+   with freemem(). */
 #define CREATE_BITARRAY(size)				\
-  ((uchar *) getmem(((size)/8 + 1) * sizeof(uchar)))
+  ((uchar *) getmem(BITARRAY_BYTES(size) * sizeof(uchar)))
+#define CREATE_BITARRAY_TAG(size, tag)				\
+  ((uchar *) getmem_tag(BITARRAY_BYTES(size) * sizeof(uchar), (tag)))
 
 /* Change (increase) the size of a bitarray. */
 #define REALLOC_BITARRAY(bitarray, newsize)		\
    (bitarray) = (uchar *)				\
-     realloc((bitarray),				\
-	     ((newsize) / 8 + 1) * sizeof(uchar));	\
-   if ((bitarray) == (uchar *) NULL)			\
-     USER_ERROR1("realloc(%d bytes)",			\
-		 ((newsize) + 1) / 8 * sizeof(uchar));
+     regetmem((bitarray),				\
+	      BITARRAY_BYTES(newsize) * sizeof(uchar));
 
 /* Read an element (bit) from a bit array. */
 #define READ_BITARRAY(bitarray, offset)					\
@@ -47,30 +53,31 @@
 
 /* Set bits from begin to end inclusive to 1. */
 #define SET_BITARRAY_RANGE(bitarray,begin,end){                 \
-  int i;                                                        \
+  long i;                                                       \
   for(i=begin;i<=end;i++)                                        \
     WRITE_BITARRAY(bitarray,i,1);                               \
 }
 
 /* Fill a bit array with zeros. */
 #define ZERO_BITARRAY(bitarray, size) {				\
-  int i;							\
-  for (i = 0; i < (size)/8/sizeof(long); i++)			\
+  size_t i;							\
+  for (i = 0; i < BITARRAY_BYTES(size)/sizeof(long); i++)	\
     ((long *) (bitarray))[i] = (long) 0;			\
-  for (i = (size)/8/sizeof(long); i < (size)/8 + 1; i++)	\
+  for (i = BITARRAY_BYTES(size)/sizeof(long) * sizeof(long);	\
+       i < BITARRAY_BYTES(size); i++)				\
     ((uchar *) (bitarray))[i] = '\0';				\
 }
 
 /* Cpoy a bitarray into another. */
 #define COPY_BITARRAY(dest_bitarray, source_bitarray, size) {		 \
-  int i;								 \
+  long i;								 \
   for (i = 0; i < (size); i++) {					 \
     WRITE_BITARRAY(dest_bitarray, i, READ_BITARRAY(source_bitarray, i)); \
   }									 \
 }
 
 #define COPY_BITARRAY_RANGE(dest_bitarray, dest_begin, source_bitarray, source_begin, size) {    \
-  int i;                                                                                         \
+  long i;                                                                                        \
   for (i = 0; i< (size); i++) {                                                                  \
     WRITE_BITARRAY(dest_bitarray, i+dest_begin, READ_BITARRAY(source_bitarray, i+source_begin)); \
   }								                                 \
@@ -0,0 +1,724 @@
+/**************************************************************************
+ *
+ * boost.c
+ *
+ * Source file containing routines related to gradient boosting of shallow
+ * decision trees under the logistic loss.  The data set is binned once and
+ * the binned representation is shared by all boosting rounds; the gradient
+ * histogram of a node is obtained from its parent's by subtracting those of
+ * its smaller siblings.
+ *
+ **************************************************************************/
+
+#include <string.h>
+#include "auxi.h"
+#include "dt.h"
+#include "boost.h"
+#include "ssv.h"
+#include "bitarray.h"
+#include "profile.h"
+
+/* One bin of a gradient histogram. */
+typedef struct histbin {
+  double sum_grad;
+  double sum_hess;
+  long count;
+} HISTBIN;
+
+/* State shared while growing the trees of one boosting round. */
+typedef struct boostwork {
+  void **data;
+  BINDATA *bd;
+  double *grad;                 /* Loss gradient of every example. */
+  double *hess;                 /* Loss hessian of every example. */
+  long *rows;                   /* Training examples, grouped by node. */
+  long *rows_temp;              /* Scratch space for regrouping rows. */
+  int max_depth;
+  double learning_rate;
+  SSVINFO *ssvinfo;
+} BOOSTWORK;
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary function used by qsort to sort an array of doubles.
+
+   ---------------------------------------------------------------------- */
+
+static int comp_doubles(const void *a, const void *b)
+{
+  double x = *((double *) a), y = *((double *) b);
+
+  return (x == y) ? 0 : ((x < y) ? -1 : 1);
+}
+
+/* ----------------------------------------------------------------------
+
+   Compute the bin boundaries of the continuous attribute "attr" over the
+   training examples.  With few distinct values every value gets its own
+   bin (the boundaries are the midpoints used by the unboosted learner),
+   otherwise the boundaries are placed at the quantiles of the values.
+
+   ---------------------------------------------------------------------- */
+
+static double *ContinuousCuts(void **data, MEMBERSET *train_members,
+			      long num_train, int attr, int *num_cuts_ptr)
+{
+  MEMBERITER iter;
+  double *vals, *cuts;
+  long example, i, num_vals, num_distinct;
+  int b, num_cuts;
+
+  vals = (double *) getmem_tag((num_train + 1) * sizeof(double), MEM_SPLIT);
+  num_vals = 0;
+  FOR_EACH_MEMBER(iter, train_members, example)
+    vals[num_vals++] = READ_ATTRIB_C(data, example, attr);
+  qsort(vals, num_vals, sizeof(double), comp_doubles);
+  PROFILE_COUNT(sorts, 1);
+
+  num_distinct = (num_vals > 0) ? 1 : 0;
+  for (i = 1; i < num_vals; i++)
+    if (vals[i] != vals[i-1])
+      num_distinct++;
+
+  cuts = (double *) getmem_tag(BOOST_MAX_BINS * sizeof(double), MEM_DATASET);
+  num_cuts = 0;
+  if (num_distinct <= BOOST_MAX_BINS) {
+    for (i = 1; i < num_vals; i++)
+      if (vals[i] != vals[i-1])
+	cuts[num_cuts++] = (vals[i-1] + vals[i]) / 2.0;
+  } else {
+    for (b = 1; b < BOOST_MAX_BINS; b++) {
+      i = (long) (((double) b * num_vals) / BOOST_MAX_BINS);
+      if (i <= 0 || vals[i] == vals[i-1])
+	continue;
+      if (num_cuts > 0 && cuts[num_cuts-1] >= (vals[i-1] + vals[i]) / 2.0)
+	continue;
+      cuts[num_cuts++] = (vals[i-1] + vals[i]) / 2.0;
+    }
+  }
+  freemem(vals);
+
+  *num_cuts_ptr = num_cuts;
+  return cuts;
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the bin of value "val", that is, the number of boundaries that
+   are smaller than or equal to it.
+
+   ---------------------------------------------------------------------- */
+
+static int ContinuousBin(double *cuts, int num_cuts, double val)
+{
+  int lo = 0, hi = num_cuts, mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (cuts[mid] <= val)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* ----------------------------------------------------------------------
+
+   Create the binned representation of a data set.  Bin boundaries of
+   continuous attributes are computed on the training examples only.
+
+   ---------------------------------------------------------------------- */
+
+BINDATA *CreateBinnedData(void **data, long num_data, int num_features,
+			  MEMBERSET *train_members, long num_train,
+			  SSVINFO *ssvinfo)
+{
+  BINDATA *bd;
+  long example;
+  int attr, num_cuts;
+  unsigned short *row;
+
+  bd = (BINDATA *) getmem_tag(sizeof(BINDATA), MEM_DATASET);
+  bd->num_data = num_data;
+  bd->num_features = num_features;
+  bd->num_bins = (int *) getmem_tag(num_features * sizeof(int), MEM_DATASET);
+  bd->hist_offset = (int *) getmem_tag(num_features * sizeof(int), MEM_DATASET);
+  bd->cuts = (double **) getmem_tag(num_features * sizeof(double *), MEM_DATASET);
+  bd->bins = (unsigned short *)
+    getmem_tag((size_t) num_data * num_features * sizeof(unsigned short), MEM_DATASET);
+
+  bd->hist_size = 0;
+  for (attr = 0; attr < num_features; attr++) {
+    bd->cuts[attr] = (double *) NULL;
+    if (attr == 0) {  /* The target is never binned. */
+      bd->num_bins[attr] = 0;
+    } else {
+      switch (ssvinfo->types[attr]) {
+      case 'b':
+	bd->num_bins[attr] = 2;
+	break;
+      case 'd':
+	bd->num_bins[attr] = ssvinfo->num_discrete_vals[attr];
+	if (bd->num_bins[attr] > 65535)
+	  USER_ERROR2("attribute \"%s\" has too many values (%d) to bin",
+		      ssvinfo->feat_names[attr], bd->num_bins[attr]);
+	break;
+      case 'c':
+	bd->cuts[attr] = ContinuousCuts(data, train_members, num_train,
+					attr, &num_cuts);
+	bd->num_bins[attr] = num_cuts + 1;
+	break;
+      default:
+	USER_ERROR1("Unknown attribute type '%c'", ssvinfo->types[attr]);
+      }
+    }
+    bd->hist_offset[attr] = bd->hist_size;
+    bd->hist_size += bd->num_bins[attr];
+  }
+
+  for (example = 0; example < num_data; example++) {
+    row = bd->bins + (size_t) example * num_features;
+    row[0] = 0;
+    for (attr = 1; attr < num_features; attr++) {
+      switch (ssvinfo->types[attr]) {
+      case 'b':
+	row[attr] = READ_ATTRIB_B(data, example, attr);
+	break;
+      case 'd':
+	row[attr] = READ_ATTRIB_I(data, example, attr);
+	break;
+      case 'c':
+	row[attr] = ContinuousBin(bd->cuts[attr], bd->num_bins[attr] - 1,
+				  READ_ATTRIB_C(data, example, attr));
+	break;
+      }
+    }
+  }
+
+  return bd;
+}
+
+/* ----------------------------------------------------------------------
+
+   Free all memory associated with a binned data set.
+
+   ---------------------------------------------------------------------- */
+
+void FreeBinnedData(BINDATA *bd)
+{
+  int attr;
+
+  if (bd == NULL)
+    return;
+  for (attr = 0; attr < bd->num_features; attr++)
+    if (bd->cuts[attr] != NULL)
+      freemem(bd->cuts[attr]);
+  freemem(bd->cuts);
+  freemem(bd->num_bins);
+  freemem(bd->hist_offset);
+  freemem(bd->bins);
+  freemem(bd);
+}
+
+/* ----------------------------------------------------------------------
+
+   Accumulate the gradient histogram of the examples rows[0..num_rows-1].
+
+   ---------------------------------------------------------------------- */
+
+static void BuildHistogram(BOOSTWORK *work, long *rows, long num_rows,
+			   HISTBIN *hist)
+{
+  BINDATA *bd = work->bd;
+  int num_features = bd->num_features;
+  int *offset = bd->hist_offset;
+  unsigned short *row;
+  HISTBIN *hb;
+  double g, h;
+  long i;
+  int attr;
+
+  PROFILE_COUNT(rows_scanned, num_rows);
+  memset(hist, 0, bd->hist_size * sizeof(HISTBIN));
+  for (i = 0; i < num_rows; i++) {
+    row = bd->bins + (size_t) rows[i] * num_features;
+    g = work->grad[rows[i]];
+    h = work->hess[rows[i]];
+    for (attr = 1; attr < num_features; attr++) {
+      hb = hist + offset[attr] + row[attr];
+      hb->sum_grad += g;
+      hb->sum_hess += h;
+      hb->count++;
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Find the split of a node with the largest reduction of the regularized
+   logistic loss, given the node's gradient histogram.  Binary and
+   continuous attributes are split in two at a bin boundary; discrete
+   attributes get one branch per value.  Returns the attribute, or -1 if no
+   split reduces the loss.
+
+   ---------------------------------------------------------------------- */
+
+static int BestBoostSplit(BOOSTWORK *work, HISTBIN *hist,
+			  double sum_grad, double sum_hess, long num_members,
+			  int *split_bin_ptr, double *gain_ptr)
+{
+  BINDATA *bd = work->bd;
+  SSVINFO *ssvinfo = work->ssvinfo;
+  double parent_score, score, gain, max_gain;
+  double grad_left, hess_left, grad_right, hess_right;
+  long num_left;
+  int attr, b, num_nonempty, max_gain_attr;
+  HISTBIN *hb;
+
+  PROFILE_COUNT(max_gain_calls, 1);
+  PROFILE_COUNT(attribs_evaluated, bd->num_features - 1);
+  parent_score = SQUARE(sum_grad) / (sum_hess + BOOST_LAMBDA);
+  max_gain = 0.0;
+  max_gain_attr = -1;
+  for (attr = 1; attr < bd->num_features; attr++) {
+    hb = hist + bd->hist_offset[attr];
+    if (ssvinfo->types[attr] == 'd') {
+      score = 0.0;
+      num_nonempty = 0;
+      for (b = 0; b < bd->num_bins[attr]; b++) {
+	if (hb[b].count == 0)
+	  continue;
+	score += SQUARE(hb[b].sum_grad) / (hb[b].sum_hess + BOOST_LAMBDA);
+	num_nonempty++;
+      }
+      gain = 0.5 * (score - parent_score);
+      if (num_nonempty >= 2 && gain > max_gain) {
+	max_gain = gain;
+	max_gain_attr = attr;
+      }
+    } else {
+      grad_left = hess_left = 0.0;
+      num_left = 0;
+      for (b = 0; b < bd->num_bins[attr] - 1; b++) {
+	grad_left += hb[b].sum_grad;
+	hess_left += hb[b].sum_hess;
+	num_left += hb[b].count;
+	if (num_left == 0)
+	  continue;
+	if (num_left == num_members)
+	  break;
+	grad_right = sum_grad - grad_left;
+	hess_right = sum_hess - hess_left;
+	gain = 0.5 * (SQUARE(grad_left) / (hess_left + BOOST_LAMBDA) +
+		      SQUARE(grad_right) / (hess_right + BOOST_LAMBDA) -
+		      parent_score);
+	if (gain > max_gain) {
+	  max_gain = gain;
+	  max_gain_attr = attr;
+	  *split_bin_ptr = b;
+	}
+      }
+    }
+  }
+
+  *gain_ptr = max_gain;
+  return max_gain_attr;
+}
+
+/* ----------------------------------------------------------------------
+
+   Grow a boosted subtree over the examples rows[begin..end-1], whose
+   gradient histogram is "hist" (NULL if the node is too deep or too small
+   to be split).  The histogram is consumed: it is either freed or handed
+   down to the largest child, after the histograms of the smaller children
+   have been subtracted from it.  Children that will not be split get no
+   histogram.
+
+   ---------------------------------------------------------------------- */
+
+static DTNODE *GrowBoostNode(BOOSTWORK *work, long begin, long end,
+			     HISTBIN *hist, int depth)
+{
+  BINDATA *bd = work->bd;
+  DTNODE *node;
+  long num_members = end - begin;
+  long i, *child_count, *child_begin, *child_pos;
+  int b, n, attr, split_bin, child, num_children, largest, split_children;
+  unsigned short bin;
+  double gain;
+  HISTBIN *child_hist;
+
+  node = NewDecisionTreeNode();
+  node->num_members = num_members;
+  for (i = begin; i < end; i++) {
+    if (READ_ATTRIB_B(work->data, work->rows[i], 0) == 1)
+      node->num_pos++;
+    else
+      node->num_neg++;
+    node->sum_grad += work->grad[work->rows[i]];
+    node->sum_hess += work->hess[work->rows[i]];
+  }
+  node->value = -work->learning_rate * node->sum_grad /
+    (node->sum_hess + BOOST_LAMBDA);
+
+  attr = -1;
+  split_bin = 0;
+  if (depth < work->max_depth && num_members > MIN_LEAF_MEMBERS) {
+    PROFILE_BEGIN(PHASE_SPLIT);
+    attr = BestBoostSplit(work, hist, node->sum_grad, node->sum_hess,
+			  num_members, &split_bin, &gain);
+    PROFILE_END(PHASE_SPLIT);
+  }
+  if (attr == -1) {
+    freemem(hist);
+    return node;
+  }
+
+  /* Group the rows of the node by child, keeping their relative order. */
+  num_children = (work->ssvinfo->types[attr] == 'd') ? bd->num_bins[attr] : 2;
+  child_count = (long *) getmem_tag(num_children * sizeof(long), MEM_SPLIT);
+  child_begin = (long *) getmem_tag(num_children * sizeof(long), MEM_SPLIT);
+  child_pos = (long *) getmem_tag(num_children * sizeof(long), MEM_SPLIT);
+  memset(child_count, 0, num_children * sizeof(long));
+  for (i = begin; i < end; i++) {
+    bin = bd->bins[(size_t) work->rows[i] * bd->num_features + attr];
+    child_count[(num_children == 2) ? (bin > split_bin) : bin]++;
+  }
+  largest = 0;
+  for (b = 0, i = begin; b < num_children; b++) {
+    child_begin[b] = child_pos[b] = i;
+    i += child_count[b];
+    if (child_count[b] > child_count[largest])
+      largest = b;
+  }
+  for (i = begin; i < end; i++) {
+    bin = bd->bins[(size_t) work->rows[i] * bd->num_features + attr];
+    child = (num_children == 2) ? (bin > split_bin) : bin;
+    work->rows_temp[child_pos[child]++] = work->rows[i];
+  }
+  memcpy(work->rows + begin, work->rows_temp + begin,
+	 num_members * sizeof(long));
+
+  /* A discrete test only gets children for the values it has seen;
+     child_pos[b] becomes the index of the child of bin b. */
+  node->test_attrib = attr;
+  if (work->ssvinfo->types[attr] == 'd') {
+    for (b = n = 0; b < num_children; b++)
+      n += (child_count[b] > 0);
+    node->num_children = n;
+    node->child_vals = (int *) getmem_tag(n * sizeof(int), MEM_TREE);
+    for (b = n = 0; b < num_children; b++) {
+      child_pos[b] = n;
+      if (child_count[b] > 0)
+	node->child_vals[n++] = b;
+    }
+  } else {
+    node->num_children = 2;
+    child_pos[0] = 0;
+    child_pos[1] = 1;
+  }
+  node->children = (DTNODE **)
+    getmem_tag(node->num_children * sizeof(DTNODE *), MEM_TREE);
+  if (work->ssvinfo->types[attr] == 'c')
+    node->threshold = bd->cuts[attr][split_bin];
+
+  /* No child has more members than the largest, so if that one is not
+     split none is, and the histograms are not needed. */
+  split_children = (depth + 1 < work->max_depth &&
+		    child_count[largest] > MIN_LEAF_MEMBERS);
+  if (!split_children) {
+    freemem(hist);
+    hist = (HISTBIN *) NULL;
+  }
+  for (b = 0; b < num_children; b++) {
+    if (child_count[b] > 0)
+      node->children[child_pos[b]] = (DTNODE *) NULL;
+    if (b == largest || child_count[b] == 0)
+      continue;
+    child_hist = (HISTBIN *) NULL;
+    if (split_children) {
+      child_hist = (HISTBIN *)
+	getmem_tag(bd->hist_size * sizeof(HISTBIN), MEM_SPLIT);
+      BuildHistogram(work, work->rows + child_begin[b], child_count[b],
+		     child_hist);
+      for (i = 0; i < bd->hist_size; i++) {
+	hist[i].sum_grad -= child_hist[i].sum_grad;
+	hist[i].sum_hess -= child_hist[i].sum_hess;
+	hist[i].count -= child_hist[i].count;
+      }
+    }
+    node->children[child_pos[b]] =
+      GrowBoostNode(work, child_begin[b], child_begin[b] + child_count[b],
+		    child_hist, depth + 1);
+  }
+  node->children[child_pos[largest]] =
+    GrowBoostNode(work, child_begin[largest],
+		  child_begin[largest] + child_count[largest],
+		  hist, depth + 1);
+
+  freemem(child_count);
+  freemem(child_begin);
+  freemem(child_pos);
+
+  return node;
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the output of a boosted tree for an example.  If the example
+   takes the default branch of a discrete test, the output of the last
+   node on its path is used.
+
+   ---------------------------------------------------------------------- */
+
+double BoostTreeValue(DTNODE *node, void **data, long example,
+		      SSVINFO *ssvinfo)
+{
+  int child;
+
+  while (node->num_children > 0) {
+    switch (ssvinfo->types[node->test_attrib]) {
+    case 'b':
+      child = READ_ATTRIB_B(data, example, node->test_attrib);
+      break;
+    case 'd':
+      child = DiscreteChildIndex(node,
+				 READ_ATTRIB_I(data, example, node->test_attrib));
+      break;
+    case 'c':
+      child =
+	(READ_ATTRIB_C(data, example, node->test_attrib) >= node->threshold);
+      break;
+    default:
+      USER_ERROR1("Unknown attribute type '%c'",
+		  ssvinfo->types[node->test_attrib]);
+    }
+    if (child < 0)
+      break;
+    node = node->children[child];
+  }
+
+  return node->value;
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the log-odds that an example is positive under a boosted model.
+
+   ---------------------------------------------------------------------- */
+
+double BoostedScore(BOOSTMODEL *model, void **data, long example,
+		    SSVINFO *ssvinfo)
+{
+  double score = model->base_score;
+  int t;
+
+  for (t = 0; t < model->num_trees; t++)
+    score += BoostTreeValue(model->trees[t], data, example, ssvinfo);
+
+  return score;
+}
+
+/* ----------------------------------------------------------------------
+
+   Compute classification accuracy over a set of examples of a boosted
+   model.  Returns a number in [0.0, 1.0].
+
+   ---------------------------------------------------------------------- */
+
+double BoostedAccuracy(BOOSTMODEL *model, void **data, long num_data,
+		       MEMBERSET *test_members, long num_test, SSVINFO *ssvinfo)
+{
+  MEMBERITER iter;
+  long example, num_correct;
+  int prediction;
+
+  (void) num_data;
+  num_correct = 0;
+  FOR_EACH_MEMBER(iter, test_members, example) {
+    prediction = (BoostedScore(model, data, example, ssvinfo) >= 0.0);
+    num_correct += (READ_ATTRIB_B(data, example, 0) == prediction);
+  }
+
+  return (double) num_correct / (double) num_test;
+}
+
+/* ----------------------------------------------------------------------
+
+   Count the number of nodes of all trees of a boosted model.
+
+   ---------------------------------------------------------------------- */
+
+int CountBoostedNodes(BOOSTMODEL *model)
+{
+  int t, nodes = 0;
+
+  for (t = 0; t < model->num_trees; t++)
+    nodes += CountNodes(model->trees[t]);
+
+  return nodes;
+}
+
+/* ----------------------------------------------------------------------
+
+   Print the training loss and accuracies of the model after "round"
+   rounds, given the current log-odds of every example.
+
+   ---------------------------------------------------------------------- */
+
+static void PrintBoostRound(BOOSTMODEL *model, void **data,
+			    MEMBERSET *train_members, long num_train,
+			    MEMBERSET *test_members, long num_test,
+			    double *score)
+{
+  MEMBERITER iter;
+  long example;
+  int y, prediction;
+  long num_train_correct = 0, num_test_correct = 0;
+  double loss = 0.0;
+
+  FOR_EACH_MEMBER(iter, train_members, example) {
+    y = READ_ATTRIB_B(data, example, 0);
+    prediction = (score[example] >= 0.0);
+    num_train_correct += (y == prediction);
+    /* log(1 + exp(-s)) for positives, log(1 + exp(s)) for negatives. */
+    loss += log1p(exp(y ? -score[example] : score[example]));
+  }
+  if (num_test > 0) {
+    FOR_EACH_MEMBER(iter, test_members, example) {
+      y = READ_ATTRIB_B(data, example, 0);
+      num_test_correct += (y == (score[example] >= 0.0));
+    }
+  }
+
+  if (num_test > 0)
+    printf("%d\t%d\t%.4f\t%.1f\t%.1f\n", model->num_trees,
+	   CountBoostedNodes(model), loss / num_train,
+	   (100.0 * num_train_correct) / num_train,
+	   (100.0 * num_test_correct) / num_test);
+  else
+    printf("%d\t%d\t%.4f\t%.1f\n", model->num_trees,
+	   CountBoostedNodes(model), loss / num_train,
+	   (100.0 * num_train_correct) / num_train);
+  fflush(stdout);
+}
+
+/* ----------------------------------------------------------------------
+
+   Create a sequence of "ssvinfo->boost_rounds" shallow trees, each fit by
+   a second order step to the gradient of the logistic loss of the previous
+   ones.  Test examples are only used to report the accuracy as the model
+   grows (not in batch mode); the test set must not share examples with
+   the training set, as none of the ways of reading or partitioning a
+   data set make it do.
+
+   ---------------------------------------------------------------------- */
+
+BOOSTMODEL *CreateBoostedTrees(void **data, long num_data, int num_features,
+			       MEMBERSET *train_members, long num_train,
+			       MEMBERSET *test_members, long num_test,
+			       SSVINFO *ssvinfo)
+{
+  MEMBERITER iter;
+  BOOSTMODEL *model;
+  BOOSTWORK work;
+  HISTBIN *hist;
+  DTNODE *tree;
+  double *score, p;
+  long example, i, num_pos;
+  int round;
+
+  work.data = data;
+  work.ssvinfo = ssvinfo;
+  work.max_depth = (ssvinfo->max_depth > 0) ? ssvinfo->max_depth
+                                            : BOOST_DEFAULT_DEPTH;
+  work.learning_rate = ssvinfo->learning_rate;
+  work.bd = CreateBinnedData(data, num_data, num_features,
+			     train_members, num_train, ssvinfo);
+  work.grad = (double *) getmem_tag(num_data * sizeof(double), MEM_SPLIT);
+  work.hess = (double *) getmem_tag(num_data * sizeof(double), MEM_SPLIT);
+  work.rows = (long *) getmem_tag(num_train * sizeof(long), MEM_SPLIT);
+  work.rows_temp = (long *) getmem_tag(num_train * sizeof(long), MEM_SPLIT);
+  score = (double *) getmem_tag(num_data * sizeof(double), MEM_SPLIT);
+
+  model = (BOOSTMODEL *) getmem_tag(sizeof(BOOSTMODEL), MEM_TREE);
+  model->trees = (DTNODE **) getmem_tag(ssvinfo->boost_rounds * sizeof(DTNODE *), MEM_TREE);
+  model->num_trees = 0;
+
+  /* Start from the log-odds of the training prior (smoothed by one
+     example of each class). */
+  num_pos = 0;
+  FOR_EACH_MEMBER(iter, train_members, example)
+    num_pos += READ_ATTRIB_B(data, example, 0);
+  model->base_score = log((num_pos + 1.0) / (num_train - num_pos + 1.0));
+  for (example = 0; example < num_data; example++)
+    score[example] = model->base_score;
+
+  if (ssvinfo->batch == 0)
+    printf("---------------------------------------\n"
+	   "Round\t# of\tTrain\tCorrect\tCorrect\n"
+	   "\tnodes\tloss\ttrain %%\ttest %%\n"
+	   "---------------------------------------\n");
+
+  for (round = 0; round < ssvinfo->boost_rounds; round++) {
+    /* Gradient and hessian of the logistic loss at the current scores. */
+    i = 0;
+    FOR_EACH_MEMBER(iter, train_members, example) {
+      p = 1.0 / (1.0 + exp(-score[example]));
+      work.grad[example] = p - READ_ATTRIB_B(data, example, 0);
+      work.hess[example] = MAX(p * (1.0 - p), 1e-16);
+      work.rows[i++] = example;
+    }
+
+    hist = (HISTBIN *) getmem_tag(work.bd->hist_size * sizeof(HISTBIN), MEM_SPLIT);
+    BuildHistogram(&work, work.rows, num_train, hist);
+    tree = GrowBoostNode(&work, 0, num_train, hist, 0);
+    model->trees[model->num_trees++] = tree;
+
+    FOR_EACH_MEMBER(iter, train_members, example)
+      score[example] += BoostTreeValue(tree, data, example, ssvinfo);
+    if (num_test > 0) {
+      FOR_EACH_MEMBER(iter, test_members, example)
+	score[example] += BoostTreeValue(tree, data, example, ssvinfo);
+    }
+
+    if (ssvinfo->batch == 0 &&
+	((round + 1) % BOOST_REPORT_EVERY == 0 ||
+	 round == ssvinfo->boost_rounds - 1))
+      PrintBoostRound(model, data, train_members, num_train,
+		      test_members, num_test, score);
+  }
+
+  if (ssvinfo->batch == 0)
+    printf("---------------------------------------\n");
+
+  freemem(score);
+  freemem(work.grad);
+  freemem(work.hess);
+  freemem(work.rows);
+  freemem(work.rows_temp);
+  FreeBinnedData(work.bd);
+
+  return model;
+}
+
+/* ----------------------------------------------------------------------
+
+   Free all memory associated with a boosted model.
+
+   ---------------------------------------------------------------------- */
+
+void FreeBoostedTrees(BOOSTMODEL *model)
+{
+  int t;
+
+  if (model == NULL)
+    return;
+  for (t = 0; t < model->num_trees; t++)
+    FreeDecisionTree(model->trees[t]);
+  freemem(model->trees);
+  freemem(model);
+}
+
+/**************************************************************************/
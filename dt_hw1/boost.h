@@ -0,0 +1,80 @@
+/**************************************************************************
+ *
+ * boost.h
+ *
+ * Header file to boost.c
+ *
+ **************************************************************************/
+
+#ifndef BOOST_H
+#define BOOST_H 1
+
+#include "dt.h"
+#include "ssv.h"
+#include "bitarray.h"
+
+#ifndef BOOST_DEFAULT_DEPTH
+#define BOOST_DEFAULT_DEPTH 3
+#endif // BOOST_DEFAULT_DEPTH
+
+#ifndef BOOST_DEFAULT_RATE
+#define BOOST_DEFAULT_RATE 0.1
+#endif // BOOST_DEFAULT_RATE
+
+#ifndef BOOST_LAMBDA
+#define BOOST_LAMBDA 1.0        /* L2 regularization of leaf outputs. */
+#endif // BOOST_LAMBDA
+
+#ifndef BOOST_MAX_BINS
+#define BOOST_MAX_BINS 256      /* Maximum number of bins of a continuous
+				   attribute. */
+#endif // BOOST_MAX_BINS
+
+#ifndef BOOST_REPORT_EVERY
+#define BOOST_REPORT_EVERY 10
+#endif // BOOST_REPORT_EVERY
+
+/* Binned representation of a data set, shared by all boosting rounds.
+   Every attribute value is replaced by a small bin number: the value itself
+   for binary and discrete attributes, and the index of the quantile
+   interval for continuous ones. */
+typedef struct bindata {
+  long num_data;                 /* Number of examples. */
+  int num_features;             /* Number of attributes (incl. target). */
+  unsigned short *bins;         /* Bin of every example, row-major:
+				   bins[example * num_features + attr]. */
+  int *num_bins;                /* Number of bins of every attribute. */
+  int *hist_offset;             /* Offset of the attribute in a histogram. */
+  int hist_size;                /* Total number of histogram bins. */
+  double **cuts;                /* Bin boundaries of continuous attributes:
+				   bin b holds values in
+				   [cuts[b-1], cuts[b]). */
+} BINDATA;
+
+/* Sequence of boosted regression trees predicting log-odds. */
+typedef struct boostmodel {
+  int num_trees;
+  DTNODE **trees;
+  double base_score;            /* Log-odds of the training prior. */
+} BOOSTMODEL;
+
+/* Function prototypes. */
+BINDATA *CreateBinnedData(void **data, long num_data, int num_features,
+			  MEMBERSET *train_members, long num_train,
+			  SSVINFO *ssvinfo);
+void FreeBinnedData(BINDATA *bd);
+BOOSTMODEL *CreateBoostedTrees(void **data, long num_data, int num_features,
+			       MEMBERSET *train_members, long num_train,
+			       MEMBERSET *test_members, long num_test,
+			       SSVINFO *ssvinfo);
+double BoostTreeValue(DTNODE *node, void **data, long example,
+		      SSVINFO *ssvinfo);
+double BoostedScore(BOOSTMODEL *model, void **data, long example,
+		    SSVINFO *ssvinfo);
+double BoostedAccuracy(BOOSTMODEL *model, void **data, long num_data,
+		       MEMBERSET *test_members, long num_test, SSVINFO *ssvinfo);
+int CountBoostedNodes(BOOSTMODEL *model);
+void FreeBoostedTrees(BOOSTMODEL *model);
+
+#endif // BOOST_H
+/**************************************************************************/
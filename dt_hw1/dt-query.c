@@ -0,0 +1,278 @@
+/**************************************************************************
+ *
+ * dt-query.c
+ *
+ * Client of "dt -serve", to try a served model out and time it: sends
+ * the examples of an SSV file, without their labels, as requests, and
+ * checks the answers against the labels.
+ *
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "auxi.h"
+
+#define USAGE "\nSend the examples of an SSV file to a model served by "	\
+              "dt -serve.\n\n"						\
+              "Usage: %s [-c <clients>] [-w <window>] [-r <repeats>] "	\
+              "[-q] <socket> [<ssvfile>]\n\n"				\
+              "  -c  number of clients at once, each sending all the "	\
+              "examples (default 1)\n"					\
+              "  -w  requests a client sends before it waits for an "	\
+              "answer (default 1)\n"					\
+              "  -r  times every client sends the examples (default 1)\n" \
+              "  -q  do not print the answers\n\n"			\
+              "The answers of the first client are printed, one per "	\
+              "line; the accuracy\nand the latency go to stderr.  The "	\
+              "SSV file is read from the standard\ninput if not "	\
+              "given.\n\n"
+
+#define MAX_LINE_LEN 65536
+
+/* The requests, and what every client does with them. */
+typedef struct query {
+  char *socket_filename;
+  long num_requests;
+  char **requests;              /* Lines to send, newline included. */
+  int *labels;                  /* Label of every request. */
+  int window, repeats;
+  int print;                    /* Print the answers. */
+  double *latencies;            /* Seconds from sending a request to its
+				   answer, for every request sent. */
+  long num_correct, num_errors;
+} QUERY;
+
+/* ----------------------------------------------------------------------
+
+   Seconds since the epoch.
+
+   ---------------------------------------------------------------------- */
+
+static double Now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/* ----------------------------------------------------------------------
+
+   Read the examples of an SSV file as requests: every data line without
+   its first word, the label.  Comments and blank lines are skipped, as
+   dt does.
+
+   ---------------------------------------------------------------------- */
+
+static void ReadRequests(FILE *fptr, QUERY *query)
+{
+  char *line, *start, *end;
+  long num_lines = 0, max_requests = 1024;
+
+  line = (char *) getmem(MAX_LINE_LEN);
+  query->num_requests = 0;
+  query->requests = (char **) getmem(max_requests * sizeof(char *));
+  query->labels = (int *) getmem(max_requests * sizeof(int));
+  while (fgets(line, MAX_LINE_LEN, fptr) != NULL) {
+    for (start = line; *start == ' ' || *start == '\t'; start++)
+      ;
+    if (*start == '#' || *start == '\n' || *start == '\r' || *start == '\0')
+      continue;
+    if (num_lines++ < 3)        /* The header. */
+      continue;
+
+    if (query->num_requests == max_requests) {
+      max_requests *= 2;
+      query->requests = (char **)
+	regetmem(query->requests, max_requests * sizeof(char *));
+      query->labels = (int *)
+	regetmem(query->labels, max_requests * sizeof(int));
+    }
+    query->labels[query->num_requests] = atoi(start);
+    while (*start != ' ' && *start != '\t' && *start != '\n' &&
+	   *start != '\0')
+      start++;
+    for (end = start + strlen(start);
+	 end > start && (end[-1] == '\n' || end[-1] == '\r'); end--)
+      ;
+    query->requests[query->num_requests] =
+      (char *) getmem(end - start + 2);
+    memcpy(query->requests[query->num_requests], start, end - start);
+    strcpy(query->requests[query->num_requests] + (end - start), "\n");
+    query->num_requests++;
+  }
+  freemem(line);
+}
+
+/* ----------------------------------------------------------------------
+
+   A client: connect, and send every request "repeats" times, keeping up
+   to "window" of them waiting for their answers.
+
+   ---------------------------------------------------------------------- */
+
+static void *RunClient(void *arg)
+{
+  QUERY *query = (QUERY *) arg;
+  struct sockaddr_un addr;
+  FILE *fptr;
+  double *sent_at;
+  char *answer;
+  long num_total, num_sent, num_answered, request;
+  int fd;
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+    SYS_ERROR1("socket(\"%s\")", query->socket_filename);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, query->socket_filename, sizeof(addr.sun_path) - 1);
+  if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    SYS_ERROR1("connect(\"%s\")", query->socket_filename);
+  if ((fptr = fdopen(fd, "r")) == NULL)
+    SYS_ERROR1("fdopen(\"%s\")", query->socket_filename);
+
+  num_total = query->num_requests * query->repeats;
+  sent_at = (double *) getmem(MAX(query->window, 1) * sizeof(double));
+  answer = (char *) getmem(MAX_LINE_LEN);
+  query->latencies = (double *) getmem(MAX(num_total, 1) * sizeof(double));
+  query->num_correct = query->num_errors = 0;
+  for (num_sent = num_answered = 0; num_answered < num_total;
+       num_answered++) {
+    for (; num_sent < num_total && num_sent - num_answered < query->window;
+	 num_sent++) {
+      request = num_sent % query->num_requests;
+      sent_at[num_sent % query->window] = Now();
+      if (write(fd, query->requests[request],
+		strlen(query->requests[request])) < 0)
+	SYS_ERROR1("write(\"%s\")", query->socket_filename);
+    }
+    if (fgets(answer, MAX_LINE_LEN, fptr) == NULL)
+      USER_ERROR1("the server closed \"%s\"", query->socket_filename);
+    query->latencies[num_answered] =
+      Now() - sent_at[num_answered % query->window];
+
+    request = num_answered % query->num_requests;
+    if (!strncmp(answer, "error", 5))
+      query->num_errors++;
+    else
+      query->num_correct += (atoi(answer) == query->labels[request] &&
+			     answer[0] != '?');
+    if (query->print && num_answered < query->num_requests)
+      fputs(answer, stdout);
+  }
+
+  fclose(fptr);
+  freemem(sent_at);
+  freemem(answer);
+  return NULL;
+}
+
+/* Order of doubles, for qsort(). */
+static int CompareDoubles(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+
+  return (x > y) - (x < y);
+}
+
+/* ----------------------------------------------------------------------
+
+   Main function.
+
+   ---------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+  QUERY query, *clients;
+  pthread_t *threads;
+  FILE *fptr = stdin;
+  double start, seconds, *latencies, sum;
+  long num_answers, num_correct, num_errors, i;
+  int num_clients = 1, client, print = 1, window = 1, repeats = 1;
+
+  progname = (char *) strrchr(argv[0], '/');
+  progname = (progname != NULL) ? (progname + 1) : argv[0];
+
+  for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+    if (!strcmp(argv[i], "-c") && i + 1 < argc)
+      num_clients = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+      window = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+      repeats = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-q"))
+      print = 0;
+    else
+      break;
+  }
+  if (i == argc || argc - i > 2 || num_clients < 1 || window < 1 ||
+      repeats < 1) {
+    fprintf(stderr, USAGE, progname);
+    exit(1);
+  }
+  query.socket_filename = argv[i];
+  if (i + 1 < argc && (fptr = fopen(argv[i + 1], "r")) == NULL)
+    SYS_ERROR1("fopen(\"%s\", \"r\")", argv[i + 1]);
+  ReadRequests(fptr, &query);
+  if (query.num_requests == 0)
+    USER_ERROR1("no examples to send%s", "");
+  query.window = window;
+  query.repeats = repeats;
+
+  /* Every client gets a copy of the requests; the first one prints. */
+  clients = (QUERY *) getmem(num_clients * sizeof(QUERY));
+  threads = (pthread_t *) getmem(num_clients * sizeof(pthread_t));
+  start = Now();
+  for (client = 0; client < num_clients; client++) {
+    clients[client] = query;
+    clients[client].print = (print && client == 0);
+    if ((errno = pthread_create(threads + client, NULL, RunClient,
+				clients + client)) != 0)
+      SYS_ERROR1("pthread_create(%d)", client);
+  }
+  for (client = 0; client < num_clients; client++)
+    pthread_join(threads[client], NULL);
+  seconds = Now() - start;
+
+  num_answers = (long) num_clients * query.num_requests * repeats;
+  latencies = (double *) getmem(num_answers * sizeof(double));
+  num_correct = num_errors = 0;
+  for (client = 0; client < num_clients; client++) {
+    memcpy(latencies + (long) client * query.num_requests * repeats,
+	   clients[client].latencies,
+	   (long) query.num_requests * repeats * sizeof(double));
+    num_correct += clients[client].num_correct;
+    num_errors += clients[client].num_errors;
+    freemem(clients[client].latencies);
+  }
+  qsort(latencies, num_answers, sizeof(double), CompareDoubles);
+  for (i = 0, sum = 0.0; i < num_answers; i++)
+    sum += latencies[i];
+
+  fprintf(stderr, "%ld requests, %ld errors, accuracy %.2f%%\n",
+	  num_answers, num_errors, 100.0 * num_correct / num_answers);
+  fprintf(stderr, "%.0f requests/s, latency (us) mean %.1f, median %.1f, "
+	  "99%% %.1f, max %.1f\n", num_answers / seconds,
+	  1e6 * sum / num_answers, 1e6 * latencies[num_answers / 2],
+	  1e6 * latencies[(long) (0.99 * (num_answers - 1))],
+	  1e6 * latencies[num_answers - 1]);
+
+  for (i = 0; i < query.num_requests; i++)
+    freemem(query.requests[i]);
+  freemem(query.requests);
+  freemem(query.labels);
+  freemem(latencies);
+  freemem(clients);
+  freemem(threads);
+  if (fptr != stdin)
+    fclose(fptr);
+  exit(0);
+}
+/**************************************************************************/
@@ -14,10 +14,11 @@
 
 #include "dt.h"
 #include "prune-dt.h"
-#include "main.h"
 #include "bitarray.h"
 #include "ssv.h"
 #include "entropy.h"
+#include "grow.h"
+#include "profile.h"
 
 /* ----------------------------------------------------------------------
 
@@ -25,24 +26,131 @@
    or discrete (multi-valued) or binary attributes.  Split the examples into
    three sets: training, pruning and testing.  Training is used to grow the
    tree, pruning to post-prune it and test is not used, but a membership
-   array of flags is returned (for accuracy testing perhaps by the caller).
+   set is returned (for accuracy testing perhaps by the caller).
 
    ---------------------------------------------------------------------- */
 
-DTNODE *CreateDecisionTree(void **data, int num_data, int num_features,
+DTNODE *CreateDecisionTree(void **data, long num_data, int num_features,
 			   double approx_prune_pct, double approx_test_pct,
-			   uchar *train_members, int num_train,
+			   MEMBERSET *train_members, long num_train,
 			   SSVINFO *ssvinfo)
 {
   DTNODE *root;
 
-  /* Call the auxiliary recursive subroutine to create the tree. */
-  root = CreateDecisionTreeAux(data, num_data, train_members, num_train,
-			       num_features, ssvinfo);
+  (void) approx_prune_pct;
+  (void) approx_test_pct;
+  switch (ssvinfo->grow_mode) {
+  case GROW_BEST_FIRST:
+    root = CreateDecisionTreeBestFirst(data, num_data, train_members,
+				       num_train, num_features, ssvinfo);
+    break;
+  case GROW_LEVEL_WISE:
+    root = CreateDecisionTreeLevelWise(data, num_data, train_members,
+				       num_train, num_features, ssvinfo);
+    break;
+  default:
+    /* Call the auxiliary recursive subroutine to create the tree. */
+    root = CreateDecisionTreeAux(data, num_data, train_members, num_train,
+				 num_features, ssvinfo);
+  }
 
   return root;
 }
 
+/* ----------------------------------------------------------------------
+
+   Allocate a tree node, with all its fields zero: a leaf without
+   examples.
+
+   ---------------------------------------------------------------------- */
+
+DTNODE *NewDecisionTreeNode(void)
+{
+  DTNODE *node;
+
+  node = (DTNODE *) getmem_tag(sizeof(DTNODE), MEM_TREE);
+  PROFILE_COUNT(nodes_created, 1);
+  memset(node, 0, sizeof(DTNODE));
+
+  return node;
+}
+
+/* ----------------------------------------------------------------------
+
+   Give a node testing a discrete attribute one (NULL) child for every
+   value that reaches it, i.e. whose entry of the "counts" table (see
+   PartialEntropyCounts()) is not empty.  Also record the node's class
+   counts.
+
+   ---------------------------------------------------------------------- */
+
+void SetDiscreteChildren(DTNODE *node, long (*counts)[2], int num_vals)
+{
+  int val, i;
+
+  node->num_pos = node->num_neg = node->num_children = 0;
+  for (val = 0; val < num_vals; val++) {
+    node->num_neg += counts[val][0];
+    node->num_pos += counts[val][1];
+    if (counts[val][0] + counts[val][1] > 0)
+      node->num_children++;
+  }
+  node->children =
+    (DTNODE **) getmem_tag(node->num_children * sizeof(DTNODE *), MEM_TREE);
+  node->child_vals =
+    (int *) getmem_tag(node->num_children * sizeof(int), MEM_TREE);
+  for (val = i = 0; val < num_vals; val++) {
+    if (counts[val][0] + counts[val][1] > 0) {
+      node->child_vals[i] = val;
+      node->children[i++] = (DTNODE *) NULL;
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Make a node testing a discrete attribute with "num_vals" values a
+   two-way test on a copy of the bitarray "subset", with two (NULL)
+   children.
+
+   ---------------------------------------------------------------------- */
+
+void SetSubsetChildren(DTNODE *node, uchar *subset, int num_vals)
+{
+  node->num_children = 2;
+  node->children = (DTNODE **) getmem_tag(2 * sizeof(DTNODE *), MEM_TREE);
+  node->children[0] = node->children[1] = (DTNODE *) NULL;
+  node->subset = CREATE_BITARRAY_TAG(num_vals, MEM_TREE);
+  memcpy(node->subset, subset, num_vals / 8 + 1);
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the index of the child of a discrete test for value "val", or -1
+   for the default branch.
+
+   ---------------------------------------------------------------------- */
+
+int DiscreteChildIndex(DTNODE *node, int val)
+{
+  int low = 0, high = node->num_children - 1, mid;
+
+  if (node->subset != NULL)
+    return READ_BITARRAY(node->subset, val);
+
+  while (low <= high) {
+    mid = (low + high) / 2;
+    if (node->child_vals[mid] < val)
+      low = mid + 1;
+    else if (node->child_vals[mid] > val)
+      high = mid - 1;
+    else
+      return mid;
+  }
+
+  return -1;
+}
+
 /* ......................................................................
 
    Create a decision subtree having a root test on the binary-valued
@@ -50,52 +158,43 @@ DTNODE *CreateDecisionTree(void **data, int num_data, int num_features,
 
    ...................................................................... */
 
-DTNODE *CreateDecisionSubTreeBinary(void **data, int num_data,
-				    uchar *train_members, int num_train,
+DTNODE *CreateDecisionSubTreeBinary(void **data, long num_data,
+				    MEMBERSET *train_members, long num_train,
 				    int num_features, int attr,
 				    SSVINFO *ssvinfo)
 {
   int val;
-  uchar *members_temp;
-  int memb, num_members_temp;
+  MEMBERSET *members_temp[2];
+  MEMBERITER iter;
+  long memb;
   DTNODE *node;
 
-  /* Allocate space for a temporary copy of the members array. */
-  members_temp = CREATE_BITARRAY(num_data);
-
-  node = (DTNODE *) getmem(sizeof(DTNODE));
-  node->children = (DTNODE **) getmem(2 * sizeof(DTNODE *));
-  node->test_attrib = attr;
-  node->num_children = 2;
+  /* Split the members by value. */
+  members_temp[0] = NewMemberSet(MEM_SPLIT);
+  members_temp[1] = NewMemberSet(MEM_SPLIT);
+  PROFILE_COUNT(rows_scanned, num_train);
+  FOR_EACH_MEMBER(iter, train_members, memb)
+    AddMember(members_temp[READ_ATTRIB_B(data, memb, attr)], memb);
 
-  for (val = 0; val <= 1; val++) {
-    num_members_temp = 0;
-    ZERO_BITARRAY(members_temp, num_data);
-    for (memb = 0; memb < num_data; memb++) {
-      if (READ_BITARRAY(train_members, memb) &&
-	  READ_ATTRIB_B(data, memb, attr) == val) {
-	WRITE_BITARRAY(members_temp, memb, 1);
-	num_members_temp++;
-      }
-    }
-    if (num_members_temp == num_train || num_members_temp == 0) {
-      /* Create leaf node. */
-      free(node->children);
-      node->children = (DTNODE **) NULL;
-      node->num_children = 0;
-      node->test_attrib = 0;
-      CountExamples(data, num_data, train_members, num_train,
-		    &(node->num_pos), &(node->num_neg));
-      break;
-    } else {
+  node = NewDecisionTreeNode();
+  node->num_members = num_train;
+  if (MEMBERSET_CARDINALITY(members_temp[0]) == 0 ||
+      MEMBERSET_CARDINALITY(members_temp[1]) == 0) {
+    /* Create leaf node. */
+    CountExamples(data, num_data, train_members, num_train,
+		  &(node->num_pos), &(node->num_neg));
+  } else {
+    node->children = (DTNODE **) getmem_tag(2 * sizeof(DTNODE *), MEM_TREE);
+    node->test_attrib = attr;
+    node->num_children = 2;
+    for (val = 0; val <= 1; val++)
       node->children[val] =
-	CreateDecisionTreeAux(data, num_data, members_temp,
-			      num_members_temp, num_features,
-			      ssvinfo);
-    }
+	CreateDecisionTreeAux(data, num_data, members_temp[val],
+			      MEMBERSET_CARDINALITY(members_temp[val]),
+			      num_features, ssvinfo);
   }
-  node->num_members = num_train;
-  free(members_temp);
+  FreeMemberSet(members_temp[0]);
+  FreeMemberSet(members_temp[1]);
 
   return node;
 }
@@ -107,52 +206,124 @@ DTNODE *CreateDecisionSubTreeBinary(void **data, int num_data,
 
    ...................................................................... */
 
-DTNODE *CreateDecisionSubTreeDiscrete(void **data, int num_data,
-				      uchar *train_members, int num_train,
+DTNODE *CreateDecisionSubTreeDiscrete(void **data, long num_data,
+				      MEMBERSET *train_members, long num_train,
 				      int num_features, int attr,
 				      SSVINFO *ssvinfo)
 {
-  int val;
-  uchar *members_temp;
-  int memb, num_members_temp;
+  int i;
+  MEMBERSET **members_temp;
+  MEMBERITER iter;
+  long memb;
+  int *child_of;
   DTNODE *node;
-  int num_branches = ssvinfo->num_discrete_vals[attr];
+  int num_vals = ssvinfo->num_discrete_vals[attr];
+  long (*counts)[2];
+
+  /* Count the examples of every value, to only create children for the
+     values present. */
+  counts = (long (*)[2]) getmem_tag(num_vals * sizeof(*counts), MEM_SPLIT);
+  memset(counts, 0, num_vals * sizeof(*counts));
+  PROFILE_COUNT(rows_scanned, num_train);
+  FOR_EACH_MEMBER(iter, train_members, memb)
+    counts[READ_ATTRIB_I(data, memb, attr)][READ_ATTRIB_B(data, memb, 0)]++;
+
+  node = NewDecisionTreeNode();
+  node->num_members = num_train;
+  SetDiscreteChildren(node, counts, num_vals);
+  freemem(counts);
+  if (node->num_children == 1) {
+    /* Create leaf node. */
+    freemem(node->children);
+    freemem(node->child_vals);
+    node->children = (DTNODE **) NULL;
+    node->child_vals = (int *) NULL;
+    node->num_children = 0;
+    return node;
+  }
+  node->test_attrib = attr;
+
+  /* Split the members among the children, in one pass. */
+  child_of = (int *) getmem_tag(num_vals * sizeof(int), MEM_SPLIT);
+  members_temp = (MEMBERSET **)
+    getmem_tag(node->num_children * sizeof(MEMBERSET *), MEM_SPLIT);
+  for (i = 0; i < node->num_children; i++) {
+    child_of[node->child_vals[i]] = i;
+    members_temp[i] = NewMemberSet(MEM_SPLIT);
+  }
+  PROFILE_COUNT(rows_scanned, num_train);
+  FOR_EACH_MEMBER(iter, train_members, memb)
+    AddMember(members_temp[child_of[READ_ATTRIB_I(data, memb, attr)]], memb);
+  freemem(child_of);
+
+  for (i = 0; i < node->num_children; i++) {
+    node->children[i] =
+      CreateDecisionTreeAux(data, num_data, members_temp[i],
+			    MEMBERSET_CARDINALITY(members_temp[i]),
+			    num_features, ssvinfo);
+    FreeMemberSet(members_temp[i]);
+  }
+  freemem(members_temp);
+
+  return node;
+}
+
+/* ......................................................................
+
+   Create a decision subtree having a two-way root test on the discrete
+   attribute "attr": the values in "subset" against all others.
+
+   ...................................................................... */
 
-  /* Allocate space for a temporary copy of the members array. */
-  members_temp = CREATE_BITARRAY(num_data);
+DTNODE *CreateDecisionSubTreeSubset(void **data, long num_data,
+				    MEMBERSET *train_members, long num_train,
+				    int num_features, int attr, uchar *subset,
+				    SSVINFO *ssvinfo)
+{
+  long memb, num_members_in, num_members_out;
+  MEMBERSET *members_in, *members_out;
+  MEMBERITER iter;
+  DTNODE *node;
+
+  /* The members of either branch. */
+  members_in = NewMemberSet(MEM_SPLIT);
+  members_out = NewMemberSet(MEM_SPLIT);
 
-  node = (DTNODE *) getmem(sizeof(DTNODE));
-  node->children = (DTNODE **) getmem(num_branches * sizeof(DTNODE *));
+  node = NewDecisionTreeNode();
   node->test_attrib = attr;
-  node->num_children = num_branches;
-
-  for (val = 0; val < num_branches; val++) {
-    num_members_temp = 0;
-    ZERO_BITARRAY(members_temp, num_data);
-    for (memb = 0; memb < num_data; memb++) {
-      if (READ_BITARRAY(train_members, memb) &&
-	  READ_ATTRIB_I(data, memb, attr) == val) {
-	WRITE_BITARRAY(members_temp, memb, 1);
-	num_members_temp++;
-      }
-    }
-    if (num_members_temp == num_train) {
-      /* Create leaf node. */
-      node->children = (DTNODE **) NULL;
-      node->num_children = 0;
-      node->test_attrib = 0;
-      CountExamples(data, num_data, train_members, num_train,
-		    &(node->num_pos), &(node->num_neg));
-      break;
-    } else {
-      node->children[val] =
-	CreateDecisionTreeAux(data, num_data, members_temp,
-			      num_members_temp, num_features,
-			      ssvinfo);
-    }
-  }
   node->num_members = num_train;
-  free(members_temp);
+  SetSubsetChildren(node, subset, ssvinfo->num_discrete_vals[attr]);
+
+  PROFILE_COUNT(rows_scanned, num_train);
+  FOR_EACH_MEMBER(iter, train_members, memb) {
+    if (READ_BITARRAY(subset, READ_ATTRIB_I(data, memb, attr)))
+      AddMember(members_in, memb);
+    else
+      AddMember(members_out, memb);
+  }
+  num_members_in = MEMBERSET_CARDINALITY(members_in);
+  num_members_out = MEMBERSET_CARDINALITY(members_out);
+
+  if (num_members_in == 0 || num_members_out == 0) {
+    /* Create leaf node. */
+    freemem(node->children);
+    freemem(node->subset);
+    node->children = (DTNODE **) NULL;
+    node->subset = (uchar *) NULL;
+    node->num_children = 0;
+    node->test_attrib = 0;
+    CountExamples(data, num_data, train_members, num_train,
+		  &(node->num_pos), &(node->num_neg));
+  } else {
+    node->children[0] =
+      CreateDecisionTreeAux(data, num_data, members_out, num_members_out,
+			    num_features, ssvinfo);
+    node->children[1] =
+      CreateDecisionTreeAux(data, num_data, members_in, num_members_in,
+			    num_features, ssvinfo);
+  }
+  FreeMemberSet(members_in);
+  FreeMemberSet(members_out);
 
   return node;
 }
@@ -164,47 +335,63 @@ DTNODE *CreateDecisionSubTreeDiscrete(void **data, int num_data,
 
    ...................................................................... */
 
-DTNODE *CreateDecisionSubTreeContinuous(void **data, int num_data,
-					uchar *train_members, int num_train,
+DTNODE *CreateDecisionSubTreeContinuous(void **data, long num_data,
+					MEMBERSET *train_members,
+					long num_train,
 					int num_features,
 					int attr, double threshold,
 					SSVINFO *ssvinfo)
 {
-  int memb, num_members_smaller, num_members_larger;
-  uchar *members_smaller, *members_larger;
+  long memb, num_members_smaller, num_members_larger, i;
+  MEMBERSET *members_smaller, *members_larger;
+  MEMBERITER iter;
+  SPARSECOLUMN *column;
+  double value;
   DTNODE *node;
 
-  /* Allocate space for a temporary copy of the members array. */
-  members_smaller = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(members_smaller, num_data);
-  members_larger = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(members_larger, num_data);
+  /* The members on either side of the threshold. */
+  members_smaller = NewMemberSet(MEM_SPLIT);
+  members_larger = NewMemberSet(MEM_SPLIT);
 
   /* Split node recursively according to threshold. */
-  node = (DTNODE *) getmem(sizeof(DTNODE));
-  node->children = (DTNODE **) getmem(2 * sizeof(DTNODE *));
+  node = NewDecisionTreeNode();
+  node->children = (DTNODE **) getmem_tag(2 * sizeof(DTNODE *), MEM_TREE);
   node->test_attrib = attr;
   node->threshold = threshold;
   node->num_children = 2;
   node->num_members = num_train;
 
-  /* Split elements into smaller and larger or equal to the threshold. */
-  num_members_smaller = num_members_larger = 0;
-  for (memb = 0; memb < num_data; memb++) {
-    if (READ_BITARRAY(train_members, memb)) {
-      if (READ_ATTRIB_C(data, memb, attr) < threshold) {
-	WRITE_BITARRAY(members_smaller, memb, 1);
-	num_members_smaller++;
-      } else {
-	WRITE_BITARRAY(members_larger, memb, 1);
-	num_members_larger++;
-      }
+  /* Split elements into smaller and larger or equal to the threshold.  The
+     rows of a sparse column are walked along with the members, rather than
+     searched for every member. */
+  PROFILE_COUNT(rows_scanned, num_train);
+  if (COLUMN_WIDTH(data[attr]) == COLUMN_SPARSE) {
+    column = SPARSE_COLUMN(data[attr]);
+    i = 0;
+    FOR_EACH_MEMBER(iter, train_members, memb) {
+      while (i < column->num_nonzero && column->rows[i] < memb)
+	i++;
+      value = (i == column->num_nonzero || column->rows[i] != memb) ? 0.0 :
+	(column->vals != NULL) ? column->vals[i] : 1.0;
+      if (value < threshold)
+	AddMember(members_smaller, memb);
+      else
+	AddMember(members_larger, memb);
+    }
+  } else {
+    FOR_EACH_MEMBER(iter, train_members, memb) {
+      if (READ_ATTRIB_C(data, memb, attr) < threshold)
+	AddMember(members_smaller, memb);
+      else
+	AddMember(members_larger, memb);
     }
   }
+  num_members_smaller = MEMBERSET_CARDINALITY(members_smaller);
+  num_members_larger = MEMBERSET_CARDINALITY(members_larger);
 
   if (num_members_smaller == 0 || num_members_larger == 0) {
     /* Create leaf node. */
-    free(node->children);
+    freemem(node->children);
     node->children = (DTNODE **) NULL;
     node->num_children = 0;
     node->test_attrib = 0;
@@ -220,8 +407,8 @@ DTNODE *CreateDecisionSubTreeContinuous(void **data, int num_data,
 			    members_larger, num_members_larger,
 			    num_features, ssvinfo);
   }
-  free(members_smaller);
-  free(members_larger);
+  FreeMemberSet(members_smaller);
+  FreeMemberSet(members_larger);
 
   return node;
 }
@@ -234,64 +421,70 @@ DTNODE *CreateDecisionSubTreeContinuous(void **data, int num_data,
 
    ...................................................................... */
 
-DTNODE *CreateDecisionTreeAux(void **data, int num_data,
-			      uchar *train_members, int num_train,
+DTNODE *CreateDecisionTreeAux(void **data, long num_data,
+			      MEMBERSET *train_members, long num_train,
 			      int num_features, SSVINFO *ssvinfo)
 {
   DTNODE *node = NULL;
-  int min_gain_attr;
-  double best_threshold;
+  SPLIT split;
   int create_leaf_node;
 
   if (num_train == 0)
     return (DTNODE *) NULL;
+  TRACE_BEGIN("node", "\"rows\": %ld", num_train);
 
   create_leaf_node = 0;
   /* Check if all examples belong to the same class. */
   if (num_train <= MIN_LEAF_MEMBERS) {
     create_leaf_node = 1;
   } else {  /* Else split and recurse. */
-    min_gain_attr = MaxGainAttribute(data, num_data, num_features,
-				     train_members, num_train,
-				     &best_threshold, ssvinfo);
-    if (min_gain_attr == -1) {
+    FindBestSplit(data, num_data, num_features, train_members, num_train,
+		  &split, ssvinfo);
+    PrintSelectedAttribute(&split, ssvinfo);
+    if (split.attr == -1) {
       create_leaf_node = 1;
     } else {
-      switch((ssvinfo->types)[min_gain_attr]) {
+      switch((ssvinfo->types)[split.attr]) {
       case 'b': /* Binary min-gain attribute. */
 	node = CreateDecisionSubTreeBinary(data, num_data,
 					   train_members, num_train,
-					   num_features, min_gain_attr,
+					   num_features, split.attr,
 					   ssvinfo);
 	break;
       case 'd':
-	node = CreateDecisionSubTreeDiscrete(data, num_data,
+	if (split.subset != NULL)
+	  node = CreateDecisionSubTreeSubset(data, num_data,
 					     train_members, num_train,
-					     num_features, min_gain_attr,
-					     ssvinfo);
+					     num_features, split.attr,
+					     split.subset, ssvinfo);
+	else
+	  node = CreateDecisionSubTreeDiscrete(data, num_data,
+					       train_members, num_train,
+					       num_features, split.attr,
+					       ssvinfo);
 	break;
       case 'c':
 	node = CreateDecisionSubTreeContinuous(data, num_data,
 					       train_members, num_train,
-					       num_features, min_gain_attr,
-					       best_threshold, ssvinfo);
+					       num_features, split.attr,
+					       split.threshold, ssvinfo);
 	break;
       default:
-	USER_ERROR1("type unknown ('%c')", ssvinfo->types[min_gain_attr]);
+	USER_ERROR1("type unknown ('%c')", ssvinfo->types[split.attr]);
       }
+      freemem(split.subset);
     }
   }
 
   /* Create leaf node. */
   if (create_leaf_node) {
-    node = (DTNODE *) getmem(sizeof(DTNODE));
-    node->num_children = 0;
-    node->children = (DTNODE **) NULL;
-    node->test_attrib = 0;
+    node = NewDecisionTreeNode();
     CountExamples(data, num_data, train_members, num_train,
 		  &(node->num_pos), &(node->num_neg));
     node->num_members = num_train;
   }
+  TRACE_END("\"attribute\": %s", (node->num_children > 0) ?
+	    TraceString(ssvinfo->feat_names[node->test_attrib]) : "null");
 
   return node;
 }
@@ -306,11 +499,11 @@ void FreeDecisionTreeNode(DTNODE *node)
 {
   if (node == NULL)
     return;
-  if (node->num_children == 0) {
-    free(node);
-  } else {
-/*     free(node->test_attrib_name); */
-  }
+  freemem(node->children);
+  freemem(node->child_vals);
+  freemem(node->subset);
+  freemem(node->stats);
+  freemem(node);
 }
 
 /* ----------------------------------------------------------------------
@@ -327,6 +520,12 @@ void FreeDecisionTreeChildren(DTNODE *node)
     return;
   for (i = 0; i < node->num_children; i++)
     FreeDecisionTree(node->children[i]);
+  freemem(node->children);
+  freemem(node->child_vals);
+  freemem(node->subset);
+  node->children = (DTNODE **) NULL;
+  node->child_vals = (int *) NULL;
+  node->subset = (uchar *) NULL;
   node->num_children = 0;
 }
 
@@ -379,4 +578,23 @@ int CountNodes(DTNODE *root)
   return nodes;
 }
 
+/* ----------------------------------------------------------------------
+
+   Set tested[attr] for every attribute a node of the tree tests.  Along
+   with the class, these are the only attributes needed to classify an
+   example with the tree.
+
+   ---------------------------------------------------------------------- */
+
+void MarkTestedAttributes(DTNODE *root, uchar *tested)
+{
+  int i;
+
+  if (root == NULL || root->num_children == 0)
+    return;
+  tested[root->test_attrib] = 1;
+  for (i = 0; i < root->num_children; i++)
+    MarkTestedAttributes(root->children[i], tested);
+}
+
 /**************************************************************************/
@@ -22,10 +22,10 @@
 
 /* Tree node definition. */
 typedef struct dtnode {
-  int num_members;              /* Number of examples within the subtree
+  long num_members;              /* Number of examples within the subtree
 				   rooted at this node. */
-  int num_pos;                  /* Number of positive examples in subtree. */
-  int num_neg;                  /* Number of negative examples in subtree. */
+  long num_pos;                  /* Number of positive examples in subtree. */
+  long num_neg;                  /* Number of negative examples in subtree. */
 
   /* ---- The following fields are only used for internal nodes. ---- */
   int num_children;             /* Number of children; 0 if a leaf. */
@@ -35,6 +35,32 @@ typedef struct dtnode {
 				   if non-leaf. */
   double threshold;             /* Value to test against at this node if
 				   continuous, compare using <. */
+  int *child_vals;              /* Values with a child, in increasing order,
+				   if the attribute tested is discrete:
+				   children[i] is the subtree for value
+				   child_vals[i].  Any other value takes the
+				   default branch, which predicts as if this
+				   node were a leaf. */
+  unsigned char *subset;        /* If not NULL, the discrete test is
+				   two-way: the values in this bitarray take
+				   children[1] and all others children[0]
+				   (child_vals is then NULL). */
+
+  /* ---- The following fields are only used for boosted trees. ---- */
+  double value;                 /* Real-valued output of the node (the
+				   leaf output, or the fallback output of an
+				   internal node whose child is missing). */
+  double sum_grad;              /* Sum of loss gradients over members. */
+  double sum_hess;              /* Sum of loss hessians over members. */
+
+  /* ---- The following field is only used by incremental updates. ---- */
+  long (*stats)[2];              /* Count table of every binary and discrete
+				   attribute over the members of an internal
+				   node (see update.h); NULL if not kept. */
+
+  /* ---- The following field is only used while growing from a stream. */
+  void *stream_leaf;            /* Statistics of a leaf (a STREAMLEAF, see
+				   hoeffding.h); NULL for internal nodes. */
 
   /* ---------------------------------------------------------------- */
 } DTNODE;
@@ -45,34 +71,45 @@ typedef struct dtnode {
 #include "auxi.h"
 #include "entropy.h"
 #include "bitarray.h"
+#include "memberset.h"
 #include "ssv.h"
 
 /* Function prototypes. */
-DTNODE *CreateDecisionTree(void **data, int num_data, int num_features,
+DTNODE *CreateDecisionTree(void **data, long num_data, int num_features,
 			   double approx_prune_pct, double approx_test_pct,
-			   uchar *train_members, int num_train,
+			   MEMBERSET *train_members, long num_train,
 			   SSVINFO *ssvinfo);
-DTNODE *CreateDecisionSubTreeBinary(void **data, int num_data,
-				    uchar *train_members, int num_train,
+DTNODE *CreateDecisionSubTreeBinary(void **data, long num_data,
+				    MEMBERSET *train_members, long num_train,
 				    int num_features, int attr,
 				    SSVINFO *ssvinfo);
-DTNODE *CreateDecisionSubTreeDiscrete(void **data, int num_data,
-				      uchar *train_members, int num_train,
+DTNODE *CreateDecisionSubTreeDiscrete(void **data, long num_data,
+				      MEMBERSET *train_members, long num_train,
 				      int num_features, int attr,
 				      SSVINFO *ssvinfo);
-DTNODE *CreateDecisionSubTreeContinuous(void **data, int num_data,
-					uchar *train_members, int num_train,
+DTNODE *CreateDecisionSubTreeSubset(void **data, long num_data,
+				    MEMBERSET *train_members, long num_train,
+				    int num_features, int attr, uchar *subset,
+				    SSVINFO *ssvinfo);
+DTNODE *CreateDecisionSubTreeContinuous(void **data, long num_data,
+					MEMBERSET *train_members,
+					long num_train,
 					int num_features,
 					int attr, double threshold,
 					SSVINFO *ssvinfo);
-DTNODE *CreateDecisionTreeAux(void **data, int num_data,
-			      uchar *train_members, int num_train,
+DTNODE *CreateDecisionTreeAux(void **data, long num_data,
+			      MEMBERSET *train_members, long num_train,
 			      int num_features, SSVINFO *ssvinfo);
+DTNODE *NewDecisionTreeNode(void);
+void SetDiscreteChildren(DTNODE *node, long (*counts)[2], int num_vals);
+void SetSubsetChildren(DTNODE *node, uchar *subset, int num_vals);
+int DiscreteChildIndex(DTNODE *node, int val);
 void FreeDecisionTreeNode(DTNODE *node);
 void FreeDecisionTreeChildren(DTNODE *node);
 void FreeDecisionTree(DTNODE *root);
 int CountNodes(DTNODE *root);
 int CountNodesDepth(DTNODE *root, int depth);
+void MarkTestedAttributes(DTNODE *root, uchar *tested);
 
 #endif // DT_H
 /**************************************************************************/
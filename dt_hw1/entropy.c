@@ -11,11 +11,20 @@
  *
  **************************************************************************/
 
+#include <string.h>
 #include "auxi.h"
 #include "dt.h"
 #include "entropy.h"
 #include "ssv.h"
 #include "bitarray.h"
+#include "profile.h"
+
+/* A value of a discrete attribute, for sorting by its rate of positive
+   examples. */
+typedef struct valrate {
+  double rate;
+  int val;
+} VALRATE;
 
 /* ----------------------------------------------------------------------
 
@@ -28,29 +37,47 @@ static int comp_doubles(double *a, double *b)
   return (*a == *b) ? 0 : ((*a < *b) ? -1 : 1);
 }
 
+/* ----------------------------------------------------------------------
+
+   Auxiliary function used by qsort to sort values by rate of positive
+   examples (and by value, for a fixed order among equal rates).
+
+   ---------------------------------------------------------------------- */
+
+static int comp_valrates(const void *a, const void *b)
+{
+  const VALRATE *va = (const VALRATE *) a, *vb = (const VALRATE *) b;
+
+  if (va->rate != vb->rate)
+    return (va->rate < vb->rate) ? -1 : 1;
+  return va->val - vb->val;
+}
+
 /* ----------------------------------------------------------------------
 
    Auxiliary function.  Count the positive and negative examples that are
-   members of the "members" array.  If "members" is NULL, all examples are
+   members of the "members" set.  If "members" is NULL, all examples are
    assumed to be members.
 
    ---------------------------------------------------------------------- */
 
-void CountExamples(void **data, int num_data,
-		   uchar *members, int num_members,
-		   int *num_pos, int *num_neg)
+void CountExamples(void **data, long num_data,
+		   MEMBERSET *members, long num_members,
+		   long *num_pos, long *num_neg)
 {
-  int memb;
-
-  *num_pos = *num_neg = 0;
-  for (memb = 0; memb < num_data; memb++) {
-    if (members == NULL || READ_BITARRAY(members, memb)) {
-      if (READ_ATTRIB_B(data, memb, 0) == 1)
-	(*num_pos)++;
-      else
-	(*num_neg)++;
-    }
+  long counts[3];
+
+  (void) num_members;
+  CountMemberBits(members, num_data, LABEL_COLUMN(data), (uchar *) NULL,
+		  counts);
+  *num_pos = counts[0];
+  if (members == NULL) {
+    PROFILE_COUNT(rows_scanned, num_data);
+    *num_neg = num_data - *num_pos;
+    return;
   }
+  PROFILE_COUNT(rows_scanned, MEMBERSET_CARDINALITY(members));
+  *num_neg = MEMBERSET_CARDINALITY(members) - *num_pos;
 }
 
 /* ----------------------------------------------------------------------
@@ -72,7 +99,7 @@ double LogBase2(double x){
 
    ---------------------------------------------------------------------- */
 
-double Entropy(int num_pos, int num_neg) {
+double Entropy(long num_pos, long num_neg) {
   // In this example, variable space is positive and negative
   // so we calculate entropy by summing P(x)log(x) for the 
   // positive and negative examples
@@ -92,12 +119,13 @@ double Entropy(int num_pos, int num_neg) {
 
    ---------------------------------------------------------------------- */
 
-double DataEntropy(void **data, int num_data,
-	       uchar *members, int num_members,
+double DataEntropy(void **data, long num_data,
+	       MEMBERSET *members, long num_members,
 	       SSVINFO *ssvinfo)
 {
-  int num_pos, num_neg;
+  long num_pos, num_neg;
 
+  (void) ssvinfo;
   if (num_members == 0)
     return 0.0;
 
@@ -108,43 +136,103 @@ double DataEntropy(void **data, int num_data,
 
 /* ----------------------------------------------------------------------
 
-   Compute the partial entropy that would result if the data set was split
-   according to the binary attribute "attr".
+   Compute the partial entropy of a split from its count table:
+   counts[val][1] and counts[val][0] are the numbers of positive and
+   negative examples taking branch "val".
 
    ---------------------------------------------------------------------- */
 
-double PartialEntropyBinary(void **data, int num_data,
-			    uchar *members, int num_members, int attr,
-			    SSVINFO *ssvinfo)
+double PartialEntropyCounts(long (*counts)[2], int num_vals, long num_members)
 {
   double partial_entropy;
-  int example, num_split, val;
-  uchar *split_members;
+  long num_split;
+  int val;
 
   if (num_members == 0)
     return 0.0;
 
-  split_members = CREATE_BITARRAY(num_data);
   partial_entropy = 0.0;
-  for (val = 0; val <= 1; val++) {
-    num_split = 0;
-    ZERO_BITARRAY(split_members, num_data);
-    for (example = 0; example < num_data; example++) {
-      if (READ_BITARRAY(members, example) &&
-	  READ_ATTRIB_B(data, example, attr) == val) {
-	WRITE_BITARRAY(split_members, example, 1);
-	num_split++;
-      }
-    }
-    partial_entropy += num_split * DataEntropy(data, num_data, split_members,
-					   num_split, ssvinfo);
+  for (val = 0; val < num_vals; val++) {
+    num_split = counts[val][0] + counts[val][1];
+    partial_entropy += num_split *
+      ((num_split == 0) ? 0.0 : Entropy(counts[val][1], counts[val][0]));
   }
   partial_entropy /= (double) num_members;
-  free(split_members);
 
   return partial_entropy;
 }
+
+/* ----------------------------------------------------------------------
+
+   Compute the partial entropy that would result if the data set was split
+   according to the binary attribute "attr".
+
+   ---------------------------------------------------------------------- */
+
+double PartialEntropyBinary(void **data, long num_data,
+			    MEMBERSET *members, long num_members, int attr,
+			    SSVINFO *ssvinfo)
+{
+  long counts[2][2], bits[3];
+
+  (void) ssvinfo;
+  if (num_members == 0)
+    return 0.0;
+
+  /* The members with the attribute set, the positive ones, and the
+     positive ones with the attribute set, a word of rows at a time. */
+  PROFILE_COUNT(rows_scanned, num_members);
+  CountMemberBits(members, num_data, (uchar *) data[attr],
+		  LABEL_COLUMN(data), bits);
+  counts[1][1] = bits[2];
+  counts[1][0] = bits[0] - bits[2];
+  counts[0][1] = bits[1] - bits[2];
+  counts[0][0] = MEMBERSET_CARDINALITY(members) - bits[0] - counts[0][1];
+
+  return PartialEntropyCounts(counts, 2, num_members);
+}
  
+/* ----------------------------------------------------------------------
+
+   Auxiliary function.  Return the count table of the discrete attribute
+   "attr" over the members (see PartialEntropyCounts()), to be freed by the
+   caller.
+
+   ---------------------------------------------------------------------- */
+
+static long (*DiscreteCounts(void **data, MEMBERSET *members, int attr,
+			    SSVINFO *ssvinfo))[2]
+{
+  MEMBERITER iter;
+  long example;
+  int num_vals = ssvinfo->num_discrete_vals[attr];
+  long (*counts)[2];
+
+  PROFILE_COUNT(rows_scanned, MEMBERSET_CARDINALITY(members));
+  counts = (long (*)[2]) getmem_tag(num_vals * sizeof(*counts), MEM_SPLIT);
+  memset(counts, 0, num_vals * sizeof(*counts));
+
+  /* One loop per width of the codes. */
+#define COUNT_CODES(code_type) {					\
+    code_type *codes = (code_type *) data[attr];			\
+    FOR_EACH_MEMBER(iter, members, example)				\
+      counts[codes[example]][READ_ATTRIB_B(data, example, 0)]++;	\
+  }
+  switch (COLUMN_WIDTH(data[attr])) {
+  case 1:
+    COUNT_CODES(unsigned char);
+    break;
+  case 2:
+    COUNT_CODES(unsigned short);
+    break;
+  default:
+    COUNT_CODES(int);
+  }
+#undef COUNT_CODES
+
+  return counts;
+}
+
 /* ----------------------------------------------------------------------
 
    Compute the partial entropy that would result if the data set was split
@@ -152,75 +240,300 @@ double PartialEntropyBinary(void **data, int num_data,
 
    ---------------------------------------------------------------------- */
 
-double PartialEntropyDiscrete(void **data, int num_data,
-			      uchar *members, int num_members, int attr,
+double PartialEntropyDiscrete(void **data, long num_data,
+			      MEMBERSET *members, long num_members, int attr,
 			      SSVINFO *ssvinfo)
 {
   double partial_entropy;
-  int example, num_split, val;
-  uchar *split_members;
+  long (*counts)[2];
 
+  (void) num_data;
   if (num_members == 0)
     return 0.0;
 
-  split_members = CREATE_BITARRAY(num_data);
-  partial_entropy = 0.0;
-  for (val = 0; val < ssvinfo->num_discrete_vals[attr]; val++) {
-    num_split = 0;
-    ZERO_BITARRAY(split_members, num_data);
-    for (example = 0; example < num_data; example++) {
-      if (READ_BITARRAY(members, example) &&
-	  READ_ATTRIB_I(data, example, attr) == val) {
-	WRITE_BITARRAY(split_members, example, 1);
-	num_split++;
-      }
+  counts = DiscreteCounts(data, members, attr, ssvinfo);
+  partial_entropy = PartialEntropyCounts(counts,
+					 ssvinfo->num_discrete_vals[attr],
+					 num_members);
+  freemem(counts);
+
+  return partial_entropy;
+}
+
+/* ----------------------------------------------------------------------
+
+   Find the best two-way split of the values of a discrete attribute from
+   its count table (see PartialEntropyCounts()).  For a binary target the
+   best subset is a prefix of the values sorted by rate of positive
+   examples, so only the k-1 prefixes of the k values present are tried.
+   The best subset is written to the bitarray "subset" (of "num_vals"
+   bits) and its partial entropy returned; HUGE_VAL if fewer than two
+   values are present.
+
+   ---------------------------------------------------------------------- */
+
+double PartialEntropySubsetCounts(long (*counts)[2], int num_vals,
+				  long num_members, uchar *subset)
+{
+  VALRATE *order;
+  long num_left, left[2], right[2];
+  int val, i, num_present, best_prefix;
+  double partial_entropy, min_partial_entropy;
+
+  order = (VALRATE *) getmem_tag((num_vals + 1) * sizeof(VALRATE), MEM_SPLIT);
+  num_present = 0;
+  right[0] = right[1] = 0;
+  for (val = 0; val < num_vals; val++) {
+    if (counts[val][0] + counts[val][1] == 0)
+      continue;
+    order[num_present].rate =
+      (double) counts[val][1] / (counts[val][0] + counts[val][1]);
+    order[num_present++].val = val;
+    right[0] += counts[val][0];
+    right[1] += counts[val][1];
+  }
+  qsort(order, num_present, sizeof(VALRATE), comp_valrates);
+  PROFILE_COUNT(sorts, 1);
+
+  min_partial_entropy = HUGE_VAL;
+  best_prefix = 0;
+  left[0] = left[1] = 0;
+  for (i = 0; i < num_present - 1; i++) {
+    val = order[i].val;
+    left[0] += counts[val][0];
+    left[1] += counts[val][1];
+    right[0] -= counts[val][0];
+    right[1] -= counts[val][1];
+    num_left = left[0] + left[1];
+    partial_entropy =
+      (num_left * Entropy(left[1], left[0]) +
+       (right[0] + right[1]) * Entropy(right[1], right[0])) /
+      (double) num_members;
+    if (partial_entropy < min_partial_entropy) {
+      min_partial_entropy = partial_entropy;
+      best_prefix = i + 1;
     }
-    partial_entropy += num_split * DataEntropy(data, num_data, split_members,
-					   num_split, ssvinfo);
   }
-  partial_entropy /= (double) num_members;
-  free(split_members);
+
+  ZERO_BITARRAY(subset, num_vals);
+  for (i = 0; i < best_prefix; i++)
+    WRITE_BITARRAY(subset, order[i].val, 1);
+  freemem(order);
+
+  return min_partial_entropy;
+}
+
+/* ----------------------------------------------------------------------
+
+   Compute the partial entropy of the best two-way split of the discrete
+   attribute "attr", and write its subset of values to "subset".
+
+   ---------------------------------------------------------------------- */
+
+double PartialEntropySubset(void **data, long num_data,
+			    MEMBERSET *members, long num_members, int attr,
+			    uchar *subset, SSVINFO *ssvinfo)
+{
+  double partial_entropy;
+  long (*counts)[2];
+
+  (void) num_data;
+  if (num_members == 0)
+    return HUGE_VAL;
+
+  counts = DiscreteCounts(data, members, attr, ssvinfo);
+  partial_entropy =
+    PartialEntropySubsetCounts(counts, ssvinfo->num_discrete_vals[attr],
+			       num_members, subset);
+  freemem(counts);
 
   return partial_entropy;
 }
  
+/* ----------------------------------------------------------------------
+
+   Compute the partial entropy of a split on the sparse continuous
+   attribute "attr" (see SPARSECOLUMN in ssv.h), and its best threshold,
+   as PartialEntropyContinuous() does, given the "num_pos" positive and
+   "num_neg" negative examples among the members.  Only the nonzero
+   members are visited: the examples of value 0 are counted by
+   subtraction from these totals, and sorted as a single value among the
+   others.  An attribute whose nonzero values are all 1 needs no sorting,
+   its only threshold being 0.5.
+
+   ---------------------------------------------------------------------- */
+
+double PartialEntropySparse(void **data, long num_data,
+			    MEMBERSET *members, long num_members,
+			    int attr, long num_pos, long num_neg,
+			    double *best_threshold)
+{
+  SPARSECOLUMN *column = SPARSE_COLUMN(data[attr]);
+  long num_smaller_0, num_smaller_1;
+  long num_larger_0, num_larger_1;
+  long num_smaller, num_larger;
+  long nonzero_0 = 0, nonzero_1 = 0, zero_0, zero_1;
+  long i, pos, example, num_vals = 0, count_0, count_1;
+  MEMBERITER iter;
+  double *vals = (double *) NULL;
+  double partial_entropy, min_partial_entropy = HUGE_VAL;
+  double val, prev_val = 0.0;
+  int label, zero_pending;
+
+  (void) num_data;
+  if (column->vals != NULL)
+    vals = (double *) getmem_tag(2 * MAX(MIN(column->num_nonzero,
+					     num_members), 1) *
+				 sizeof(double), MEM_SPLIT);
+
+  /* The nonzero members.  A column with fewer nonzero rows than the node
+     has members is walked looking each row up in the members, else both,
+     in increasing order, are walked together. */
+#define GATHER_NONZERO(i) {						\
+    label = READ_ATTRIB_B(data, column->rows[i], 0);			\
+    if (label)								\
+      nonzero_1++;							\
+    else								\
+      nonzero_0++;							\
+    if (vals != NULL) {							\
+      vals[num_vals++] = column->vals[i];				\
+      vals[num_vals++] = label;						\
+    }									\
+  }
+  if (column->num_nonzero < num_members) {
+    PROFILE_COUNT(rows_scanned, column->num_nonzero);
+    for (i = 0; i < column->num_nonzero; i++)
+      if (IsMember(members, column->rows[i]))
+	GATHER_NONZERO(i);
+  } else {
+    PROFILE_COUNT(rows_scanned, num_members);
+    i = 0;
+    FOR_EACH_MEMBER(iter, members, example) {
+      while (i < column->num_nonzero && column->rows[i] < example)
+	i++;
+      if (i == column->num_nonzero)
+	break;
+      if (column->rows[i] == example)
+	GATHER_NONZERO(i);
+    }
+  }
+#undef GATHER_NONZERO
+  zero_0 = num_neg - nonzero_0;
+  zero_1 = num_pos - nonzero_1;
+
+  if (vals == NULL) {
+    if (zero_0 + zero_1 == 0 || nonzero_0 + nonzero_1 == 0)
+      return HUGE_VAL;
+    *best_threshold = 0.5;
+    return
+      (double) (zero_0 + zero_1) / (double) num_members *
+      Entropy(zero_0, zero_1) +
+      (double) (nonzero_0 + nonzero_1) / (double) num_members *
+      Entropy(nonzero_0, nonzero_1);
+  }
+
+  qsort(vals, num_vals / 2, 2 * sizeof(double), (int (*)()) comp_doubles);
+  PROFILE_COUNT(sorts, 1);
+
+  /* Sweep the values in increasing order, the zero examples taking their
+     place before the first positive value, and try a threshold between
+     every two values. */
+  num_smaller_0 = num_smaller_1 = 0;
+  num_larger_0 = num_neg;
+  num_larger_1 = num_pos;
+  zero_pending = (zero_0 + zero_1 > 0);
+  for (pos = 0; pos < num_vals || zero_pending; ) {
+    if (zero_pending && (pos == num_vals || vals[pos] > 0.0)) {
+      val = 0.0;
+      count_0 = zero_0;
+      count_1 = zero_1;
+      zero_pending = 0;
+    } else {
+      val = vals[pos];
+      count_1 = (vals[pos+1] != 0.0);
+      count_0 = 1 - count_1;
+      pos += 2;
+    }
+
+    if (num_smaller_0 + num_smaller_1 > 0 && val != prev_val) {
+      num_smaller = num_smaller_0 + num_smaller_1;
+      num_larger = num_larger_0 + num_larger_1;
+      partial_entropy =
+	(double) num_smaller / (double) num_members *
+	Entropy(num_smaller_0, num_smaller_1) +
+	(double) num_larger / (double) num_members *
+	Entropy(num_larger_0, num_larger_1);
+      if (partial_entropy < min_partial_entropy) {
+	min_partial_entropy = partial_entropy;
+	*best_threshold = (prev_val + val) / 2.0;
+      }
+    }
+    num_smaller_0 += count_0;
+    num_smaller_1 += count_1;
+    num_larger_0 -= count_0;
+    num_larger_1 -= count_1;
+    prev_val = val;
+  }
+
+  freemem(vals);
+
+  return min_partial_entropy;
+}
+
 /* ----------------------------------------------------------------------
 
    Compute the partial entropy that would result if the data set was split
    according to the continuous attribute "attr".  Return the best threshold
    value for that split also (the one that gives the maximum reduction in
-   entropy).
+   entropy).  Sparse attributes are handed to PartialEntropySparse().
 
    ---------------------------------------------------------------------- */
 
-double PartialEntropyContinuous(void **data, int num_data,
-				uchar *members, int num_members,
+double PartialEntropyContinuous(void **data, long num_data,
+				MEMBERSET *members, long num_members,
 				int attr, double *best_threshold)
 {
-  int num_smaller_0, num_smaller_1;
-  int num_larger_0, num_larger_1;
-  int num_smaller, num_larger;
-  int example, pos;
+  long num_smaller_0, num_smaller_1;
+  long num_larger_0, num_larger_1;
+  long num_smaller, num_larger;
+  MEMBERITER iter;
+  long example, pos;
   double partial_entropy;
-  double *vals = (double *) getmem(2 * num_members * sizeof(double));
-  int num_vals;
+  double *vals;
+  long num_vals;
   double min_partial_entropy = HUGE_VAL;
   double val;
 
+  if (COLUMN_WIDTH(data[attr]) == COLUMN_SPARSE) {
+    CountExamples(data, num_data, members, num_members,
+		  &num_larger_1, &num_larger_0);
+    return PartialEntropySparse(data, num_data, members, num_members, attr,
+				num_larger_1, num_larger_0, best_threshold);
+  }
+
+  vals = (double *) getmem_tag(2 * num_members * sizeof(double), MEM_SPLIT);
+  PROFILE_COUNT(rows_scanned, num_members);
   num_vals = 0;
   num_larger_0 = num_larger_1 = 0;
-  for (example = 0; example < num_data; example++) {
-    if (READ_BITARRAY(members, example)) {
-      vals[num_vals++] = READ_ATTRIB_C(data, example, attr);
-      val = (double) READ_ATTRIB_B(data, example, 0);
-      if (val == 0.0)
-	num_larger_0++;
-      else 
-	num_larger_1++;
-      vals[num_vals++] = val;
-    }
+#define GATHER_VALUES(value_type) {					\
+    value_type *column = (value_type *) data[attr];			\
+    FOR_EACH_MEMBER(iter, members, example) {				\
+      vals[num_vals++] = column[example];				\
+      val = (double) READ_ATTRIB_B(data, example, 0);			\
+      if (val == 0.0)							\
+	num_larger_0++;							\
+      else								\
+	num_larger_1++;							\
+      vals[num_vals++] = val;						\
+    }									\
   }
+  if (COLUMN_WIDTH(data[attr]) == 4)
+    GATHER_VALUES(float)
+  else
+    GATHER_VALUES(double)
+#undef GATHER_VALUES
   qsort(vals, num_vals / 2, 2 * sizeof(double), (int (*)()) comp_doubles);
+  PROFILE_COUNT(sorts, 1);
 
   num_smaller_0 = num_smaller_1 = 0;
   for (pos = 0; pos <= num_vals - 4; pos += 2) {
@@ -234,7 +547,7 @@ double PartialEntropyContinuous(void **data, int num_data,
       num_larger_1--;
       break;
     default:   /* Sanity check. */
-      USER_ERROR2("vals[%d] contains %g (not 0 or 1)",
+      USER_ERROR2("vals[%ld] contains %g (not 0 or 1)",
 		  pos+1, vals[pos+1]);
     }
     if (vals[pos] == vals[pos+2] || pos > num_vals - 4)
@@ -256,33 +569,46 @@ double PartialEntropyContinuous(void **data, int num_data,
     }
   }
 
-  free(vals);
+  freemem(vals);
 
   return min_partial_entropy;
 }
 
 /* ----------------------------------------------------------------------
 
-   Return the attribute that results in the greatest information gain
-   (lowest entropy).  If it is continuous, also return the best splitting
-   threshold.
+   Find the attribute that results in the greatest information gain
+   (lowest entropy), and its gain.  If it is continuous, also find the best
+   splitting threshold, and if it is discrete and split two ways, the best
+   subset of values (which the caller must free).  If no attribute has a
+   positive gain, split->attr is set to -1.
 
    ---------------------------------------------------------------------- */
 
-int MaxGainAttribute(void **examples, int num_examples, int num_attribs,
-		     uchar *members, int num_members,
-		     double *best_threshold, SSVINFO *ssvinfo)
+void FindBestSplit(void **examples, long num_examples, int num_attribs,
+		   MEMBERSET *members, long num_members,
+		   SPLIT *split, SSVINFO *ssvinfo)
 {
   double entropy_orig, new_entropy;
   int attr, max_gain_attr;
   double gain, max_gain, threshold;
+  long num_pos = -1, num_neg = 0;
+  uchar *subset;
+
+  PROFILE_BEGIN(PHASE_SPLIT);
+  PROFILE_COUNT(max_gain_calls, 1);
+  PROFILE_COUNT(attribs_evaluated, num_attribs - 1);
 
   entropy_orig = DataEntropy(examples, num_examples,
 			 members, num_members, ssvinfo);
 
   max_gain = 0.0;
   max_gain_attr = -1;
+  split->threshold = 0.0;
+  split->subset = (uchar *) NULL;
   for (attr = 1; attr < num_attribs; attr++) {
+    subset = (uchar *) NULL;
+    TRACE_BEGIN("attribute", "\"attribute\": %s",
+		TraceString(ssvinfo->feat_names[attr]));
     switch (ssvinfo->types[attr]) {
     case 'b':
       new_entropy = PartialEntropyBinary(examples, num_examples,
@@ -290,19 +616,38 @@ int MaxGainAttribute(void **examples, int num_examples, int num_attribs,
 					 attr, ssvinfo);
       break;
     case 'd':
-      new_entropy = PartialEntropyDiscrete(examples, num_examples,
+      if (ssvinfo->subset_splits) {
+	subset = CREATE_BITARRAY_TAG(ssvinfo->num_discrete_vals[attr],
+				     MEM_SPLIT);
+	new_entropy = PartialEntropySubset(examples, num_examples,
 					   members, num_members,
-					   attr, ssvinfo);
+					   attr, subset, ssvinfo);
+      } else {
+	new_entropy = PartialEntropyDiscrete(examples, num_examples,
+					     members, num_members,
+					     attr, ssvinfo);
+      }
       break;
     case 'c':
-      new_entropy = PartialEntropyContinuous(examples, num_examples,
-					     members, num_members,
-					     attr, &threshold);
+      if (COLUMN_WIDTH(examples[attr]) != COLUMN_SPARSE) {
+	new_entropy = PartialEntropyContinuous(examples, num_examples,
+					       members, num_members,
+					       attr, &threshold);
+	break;
+      }
+      /* The counts of the members are shared by all sparse attributes. */
+      if (num_pos < 0)
+	CountExamples(examples, num_examples, members, num_members,
+		      &num_pos, &num_neg);
+      new_entropy = PartialEntropySparse(examples, num_examples,
+					 members, num_members, attr,
+					 num_pos, num_neg, &threshold);
       break;
     default:
       USER_ERROR1("Unknown attribute type '%c'", ssvinfo->types[attr]);
     }
     gain = entropy_orig - new_entropy;
+    TRACE_END("\"gain\": %s", TraceNumber(gain));
 
     /* Only print intermediate results if not in batch mode */
     /* DISABLED - uncomment this if you want to see more details
@@ -314,26 +659,68 @@ int MaxGainAttribute(void **examples, int num_examples, int num_attribs,
     if (gain > max_gain) {
       max_gain = gain;
       max_gain_attr = attr;
-      *best_threshold = threshold;
+      split->threshold = threshold;
+      freemem(split->subset);
+      split->subset = subset;
+      subset = (uchar *) NULL;
     }
+    freemem(subset);
   }
 
   if (max_gain<=0) {
     max_gain_attr = -1;
+    freemem(split->subset);
+    split->subset = (uchar *) NULL;
   }
 
+  split->attr = max_gain_attr;
+  split->gain = max_gain;
+
+  PROFILE_END(PHASE_SPLIT);
+}
+
+/* ----------------------------------------------------------------------
+
+   Report the attribute chosen for a split (not in batch mode).
+
+   ---------------------------------------------------------------------- */
+
+void PrintSelectedAttribute(SPLIT *split, SSVINFO *ssvinfo)
+{
   /* Only print intermediate results if not in batch mode */
   if (ssvinfo->batch==0) {
-    if (max_gain_attr >= 1) {
-      printf("Selected attribute \"%s\" (Gain = %g)",ssvinfo->feat_names[max_gain_attr],max_gain);
-      if (ssvinfo->types[max_gain_attr] == 'c') {
-	printf("\t(Threshold = %g)", *best_threshold);
+    if (split->attr >= 1) {
+      printf("Selected attribute \"%s\" (Gain = %g)",ssvinfo->feat_names[split->attr],split->gain);
+      if (ssvinfo->types[split->attr] == 'c') {
+	printf("\t(Threshold = %g)", split->threshold);
       }
       printf("\n"); fflush(stdout);
     }  
   }
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the attribute that results in the greatest information gain
+   (lowest entropy).  If it is continuous, also return the best splitting
+   threshold.
+
+   ---------------------------------------------------------------------- */
+
+int MaxGainAttribute(void **examples, long num_examples, int num_attribs,
+		     MEMBERSET *members, long num_members,
+		     double *best_threshold, SSVINFO *ssvinfo)
+{
+  SPLIT split;
+
+  FindBestSplit(examples, num_examples, num_attribs, members, num_members,
+		&split, ssvinfo);
+  PrintSelectedAttribute(&split, ssvinfo);
+  freemem(split.subset);
+  if (split.attr != -1)
+    *best_threshold = split.threshold;
 
-  return max_gain_attr;
+  return split.attr;
 }
 
 /**************************************************************************/
@@ -15,27 +15,55 @@
 #define ENTROPY_H 1
 
 #include "bitarray.h"
+#include "memberset.h"
 #include "ssv.h"
 
+/* The best way found to split a set of examples. */
+typedef struct split {
+  int attr;                     /* Attribute to test, or -1 if no attribute
+				   gives a positive gain. */
+  double threshold;             /* Threshold if the attribute is
+				   continuous. */
+  double gain;                  /* Information gain of the split. */
+  uchar *subset;                /* If the attribute is discrete and split
+				   two ways (see SSVINFO.subset_splits), the
+				   bitarray of the values taking branch 1;
+				   NULL otherwise.  Owned by the split. */
+} SPLIT;
+
 /* Function prototypes. */
-void CountExamples(void **data, int num_data,
-		   uchar *train_members, int num_train,
-		   int *num_pos, int *num_neg);
-double Entropy(int num_pos, int num_neg);
-double DataEntropy(void **data, int num_data,
-	       uchar *members, int num_members,
+void CountExamples(void **data, long num_data,
+		   MEMBERSET *train_members, long num_train,
+		   long *num_pos, long *num_neg);
+double Entropy(long num_pos, long num_neg);
+double DataEntropy(void **data, long num_data,
+	       MEMBERSET *members, long num_members,
 	       SSVINFO *ssvinfo);
-double PartialEntropyBinary(void **data, int num_data,
-			    uchar *members, int num_members, int attr,
+double PartialEntropyCounts(long (*counts)[2], int num_vals, long num_members);
+double PartialEntropyBinary(void **data, long num_data,
+			    MEMBERSET *members, long num_members, int attr,
 			    SSVINFO *ssvinfo);
-double PartialEntropyDiscrete(void **data, int num_data,
-			      uchar *members, int num_members, int attr,
+double PartialEntropyDiscrete(void **data, long num_data,
+			      MEMBERSET *members, long num_members, int attr,
 			      SSVINFO *ssvinfo);
-double PartialEntropyContinuous(void **data, int num_data,
-				uchar *members, int num_members,
+double PartialEntropySubsetCounts(long (*counts)[2], int num_vals,
+				  long num_members, uchar *subset);
+double PartialEntropySubset(void **data, long num_data,
+			    MEMBERSET *members, long num_members, int attr,
+			    uchar *subset, SSVINFO *ssvinfo);
+double PartialEntropyContinuous(void **data, long num_data,
+				MEMBERSET *members, long num_members,
 				int attr, double *best_threshold);
-int MaxGainAttribute(void **examples, int num_examples, int num_attribs,
-		     uchar *members, int num_members,
+double PartialEntropySparse(void **data, long num_data,
+			    MEMBERSET *members, long num_members,
+			    int attr, long num_pos, long num_neg,
+			    double *best_threshold);
+void FindBestSplit(void **examples, long num_examples, int num_attribs,
+		   MEMBERSET *members, long num_members,
+		   SPLIT *split, SSVINFO *ssvinfo);
+void PrintSelectedAttribute(SPLIT *split, SSVINFO *ssvinfo);
+int MaxGainAttribute(void **examples, long num_examples, int num_attribs,
+		     MEMBERSET *members, long num_members,
 		     double *best_threshold, SSVINFO *ssvinfo);
 
 #endif // ENTROPY_H
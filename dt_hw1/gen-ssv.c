@@ -0,0 +1,220 @@
+/**************************************************************************
+ *
+ * gen-ssv.c
+ *
+ * Deterministic generator of synthetic SSV data sets, used by the
+ * benchmark suite (see bench.sh).  The same arguments always produce the
+ * same file, on any machine.
+ *
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "auxi.h"
+
+#define USAGE "\nGenerate a synthetic SSV data set.\n\n"			\
+              "Usage: %s [-n <rows>] [-b <binary>] [-d <discrete>] "	\
+              "[-c <continuous>] [-k <values>] [-noise <rate>] "	\
+              "[-rule linear|conj|xor] [-s <seed>] [-rs <seed>] "	\
+              "[-o <file>]\n\n"						\
+              "  -n      number of examples (default 10000)\n"		\
+              "  -b      number of binary attributes (default 4)\n"	\
+              "  -d      number of discrete attributes (default 4)\n"	\
+              "  -c      number of continuous attributes (default 4)\n"	\
+              "  -k      values of every discrete attribute (default 8)\n" \
+              "  -noise  fraction of labels flipped at random (default 0.1)\n" \
+              "  -rule   how the label depends on the attributes "	\
+              "(default linear)\n"					\
+              "  -s      random seed (default 1)\n"			\
+              "  -rs     seed of the weights of the linear rule "	\
+              "(default -s)\n"						\
+              "  -o      output file (default standard output)\n\n"
+
+#define RULE_LINEAR 0  /* Sign of a weighted sum of all attributes. */
+#define RULE_CONJ   1  /* (b1 and c1 > 0.5) or d1 in the first third. */
+#define RULE_XOR    2  /* Parity of the first two binary/continuous
+			  attributes. */
+
+/* State of the random number generator (splitmix64). */
+static uint64_t rng_state;
+
+/* ----------------------------------------------------------------------
+
+   Return the next 64 random bits, and a random number in [0, 1).
+
+   ---------------------------------------------------------------------- */
+
+static uint64_t NextRandom(void)
+{
+  uint64_t z = (rng_state += 0x9E3779B97F4A7C15ULL);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static double NextUniform(void)
+{
+  return (NextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* ----------------------------------------------------------------------
+
+   Main function.
+
+   ---------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+  long num_rows = 10000, row;
+  int num_b = 4, num_d = 4, num_c = 4, num_vals = 8, rule = RULE_LINEAR;
+  int i, label, num_features;
+  double noise = 0.1, score, *weights;
+  unsigned long seed = 1, rule_seed = 0;
+  int rule_seed_set = 0;
+  char *out_filename = NULL;
+  FILE *out;
+  int *b, *d;
+  double *c;
+
+  progname = (char *) strrchr(argv[0], '/');
+  progname = (progname != NULL) ? (progname + 1) : argv[0];
+
+  for (i = 1; i < argc; i++) {
+    if (i + 1 >= argc) {
+      fprintf(stderr, USAGE, progname);
+      exit(1);
+    }
+    if (!strcmp(argv[i], "-n"))
+      num_rows = atol(argv[++i]);
+    else if (!strcmp(argv[i], "-b"))
+      num_b = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-d"))
+      num_d = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-c"))
+      num_c = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-k"))
+      num_vals = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-noise"))
+      noise = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-s"))
+      seed = strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "-rs")) {
+      rule_seed = strtoul(argv[++i], NULL, 10);
+      rule_seed_set = 1;
+    }
+    else if (!strcmp(argv[i], "-o"))
+      out_filename = argv[++i];
+    else if (!strcmp(argv[i], "-rule")) {
+      i++;
+      if (!strcmp(argv[i], "linear"))
+	rule = RULE_LINEAR;
+      else if (!strcmp(argv[i], "conj"))
+	rule = RULE_CONJ;
+      else if (!strcmp(argv[i], "xor"))
+	rule = RULE_XOR;
+      else
+	rule = -1;
+    } else
+      rule = -1;
+  }
+  if (rule < 0 || num_rows < 0 || num_b < 0 || num_d < 0 || num_c < 0 ||
+      num_vals < 2 || noise < 0.0 || noise > 1.0 ||
+      num_b + num_d + num_c == 0) {
+    fprintf(stderr, USAGE, progname);
+    exit(1);
+  }
+
+  if (out_filename == NULL)
+    out = stdout;
+  else if ((out = fopen(out_filename, "w")) == NULL)
+    SYS_ERROR1("fopen(\"%s\", \"w\")", out_filename);
+
+  /* The weights come from -rs if given, so that files of different rows
+     (-s) can share the same concept, e.g. training and test sets; else
+     they are the first numbers drawn with -s. */
+  rng_state = rule_seed_set ? rule_seed : seed;
+  num_features = 1 + num_b + num_d + num_c;
+  b = (int *) getmem((num_b + 1) * sizeof(int));
+  d = (int *) getmem((num_d + 1) * sizeof(int));
+  c = (double *) getmem((num_c + 1) * sizeof(double));
+  weights = (double *) getmem(num_features * sizeof(double));
+  for (i = 0; i < num_features; i++)
+    weights[i] = 2.0 * NextUniform() - 1.0;
+  if (rule_seed_set)
+    rng_state = seed;
+
+  /* Header: sizes, attribute names and types. */
+  fprintf(out, "%d %ld\n", num_features, num_rows);
+  fprintf(out, "label");
+  for (i = 0; i < num_b; i++)
+    fprintf(out, " b%d", i + 1);
+  for (i = 0; i < num_d; i++)
+    fprintf(out, " d%d", i + 1);
+  for (i = 0; i < num_c; i++)
+    fprintf(out, " c%d", i + 1);
+  fprintf(out, "\nb");
+  for (i = 0; i < num_b; i++)
+    fputc('b', out);
+  for (i = 0; i < num_d; i++)
+    fputc('d', out);
+  for (i = 0; i < num_c; i++)
+    fputc('c', out);
+  fputc('\n', out);
+
+  for (row = 0; row < num_rows; row++) {
+    for (i = 0; i < num_b; i++)
+      b[i] = (NextUniform() < 0.5);
+    for (i = 0; i < num_d; i++)
+      d[i] = (int) (NextUniform() * num_vals);
+    for (i = 0; i < num_c; i++)
+      c[i] = NextUniform();
+
+    switch (rule) {
+    case RULE_LINEAR:
+      score = 0.0;
+      for (i = 0; i < num_b; i++)
+	score += weights[1 + i] * (b[i] - 0.5);
+      for (i = 0; i < num_d; i++)
+	score += weights[1 + num_b + i] * ((d[i] % 2) - 0.5);
+      for (i = 0; i < num_c; i++)
+	score += weights[1 + num_b + num_d + i] * (c[i] - 0.5);
+      label = (score > 0.0);
+      break;
+    case RULE_CONJ:
+      label = ((num_b == 0 || b[0]) && (num_c == 0 || c[0] > 0.5)) ||
+	(num_d > 0 && d[0] < num_vals / 3);
+      break;
+    default:  /* RULE_XOR */
+      label = 0;
+      for (i = 0; i < num_b && i < 2; i++)
+	label ^= b[i];
+      for (i = 0; i < num_c && num_b + i < 2; i++)
+	label ^= (c[i] > 0.5);
+      break;
+    }
+    if (NextUniform() < noise)
+      label = !label;
+
+    fprintf(out, "%d", label);
+    for (i = 0; i < num_b; i++)
+      fprintf(out, " %d", b[i]);
+    for (i = 0; i < num_d; i++)
+      fprintf(out, " v%d", d[i]);
+    for (i = 0; i < num_c; i++)
+      fprintf(out, " %.6f", c[i]);
+    fputc('\n', out);
+  }
+
+  if (out != stdout)
+    fclose(out);
+  freemem(b);
+  freemem(d);
+  freemem(c);
+  freemem(weights);
+  exit(0);
+}
+
+/**************************************************************************/
@@ -0,0 +1,728 @@
+/**************************************************************************
+ *
+ * grow.c
+ *
+ * Source file containing alternative strategies for growing a decision
+ * tree under a budget.  The best-first grower keeps the open leaves in a
+ * priority queue keyed by the gain of their best split and always expands
+ * the most promising one, until a leaf, depth, gain or time budget is
+ * exhausted.  The level-wise grower decides the splits of all nodes of a
+ * depth together, with one pass over each column per level.
+ *
+ **************************************************************************/
+
+#include <sys/time.h>
+#include <string.h>
+#include "grow.h"
+#include "dt.h"
+#include "entropy.h"
+#include "bitarray.h"
+#include "ssv.h"
+#include "profile.h"
+
+/* A leaf that may still be expanded. */
+typedef struct openleaf {
+  DTNODE *node;
+  MEMBERSET *members;           /* Training examples reaching the leaf. */
+  long num_members;
+  int depth;                    /* Number of tests above the leaf. */
+  int order;                    /* Creation order, breaks ties in gain. */
+  SPLIT split;                  /* Best split of the leaf's examples. */
+} OPENLEAF;
+
+/* A node of the level being grown. */
+typedef struct levelnode {
+  DTNODE *node;
+  long num_pos;
+  long num_neg;
+  int evaluate;                 /* Whether the node may be split. */
+  double entropy;               /* Entropy of the node's examples. */
+  SPLIT split;                  /* Best split found so far. */
+  int num_nonempty;             /* Branches of that split with examples. */
+  int first_child;              /* Index of its first child in the next
+				   level. */
+} LEVELNODE;
+
+/* A training example, for sorting by a continuous attribute. */
+typedef struct sortedval {
+  double val;
+  long example;
+} SORTEDVAL;
+
+/* Max-heap of open leaves. */
+typedef struct leafheap {
+  OPENLEAF **leaves;
+  int num_leaves;
+  int max_leaves;
+} LEAFHEAP;
+
+/* ----------------------------------------------------------------------
+
+   Priority of open leaves: higher gain first, then older leaves first (so
+   that equal gains are expanded in a fixed order).
+
+   ---------------------------------------------------------------------- */
+
+static int LeafBefore(OPENLEAF *a, OPENLEAF *b)
+{
+  if (a->split.gain != b->split.gain)
+    return a->split.gain > b->split.gain;
+  return a->order < b->order;
+}
+
+static void HeapPush(LEAFHEAP *heap, OPENLEAF *leaf)
+{
+  int pos, parent;
+
+  if (heap->num_leaves == heap->max_leaves) {
+    heap->max_leaves = 2 * heap->max_leaves + 16;
+    heap->leaves = (OPENLEAF **)
+      regetmem(heap->leaves, heap->max_leaves * sizeof(OPENLEAF *));
+  }
+  pos = heap->num_leaves++;
+  while (pos > 0) {
+    parent = (pos - 1) / 2;
+    if (!LeafBefore(leaf, heap->leaves[parent]))
+      break;
+    heap->leaves[pos] = heap->leaves[parent];
+    pos = parent;
+  }
+  heap->leaves[pos] = leaf;
+}
+
+static OPENLEAF *HeapPop(LEAFHEAP *heap)
+{
+  OPENLEAF *top, *last;
+  int pos, child;
+
+  if (heap->num_leaves == 0)
+    return (OPENLEAF *) NULL;
+  top = heap->leaves[0];
+  last = heap->leaves[--heap->num_leaves];
+  pos = 0;
+  while ((child = 2 * pos + 1) < heap->num_leaves) {
+    if (child + 1 < heap->num_leaves &&
+	LeafBefore(heap->leaves[child + 1], heap->leaves[child]))
+      child++;
+    if (!LeafBefore(heap->leaves[child], last))
+      break;
+    heap->leaves[pos] = heap->leaves[child];
+    pos = child;
+  }
+  if (heap->num_leaves > 0)
+    heap->leaves[pos] = last;
+
+  return top;
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the number of seconds elapsed since "start".
+
+   ---------------------------------------------------------------------- */
+
+static double ElapsedSeconds(struct timeval *start)
+{
+  struct timeval now;
+
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec) / 1e6;
+}
+
+/* ----------------------------------------------------------------------
+
+   Create a leaf node for a set of examples and, if the budgets allow it to
+   be split later, queue it with its best split.  Takes ownership of the
+   "members" set.
+
+   ---------------------------------------------------------------------- */
+
+static DTNODE *OpenLeaf(void **data, long num_data, int num_features,
+			MEMBERSET *members, long num_members, int depth,
+			LEAFHEAP *heap, int *order, SSVINFO *ssvinfo)
+{
+  DTNODE *node;
+  OPENLEAF *leaf;
+
+  node = NewDecisionTreeNode();
+  node->num_members = num_members;
+  CountExamples(data, num_data, members, num_members,
+		&(node->num_pos), &(node->num_neg));
+
+  if (num_members <= MIN_LEAF_MEMBERS ||
+      (ssvinfo->max_depth > 0 && depth >= ssvinfo->max_depth)) {
+    FreeMemberSet(members);
+    return node;
+  }
+
+  leaf = (OPENLEAF *) getmem_tag(sizeof(OPENLEAF), MEM_SPLIT);
+  FindBestSplit(data, num_data, num_features, members, num_members,
+		&(leaf->split), ssvinfo);
+  if (leaf->split.attr == -1 || leaf->split.gain <= ssvinfo->min_gain) {
+    FreeMemberSet(members);
+    freemem(leaf->split.subset);
+    freemem(leaf);
+    return node;
+  }
+  leaf->node = node;
+  leaf->members = members;
+  leaf->num_members = num_members;
+  leaf->depth = depth;
+  leaf->order = (*order)++;
+  HeapPush(heap, leaf);
+
+  return node;
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the branch an example takes under the split of an open leaf.
+
+   ---------------------------------------------------------------------- */
+
+static int SplitBranch(void **data, long example, SPLIT *split,
+		       SSVINFO *ssvinfo)
+{
+  switch (ssvinfo->types[split->attr]) {
+  case 'b':
+    return READ_ATTRIB_B(data, example, split->attr);
+  case 'd':
+    if (split->subset != NULL)
+      return READ_BITARRAY(split->subset,
+			   READ_ATTRIB_I(data, example, split->attr));
+    return READ_ATTRIB_I(data, example, split->attr);
+  case 'c':
+    return (READ_ATTRIB_C(data, example, split->attr) >= split->threshold);
+  default:
+    USER_ERROR1("type unknown ('%c')", ssvinfo->types[split->attr]);
+  }
+  return 0;
+}
+
+/* ----------------------------------------------------------------------
+
+   Create a decision tree by repeatedly expanding the open leaf whose best
+   split has the highest gain.  Growth stops when no leaf is worth
+   expanding or when one of the budgets in "ssvinfo" runs out: the number
+   of leaves (max_leaves), the depth (max_depth), the gain of a split
+   (min_gain) or the wall-clock time (time_limit, in seconds).  Budgets
+   that are 0 are not enforced.  Without budgets the tree is the same as
+   the one grown depth-first.
+
+   ---------------------------------------------------------------------- */
+
+DTNODE *CreateDecisionTreeBestFirst(void **data, long num_data,
+				    MEMBERSET *train_members, long num_train,
+				    int num_features, SSVINFO *ssvinfo)
+{
+  DTNODE *root, *node;
+  LEAFHEAP heap;
+  OPENLEAF *leaf;
+  MEMBERSET **child_members;
+  MEMBERITER iter;
+  long (*counts)[2];
+  int *branch_child;
+  long example;
+  int val, i, num_branches, num_nonempty, num_leaves, order;
+  struct timeval start;
+
+  if (num_train == 0)
+    return (DTNODE *) NULL;
+
+  gettimeofday(&start, NULL);
+  heap.max_leaves = 16;
+  heap.leaves = (OPENLEAF **)
+    getmem_tag(heap.max_leaves * sizeof(OPENLEAF *), MEM_SPLIT);
+  heap.num_leaves = 0;
+  order = 0;
+
+  root = OpenLeaf(data, num_data, num_features,
+		  CopyMemberSet(train_members, MEM_SPLIT), num_train, 0,
+		  &heap, &order, ssvinfo);
+  num_leaves = 1;
+
+  while ((leaf = HeapPop(&heap)) != NULL) {
+    if (ssvinfo->time_limit > 0.0 &&
+	ElapsedSeconds(&start) >= ssvinfo->time_limit) {
+      FreeMemberSet(leaf->members);
+      freemem(leaf->split.subset);
+      freemem(leaf);
+      break;
+    }
+
+    /* Count the leaf's examples on every branch of its split. */
+    node = leaf->node;
+    num_branches = (ssvinfo->types[leaf->split.attr] == 'd' &&
+		    leaf->split.subset == NULL) ?
+      ssvinfo->num_discrete_vals[leaf->split.attr] : 2;
+    counts = (long (*)[2])
+      getmem_tag(num_branches * sizeof(*counts), MEM_SPLIT);
+    memset(counts, 0, num_branches * sizeof(*counts));
+    PROFILE_COUNT(rows_scanned, leaf->num_members);
+    FOR_EACH_MEMBER(iter, leaf->members, example)
+      counts[SplitBranch(data, example, &(leaf->split), ssvinfo)]
+	[READ_ATTRIB_B(data, example, 0)]++;
+    num_nonempty = 0;
+    for (val = 0; val < num_branches; val++)
+      if (counts[val][0] + counts[val][1] > 0)
+	num_nonempty++;
+
+    /* Expand the leaf unless the split would exceed the leaf budget.  Only
+       the branches with examples get a child. */
+    if (num_nonempty >= 2 &&
+	(ssvinfo->max_leaves == 0 ||
+	 num_leaves - 1 + num_nonempty <= ssvinfo->max_leaves)) {
+      PrintSelectedAttribute(&(leaf->split), ssvinfo);
+      node->test_attrib = leaf->split.attr;
+      node->threshold = leaf->split.threshold;
+      if (leaf->split.subset != NULL) {
+	SetSubsetChildren(node, leaf->split.subset,
+			  ssvinfo->num_discrete_vals[leaf->split.attr]);
+      } else if (ssvinfo->types[leaf->split.attr] == 'd') {
+	SetDiscreteChildren(node, counts, num_branches);
+      } else {
+	node->num_children = 2;
+	node->children = (DTNODE **) getmem_tag(2 * sizeof(DTNODE *), MEM_TREE);
+      }
+      branch_child = (int *) getmem_tag(num_branches * sizeof(int), MEM_SPLIT);
+      child_members = (MEMBERSET **)
+	getmem_tag(num_nonempty * sizeof(MEMBERSET *), MEM_SPLIT);
+      for (val = i = 0; val < num_branches; val++) {
+	branch_child[val] = -1;
+	if (counts[val][0] + counts[val][1] > 0) {
+	  branch_child[val] = i;
+	  child_members[i++] = NewMemberSet(MEM_SPLIT);
+	}
+      }
+      PROFILE_COUNT(rows_scanned, leaf->num_members);
+      FOR_EACH_MEMBER(iter, leaf->members, example) {
+	val = SplitBranch(data, example, &(leaf->split), ssvinfo);
+	AddMember(child_members[branch_child[val]], example);
+      }
+      for (val = 0; val < num_branches; val++) {
+	if ((i = branch_child[val]) >= 0)
+	  node->children[i] =
+	    OpenLeaf(data, num_data, num_features, child_members[i],
+		     counts[val][0] + counts[val][1], leaf->depth + 1,
+		     &heap, &order, ssvinfo);
+      }
+      num_leaves += num_nonempty - 1;
+      freemem(branch_child);
+      freemem(child_members);
+    }
+
+    freemem(counts);
+    FreeMemberSet(leaf->members);
+    freemem(leaf->split.subset);
+    freemem(leaf);
+  }
+
+  /* Whatever is left in the queue stays a leaf. */
+  while ((leaf = HeapPop(&heap)) != NULL) {
+    FreeMemberSet(leaf->members);
+    freemem(leaf->split.subset);
+    freemem(leaf);
+  }
+  freemem(heap.leaves);
+
+  return root;
+}
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary function used by qsort to sort training examples by value
+   (and by position, for a fixed order among equal values).
+
+   ---------------------------------------------------------------------- */
+
+static int comp_sortedvals(const void *a, const void *b)
+{
+  SORTEDVAL *x = (SORTEDVAL *) a, *y = (SORTEDVAL *) b;
+
+  if (x->val != y->val)
+    return (x->val < y->val) ? -1 : 1;
+  return (x->example == y->example) ? 0 :
+    ((x->example < y->example) ? -1 : 1);
+}
+
+/* ----------------------------------------------------------------------
+
+   Create a leaf node with the given class counts.
+
+   ---------------------------------------------------------------------- */
+
+static DTNODE *CountedLeaf(long num_pos, long num_neg)
+{
+  DTNODE *node;
+
+  node = NewDecisionTreeNode();
+  node->num_pos = num_pos;
+  node->num_neg = num_neg;
+  node->num_members = num_pos + num_neg;
+
+  return node;
+}
+
+/* ----------------------------------------------------------------------
+
+   Find the best split of every open node of a level for the binary or
+   discrete attribute "attr", by filling the nodes' count tables in a
+   single pass over the column.
+
+   ---------------------------------------------------------------------- */
+
+static void LevelSplitsDiscrete(void **data, long num_data, int *node_of,
+				LEVELNODE *level, int num_open, int attr,
+				long (*counts)[2], SSVINFO *ssvinfo)
+{
+  long example, n;
+  int val, num_vals, num_nonempty, two_way;
+  long (*node_counts)[2];
+  uchar *subset;
+  double gain;
+
+  num_vals = (ssvinfo->types[attr] == 'b') ? 2 :
+    ssvinfo->num_discrete_vals[attr];
+  memset(counts, 0, (size_t) num_open * num_vals * sizeof(*counts));
+  PROFILE_COUNT(rows_scanned, num_data);
+
+  if (ssvinfo->types[attr] == 'b') {
+    for (example = 0; example < num_data; example++)
+      if ((n = node_of[example]) >= 0 && level[n].evaluate)
+	counts[n * 2 + READ_ATTRIB_B(data, example, attr)]
+	  [READ_ATTRIB_B(data, example, 0)]++;
+  } else {
+    /* One loop per width of the codes. */
+#define COUNT_CODES(code_type) {					\
+      code_type *codes = (code_type *) data[attr];			\
+      for (example = 0; example < num_data; example++)			\
+	if ((n = node_of[example]) >= 0 && level[n].evaluate)		\
+	  counts[(size_t) n * num_vals + codes[example]]		\
+	    [READ_ATTRIB_B(data, example, 0)]++;			\
+    }
+    switch (COLUMN_WIDTH(data[attr])) {
+    case 1:
+      COUNT_CODES(unsigned char);
+      break;
+    case 2:
+      COUNT_CODES(unsigned short);
+      break;
+    default:
+      COUNT_CODES(int);
+    }
+#undef COUNT_CODES
+  }
+
+  /* Discrete attributes split two ways get the best subset of values of
+     every node. */
+  two_way = (ssvinfo->types[attr] == 'd' && ssvinfo->subset_splits);
+  subset = two_way ? CREATE_BITARRAY_TAG(num_vals, MEM_SPLIT) : NULL;
+  for (n = 0; n < num_open; n++) {
+    if (!level[n].evaluate)
+      continue;
+    node_counts = counts + (size_t) n * num_vals;
+    if (two_way)
+      gain = level[n].entropy -
+	PartialEntropySubsetCounts(node_counts, num_vals,
+				   level[n].num_pos + level[n].num_neg,
+				   subset);
+    else
+      gain = level[n].entropy -
+	PartialEntropyCounts(node_counts, num_vals,
+			     level[n].num_pos + level[n].num_neg);
+    if (gain > level[n].split.gain) {
+      num_nonempty = 0;
+      for (val = 0; val < num_vals; val++)
+	if (node_counts[val][0] + node_counts[val][1] > 0)
+	  num_nonempty++;
+      level[n].split.gain = gain;
+      level[n].split.attr = attr;
+      level[n].num_nonempty = num_nonempty;
+      freemem(level[n].split.subset);
+      level[n].split.subset = (uchar *) NULL;
+      if (two_way) {
+	level[n].split.subset = subset;
+	subset = CREATE_BITARRAY_TAG(num_vals, MEM_SPLIT);
+      }
+    }
+  }
+  freemem(subset);
+}
+
+/* ----------------------------------------------------------------------
+
+   Find the best threshold of every open node of a level for the
+   continuous attribute "attr", in a single pass over the training
+   examples sorted by that attribute.  Candidate thresholds and their
+   partial entropies are the same as in PartialEntropyContinuous().
+
+   ---------------------------------------------------------------------- */
+
+static void LevelSplitsContinuous(void **data, int *node_of,
+				  LEVELNODE *level, int num_open, int attr,
+				  SORTEDVAL *sorted, long num_sorted,
+				  long (*left)[2], double *last_val,
+				  double *min_entropy, double *threshold)
+{
+  long i, num_members, num_smaller, num_larger;
+  int n, label;
+  double partial_entropy, gain;
+
+  PROFILE_COUNT(rows_scanned, num_sorted);
+  for (n = 0; n < num_open; n++) {
+    left[n][0] = left[n][1] = 0;
+    min_entropy[n] = HUGE_VAL;
+  }
+
+  for (i = 0; i < num_sorted; i++) {
+    if ((n = node_of[sorted[i].example]) < 0 || !level[n].evaluate)
+      continue;
+    num_smaller = left[n][0] + left[n][1];
+    if (num_smaller > 0 && sorted[i].val != last_val[n]) {
+      num_members = level[n].num_pos + level[n].num_neg;
+      num_larger = num_members - num_smaller;
+      partial_entropy =
+	(double) num_smaller / (double) num_members *
+	Entropy(left[n][0], left[n][1]) +
+	(double) num_larger / (double) num_members *
+	Entropy(level[n].num_neg - left[n][0], level[n].num_pos - left[n][1]);
+      if (partial_entropy < min_entropy[n]) {
+	min_entropy[n] = partial_entropy;
+	threshold[n] = (last_val[n] + sorted[i].val) / 2.0;
+      }
+    }
+    label = READ_ATTRIB_B(data, sorted[i].example, 0);
+    left[n][label]++;
+    last_val[n] = sorted[i].val;
+  }
+
+  for (n = 0; n < num_open; n++) {
+    if (!level[n].evaluate)
+      continue;
+    gain = level[n].entropy - min_entropy[n];
+    if (gain > level[n].split.gain) {
+      level[n].split.gain = gain;
+      level[n].split.threshold = threshold[n];
+      level[n].split.attr = attr;
+      freemem(level[n].split.subset);
+      level[n].split.subset = (uchar *) NULL;
+      level[n].num_nonempty = 2;
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Create a decision tree breadth-first.  All open nodes of a depth are
+   handled together: "node_of" maps every training example to its open
+   node, so one pass over each column fills the count tables (or, for
+   continuous attributes, scans the presorted values) of every node at
+   once, and one more pass routes the examples to the next level.  The
+   tree is the same as the one grown depth-first, limited to
+   ssvinfo->max_depth tests on a path if that is set.
+
+   ---------------------------------------------------------------------- */
+
+DTNODE *CreateDecisionTreeLevelWise(void **data, long num_data,
+				    MEMBERSET *train_members, long num_train,
+				    int num_features, SSVINFO *ssvinfo)
+{
+  DTNODE *root, *node;
+  LEVELNODE *level, *next;
+  SORTEDVAL **sorted;
+  int *node_of;
+  MEMBERITER iter;
+  long (*counts)[2], (*left)[2], (*branch_counts)[2];
+  int *branch_child;
+  double *last_val, *min_entropy, *threshold;
+  long example;
+  int attr, n, c, i, val, num_open, num_next, num_vals, max_vals;
+  long num_sorted;
+  int depth, any_evaluated, num_branches, num_children;
+
+  if (num_train == 0)
+    return (DTNODE *) NULL;
+
+  /* Map training examples to the root; sort them once by each continuous
+     attribute. */
+  node_of = (int *) getmem_tag(num_data * sizeof(int), MEM_SPLIT);
+  num_sorted = 0;
+  for (example = 0; example < num_data; example++)
+    node_of[example] = -1;
+  FOR_EACH_MEMBER(iter, train_members, example)
+    node_of[example] = 0;
+  sorted = (SORTEDVAL **) getmem_tag(num_features * sizeof(SORTEDVAL *), MEM_SPLIT);
+  max_vals = 2;
+  for (attr = 0; attr < num_features; attr++) {
+    sorted[attr] = (SORTEDVAL *) NULL;
+    if (attr == 0)
+      continue;
+    if (ssvinfo->types[attr] == 'd')
+      max_vals = MAX(max_vals, ssvinfo->num_discrete_vals[attr]);
+    if (ssvinfo->types[attr] != 'c')
+      continue;
+    sorted[attr] = (SORTEDVAL *) getmem_tag(num_train * sizeof(SORTEDVAL), MEM_SPLIT);
+    for (example = num_sorted = 0; example < num_data; example++) {
+      if (node_of[example] == 0) {
+	sorted[attr][num_sorted].val = READ_ATTRIB_C(data, example, attr);
+	sorted[attr][num_sorted++].example = example;
+      }
+    }
+    qsort(sorted[attr], num_sorted, sizeof(SORTEDVAL), comp_sortedvals);
+    PROFILE_COUNT(sorts, 1);
+  }
+
+  level = (LEVELNODE *) getmem_tag(sizeof(LEVELNODE), MEM_SPLIT);
+  CountExamples(data, num_data, train_members, num_train,
+		&(level[0].num_pos), &(level[0].num_neg));
+  root = level[0].node = CountedLeaf(level[0].num_pos, level[0].num_neg);
+  num_open = 1;
+
+  for (depth = 0; num_open > 0; depth++) {
+    /* Find the best split of every node that may be split. */
+    any_evaluated = 0;
+    for (n = 0; n < num_open; n++) {
+      level[n].evaluate = (level[n].node->num_members > MIN_LEAF_MEMBERS &&
+			   (ssvinfo->max_depth == 0 ||
+			    depth < ssvinfo->max_depth));
+      level[n].entropy = Entropy(level[n].num_pos, level[n].num_neg);
+      level[n].split.attr = -1;
+      level[n].split.gain = 0.0;
+      level[n].split.threshold = 0.0;
+      level[n].split.subset = (uchar *) NULL;
+      level[n].num_nonempty = 0;
+      any_evaluated |= level[n].evaluate;
+      PROFILE_COUNT(max_gain_calls, level[n].evaluate);
+      PROFILE_COUNT(attribs_evaluated, level[n].evaluate * (num_features - 1));
+    }
+    if (any_evaluated) {
+      PROFILE_BEGIN(PHASE_SPLIT);
+      counts = (long (*)[2])
+	getmem_tag((size_t) num_open * max_vals * sizeof(*counts), MEM_SPLIT);
+      left = (long (*)[2]) getmem_tag(num_open * sizeof(*left), MEM_SPLIT);
+      last_val = (double *) getmem_tag(num_open * sizeof(double), MEM_SPLIT);
+      min_entropy = (double *) getmem_tag(num_open * sizeof(double), MEM_SPLIT);
+      threshold = (double *) getmem_tag(num_open * sizeof(double), MEM_SPLIT);
+      for (attr = 1; attr < num_features; attr++) {
+	switch (ssvinfo->types[attr]) {
+	case 'b':
+	case 'd':
+	  LevelSplitsDiscrete(data, num_data, node_of, level, num_open,
+			      attr, counts, ssvinfo);
+	  break;
+	case 'c':
+	  LevelSplitsContinuous(data, node_of, level, num_open, attr,
+				sorted[attr], num_sorted, left, last_val,
+				min_entropy, threshold);
+	  break;
+	default:
+	  USER_ERROR1("Unknown attribute type '%c'", ssvinfo->types[attr]);
+	}
+      }
+      freemem(counts);
+      freemem(left);
+      freemem(last_val);
+      freemem(min_entropy);
+      freemem(threshold);
+      PROFILE_END(PHASE_SPLIT);
+    }
+
+    /* Turn the nodes with a useful split into internal nodes. */
+    num_next = 0;
+    for (n = 0; n < num_open; n++) {
+      if (level[n].split.attr == -1 || level[n].num_nonempty < 2) {
+	level[n].split.attr = -1;
+	continue;
+      }
+      PrintSelectedAttribute(&(level[n].split), ssvinfo);
+      node = level[n].node;
+      num_branches = (ssvinfo->types[level[n].split.attr] == 'd' &&
+		      level[n].split.subset == NULL) ?
+	ssvinfo->num_discrete_vals[level[n].split.attr] : 2;
+      node->test_attrib = level[n].split.attr;
+      node->threshold = level[n].split.threshold;
+      level[n].first_child = num_next;
+      num_next += num_branches;
+    }
+
+    /* Route the examples of the split nodes to their branches. */
+    branch_counts = (long (*)[2])
+      getmem_tag((num_next + 1) * sizeof(*branch_counts), MEM_SPLIT);
+    memset(branch_counts, 0, (num_next + 1) * sizeof(*branch_counts));
+    PROFILE_COUNT(rows_scanned, num_data);
+    for (example = 0; example < num_data; example++) {
+      if ((n = node_of[example]) < 0)
+	continue;
+      if (level[n].split.attr == -1) {
+	node_of[example] = -1;
+	continue;
+      }
+      c = level[n].first_child +
+	SplitBranch(data, example, &(level[n].split), ssvinfo);
+      node_of[example] = c;
+      branch_counts[c][READ_ATTRIB_B(data, example, 0)]++;
+    }
+
+    /* Only the branches with examples get a child, which becomes a node
+       of the next level. */
+    branch_child = (int *) getmem_tag((num_next + 1) * sizeof(int), MEM_SPLIT);
+    num_children = 0;
+    for (c = 0; c < num_next; c++) {
+      branch_child[c] = -1;
+      if (branch_counts[c][0] + branch_counts[c][1] > 0)
+	branch_child[c] = num_children++;
+    }
+    next = (LEVELNODE *) getmem_tag((num_children + 1) * sizeof(LEVELNODE), MEM_SPLIT);
+    for (n = 0; n < num_open; n++) {
+      if (level[n].split.attr == -1)
+	continue;
+      node = level[n].node;
+      if (level[n].split.subset != NULL) {
+	num_vals = 2;
+	SetSubsetChildren(node, level[n].split.subset,
+			  ssvinfo->num_discrete_vals[node->test_attrib]);
+      } else if (ssvinfo->types[node->test_attrib] == 'd') {
+	num_vals = ssvinfo->num_discrete_vals[node->test_attrib];
+	SetDiscreteChildren(node, branch_counts + level[n].first_child,
+			    num_vals);
+      } else {
+	num_vals = 2;
+	node->num_children = 2;
+	node->children = (DTNODE **) getmem_tag(2 * sizeof(DTNODE *), MEM_TREE);
+      }
+      for (val = i = 0; val < num_vals; val++) {
+	c = level[n].first_child + val;
+	if (branch_child[c] < 0)
+	  continue;
+	next[branch_child[c]].num_pos = branch_counts[c][1];
+	next[branch_child[c]].num_neg = branch_counts[c][0];
+	next[branch_child[c]].node = node->children[i++] =
+	  CountedLeaf(branch_counts[c][1], branch_counts[c][0]);
+      }
+    }
+    PROFILE_COUNT(rows_scanned, num_data);
+    for (example = 0; example < num_data; example++)
+      if (node_of[example] >= 0)
+	node_of[example] = branch_child[node_of[example]];
+    freemem(branch_counts);
+    freemem(branch_child);
+    for (n = 0; n < num_open; n++)
+      freemem(level[n].split.subset);
+    num_next = num_children;
+
+    freemem(level);
+    level = next;
+    num_open = num_next;
+  }
+
+  freemem(level);
+  for (attr = 0; attr < num_features; attr++)
+    if (sorted[attr] != NULL)
+      freemem(sorted[attr]);
+  freemem(sorted);
+  freemem(node_of);
+
+  return root;
+}
+
+/**************************************************************************/
@@ -0,0 +1,30 @@
+/**************************************************************************
+ *
+ * grow.h
+ *
+ * Header file to grow.c
+ *
+ **************************************************************************/
+
+#ifndef GROW_H
+#define GROW_H 1
+
+#include "dt.h"
+#include "ssv.h"
+#include "bitarray.h"
+
+/* Ways of growing a decision tree (ssvinfo->grow_mode). */
+#define GROW_DEPTH_FIRST 0      /* Recursively, see CreateDecisionTreeAux(). */
+#define GROW_BEST_FIRST  1      /* Highest-gain open leaf first. */
+#define GROW_LEVEL_WISE  2      /* All nodes of a depth at once. */
+
+/* Function prototypes. */
+DTNODE *CreateDecisionTreeBestFirst(void **data, long num_data,
+				    MEMBERSET *train_members, long num_train,
+				    int num_features, SSVINFO *ssvinfo);
+DTNODE *CreateDecisionTreeLevelWise(void **data, long num_data,
+				    MEMBERSET *train_members, long num_train,
+				    int num_features, SSVINFO *ssvinfo);
+
+#endif // GROW_H
+/**************************************************************************/
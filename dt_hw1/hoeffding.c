@@ -0,0 +1,549 @@
+/**************************************************************************
+ *
+ * hoeffding.c
+ *
+ * Source file containing routines related to growing a decision tree from
+ * a stream of examples (a Hoeffding tree).  Every leaf keeps the count
+ * tables of its examples instead of the examples themselves, and is split
+ * once the Hoeffding bound shows, with high confidence, that its best
+ * attribute beats the runner-up.  Memory thus depends on the size of the
+ * tree and not on the length of the stream, and the tree can classify
+ * examples at any point of the stream.
+ *
+ **************************************************************************/
+
+#include <string.h>
+#include <math.h>
+#include "auxi.h"
+#include "dt.h"
+#include "hoeffding.h"
+#include "prune-dt.h"
+#include "ssv.h"
+#include "bitarray.h"
+#include "profile.h"
+
+/* ----------------------------------------------------------------------
+
+   Entropy of a two-class distribution given by (possibly estimated,
+   fractional) counts.  Unlike Entropy(), a pure distribution has entropy
+   0, since leaves of a stream are split while some of their branches are
+   still pure.
+
+   ---------------------------------------------------------------------- */
+
+static double CountsEntropy(double num_pos, double num_neg)
+{
+  double n = num_pos + num_neg, entropy = 0.0;
+
+  if (num_pos > 0.0)
+    entropy -= num_pos / n * log2(num_pos / n);
+  if (num_neg > 0.0)
+    entropy -= num_neg / n * log2(num_neg / n);
+
+  return entropy;
+}
+
+/* ----------------------------------------------------------------------
+
+   Allocate the (empty) statistics of a new leaf at depth "depth".
+
+   ---------------------------------------------------------------------- */
+
+static STREAMLEAF *NewStreamLeaf(int depth, int num_features,
+				 SSVINFO *ssvinfo)
+{
+  STREAMLEAF *leaf;
+  int attr;
+
+  leaf = (STREAMLEAF *) getmem_tag(sizeof(STREAMLEAF), MEM_SPLIT);
+  leaf->depth = depth;
+  leaf->num_pos = leaf->num_neg = leaf->num_unchecked = 0;
+  leaf->num_vals = (int *) getmem_tag(num_features * sizeof(int), MEM_SPLIT);
+  leaf->counts = (long (**)[2])
+    getmem_tag(num_features * sizeof(*leaf->counts), MEM_SPLIT);
+  leaf->gauss = (GAUSSSTATS (*)[2])
+    getmem_tag(num_features * sizeof(*leaf->gauss), MEM_SPLIT);
+  memset(leaf->gauss, 0, num_features * sizeof(*leaf->gauss));
+  leaf->min_val = (double *) getmem_tag(num_features * sizeof(double), MEM_SPLIT);
+  leaf->max_val = (double *) getmem_tag(num_features * sizeof(double), MEM_SPLIT);
+
+  for (attr = 0; attr < num_features; attr++) {
+    leaf->num_vals[attr] = 0;
+    leaf->counts[attr] = NULL;
+    leaf->min_val[attr] = HUGE_VAL;
+    leaf->max_val[attr] = -HUGE_VAL;
+    if (attr == 0)
+      continue;
+    switch (ssvinfo->types[attr]) {
+    case 'b':
+      leaf->num_vals[attr] = 2;
+      break;
+    case 'd':
+      leaf->num_vals[attr] = ssvinfo->num_discrete_vals[attr];
+      break;
+    default:
+      continue;
+    }
+    leaf->counts[attr] = (long (*)[2])
+      getmem_tag((leaf->num_vals[attr] + 1) * sizeof(*leaf->counts[attr]),
+		 MEM_SPLIT);
+    memset(leaf->counts[attr], 0,
+	   (leaf->num_vals[attr] + 1) * sizeof(*leaf->counts[attr]));
+  }
+
+  return leaf;
+}
+
+/* ----------------------------------------------------------------------
+
+   Free the statistics of a leaf.
+
+   ---------------------------------------------------------------------- */
+
+static void FreeStreamLeaf(STREAMLEAF *leaf, int num_features)
+{
+  int attr;
+
+  for (attr = 0; attr < num_features; attr++)
+    freemem(leaf->counts[attr]);
+  freemem(leaf->counts);
+  freemem(leaf->num_vals);
+  freemem(leaf->gauss);
+  freemem(leaf->min_val);
+  freemem(leaf->max_val);
+  freemem(leaf);
+}
+
+/* ----------------------------------------------------------------------
+
+   Free the statistics of all the leaves of a tree, which stays usable as
+   an ordinary decision tree.
+
+   ---------------------------------------------------------------------- */
+
+static void FreeStreamLeaves(DTNODE *node, int num_features)
+{
+  int i;
+
+  if (node == NULL)
+    return;
+  if (node->stream_leaf != NULL) {
+    FreeStreamLeaf((STREAMLEAF *) node->stream_leaf, num_features);
+    node->stream_leaf = NULL;
+  }
+  for (i = 0; i < node->num_children; i++)
+    FreeStreamLeaves(node->children[i], num_features);
+}
+
+/* ----------------------------------------------------------------------
+
+   Add the example "row" (a data set of one example) to the statistics of
+   a leaf.  The count table of a discrete attribute grows with the values
+   of the attribute seen so far.
+
+   ---------------------------------------------------------------------- */
+
+static void UpdateStreamLeaf(STREAMLEAF *leaf, void **row, int num_features,
+			     SSVINFO *ssvinfo)
+{
+  int attr, val, label, num_vals;
+  double x, delta;
+  GAUSSSTATS *g;
+
+  label = READ_ATTRIB_B(row, 0, 0);
+  if (label)
+    leaf->num_pos++;
+  else
+    leaf->num_neg++;
+
+  for (attr = 1; attr < num_features; attr++) {
+    switch (ssvinfo->types[attr]) {
+    case 'b':
+      leaf->counts[attr][READ_ATTRIB_B(row, 0, attr)][label]++;
+      break;
+    case 'd':
+      val = READ_ATTRIB_I(row, 0, attr);
+      if (val >= leaf->num_vals[attr]) {
+	num_vals = ssvinfo->num_discrete_vals[attr];
+	leaf->counts[attr] = (long (*)[2])
+	  regetmem(leaf->counts[attr],
+		   (num_vals + 1) * sizeof(*leaf->counts[attr]));
+	memset(leaf->counts[attr] + leaf->num_vals[attr], 0,
+	       (num_vals + 1 - leaf->num_vals[attr]) *
+	       sizeof(*leaf->counts[attr]));
+	leaf->num_vals[attr] = num_vals;
+      }
+      leaf->counts[attr][val][label]++;
+      break;
+    case 'c':
+      /* Welford's running mean and variance. */
+      x = READ_ATTRIB_C(row, 0, attr);
+      g = &(leaf->gauss[attr][label]);
+      g->n += 1.0;
+      delta = x - g->mean;
+      g->mean += delta / g->n;
+      g->m2 += delta * (x - g->mean);
+      if (x < leaf->min_val[attr])
+	leaf->min_val[attr] = x;
+      if (x > leaf->max_val[attr])
+	leaf->max_val[attr] = x;
+      break;
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Estimate the number of examples of one class of a leaf whose value of
+   a continuous attribute is below "threshold", assuming the values are
+   normally distributed.
+
+   ---------------------------------------------------------------------- */
+
+static double GaussBelow(GAUSSSTATS *g, double threshold)
+{
+  double sd;
+
+  if (g->n == 0.0)
+    return 0.0;
+  sd = sqrt(g->m2 / g->n);
+  if (sd == 0.0)
+    return (g->mean < threshold) ? g->n : 0.0;
+  return g->n * 0.5 * erfc((g->mean - threshold) / (sd * M_SQRT2));
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the smallest partial entropy of a leaf's continuous attribute
+   "attr" over HOEFFDING_NUM_CUTS thresholds evenly spaced in the range of
+   the attribute, and that threshold; HUGE_VAL if the range is empty.
+
+   ---------------------------------------------------------------------- */
+
+static double StreamEntropyContinuous(STREAMLEAF *leaf, int attr,
+				      double *best_threshold)
+{
+  double threshold, below[2], above[2], partial_entropy;
+  double min_partial_entropy = HUGE_VAL;
+  double n = leaf->num_pos + leaf->num_neg;
+  int i, label;
+
+  if (leaf->min_val[attr] >= leaf->max_val[attr])
+    return HUGE_VAL;
+  for (i = 1; i <= HOEFFDING_NUM_CUTS; i++) {
+    threshold = leaf->min_val[attr] +
+      (leaf->max_val[attr] - leaf->min_val[attr]) * i /
+      (HOEFFDING_NUM_CUTS + 1);
+    for (label = 0; label <= 1; label++) {
+      below[label] = GaussBelow(&(leaf->gauss[attr][label]), threshold);
+      above[label] = leaf->gauss[attr][label].n - below[label];
+    }
+    partial_entropy =
+      ((below[0] + below[1]) * CountsEntropy(below[1], below[0]) +
+       (above[0] + above[1]) * CountsEntropy(above[1], above[0])) / n;
+    if (partial_entropy < min_partial_entropy) {
+      min_partial_entropy = partial_entropy;
+      *best_threshold = threshold;
+    }
+  }
+
+  return min_partial_entropy;
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the partial entropy of a leaf's binary or discrete attribute
+   "attr", and its number of values with examples.
+
+   ---------------------------------------------------------------------- */
+
+static double StreamEntropyDiscrete(STREAMLEAF *leaf, int attr,
+				    int *num_nonempty)
+{
+  long num_split;
+  int val;
+  double partial_entropy = 0.0;
+
+  *num_nonempty = 0;
+  for (val = 0; val < leaf->num_vals[attr]; val++) {
+    num_split = leaf->counts[attr][val][0] + leaf->counts[attr][val][1];
+    if (num_split == 0)
+      continue;
+    (*num_nonempty)++;
+    partial_entropy += num_split *
+      CountsEntropy(leaf->counts[attr][val][1], leaf->counts[attr][val][0]);
+  }
+
+  return partial_entropy / (leaf->num_pos + leaf->num_neg);
+}
+
+/* ----------------------------------------------------------------------
+
+   Create a child of a leaf being split, which predicts from the
+   examples its parent saw on its branch until it sees its own.
+
+   ---------------------------------------------------------------------- */
+
+static DTNODE *NewStreamChild(long num_pos, long num_neg, int depth,
+			      int num_features, SSVINFO *ssvinfo)
+{
+  DTNODE *node;
+
+  node = NewDecisionTreeNode();
+  node->num_pos = num_pos;
+  node->num_neg = num_neg;
+  node->num_members = num_pos + num_neg;
+  node->stream_leaf = NewStreamLeaf(depth, num_features, ssvinfo);
+
+  return node;
+}
+
+/* ----------------------------------------------------------------------
+
+   Split a leaf on attribute "attr" (at "threshold" if continuous), and
+   drop its statistics.
+
+   ---------------------------------------------------------------------- */
+
+static void SplitStreamLeaf(DTNODE *node, int attr, double threshold,
+			    int num_features, SSVINFO *ssvinfo)
+{
+  STREAMLEAF *leaf = (STREAMLEAF *) node->stream_leaf;
+  long num_pos, num_neg, counts[2][2];
+  int i, val, label;
+
+  node->test_attrib = attr;
+  switch (ssvinfo->types[attr]) {
+  case 'b':
+    node->num_children = 2;
+    node->children = (DTNODE **) getmem_tag(2 * sizeof(DTNODE *), MEM_TREE);
+    for (val = 0; val <= 1; val++)
+      node->children[val] =
+	NewStreamChild(leaf->counts[attr][val][1], leaf->counts[attr][val][0],
+		       leaf->depth + 1, num_features, ssvinfo);
+    break;
+  case 'd':
+    /* SetDiscreteChildren() counts the leaf's examples only, while the
+       node's counts cover all those that reached it. */
+    num_pos = node->num_pos;
+    num_neg = node->num_neg;
+    SetDiscreteChildren(node, leaf->counts[attr], leaf->num_vals[attr]);
+    node->num_pos = num_pos;
+    node->num_neg = num_neg;
+    for (i = 0; i < node->num_children; i++) {
+      val = node->child_vals[i];
+      node->children[i] =
+	NewStreamChild(leaf->counts[attr][val][1], leaf->counts[attr][val][0],
+		       leaf->depth + 1, num_features, ssvinfo);
+    }
+    break;
+  case 'c':
+    node->threshold = threshold;
+    for (label = 0; label <= 1; label++) {
+      counts[0][label] =
+	lrint(GaussBelow(&(leaf->gauss[attr][label]), threshold));
+      counts[1][label] = (long) leaf->gauss[attr][label].n - counts[0][label];
+    }
+    node->num_children = 2;
+    node->children = (DTNODE **) getmem_tag(2 * sizeof(DTNODE *), MEM_TREE);
+    for (i = 0; i <= 1; i++)
+      node->children[i] =
+	NewStreamChild(counts[i][1], counts[i][0], leaf->depth + 1,
+		       num_features, ssvinfo);
+    break;
+  }
+
+  FreeStreamLeaf(leaf, num_features);
+  node->stream_leaf = NULL;
+}
+
+/* ----------------------------------------------------------------------
+
+   Split a leaf if the Hoeffding bound allows it: with n examples seen,
+   the observed gain of the best attribute is within
+
+     epsilon = sqrt(ln(1/delta) / 2n)
+
+   of its true gain with probability 1 - delta (the range of the entropy
+   of a binary target is 1).  The leaf is split if the best attribute
+   beats both the runner-up and not splitting by more than epsilon, or if
+   epsilon has dropped below the tie threshold.  Returns the number of
+   leaves added.
+
+   ---------------------------------------------------------------------- */
+
+static int TrySplitStreamLeaf(DTNODE *node, int num_leaves, int num_features,
+			      SSVINFO *ssvinfo)
+{
+  STREAMLEAF *leaf = (STREAMLEAF *) node->stream_leaf;
+  int attr, best_attr, num_nonempty, best_nonempty, num_children;
+  double n, entropy, gain, best_gain, second_gain, epsilon;
+  double threshold, best_threshold;
+
+  if (leaf->num_pos == 0 || leaf->num_neg == 0 ||
+      (ssvinfo->max_depth > 0 && leaf->depth >= ssvinfo->max_depth))
+    return 0;
+
+  PROFILE_BEGIN(PHASE_SPLIT);
+  PROFILE_COUNT(max_gain_calls, 1);
+  PROFILE_COUNT(attribs_evaluated, num_features - 1);
+  n = leaf->num_pos + leaf->num_neg;
+  entropy = CountsEntropy(leaf->num_pos, leaf->num_neg);
+  best_attr = -1;
+  best_gain = second_gain = 0.0;   /* Not splitting gains nothing. */
+  best_threshold = 0.0;
+  best_nonempty = 0;
+  for (attr = 1; attr < num_features; attr++) {
+    threshold = 0.0;
+    num_nonempty = 2;
+    if (ssvinfo->types[attr] == 'c') {
+      gain = entropy - StreamEntropyContinuous(leaf, attr, &threshold);
+    } else {
+      gain = entropy - StreamEntropyDiscrete(leaf, attr, &num_nonempty);
+      if (num_nonempty < 2)
+	continue;
+    }
+    if (gain > best_gain) {
+      second_gain = best_gain;
+      best_gain = gain;
+      best_attr = attr;
+      best_threshold = threshold;
+      best_nonempty = num_nonempty;
+    } else if (gain > second_gain) {
+      second_gain = gain;
+    }
+  }
+  PROFILE_END(PHASE_SPLIT);
+
+  epsilon = sqrt(log(1.0 / ssvinfo->stream_delta) / (2.0 * n));
+  if (best_attr == -1 ||
+      (best_gain - second_gain <= epsilon && epsilon >= ssvinfo->stream_tie))
+    return 0;
+
+  num_children = (ssvinfo->types[best_attr] == 'd') ? best_nonempty : 2;
+  if (ssvinfo->max_leaves > 0 &&
+      num_leaves - 1 + num_children > ssvinfo->max_leaves)
+    return 0;
+
+  SplitStreamLeaf(node, best_attr, best_threshold, num_features, ssvinfo);
+
+  return num_children - 1;
+}
+
+/* ----------------------------------------------------------------------
+
+   Learn from one example: update the counts of the nodes on its path, and
+   the statistics of the leaf it reaches, which may then be split.  An
+   example that takes the default branch of a discrete test (a value not
+   seen when the test was made) stops at the test.  Returns the number of
+   leaves added.
+
+   ---------------------------------------------------------------------- */
+
+static int LearnStreamExample(DTNODE *root, void **row, int num_leaves,
+			      int num_features, SSVINFO *ssvinfo)
+{
+  DTNODE *node = root;
+  STREAMLEAF *leaf;
+  int label, child;
+
+  label = READ_ATTRIB_B(row, 0, 0);
+  for (;;) {
+    node->num_members++;
+    if (label)
+      node->num_pos++;
+    else
+      node->num_neg++;
+    if (node->num_children == 0)
+      break;
+    switch (ssvinfo->types[node->test_attrib]) {
+    case 'b':
+      child = READ_ATTRIB_B(row, 0, node->test_attrib);
+      break;
+    case 'd':
+      child = DiscreteChildIndex(node, READ_ATTRIB_I(row, 0, node->test_attrib));
+      break;
+    case 'c':
+      child = (READ_ATTRIB_C(row, 0, node->test_attrib) >= node->threshold);
+      break;
+    default:
+      USER_ERROR1("Unknown attribute type '%c'",
+		  ssvinfo->types[node->test_attrib]);
+    }
+    if (child < 0)
+      return 0;
+    node = node->children[child];
+  }
+
+  leaf = (STREAMLEAF *) node->stream_leaf;
+  UpdateStreamLeaf(leaf, row, num_features, ssvinfo);
+  if (++leaf->num_unchecked < ssvinfo->stream_grace)
+    return 0;
+  leaf->num_unchecked = 0;
+
+  return TrySplitStreamLeaf(node, num_leaves, num_features, ssvinfo);
+}
+
+/* ----------------------------------------------------------------------
+
+   Grow a decision tree from the examples of an SSV file ("-" for the
+   standard input) read one at a time.  Every example is first classified
+   by the tree as it stands and then learnt from (prequential evaluation);
+   every "ssvinfo->stream_report" examples the accuracy since the last
+   report and overall is printed.  The returned tree is an ordinary
+   decision tree; the attribute and value names stay in "ssvinfo".
+
+   ---------------------------------------------------------------------- */
+
+DTNODE *CreateDecisionTreeStream(char *filename, int *num_features_ptr,
+				 SSVINFO *ssvinfo)
+{
+  SSVSTREAM *stream;
+  DTNODE *root;
+  int num_features, num_leaves, correct;
+  long num_window, num_window_correct, num_correct;
+
+  stream = OpenSSVStream(filename, &num_features, ssvinfo);
+  if (ssvinfo->types[0] != 'b')
+    USER_ERROR1("the target attribute \"%s\" is not binary",
+		ssvinfo->feat_names[0]);
+  root = NewStreamChild(0, 0, 0, num_features, ssvinfo);
+  num_leaves = 1;
+
+  printf("-----------------------------------------------\n"
+	 "Examples\t# of\t# of\tCorrect\tCorrect\n"
+	 "\t\tnodes\tleaves\tlast %%\ttotal %%\n"
+	 "-----------------------------------------------\n");
+
+  num_window = num_window_correct = num_correct = 0;
+  while (ReadSSVStream(stream, ssvinfo)) {
+    correct = CheckCorrectness(root, stream->row, 1, 0.5, 0, ssvinfo, 0);
+    num_window++;
+    num_window_correct += correct;
+    num_correct += correct;
+    num_leaves += LearnStreamExample(root, stream->row, num_leaves,
+				     num_features, ssvinfo);
+    if (stream->num_read % ssvinfo->stream_report == 0) {
+      printf("%ld\t\t%d\t%d\t%.1f\t%.1f\n", stream->num_read,
+	     CountNodes(root), num_leaves,
+	     (100.0 * num_window_correct) / num_window,
+	     (100.0 * num_correct) / stream->num_read);
+      fflush(stdout);
+      num_window = num_window_correct = 0;
+    }
+  }
+  if (num_window > 0)
+    printf("%ld\t\t%d\t%d\t%.1f\t%.1f\n", stream->num_read,
+	   CountNodes(root), num_leaves,
+	   (100.0 * num_window_correct) / num_window,
+	   (100.0 * num_correct) / stream->num_read);
+  printf("-----------------------------------------------\n");
+
+  FreeStreamLeaves(root, num_features);
+  CloseSSVStream(stream, ssvinfo);
+  *num_features_ptr = num_features;
+
+  return root;
+}
+
+/**************************************************************************/
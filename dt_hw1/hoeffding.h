@@ -0,0 +1,70 @@
+/**************************************************************************
+ *
+ * hoeffding.h
+ *
+ * Header file to hoeffding.c
+ *
+ **************************************************************************/
+
+#ifndef HOEFFDING_H
+#define HOEFFDING_H 1
+
+#include "dt.h"
+#include "ssv.h"
+
+#ifndef HOEFFDING_DEFAULT_DELTA
+#define HOEFFDING_DEFAULT_DELTA 1e-7  /* One minus the confidence that a
+					 split is the one that infinitely
+					 many examples would choose. */
+#endif // HOEFFDING_DEFAULT_DELTA
+
+#ifndef HOEFFDING_DEFAULT_GRACE
+#define HOEFFDING_DEFAULT_GRACE 200   /* Examples a leaf sees between two
+					 attempts to split it. */
+#endif // HOEFFDING_DEFAULT_GRACE
+
+#ifndef HOEFFDING_DEFAULT_TIE
+#define HOEFFDING_DEFAULT_TIE 0.05    /* Split anyway once the bound is
+					 this tight. */
+#endif // HOEFFDING_DEFAULT_TIE
+
+#ifndef HOEFFDING_DEFAULT_REPORT
+#define HOEFFDING_DEFAULT_REPORT 10000
+#endif // HOEFFDING_DEFAULT_REPORT
+
+#ifndef HOEFFDING_NUM_CUTS
+#define HOEFFDING_NUM_CUTS 10         /* Thresholds tried for a continuous
+					 attribute at a leaf. */
+#endif // HOEFFDING_NUM_CUTS
+
+/* Running mean and variance of a continuous attribute over the examples
+   of one class at a leaf. */
+typedef struct gaussstats {
+  double n;
+  double mean;
+  double m2;                    /* Sum of squared deviations from the
+				   mean. */
+} GAUSSSTATS;
+
+/* Sufficient statistics of a leaf of a tree grown from a stream: enough to
+   choose its best split without keeping its examples. */
+typedef struct streamleaf {
+  int depth;                    /* Number of tests above the leaf. */
+  long num_pos;                  /* Examples seen since the leaf was made. */
+  long num_neg;
+  int num_unchecked;            /* Examples since the last split attempt. */
+  int *num_vals;                /* Entries of counts[attr]. */
+  long (**counts)[2];            /* Count table of every binary or discrete
+				   attribute (see PartialEntropyCounts()). */
+  GAUSSSTATS (*gauss)[2];       /* Per-class statistics of every continuous
+				   attribute, gauss[attr][label]. */
+  double *min_val;              /* Range of every continuous attribute. */
+  double *max_val;
+} STREAMLEAF;
+
+/* Function prototypes. */
+DTNODE *CreateDecisionTreeStream(char *filename, int *num_features_ptr,
+				 SSVINFO *ssvinfo);
+
+#endif // HOEFFDING_H
+/**************************************************************************/
@@ -0,0 +1,481 @@
+/**************************************************************************
+ *
+ * libdt.c
+ *
+ * Source file containing the interface of the dt library to programs that
+ * embed it (see libdt.h): the calls that take a context and return the
+ * status of their errors instead of ending the program.
+ *
+ **************************************************************************/
+
+#include <string.h>
+
+#include "libdt.h"
+#include "prune-dt.h"
+#include "print-dt.h"
+#include "hoeffding.h"
+#include "grow.h"
+#include "update.h"
+#include "roc.h"
+
+/* Prior of the positive class of DTClassify(), as in
+   DecisionTreeAccuracy(). */
+#define DT_POS_PRIOR 0.5
+
+/* ----------------------------------------------------------------------
+
+   Set up a context with the defaults: memory from malloc(), no memory cap,
+   no limit on threads, and errors printed on stderr under progname.  The
+   generator of random numbers is seeded with 1, as random() is.
+
+   ---------------------------------------------------------------------- */
+
+void DTInitContext(DTCONTEXT *context)
+{
+  InitContext(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Release a context, with all the memory still allocated in it.  Trees
+   and data sets of the context must not be used any more.
+
+   ---------------------------------------------------------------------- */
+
+void DTFreeContext(DTCONTEXT *context)
+{
+  ReleaseContext(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Make "context" (NULL for the default one) the context of this thread,
+   which the functions of the modules run in when called directly, and
+   return the one it replaces.
+
+   ---------------------------------------------------------------------- */
+
+DTCONTEXT *DTSetContext(DTCONTEXT *context)
+{
+  return SetContext(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Seed the generator of random numbers of a context, which splits data
+   sets in DTPartition().
+
+   ---------------------------------------------------------------------- */
+
+void DTSeedRandom(DTCONTEXT *context, unsigned int seed)
+{
+  DTCONTEXT *outer = SetContext(context);
+
+  SeedRandom(seed);
+  SetContext(outer);
+}
+
+/* ----------------------------------------------------------------------
+
+   Set the options of the learners to their defaults: a single tree,
+   grown depth-first and split one way per value.
+
+   ---------------------------------------------------------------------- */
+
+void DTInitOptions(SSVINFO *ssvinfo)
+{
+  bzero(ssvinfo, sizeof(SSVINFO));
+  ssvinfo->grow_mode = GROW_DEPTH_FIRST;
+  ssvinfo->learning_rate = BOOST_DEFAULT_RATE;
+  ssvinfo->stream_delta = HOEFFDING_DEFAULT_DELTA;
+  ssvinfo->stream_grace = HOEFFDING_DEFAULT_GRACE;
+  ssvinfo->stream_tie = HOEFFDING_DEFAULT_TIE;
+  ssvinfo->stream_report = HOEFFDING_DEFAULT_REPORT;
+}
+
+/* ----------------------------------------------------------------------
+
+   Read a data set from an SSV file (or a LIBSVM file, if
+   ssvinfo.libsvm is set), to be split with DTPartition().
+
+   ---------------------------------------------------------------------- */
+
+int DTReadFile(DTCONTEXT *context, char *filename, DTDATA *dataset)
+{
+  DT_ENTER(context);
+
+  dataset->data = ReadSSVFile(filename, &dataset->num_data,
+			      &dataset->num_features, &dataset->ssvinfo);
+  dataset->train_members = NewMemberSet(MEM_DATASET);
+  dataset->prune_members = NewMemberSet(MEM_DATASET);
+  dataset->test_members = NewMemberSet(MEM_DATASET);
+  dataset->num_train = dataset->num_prune = dataset->num_test = 0;
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Read a data set from a training file and a pruning and a test file,
+   either of which may be NULL, the examples of every file making up its
+   set.
+
+   ---------------------------------------------------------------------- */
+
+int DTReadFiles(DTCONTEXT *context, char *train_filename,
+		char *prune_filename, char *test_filename, DTDATA *dataset)
+{
+  DT_ENTER(context);
+
+  if (prune_filename != NULL && test_filename != NULL) {
+    dataset->data = ReadTPT(train_filename, prune_filename, test_filename,
+			    &dataset->train_members, &dataset->prune_members,
+			    &dataset->test_members, &dataset->num_train,
+			    &dataset->num_prune, &dataset->num_test,
+			    &dataset->num_data, &dataset->num_features,
+			    &dataset->ssvinfo);
+  } else if (prune_filename != NULL) {
+    dataset->data = ReadTwo(train_filename, prune_filename,
+			    &dataset->train_members, &dataset->prune_members,
+			    &dataset->num_train, &dataset->num_prune,
+			    &dataset->num_data, &dataset->num_features,
+			    &dataset->ssvinfo);
+    dataset->test_members = NewMemberSet(MEM_DATASET);
+    dataset->num_test = 0;
+  } else if (test_filename != NULL) {
+    dataset->data = ReadTwo(train_filename, test_filename,
+			    &dataset->train_members, &dataset->test_members,
+			    &dataset->num_train, &dataset->num_test,
+			    &dataset->num_data, &dataset->num_features,
+			    &dataset->ssvinfo);
+    dataset->prune_members = NewMemberSet(MEM_DATASET);
+    dataset->num_prune = 0;
+  } else {
+    USER_ERROR1("no pruning or test file given with \"%s\"",
+		train_filename);
+  }
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Split a data set at random into training, pruning and test sets of the
+   given fractions, in place of the sets it had.
+
+   ---------------------------------------------------------------------- */
+
+int DTPartition(DTCONTEXT *context, DTDATA *dataset, double train_pct,
+		double prune_pct, double test_pct)
+{
+  DT_ENTER(context);
+
+  FreeMemberSet(dataset->train_members);
+  FreeMemberSet(dataset->prune_members);
+  FreeMemberSet(dataset->test_members);
+  dataset->train_members = NULL;
+  dataset->prune_members = NULL;
+  dataset->test_members = NULL;
+  PartitionExamples(dataset->data, &dataset->num_data,
+		    dataset->num_features,
+		    &dataset->train_members, &dataset->num_train,
+		    &dataset->test_members, &dataset->num_test,
+		    &dataset->prune_members, &dataset->num_prune,
+		    train_pct, prune_pct, test_pct, &dataset->ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Grow a decision tree from the training set, as the options of the data
+   set say.
+
+   ---------------------------------------------------------------------- */
+
+int DTGrowTree(DTCONTEXT *context, DTDATA *dataset, DTNODE **tree_ptr)
+{
+  DT_ENTER(context);
+
+  if (dataset->num_train == 0)
+    USER_ERROR1("no examples to train on%s", "");
+  *tree_ptr = CreateDecisionTree(dataset->data, dataset->num_data,
+				 dataset->num_features, 0.0, 0.0,
+				 dataset->train_members, dataset->num_train,
+				 &dataset->ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Grow gradient-boosted trees from the training set, reporting the
+   accuracy on the training and test sets as rounds are added.
+
+   ---------------------------------------------------------------------- */
+
+int DTGrowBoosted(DTCONTEXT *context, DTDATA *dataset,
+		  BOOSTMODEL **model_ptr)
+{
+  DT_ENTER(context);
+
+  if (dataset->num_train == 0)
+    USER_ERROR1("no examples to train on%s", "");
+  *model_ptr = CreateBoostedTrees(dataset->data, dataset->num_data,
+				  dataset->num_features,
+				  dataset->train_members, dataset->num_train,
+				  dataset->test_members, dataset->num_test,
+				  &dataset->ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Grow a decision tree from the examples of an SSV file as they are read,
+   never holding them (see hoeffding.h).  The names of the attributes and
+   values are left in "ssvinfo", to be released with FreeSSVInfo().
+
+   ---------------------------------------------------------------------- */
+
+int DTGrowStream(DTCONTEXT *context, char *filename, SSVINFO *ssvinfo,
+		 int *num_features_ptr, DTNODE **tree_ptr)
+{
+  DT_ENTER(context);
+
+  *tree_ptr = CreateDecisionTreeStream(filename, num_features_ptr, ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Post-prune a decision tree with the pruning set.
+
+   ---------------------------------------------------------------------- */
+
+int DTPruneTree(DTCONTEXT *context, DTDATA *dataset, DTNODE *tree)
+{
+  DT_ENTER(context);
+
+  if (dataset->num_prune > 0)
+    PruneDecisionTree(tree, tree, dataset->data, dataset->num_data,
+		      dataset->prune_members, dataset->num_prune,
+		      &dataset->ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Save a decision tree grown depth-first, to be updated later.  A tree
+   just grown is saved with the count tables of its training set; a tree
+   loaded or updated already has them.
+
+   ---------------------------------------------------------------------- */
+
+int DTSaveTree(DTCONTEXT *context, char *filename, DTNODE *tree,
+	       DTDATA *dataset)
+{
+  DT_ENTER(context);
+
+  if (tree->num_children > 0 && tree->stats == NULL)
+    CountDecisionTreeStats(tree, dataset->data, dataset->num_data,
+			   dataset->train_members, dataset->num_features,
+			   &dataset->ssvinfo);
+  SaveDecisionTree(filename, tree, dataset->num_features,
+		   &dataset->ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Load a decision tree saved with DTSaveTree(), for the attributes of a
+   data set.
+
+   ---------------------------------------------------------------------- */
+
+int DTLoadTree(DTCONTEXT *context, char *filename, DTDATA *dataset,
+	       DTNODE **tree_ptr)
+{
+  DT_ENTER(context);
+
+  *tree_ptr = LoadDecisionTree(filename, dataset->num_features,
+			       &dataset->ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Load a tree saved with DTSaveTree(), without a data set, and read the
+   examples of an SSV file with the same attributes to classify with it.
+   Only the class and the attributes the tree tests are read (see
+   ReadSSVColumns()); the columns of the others are NULL.  The examples
+   make up the test set.
+
+   ---------------------------------------------------------------------- */
+
+int DTReadForTree(DTCONTEXT *context, char *model_filename, char *filename,
+		  DTDATA *dataset, DTNODE **tree_ptr)
+{
+  uchar *columns;
+
+  DT_ENTER(context);
+
+  *tree_ptr = LoadModel(model_filename, &dataset->num_features,
+			&dataset->ssvinfo);
+  columns = (uchar *) getmem(dataset->num_features);
+  memset(columns, 0, dataset->num_features);
+  columns[0] = 1;
+  MarkTestedAttributes(*tree_ptr, columns);
+  dataset->data = ReadSSVColumns(filename, &dataset->num_data,
+				 dataset->num_features, columns,
+				 &dataset->ssvinfo);
+  freemem(columns);
+  dataset->train_members = NewMemberSet(MEM_DATASET);
+  dataset->prune_members = NewMemberSet(MEM_DATASET);
+  dataset->test_members = NewMemberRange(0, dataset->num_data - 1,
+					 MEM_DATASET);
+  dataset->num_train = dataset->num_prune = 0;
+  dataset->num_test = dataset->num_data;
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Bring a loaded tree, grown from the training set, up to date with the
+   examples of the test set (see update.h).  The test set then joins the
+   training set, which the tree stands for from then on.
+
+   ---------------------------------------------------------------------- */
+
+int DTUpdateTree(DTCONTEXT *context, DTDATA *dataset, DTNODE **tree_ptr)
+{
+  MEMBERSET *old_members;
+
+  DT_ENTER(context);
+
+  *tree_ptr = UpdateDecisionTree(*tree_ptr, dataset->data, dataset->num_data,
+				 dataset->train_members, dataset->num_train,
+				 dataset->test_members, dataset->num_test,
+				 dataset->num_features, &dataset->ssvinfo);
+  old_members = dataset->train_members;
+  dataset->train_members = UnionMemberSets(old_members,
+					   dataset->test_members,
+					   MEM_DATASET);
+  FreeMemberSet(old_members);
+  dataset->num_train += dataset->num_test;
+  FreeMemberSet(dataset->test_members);
+  dataset->test_members = NewMemberSet(MEM_DATASET);
+  dataset->num_test = 0;
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Classify an example of a data set: 1 if positive, 0 if negative, or -1
+   if it reaches a missing subtree.
+
+   ---------------------------------------------------------------------- */
+
+int DTClassify(DTCONTEXT *context, DTNODE *tree, DTDATA *dataset,
+	       long example, int *class_ptr)
+{
+  DT_ENTER(context);
+
+  if (example < 0 || example >= dataset->num_data)
+    USER_ERROR1("no example %ld", example);
+  *class_ptr = ClassifyExample(tree, dataset->data, example, DT_POS_PRIOR,
+			       &dataset->ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Compute the fraction of a set of examples of a data set that a tree
+   classifies correctly.
+
+   ---------------------------------------------------------------------- */
+
+int DTAccuracy(DTCONTEXT *context, DTNODE *tree, DTDATA *dataset,
+	       MEMBERSET *members, long num_members, double *accuracy_ptr)
+{
+  SCORER *scorer;
+
+  DT_ENTER(context);
+
+  scorer = CompileAccuracyScorer(tree, 0, &dataset->ssvinfo, MEM_TREE);
+  *accuracy_ptr = DecisionTreeAccuracy(tree, scorer, dataset->data,
+				       dataset->num_data, members,
+				       num_members, &dataset->ssvinfo);
+  if (scorer != NULL)
+    FreeScorer(scorer);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Print the size and the accuracy on the training and test sets of a
+   tree, depth by depth.
+
+   ---------------------------------------------------------------------- */
+
+int DTPrintStats(DTCONTEXT *context, DTNODE *tree, DTDATA *dataset)
+{
+  DT_ENTER(context);
+
+  PrintStats(tree, dataset->data, dataset->num_data,
+	     dataset->train_members, dataset->num_train,
+	     dataset->test_members, dataset->num_test, &dataset->ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Sweep the decision threshold of a tree over the test set (see roc.h).
+
+   ---------------------------------------------------------------------- */
+
+int DTPrintROC(DTCONTEXT *context, DTNODE *tree, DTDATA *dataset)
+{
+  DT_ENTER(context);
+
+  PrintROC(tree, dataset->data, dataset->num_data, dataset->test_members,
+	   dataset->num_test, &dataset->ssvinfo);
+
+  DT_LEAVE(context);
+}
+
+/* ----------------------------------------------------------------------
+
+   Release a tree, boosted trees, or a data set with its sets and names.
+   Memory goes back to the context it came from.
+
+   ---------------------------------------------------------------------- */
+
+void DTFreeTree(DTNODE *tree)
+{
+  FreeDecisionTree(tree);
+}
+
+void DTFreeBoosted(BOOSTMODEL *model)
+{
+  FreeBoostedTrees(model);
+}
+
+void DTFreeData(DTDATA *dataset)
+{
+  FreeMemberSet(dataset->train_members);
+  FreeMemberSet(dataset->prune_members);
+  FreeMemberSet(dataset->test_members);
+  FreeSSVFile(dataset->data, dataset->num_features, &dataset->ssvinfo);
+}
+
+/**************************************************************************/
@@ -0,0 +1,82 @@
+/**************************************************************************
+ *
+ * libdt.h
+ *
+ * Header file to libdt.c, the interface of the dt library (libdt.a,
+ * libdt.so) to programs that embed it.
+ *
+ **************************************************************************/
+
+#ifndef LIBDT_H
+#define LIBDT_H 1
+
+#include "auxi.h"
+#include "dt.h"
+#include "boost.h"
+#include "memberset.h"
+#include "ssv.h"
+
+/* Every function of the library that can fail takes the DTCONTEXT (see
+   auxi.h) to run in and returns DT_OK, or the status of its error, which
+   it has handed to the error callback of the context (or printed on
+   stderr).  Nothing is shared between contexts, so that trees can be
+   grown with different contexts on different threads at once.  A failed
+   call waits for the threads it started, and closes the files it had
+   open, before it returns; the memory it allocated is released with its
+   context, by DTFreeContext().
+
+   The functions of the modules (dt.h, ssv.h, ...) may be called directly
+   too, in the context of the thread (see DTSetContext()); their errors
+   then end the program. */
+
+/* A data set, and the examples it is split into. */
+typedef struct dtdata {
+  void **data;                  /* Columns of the attributes, see ssv.h. */
+  long num_data;                /* Examples. */
+  int num_features;             /* Attributes, the class included. */
+  MEMBERSET *train_members;     /* Training, pruning and test sets; empty */
+  MEMBERSET *prune_members;     /* until the data set is partitioned, if */
+  MEMBERSET *test_members;      /* read from a single file. */
+  long num_train, num_prune, num_test;
+  SSVINFO ssvinfo;              /* Options of the learners, set before the
+				   data set is read (see DTInitOptions()),
+				   and the names of the attributes and
+				   values. */
+} DTDATA;
+
+/* Function prototypes. */
+void DTInitContext(DTCONTEXT *context);
+void DTFreeContext(DTCONTEXT *context);
+DTCONTEXT *DTSetContext(DTCONTEXT *context);
+void DTSeedRandom(DTCONTEXT *context, unsigned int seed);
+void DTInitOptions(SSVINFO *ssvinfo);
+int DTReadFile(DTCONTEXT *context, char *filename, DTDATA *dataset);
+int DTReadFiles(DTCONTEXT *context, char *train_filename,
+		char *prune_filename, char *test_filename, DTDATA *dataset);
+int DTPartition(DTCONTEXT *context, DTDATA *dataset, double train_pct,
+		double prune_pct, double test_pct);
+int DTGrowTree(DTCONTEXT *context, DTDATA *dataset, DTNODE **tree_ptr);
+int DTGrowBoosted(DTCONTEXT *context, DTDATA *dataset,
+		  BOOSTMODEL **model_ptr);
+int DTGrowStream(DTCONTEXT *context, char *filename, SSVINFO *ssvinfo,
+		 int *num_features_ptr, DTNODE **tree_ptr);
+int DTPruneTree(DTCONTEXT *context, DTDATA *dataset, DTNODE *tree);
+int DTSaveTree(DTCONTEXT *context, char *filename, DTNODE *tree,
+	       DTDATA *dataset);
+int DTLoadTree(DTCONTEXT *context, char *filename, DTDATA *dataset,
+	       DTNODE **tree_ptr);
+int DTReadForTree(DTCONTEXT *context, char *model_filename, char *filename,
+		  DTDATA *dataset, DTNODE **tree_ptr);
+int DTUpdateTree(DTCONTEXT *context, DTDATA *dataset, DTNODE **tree_ptr);
+int DTClassify(DTCONTEXT *context, DTNODE *tree, DTDATA *dataset,
+	       long example, int *class_ptr);
+int DTAccuracy(DTCONTEXT *context, DTNODE *tree, DTDATA *dataset,
+	       MEMBERSET *members, long num_members, double *accuracy_ptr);
+int DTPrintStats(DTCONTEXT *context, DTNODE *tree, DTDATA *dataset);
+int DTPrintROC(DTCONTEXT *context, DTNODE *tree, DTDATA *dataset);
+void DTFreeTree(DTNODE *tree);
+void DTFreeBoosted(BOOSTMODEL *model);
+void DTFreeData(DTDATA *dataset);
+
+#endif // LIBDT_H
+/**************************************************************************/
@@ -19,12 +19,19 @@
 #include <unistd.h>
 #include <errno.h>
 
+#include "libdt.h"
 #include "dt.h"
 #include "prune-dt.h"
 #include "print-dt.h"
+#include "boost.h"
+#include "grow.h"
+#include "hoeffding.h"
+#include "update.h"
+#include "serve.h"
+#include "roc.h"
+#include "profile.h"
 #include "ssv.h"
 #include "bitarray.h"
-#include "main.h"
 
 #define USAGE "\nProduce a decision tree for a set of attributes.\n\n"	 \
               "Usage: %s [ -s <seed> | -b <number>] "		         \
@@ -33,48 +40,151 @@
               "OR\n\n"		                        	         \
               "%s [-tpt <trainfile> <prunefile> <testfile> | "           \
               "-tp <trainfile> <prunefile> | "                           \
-              "-tt <trainfile> <testfile>]\n\n"                          \
+              "-tt <trainfile> <testfile> | "                            \
+              "-stream <file> | "                                        \
+              "-update <model> <trainfile> <deltafile> | "              \
+              "-score <model> <file> | "                                 \
+              "-serve <model> [<socket>]]\n\n"                          \
+	      "Options (anywhere on the command line):\n"		 \
+	      "  -boost <rounds>  grow <rounds> gradient-boosted trees\n"	 \
+	      "  -depth <d>       maximum depth of boosted or budgeted trees\n" \
+	      "  -rate <eta>      learning rate of boosted trees\n"	 \
+	      "  -grow <mode>     grow trees \"depth\"-first (default), "	 \
+	      "\"best\"-first or \"level\"-wise\n"			 \
+	      "  -leaves <n>      best-first: maximum number of leaves\n"	 \
+	      "  -mingain <g>     best-first: minimum gain of a split\n"	 \
+	      "  -time <sec>      best-first: wall-clock budget\n"	 \
+	      "  -subsets         split discrete attributes two ways, on "	 \
+	      "a subset of values\n"					 \
+	      "  -delta <d>       stream: 1 - confidence of a split\n"	 \
+	      "  -grace <n>       stream: examples between split attempts\n" \
+	      "  -tie <t>         stream: split near-ties below this bound\n" \
+	      "  -report <n>      stream: examples between reports\n"	 \
+	      "  -float           store continuous attributes as floats\n" \
+	      "  -libsvm          read the data files in the sparse LIBSVM "	 \
+	      "format\n"						 \
+	      "  -save <model>    save the grown or updated tree, to be "	 \
+	      "updated with -update\n"					 \
+	      "  -roc <file>      write the ROC and precision-recall curves "	 \
+	      "of the test set\n"					 \
+	      "  -thresholds <t>  confusion matrix of the test set at "	 \
+	      "thresholds <t>,...\n"					 \
+	      "  -memcap <MB>     exit as soon as more memory is needed\n" \
+	      "  --profile        report phase times and counters as JSON "	 \
+	      "on stderr\n"						 \
+	      "  -trace <file>    write the spans of the run as Chrome trace "	 \
+	      "events\n\n"						 \
 	      "(Note: the random seed is taken from the computer clock " \
 	      "if not specified.)\n\n"
 
-/* Global variables. */
-char *progname;
+/* Exit if a call of the library failed; it has printed its error. */
+#define CHECK_CALL(call) { if ((call) != DT_OK) exit(1); }
 
 /* ----------------------------------------------------------------------
 
-   Auxiliary function, a wrapper around strdup() really that aborts the
-   program if there's not enough memory.
+   Remove the learner options from the command line, wherever they appear,
+   and record them in "ssvinfo", or in "context" for the memory cap.
+   Returns the number of arguments left for the positional parsing done by
+   main().
 
    ---------------------------------------------------------------------- */
 
-char *my_strdup(char *s)
+static int ParseOptions(int argc, char *argv[], DTCONTEXT *context,
+			SSVINFO *ssvinfo)
 {
-  char *ptr;
-
-  if ((ptr = strdup(s)) == NULL)
-    SYS_ERROR1("can't allocate %d byte(s).\n", strlen(s));
-
-  return ptr;
-}
-
-/* ----------------------------------------------------------------------
-
-   Same as my_strdup() inly the number of characters to dplicate is
-   specified.  The actual string allocated has length "n"+1.
+  int i, new_argc;
+
+  for (i = new_argc = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-boost") && i + 1 < argc) {
+      ssvinfo->boost_rounds = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-depth") && i + 1 < argc) {
+      ssvinfo->max_depth = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-rate") && i + 1 < argc) {
+      ssvinfo->learning_rate = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "-grow") && i + 1 < argc) {
+      i++;
+      if (!strcmp(argv[i], "depth"))
+	ssvinfo->grow_mode = GROW_DEPTH_FIRST;
+      else if (!strcmp(argv[i], "best"))
+	ssvinfo->grow_mode = GROW_BEST_FIRST;
+      else if (!strcmp(argv[i], "level"))
+	ssvinfo->grow_mode = GROW_LEVEL_WISE;
+      else
+	ssvinfo->grow_mode = -1;
+    } else if (!strcmp(argv[i], "-leaves") && i + 1 < argc) {
+      ssvinfo->max_leaves = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-mingain") && i + 1 < argc) {
+      ssvinfo->min_gain = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "-subsets")) {
+      ssvinfo->subset_splits = 1;
+    } else if (!strcmp(argv[i], "-time") && i + 1 < argc) {
+      ssvinfo->time_limit = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "-delta") && i + 1 < argc) {
+      ssvinfo->stream_delta = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "-grace") && i + 1 < argc) {
+      ssvinfo->stream_grace = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-tie") && i + 1 < argc) {
+      ssvinfo->stream_tie = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "-report") && i + 1 < argc) {
+      ssvinfo->stream_report = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-float")) {
+      ssvinfo->float_columns = 1;
+    } else if (!strcmp(argv[i], "-libsvm")) {
+      ssvinfo->libsvm = 1;
+    } else if (!strcmp(argv[i], "-save") && i + 1 < argc) {
+      ssvinfo->model_filename = argv[++i];
+    } else if (!strcmp(argv[i], "-roc") && i + 1 < argc) {
+      ssvinfo->roc_filename = argv[++i];
+    } else if (!strcmp(argv[i], "-thresholds") && i + 1 < argc) {
+      ssvinfo->thresholds = argv[++i];
+    } else if (!strcmp(argv[i], "-memcap") && i + 1 < argc) {
+      context->mem_cap = (long) (atof(argv[++i]) * 1024 * 1024);
+      if (context->mem_cap < 0) {
+	fprintf(stderr, USAGE, progname, progname);
+	exit(1);
+      }
+    } else if (!strcmp(argv[i], "--profile") || !strcmp(argv[i], "-profile")) {
+      ProfileStart();
+    } else if (!strcmp(argv[i], "-trace") && i + 1 < argc) {
+      TraceStart(argv[++i]);
+    } else {
+      argv[new_argc++] = argv[i];
+    }
+  }
+  argv[new_argc] = NULL;
+
+  if (ssvinfo->boost_rounds < 0 || ssvinfo->max_depth < 0 ||
+      ssvinfo->learning_rate <= 0.0 || ssvinfo->grow_mode < 0 ||
+      ssvinfo->max_leaves < 0 || ssvinfo->min_gain < 0.0 ||
+      ssvinfo->time_limit < 0.0 || ssvinfo->stream_delta <= 0.0 ||
+      ssvinfo->stream_delta >= 1.0 || ssvinfo->stream_grace < 1 ||
+      ssvinfo->stream_tie < 0.0 || ssvinfo->stream_report < 1 ||
+      (ssvinfo->thresholds != NULL &&
+       ParseThresholds(ssvinfo->thresholds, (double *) NULL) < 0)) {
+    fprintf(stderr, USAGE, progname, progname);
+    exit(1);
+  }
 
-   ---------------------------------------------------------------------- */
+  /* A saved tree is updated by growing parts of it again depth-first,
+     which only gives the tree of a full retrain if nothing limits it. */
+  if (ssvinfo->model_filename != NULL &&
+      (ssvinfo->boost_rounds > 0 || ssvinfo->max_depth > 0 ||
+       ssvinfo->max_leaves > 0 || ssvinfo->min_gain > 0.0 ||
+       ssvinfo->time_limit > 0.0)) {
+    fprintf(stderr, USAGE, progname, progname);
+    exit(1);
+  }
 
-char *my_strndup(char *s, int n)
-{
-  char *ptr;
+  /* Boosted trees have no leaf fractions to sweep a threshold over. */
+  if (ssvinfo->boost_rounds > 0 &&
+      (ssvinfo->roc_filename != NULL || ssvinfo->thresholds != NULL)) {
+    fprintf(stderr, USAGE, progname, progname);
+    exit(1);
+  }
 
-  ptr = getmem(n + 1);
-  strncpy(ptr, s, n);
-  ptr[n] = '\0';
-  return ptr;
+  return new_argc;
 }
 
-
 /* Calculates the mean and the standard deviation of the sample mean *
  *                                                                   *
  * Observe that there is a difference between the standard deviation *
@@ -111,14 +221,15 @@ void CalculateMeanStandardDeviation(double *data, int number, double *mean_ptr,
   *stddev_ptr = stddev; 
 }
 
-void BatchMain(void **data, int num_data, int num_features, 
-	       double train_pct, double prune_pct, double test_pct, SSVINFO *ssvinfo)
+void BatchMain(DTCONTEXT *context, DTDATA *dataset,
+	       double train_pct, double prune_pct, double test_pct)
 {
   DTNODE *tree;
-  uchar *test_members, *train_members, *prune_members;
-  int num_test, num_train, num_prune;
-  int num_negatives, num_false_negatives;
-  int num_positives, num_false_positives;
+  BOOSTMODEL *model;
+  SCORER *scorer;
+  SSVINFO *ssvinfo = &dataset->ssvinfo;
+  long num_negatives, num_false_negatives;
+  long num_positives, num_false_positives;
   int i;
   double train_accuracy = 0, test_accuracy = 0;
   double count_mean, count_stddev;
@@ -133,54 +244,94 @@ void BatchMain(void **data, int num_data, int num_features,
   train_list = (double *) getmem(ssvinfo->batch * sizeof(double));
   test_list = (double *) getmem(ssvinfo->batch * sizeof(double));
 
+  /* Only the work of the iterations themselves is reported per
+     iteration. */
+  ProfileFlush(0);
+
   for (i=0; i<ssvinfo->batch; i++) {
+    TRACE_BEGIN("iteration", "\"iteration\": %d", i + 1);
 
     /* Partition examples in train, test and prune sets. */
-    PartitionExamples(data, &num_data, num_features,
-		      &train_members, &num_train,
-		      &test_members, &num_test,
-		      &prune_members, &num_prune,
-		      train_pct, prune_pct, test_pct,
-		      ssvinfo);
-
-    if (num_train == 0) {
+    PROFILE_BEGIN(PHASE_PARTITION);
+    CHECK_CALL(DTPartition(context, dataset, train_pct, prune_pct,
+			   test_pct));
+    PROFILE_END(PHASE_PARTITION);
+
+    if (dataset->num_train == 0) {
       fprintf(stderr, "%s: no examples to train on!\n", progname);
       exit(1);
     }
+
+    if (ssvinfo->boost_rounds > 0) {
+      PROFILE_BEGIN(PHASE_GROW);
+      CHECK_CALL(DTGrowBoosted(context, dataset, &model));
+      PROFILE_END(PHASE_GROW);
+      PROFILE_BEGIN(PHASE_STATS);
+      count_list[i] = CountBoostedNodes(model);
+      train_list[i] = 100.0 * BoostedAccuracy(model, dataset->data,
+					      dataset->num_data,
+					      dataset->train_members,
+					      dataset->num_train, ssvinfo);
+      test_list[i] = (dataset->num_test > 0) ?
+	100.0 * BoostedAccuracy(model, dataset->data, dataset->num_data,
+				dataset->test_members, dataset->num_test,
+				ssvinfo) : 0.0;
+      PROFILE_END(PHASE_STATS);
+      DTFreeBoosted(model);
+      TRACE_END("%s", "");
+      ProfileFlush(i + 1);
+      continue;
+    }
     
-    tree = CreateDecisionTree(data, num_data, num_features, prune_pct, test_pct,
-			      train_members, num_train, ssvinfo);
+    PROFILE_BEGIN(PHASE_GROW);
+    CHECK_CALL(DTGrowTree(context, dataset, &tree));
+    PROFILE_END(PHASE_GROW);
     
     
     /* Post-prune the decision tree. */
-    if (num_prune > 0) {
-      PruneDecisionTree(tree, tree, data, num_data,
-			       prune_members, num_prune, ssvinfo);
+    if (dataset->num_prune > 0) {
+      PROFILE_BEGIN(PHASE_PRUNE);
+      CHECK_CALL(DTPruneTree(context, dataset, tree));
+      PROFILE_END(PHASE_PRUNE);
     }
     
+    PROFILE_BEGIN(PHASE_STATS);
     count = CountNodes(tree);
     count_list[i] = count;
     /* count_sum += count; */
 
-    DecisionTreeAccuracyBinary(tree, data, num_data, train_members, num_train, train_members, 
-			       num_train, &num_negatives, &num_false_negatives,
-			       &num_positives, &num_false_positives, ssvinfo, 0);
-    train_accuracy = (100.0 * (num_train - num_false_positives - num_false_negatives))/num_train;
+    scorer = CompileAccuracyScorer(tree, 0, ssvinfo, MEM_TREE);
+    DecisionTreeAccuracyBinary(tree, scorer, dataset->data, dataset->num_data,
+			       dataset->train_members, dataset->num_train,
+			       dataset->train_members, dataset->num_train,
+			       &num_negatives, &num_false_negatives,
+			       &num_positives, &num_false_positives,
+			       ssvinfo, 0);
+    train_accuracy = (100.0 * (dataset->num_train - num_false_positives -
+			       num_false_negatives)) / dataset->num_train;
     train_list[i] = train_accuracy;
     /* train_sum += train_accuracy; */
 
-    if (num_test>0) {
-      DecisionTreeAccuracyBinary(tree, data, num_data, train_members, num_train, test_members, 
-				 num_test, &num_negatives, &num_false_negatives,
-				 &num_positives, &num_false_positives, ssvinfo, 0);
-      test_accuracy = (100.0 * (num_test - num_false_positives - num_false_negatives))/num_test;
+    if (dataset->num_test>0) {
+      DecisionTreeAccuracyBinary(tree, scorer, dataset->data,
+				 dataset->num_data,
+				 dataset->train_members, dataset->num_train,
+				 dataset->test_members, dataset->num_test,
+				 &num_negatives, &num_false_negatives,
+				 &num_positives, &num_false_positives,
+				 ssvinfo, 0);
+      test_accuracy = (100.0 * (dataset->num_test - num_false_positives -
+				num_false_negatives)) / dataset->num_test;
     }
     test_list[i] = test_accuracy;
     /* test_sum += test_accuracy; */
+    if (scorer != NULL)
+      FreeScorer(scorer);
+    PROFILE_END(PHASE_STATS);
     
-    free(train_members);
-    free(test_members);
-    free(prune_members);
+    DTFreeTree(tree);
+    TRACE_END("%s", "");
+    ProfileFlush(i + 1);
   }
 
   CalculateMeanStandardDeviation(count_list,ssvinfo->batch,&count_mean,&count_stddev);
@@ -195,80 +346,151 @@ void BatchMain(void **data, int num_data, int num_features,
 	 count_mean, count_stddev, train_mean, train_stddev, test_mean, test_stddev);
   printf("----------------------------------------------\n");
 
-  free(count_list);
-  free(train_list);
-  free(test_list);
+  freemem(count_list);
+  freemem(train_list);
+  freemem(test_list);
   
 }
 
 /* ----------------------------------------------------------------------
 
-   Main function.
+   Main function.  Everything is done through the library (see libdt.h),
+   in a context of the program's own.
 
    ---------------------------------------------------------------------- */
 
 int main(int argc, char *argv[])
 {
-  char *data_filename, *deref_filename;
+  char *data_filename;
   double train_pct, prune_pct, test_pct;
-  double train_accuracy, test_accuracy;
   DTNODE *tree;
-  uchar *test_members, *train_members, *prune_members;
+  BOOSTMODEL *model;
+  DTCONTEXT context;
+  DTDATA dataset;
   int multiple_input_files;
   char *train_filename, *prune_filename, *test_filename;
-  int num_test, num_train, num_prune, num_features, num_data;
-  int depth, count, prev_count;
-  int num_negatives, num_false_negatives;
-  int num_positives, num_false_positives;
-  void **data;
+  int num_features, feature;
+  int count, prev_count;
   struct timeval tv;
   unsigned int random_seed;
-  SSVINFO ssvinfo;
+  SSVINFO *ssvinfo = &dataset.ssvinfo;
+  double accuracy;
 
-  ssvinfo.batch = 0;
+  DTInitContext(&context);
+  DTSetContext(&context);
+  DTInitOptions(ssvinfo);
 
   progname = (char *) rindex(argv[0], '/');
   argv[0] = progname = (progname != NULL) ? (progname + 1) : argv[0];
 
+  argc = ParseOptions(argc, argv, &context, ssvinfo);
+
+  /* A tree grown from a stream never holds the data set: the examples are
+     parsed as they are learnt from. */
+  if (argc == 3 && !strcmp(argv[1], "-stream")) {
+    PrintSection("Growing decision tree from a stream");
+    PROFILE_BEGIN(PHASE_GROW);
+    CHECK_CALL(DTGrowStream(&context, argv[2], ssvinfo, &num_features,
+			    &tree));
+    PROFILE_END(PHASE_GROW);
+    DTFreeTree(tree);
+    FreeSSVInfo(num_features, ssvinfo);
+    exit(0);
+  }
+
+  /* A saved tree answers classification requests until it is stopped. */
+  if ((argc == 3 || argc == 4) && !strcmp(argv[1], "-serve")) {
+    ServeModel(argv[2], (argc == 4) ? argv[3] : (char *) NULL);
+    exit(0);
+  }
+
+  /* A saved tree is brought up to date with the examples appended to its
+     training set, instead of being grown again from all of them. */
+  if (argc == 5 && !strcmp(argv[1], "-update")) {
+    PROFILE_BEGIN(PHASE_PARSE);
+    CHECK_CALL(DTReadFiles(&context, argv[3], (char *) NULL, argv[4],
+			   &dataset));
+    PROFILE_END(PHASE_PARSE);
+    CHECK_CALL(DTLoadTree(&context, argv[2], &dataset, &tree));
+
+    /* The tree then stands for all the examples. */
+    PrintSection("Updating decision tree");
+    PROFILE_BEGIN(PHASE_GROW);
+    CHECK_CALL(DTUpdateTree(&context, &dataset, &tree));
+    PROFILE_END(PHASE_GROW);
+    if (ssvinfo->model_filename != NULL)
+      CHECK_CALL(DTSaveTree(&context, ssvinfo->model_filename, tree,
+			    &dataset));
+
+    PrintSection("Computing decision tree statistics");
+    PROFILE_BEGIN(PHASE_STATS);
+    CHECK_CALL(DTPrintStats(&context, tree, &dataset));
+    PROFILE_END(PHASE_STATS);
+
+    DTFreeTree(tree);
+    DTFreeData(&dataset);
+    exit(0);
+  }
+
+  /* A saved tree classifies the examples of a file, of which only the
+     attributes it tests are read. */
+  if (argc == 4 && !strcmp(argv[1], "-score")) {
+    PROFILE_BEGIN(PHASE_PARSE);
+    CHECK_CALL(DTReadForTree(&context, argv[2], argv[3], &dataset, &tree));
+    PROFILE_END(PHASE_PARSE);
+
+    PrintSection("Scoring decision tree");
+    PROFILE_BEGIN(PHASE_PREDICT);
+    CHECK_CALL(DTAccuracy(&context, tree, &dataset, dataset.test_members,
+			  dataset.num_test, &accuracy));
+    PROFILE_END(PHASE_PREDICT);
+    for (count = feature = 0; feature < dataset.num_features; feature++)
+      count += (dataset.data[feature] != NULL);
+    printf("Examples:           %ld\n", dataset.num_data);
+    printf("Attributes read:    %d of %d\n", count, dataset.num_features);
+    printf("Accuracy:           %.2f%%\n", 100.0 * accuracy);
+
+    if (ssvinfo->roc_filename != NULL || ssvinfo->thresholds != NULL) {
+      PrintSection("Sweeping the decision threshold over the examples");
+      PROFILE_BEGIN(PHASE_STATS);
+      CHECK_CALL(DTPrintROC(&context, tree, &dataset));
+      PROFILE_END(PHASE_STATS);
+    }
+
+    DTFreeTree(tree);
+    DTFreeData(&dataset);
+    exit(0);
+  }
+
   multiple_input_files = 0;
+  PROFILE_BEGIN(PHASE_PARSE);
   if (argc>2){
     if (!strcmp(argv[1],"-tpt") && (argc==5)){
       train_filename = argv[2];
       prune_filename = argv[3];
       test_filename = argv[4];
-      data = ReadTPT(train_filename, prune_filename, test_filename,
-                     &train_members, &prune_members, &test_members,
-                     &num_train, &num_prune, &num_test,
-                     &num_data, &num_features, &ssvinfo);
+      CHECK_CALL(DTReadFiles(&context, train_filename, prune_filename,
+			     test_filename, &dataset));
       multiple_input_files = 1;
     } else if (!strcmp(argv[1],"-tp") && (argc==4)){
       train_filename = argv[2];
       prune_filename = argv[3];
-      data = ReadTwo(train_filename, prune_filename,
-		     &train_members, &prune_members,
-                     &num_train, &num_prune,
-                     &num_data, &num_features, &ssvinfo);
-      num_test = 0;
-      test_members = CREATE_BITARRAY(num_data);
-      ZERO_BITARRAY(test_members,num_data);
+      CHECK_CALL(DTReadFiles(&context, train_filename, prune_filename,
+			     (char *) NULL, &dataset));
       multiple_input_files = 1;
     } else if (!strcmp(argv[1],"-tt")&& (argc==4)){
       train_filename = argv[2];
       test_filename = argv[3];
-      data = ReadTwo(train_filename, test_filename,
-		     &train_members, &test_members,
-                     &num_train, &num_test,
-                     &num_data, &num_features, &ssvinfo);
-      num_prune = 0;
-      prune_members = CREATE_BITARRAY(num_data);
-      ZERO_BITARRAY(prune_members,num_data);
+      CHECK_CALL(DTReadFiles(&context, train_filename, (char *) NULL,
+			     test_filename, &dataset));
       multiple_input_files = 1;
     }
   }
+  PROFILE_END(PHASE_PARSE);
 
   if (!multiple_input_files){
     if (argc != 5 && argc != 7) {
-      fprintf(stderr, USAGE, progname);
+      fprintf(stderr, USAGE, progname, progname);
       exit(1);
     }
     switch (argc) {
@@ -288,9 +510,9 @@ int main(int argc, char *argv[])
 	if (gettimeofday(&tv, NULL) == -1)
 	  SYS_ERROR1("gettimeofday(%s)", "");
 	random_seed = (unsigned int) tv.tv_usec;
-	ssvinfo.batch = atoi(argv[2]);
+	ssvinfo->batch = atoi(argv[2]);
       } else {
-	fprintf(stderr, USAGE, progname);
+	fprintf(stderr, USAGE, progname, progname);
 	exit(1);
       }
       train_pct = atof(argv[3]);
@@ -299,74 +521,97 @@ int main(int argc, char *argv[])
       data_filename = argv[6];
       break;
     default:
-      fprintf(stderr, USAGE, progname);
+      fprintf(stderr, USAGE, progname, progname);
       exit(1);
     }
-    if ((random_seed < 0) ||
-	(train_pct <= 0.0) || (train_pct > 1.0) ||
+    if ((train_pct <= 0.0) || (train_pct > 1.0) ||
 	(prune_pct < 0.0) || (prune_pct > 1.0) ||
 	(test_pct < 0.0) || (test_pct > 1.0) ||
 	(train_pct + prune_pct + test_pct > 1.00000001)) {
-      fprintf(stderr, USAGE, progname);
+      fprintf(stderr, USAGE, progname, progname);
       exit(1);
     }
 
     /* Memory-map the examples file. */
-    data = ReadSSVFile(data_filename, &num_data, &num_features, &ssvinfo);
+    PROFILE_BEGIN(PHASE_PARSE);
+    CHECK_CALL(DTReadFile(&context, data_filename, &dataset));
+    PROFILE_END(PHASE_PARSE);
     
     /* Initialize random number generator. */
-    srandom(random_seed);
+    DTSeedRandom(&context, random_seed);
 
-    if (ssvinfo.batch>0) {
-      BatchMain(data, num_data, num_features, train_pct, prune_pct, test_pct, &ssvinfo);
+    if (ssvinfo->batch>0) {
+      BatchMain(&context, &dataset, train_pct, prune_pct, test_pct);
+      DTFreeData(&dataset);
       exit(0);
     } 
 
     /* Partition examples in train, test and prune sets. */
-    PartitionExamples(data, &num_data, num_features,
-		      &train_members, &num_train,
-		      &test_members, &num_test,
-		      &prune_members, &num_prune,
-		      train_pct, prune_pct, test_pct,
-		      &ssvinfo);
+    PROFILE_BEGIN(PHASE_PARTITION);
+    CHECK_CALL(DTPartition(&context, &dataset, train_pct, prune_pct,
+			   test_pct));
+    PROFILE_END(PHASE_PARTITION);
 
     /* Print the program arguments */
     PrintSection("Program arguments");
 
     printf("Random seed:    %u\n", random_seed);
-    printf("Training:       %.0f%% (%d examples)\n", train_pct * 100.0, num_train);
-    printf("Pruning:        %.0f%% (%d examples)\n", prune_pct * 100.0, num_prune);
-    printf("Testing:        %.0f%% (%d examples)\n", test_pct * 100.0, num_test);
+    printf("Training:       %.0f%% (%ld examples)\n", train_pct * 100.0,
+	   dataset.num_train);
+    printf("Pruning:        %.0f%% (%ld examples)\n", prune_pct * 100.0,
+	   dataset.num_prune);
+    printf("Testing:        %.0f%% (%ld examples)\n", test_pct * 100.0,
+	   dataset.num_test);
     printf("Data filename:  %s\n", data_filename);
   }
 
-  if (num_train == 0) {
+  if (dataset.num_train == 0) {
     fprintf(stderr, "%s: no examples to train on!\n", progname);
     exit(1);
   }
   
+  /* Boosted trees are neither pruned nor printed; just report how the
+     accuracy evolves as rounds are added. */
+  if (ssvinfo->boost_rounds > 0) {
+    PrintSection("Growing boosted trees");
+    PROFILE_BEGIN(PHASE_GROW);
+    CHECK_CALL(DTGrowBoosted(&context, &dataset, &model));
+    PROFILE_END(PHASE_GROW);
+    DTFreeBoosted(model);
+    DTFreeData(&dataset);
+    exit(0);
+  }
+
   /* Create a decision tree and print it */
   PrintSection("Growing decision tree");
 
-  tree = CreateDecisionTree(data, num_data, num_features, prune_pct, test_pct,
-			    train_members, num_train, &ssvinfo);
+  PROFILE_BEGIN(PHASE_GROW);
+  CHECK_CALL(DTGrowTree(&context, &dataset, &tree));
+  PROFILE_END(PHASE_GROW);
 
+  /* Save the tree as grown, before pruning, to be updated later. */
+  if (ssvinfo->model_filename != NULL)
+    CHECK_CALL(DTSaveTree(&context, ssvinfo->model_filename, tree,
+			  &dataset));
 
   //PrintSection("Printing decision tree");
-  //PrintDecisionTreeStructure(tree, &ssvinfo);
+  //PrintDecisionTreeStructure(tree, ssvinfo);
 
   PrintSection("Computing decision tree statistics");
-  PrintStats(tree, data, num_data, train_members, num_train, test_members, num_test, &ssvinfo);
+  PROFILE_BEGIN(PHASE_STATS);
+  CHECK_CALL(DTPrintStats(&context, tree, &dataset));
+  PROFILE_END(PHASE_STATS);
 
   /* Post-prune the decision tree. */
-  if (num_prune > 0) {
+  if (dataset.num_prune > 0) {
 
     PrintSection("Pruning decision tree");
 
     prev_count = CountNodes(tree);
 
-    PruneDecisionTree(tree, tree, data, num_data,
-			     prune_members, num_prune, &ssvinfo);
+    PROFILE_BEGIN(PHASE_PRUNE);
+    CHECK_CALL(DTPruneTree(&context, &dataset, tree));
+    PROFILE_END(PHASE_PRUNE);
 
     count = CountNodes(tree);
     
@@ -377,7 +622,7 @@ int main(int argc, char *argv[])
       printf("\nPruning reduced the tree size from %d to %d nodes\n",prev_count,count);
 
       //PrintSection("Printing PRUNED decision tree");
-      //PrintDecisionTreeStructure(tree, &ssvinfo);
+      //PrintDecisionTreeStructure(tree, ssvinfo);
 
     } else {
       
@@ -388,13 +633,36 @@ int main(int argc, char *argv[])
     /* Print the statistics again, for comparison */
 
     PrintSection("Computing decision tree statistics after pruning");  
-    PrintStats(tree, data, num_data, train_members, num_train, test_members, num_test, &ssvinfo);
+    PROFILE_BEGIN(PHASE_STATS);
+    CHECK_CALL(DTPrintStats(&context, tree, &dataset));
+    PROFILE_END(PHASE_STATS);
+
+  }
+
+  /* Sweep the decision threshold over the test set, classifying it once
+     for all thresholds. */
+  if (ssvinfo->roc_filename != NULL || ssvinfo->thresholds != NULL) {
+    PrintSection("Sweeping the decision threshold over the test set");
+    if (dataset.num_test > 0) {
+      PROFILE_BEGIN(PHASE_STATS);
+      CHECK_CALL(DTPrintROC(&context, tree, &dataset));
+      PROFILE_END(PHASE_STATS);
+    } else {
+      printf("No test examples\n");
+    }
+  }
 
+  /* Time the classification of the test set alone, which PrintStats()
+     mixes with the per-depth statistics. */
+  if (profiling && dataset.num_test > 0) {
+    ProfileBegin(PHASE_PREDICT);
+    CHECK_CALL(DTAccuracy(&context, tree, &dataset, dataset.test_members,
+			  dataset.num_test, &accuracy));
+    ProfileEnd(PHASE_PREDICT);
   }
 
-  free(train_members);
-  free(test_members);
-  free(prune_members);
+  DTFreeTree(tree);
+  DTFreeData(&dataset);
   exit(0);
 }
 
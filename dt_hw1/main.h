@@ -1,21 +0,0 @@
-/**************************************************************************
- *
- * main.h
- *
- * Header file to main.c
- *
- * (C) 1999 Dan Foygel (dfoygel@cs.cmu.edu)
- * Carnegie Mellon University
- * 
- * Based heavily on code written by Dimitris Margaritis (dmarg@cs.cmu.edu)
- *
- **************************************************************************/
-
-#ifndef MAIN_H
-#define MAIN_H 1
-
-/* Protorypes for functions. */
-extern char *my_strdup(char *s);
-extern char *my_strndup(char *s, int n);
-#endif // MAIN_H
-/**************************************************************************/
@@ -0,0 +1,827 @@
+/**************************************************************************
+ *
+ * memberset.c
+ *
+ * Source file containing routines to build and combine compressed sets
+ * of examples (see memberset.h).
+ *
+ **************************************************************************/
+
+#include <string.h>
+#include "memberset.h"
+
+#define BITMAP_BYTES (MEMBERSET_BITMAP_WORDS * sizeof(unsigned long long))
+
+/* ......................................................................
+
+   Make sure a container has room for "num_shorts" elements.
+
+   ...................................................................... */
+
+static void GrowElems(CONTAINER *container, int num_shorts, int tag)
+{
+  if (num_shorts <= container->max_elems)
+    return;
+  container->max_elems = MAX(num_shorts, MAX(8, 2 * container->max_elems));
+  if (container->elems == NULL)
+    container->elems = (unsigned short *)
+      getmem_tag(container->max_elems * sizeof(unsigned short), tag);
+  else
+    container->elems = (unsigned short *)
+      regetmem(container->elems,
+	       container->max_elems * sizeof(unsigned short));
+}
+
+/* ......................................................................
+
+   Release the members of a container.
+
+   ...................................................................... */
+
+static void ClearContainer(CONTAINER *container)
+{
+  freemem(container->elems);
+  freemem(container->bitmap);
+  container->elems = (unsigned short *) NULL;
+  container->bitmap = (unsigned long long *) NULL;
+  container->num_elems = container->max_elems = 0;
+  container->cardinality = 0;
+}
+
+/* ......................................................................
+
+   Copy the members of a container into "to".
+
+   ...................................................................... */
+
+static void CopyContainer(CONTAINER *from, CONTAINER *to, int tag)
+{
+  int num_shorts;
+
+  *to = *from;
+  to->elems = (unsigned short *) NULL;
+  to->bitmap = (unsigned long long *) NULL;
+  to->max_elems = 0;
+  if (from->kind == CONTAINER_BITMAP) {
+    to->bitmap = (unsigned long long *) getmem_tag(BITMAP_BYTES, tag);
+    memcpy(to->bitmap, from->bitmap, BITMAP_BYTES);
+  } else {
+    num_shorts = (from->kind == CONTAINER_RUNS) ? 2 * from->num_elems :
+      from->num_elems;
+    GrowElems(to, num_shorts, tag);
+    memcpy(to->elems, from->elems, num_shorts * sizeof(unsigned short));
+  }
+}
+
+/* ......................................................................
+
+   Turn a container into a bitmap container.
+
+   ...................................................................... */
+
+static void ToBitmap(CONTAINER *container, int tag)
+{
+  unsigned long long *bitmap;
+  int i, offset, last;
+
+  if (container->kind == CONTAINER_BITMAP)
+    return;
+  bitmap = (unsigned long long *) getmem_tag(BITMAP_BYTES, tag);
+  memset(bitmap, 0, BITMAP_BYTES);
+  if (container->kind == CONTAINER_ARRAY) {
+    for (i = 0; i < container->num_elems; i++)
+      bitmap[container->elems[i] >> 6] |= 1ULL << (container->elems[i] & 63);
+  } else {
+    for (i = 0; i < container->num_elems; i++) {
+      last = container->elems[2 * i] + container->elems[2 * i + 1];
+      for (offset = container->elems[2 * i]; offset <= last; offset++)
+	bitmap[offset >> 6] |= 1ULL << (offset & 63);
+    }
+  }
+  freemem(container->elems);
+  container->elems = (unsigned short *) NULL;
+  container->num_elems = container->max_elems = 0;
+  container->bitmap = bitmap;
+  container->kind = CONTAINER_BITMAP;
+}
+
+/* ......................................................................
+
+   Write the members of a container, in increasing order, to "offsets".
+
+   ...................................................................... */
+
+static void ContainerOffsets(CONTAINER *container, unsigned short *offsets)
+{
+  unsigned long long word;
+  int i, n = 0, offset, last;
+
+  switch (container->kind) {
+  case CONTAINER_ARRAY:
+    memcpy(offsets, container->elems,
+	   container->num_elems * sizeof(unsigned short));
+    break;
+  case CONTAINER_BITMAP:
+    for (i = 0; i < MEMBERSET_BITMAP_WORDS; i++)
+      for (word = container->bitmap[i]; word != 0; word &= word - 1)
+	offsets[n++] = (i << 6) + __builtin_ctzll(word);
+    break;
+  default:
+    for (i = 0; i < container->num_elems; i++) {
+      last = container->elems[2 * i] + container->elems[2 * i + 1];
+      for (offset = container->elems[2 * i]; offset <= last; offset++)
+	offsets[n++] = offset;
+    }
+  }
+}
+
+/* ......................................................................
+
+   Count the runs of consecutive members of a container.
+
+   ...................................................................... */
+
+static int CountRuns(CONTAINER *container)
+{
+  unsigned long long word, prev_top = 0;
+  int i, num_runs = 0;
+
+  switch (container->kind) {
+  case CONTAINER_ARRAY:
+    for (i = 0; i < container->num_elems; i++)
+      num_runs +=
+	(i == 0 || container->elems[i] != container->elems[i - 1] + 1);
+    return num_runs;
+  case CONTAINER_BITMAP:
+    /* A run starts at every member whose lower neighbour is not one. */
+    for (i = 0; i < MEMBERSET_BITMAP_WORDS; i++) {
+      word = container->bitmap[i];
+      num_runs += __builtin_popcountll(word & ~((word << 1) | prev_top));
+      prev_top = word >> 63;
+    }
+    return num_runs;
+  default:
+    return container->num_elems;
+  }
+}
+
+/* ......................................................................
+
+   Rebuild a container in the kind that takes the least memory: runs if
+   there are few enough of them, else an array or a bitmap depending on
+   the number of members.
+
+   ...................................................................... */
+
+static void OptimizeContainer(CONTAINER *container, int tag)
+{
+  unsigned short *offsets;
+  int num_runs, kind, i, n;
+
+  num_runs = CountRuns(container);
+  if (4 * num_runs < MIN(2 * container->cardinality, (int) BITMAP_BYTES))
+    kind = CONTAINER_RUNS;
+  else if (container->cardinality <= MEMBERSET_ARRAY_MAX)
+    kind = CONTAINER_ARRAY;
+  else
+    kind = CONTAINER_BITMAP;
+  if (kind == container->kind)
+    return;
+  if (kind == CONTAINER_BITMAP) {
+    ToBitmap(container, tag);
+    return;
+  }
+
+  offsets = (unsigned short *)
+    getmem_tag(container->cardinality * sizeof(unsigned short), tag);
+  ContainerOffsets(container, offsets);
+  n = container->cardinality;
+  ClearContainer(container);
+  container->cardinality = n;
+  container->kind = kind;
+  if (kind == CONTAINER_ARRAY) {
+    container->elems = offsets;
+    container->num_elems = container->max_elems = n;
+    return;
+  }
+  GrowElems(container, 2 * num_runs, tag);
+  for (i = 0; i < n; i++) {
+    if (i == 0 || offsets[i] != offsets[i - 1] + 1) {
+      container->elems[2 * container->num_elems] = offsets[i];
+      container->elems[2 * container->num_elems + 1] = 0;
+      container->num_elems++;
+    } else {
+      container->elems[2 * container->num_elems - 1]++;
+    }
+  }
+  freemem(offsets);
+}
+
+/* ......................................................................
+
+   Return the container of a chunk, adding an empty array container for
+   it if there is none.
+
+   ...................................................................... */
+
+static CONTAINER *FindContainer(MEMBERSET *set, int key)
+{
+  CONTAINER *container;
+  int low, high, mid;
+
+  /* Sets are mostly built in increasing order. */
+  low = set->num_containers;
+  if (low > 0 && set->containers[low - 1].key >= key) {
+    low = 0;
+    high = set->num_containers - 1;
+    while (low <= high) {
+      mid = (low + high) / 2;
+      if (set->containers[mid].key < key)
+	low = mid + 1;
+      else if (set->containers[mid].key > key)
+	high = mid - 1;
+      else
+	return set->containers + mid;
+    }
+  }
+
+  if (set->num_containers == set->max_containers) {
+    set->max_containers = MAX(4, 2 * set->max_containers);
+    if (set->containers == NULL)
+      set->containers = (CONTAINER *)
+	getmem_tag(set->max_containers * sizeof(CONTAINER), set->tag);
+    else
+      set->containers = (CONTAINER *)
+	regetmem(set->containers, set->max_containers * sizeof(CONTAINER));
+  }
+  memmove(set->containers + low + 1, set->containers + low,
+	  (set->num_containers - low) * sizeof(CONTAINER));
+  set->num_containers++;
+  container = set->containers + low;
+  memset(container, 0, sizeof(CONTAINER));
+  container->key = key;
+  container->kind = CONTAINER_ARRAY;
+
+  return container;
+}
+
+/* ----------------------------------------------------------------------
+
+   Create an empty set, whose memory is accounted to "tag".
+
+   ---------------------------------------------------------------------- */
+
+MEMBERSET *NewMemberSet(int tag)
+{
+  MEMBERSET *set;
+
+  set = (MEMBERSET *) getmem_tag(sizeof(MEMBERSET), tag);
+  set->num_containers = set->max_containers = 0;
+  set->containers = (CONTAINER *) NULL;
+  set->cardinality = 0;
+  set->tag = tag;
+
+  return set;
+}
+
+/* ----------------------------------------------------------------------
+
+   Create the set of rows "first" to "last" (none if "last" < "first").
+
+   ---------------------------------------------------------------------- */
+
+MEMBERSET *NewMemberRange(long first, long last, int tag)
+{
+  MEMBERSET *set;
+
+  set = NewMemberSet(tag);
+  AddMemberRange(set, first, last);
+
+  return set;
+}
+
+/* ----------------------------------------------------------------------
+
+   Release a set.
+
+   ---------------------------------------------------------------------- */
+
+void FreeMemberSet(MEMBERSET *set)
+{
+  int i;
+
+  if (set == NULL)
+    return;
+  for (i = 0; i < set->num_containers; i++)
+    ClearContainer(set->containers + i);
+  freemem(set->containers);
+  freemem(set);
+}
+
+/* ----------------------------------------------------------------------
+
+   Copy a set.
+
+   ---------------------------------------------------------------------- */
+
+MEMBERSET *CopyMemberSet(MEMBERSET *set, int tag)
+{
+  MEMBERSET *copy;
+  int i;
+
+  copy = NewMemberSet(tag);
+  copy->max_containers = copy->num_containers = set->num_containers;
+  copy->cardinality = set->cardinality;
+  if (set->num_containers == 0)
+    return copy;
+  copy->containers = (CONTAINER *)
+    getmem_tag(set->num_containers * sizeof(CONTAINER), tag);
+  for (i = 0; i < set->num_containers; i++) {
+    CopyContainer(set->containers + i, copy->containers + i, tag);
+  }
+
+  return copy;
+}
+
+/* ----------------------------------------------------------------------
+
+   Add a row to a set.  Adding rows in increasing order is the fastest.
+
+   ---------------------------------------------------------------------- */
+
+void AddMember(MEMBERSET *set, long row)
+{
+  CONTAINER *container;
+  unsigned short offset = row & (MEMBERSET_CHUNK - 1);
+  unsigned long long bit;
+  int low, high, mid, n, end;
+
+  container = FindContainer(set, (int) (row >> MEMBERSET_CHUNK_BITS));
+  if (container->kind == CONTAINER_RUNS) {
+    /* The offset just past the last run. */
+    n = container->num_elems;
+    end = container->elems[2 * n - 2] + container->elems[2 * n - 1] + 1;
+    if (offset == end) {
+      container->elems[2 * n - 1]++;
+      container->cardinality++;
+      set->cardinality++;
+      return;
+    }
+    if (offset > end) {
+      GrowElems(container, 2 * n + 2, set->tag);
+      container->elems[2 * n] = offset;
+      container->elems[2 * n + 1] = 0;
+      container->num_elems++;
+      container->cardinality++;
+      set->cardinality++;
+      return;
+    }
+    ToBitmap(container, set->tag);
+  }
+
+  if (container->kind == CONTAINER_ARRAY) {
+    n = container->num_elems;
+    if (n == 0 || container->elems[n - 1] < offset) {
+      low = n;
+    } else {
+      low = 0;
+      high = n - 1;
+      while (low <= high) {
+	mid = (low + high) / 2;
+	if (container->elems[mid] < offset)
+	  low = mid + 1;
+	else if (container->elems[mid] > offset)
+	  high = mid - 1;
+	else
+	  return;
+      }
+    }
+    if (n < MEMBERSET_ARRAY_MAX) {
+      GrowElems(container, n + 1, set->tag);
+      memmove(container->elems + low + 1, container->elems + low,
+	      (n - low) * sizeof(unsigned short));
+      container->elems[low] = offset;
+      container->num_elems++;
+      container->cardinality++;
+      set->cardinality++;
+      return;
+    }
+    ToBitmap(container, set->tag);
+  }
+
+  bit = 1ULL << (offset & 63);
+  if (!(container->bitmap[offset >> 6] & bit)) {
+    container->bitmap[offset >> 6] |= bit;
+    container->cardinality++;
+    set->cardinality++;
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Add rows "first" to "last" to a set.  Chunks with no members yet get a
+   single run.
+
+   ---------------------------------------------------------------------- */
+
+void AddMemberRange(MEMBERSET *set, long first, long last)
+{
+  CONTAINER *container;
+  long start, end, row;
+
+  for (start = first; start <= last; start = end + 1) {
+    end = MIN(last, (start | (MEMBERSET_CHUNK - 1)));
+    container = FindContainer(set, (int) (start >> MEMBERSET_CHUNK_BITS));
+    if (container->cardinality == 0) {
+      container->kind = CONTAINER_RUNS;
+      GrowElems(container, 2, set->tag);
+      container->elems[0] = (unsigned short) (start & (MEMBERSET_CHUNK - 1));
+      container->elems[1] = (unsigned short) (end - start);
+      container->num_elems = 1;
+      container->cardinality = (int) (end - start + 1);
+      set->cardinality += end - start + 1;
+    } else {
+      for (row = start; row <= end; row++)
+	AddMember(set, row);
+    }
+    if (end == last)            /* Do not step past the largest long. */
+      break;
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Return 1 if a row is a member of a set, 0 otherwise.
+
+   ---------------------------------------------------------------------- */
+
+int IsMember(MEMBERSET *set, long row)
+{
+  CONTAINER *container;
+  int key = (int) (row >> MEMBERSET_CHUNK_BITS);
+  int offset = row & (MEMBERSET_CHUNK - 1);
+  int low, high, mid;
+
+  low = 0;
+  high = set->num_containers - 1;
+  container = (CONTAINER *) NULL;
+  while (low <= high) {
+    mid = (low + high) / 2;
+    if (set->containers[mid].key < key)
+      low = mid + 1;
+    else if (set->containers[mid].key > key)
+      high = mid - 1;
+    else {
+      container = set->containers + mid;
+      break;
+    }
+  }
+  if (container == NULL)
+    return 0;
+
+  switch (container->kind) {
+  case CONTAINER_BITMAP:
+    return (container->bitmap[offset >> 6] >> (offset & 63)) & 1;
+  case CONTAINER_ARRAY:
+    low = 0;
+    high = container->num_elems - 1;
+    while (low <= high) {
+      mid = (low + high) / 2;
+      if (container->elems[mid] < offset)
+	low = mid + 1;
+      else if (container->elems[mid] > offset)
+	high = mid - 1;
+      else
+	return 1;
+    }
+    return 0;
+  default:
+    /* The last run starting at or before the offset. */
+    low = 0;
+    high = container->num_elems - 1;
+    while (low <= high) {
+      mid = (low + high) / 2;
+      if (container->elems[2 * mid] <= offset)
+	low = mid + 1;
+      else
+	high = mid - 1;
+    }
+    return (high >= 0 && offset <= (container->elems[2 * high] +
+				     container->elems[2 * high + 1]));
+  }
+}
+
+/* ......................................................................
+
+   Combine two containers of the same chunk into "to" (empty), keeping the
+   members of both ("both" set) or of either.
+
+   ...................................................................... */
+
+static void CombineContainers(CONTAINER *a, CONTAINER *b, CONTAINER *to,
+			      int both, int tag)
+{
+  unsigned long long *bits_a, *bits_b, *bitmap;
+  CONTAINER temp_a, temp_b;
+  int i;
+
+  /* Small arrays are intersected directly. */
+  if (both && a->kind == CONTAINER_ARRAY && b->kind == CONTAINER_ARRAY) {
+    int ia = 0, ib = 0;
+
+    GrowElems(to, MAX(MIN(a->num_elems, b->num_elems), 1), tag);
+    while (ia < a->num_elems && ib < b->num_elems) {
+      if (a->elems[ia] < b->elems[ib])
+	ia++;
+      else if (a->elems[ia] > b->elems[ib])
+	ib++;
+      else {
+	to->elems[to->num_elems++] = a->elems[ia];
+	ia++;
+	ib++;
+      }
+    }
+    to->kind = CONTAINER_ARRAY;
+    to->cardinality = to->num_elems;
+    return;
+  }
+
+  /* Containers of other kinds are seen through a bitmap copy. */
+  if (a->kind != CONTAINER_BITMAP) {
+    CopyContainer(a, &temp_a, tag);
+    ToBitmap(&temp_a, tag);
+    bits_a = temp_a.bitmap;
+  } else {
+    bits_a = a->bitmap;
+  }
+  if (b->kind != CONTAINER_BITMAP) {
+    CopyContainer(b, &temp_b, tag);
+    ToBitmap(&temp_b, tag);
+    bits_b = temp_b.bitmap;
+  } else {
+    bits_b = b->bitmap;
+  }
+
+  bitmap = (unsigned long long *) getmem_tag(BITMAP_BYTES, tag);
+  to->cardinality = 0;
+  for (i = 0; i < MEMBERSET_BITMAP_WORDS; i++) {
+    bitmap[i] = both ? (bits_a[i] & bits_b[i]) : (bits_a[i] | bits_b[i]);
+    to->cardinality += __builtin_popcountll(bitmap[i]);
+  }
+  to->kind = CONTAINER_BITMAP;
+  to->bitmap = bitmap;
+  if (a->kind != CONTAINER_BITMAP)
+    ClearContainer(&temp_a);
+  if (b->kind != CONTAINER_BITMAP)
+    ClearContainer(&temp_b);
+  OptimizeContainer(to, tag);
+}
+
+/* ......................................................................
+
+   Combine two sets into a new one, with the members of both or of either.
+
+   ...................................................................... */
+
+static MEMBERSET *CombineMemberSets(MEMBERSET *a, MEMBERSET *b, int both,
+				    int tag)
+{
+  MEMBERSET *set;
+  CONTAINER *to, *from;
+  int ia = 0, ib = 0;
+
+  set = NewMemberSet(tag);
+  while (ia < a->num_containers || ib < b->num_containers) {
+    if (ib == b->num_containers ||
+	(ia < a->num_containers &&
+	 a->containers[ia].key < b->containers[ib].key)) {
+      from = a->containers + ia++;
+    } else if (ia == a->num_containers ||
+	       b->containers[ib].key < a->containers[ia].key) {
+      from = b->containers + ib++;
+    } else {
+      to = FindContainer(set, a->containers[ia].key);
+      CombineContainers(a->containers + ia, b->containers + ib, to, both,
+			tag);
+      ia++;
+      ib++;
+      if (to->cardinality == 0) {
+	ClearContainer(to);
+	set->num_containers--;
+      }
+      set->cardinality += to->cardinality;
+      continue;
+    }
+
+    /* A chunk of only one of the sets. */
+    if (both)
+      continue;
+    to = FindContainer(set, from->key);
+    CopyContainer(from, to, tag);
+    set->cardinality += to->cardinality;
+  }
+
+  return set;
+}
+
+/* ----------------------------------------------------------------------
+
+   Return a new set with the rows that are members of both sets.
+
+   ---------------------------------------------------------------------- */
+
+MEMBERSET *IntersectMemberSets(MEMBERSET *a, MEMBERSET *b, int tag)
+{
+  return CombineMemberSets(a, b, 1, tag);
+}
+
+/* ----------------------------------------------------------------------
+
+   Return a new set with the rows that are members of either set.
+
+   ---------------------------------------------------------------------- */
+
+MEMBERSET *UnionMemberSets(MEMBERSET *a, MEMBERSET *b, int tag)
+{
+  return CombineMemberSets(a, b, 0, tag);
+}
+
+/* ----------------------------------------------------------------------
+
+   Compress a dense bitarray of "num_data" rows into a set.
+
+   ---------------------------------------------------------------------- */
+
+MEMBERSET *MemberSetFromBitarray(uchar *bitarray, long num_data, int tag)
+{
+  MEMBERSET *set;
+  long row;
+
+  set = NewMemberSet(tag);
+  for (row = 0; row < num_data; row++)
+    if (READ_BITARRAY(bitarray, row))
+      AddMember(set, row);
+  OptimizeMemberSet(set);
+
+  return set;
+}
+
+/* ----------------------------------------------------------------------
+
+   Rebuild every container of a set in the kind that takes the least
+   memory (runs only pay off for rows in ranges, which AddMember() does
+   not look for).
+
+   ---------------------------------------------------------------------- */
+
+void OptimizeMemberSet(MEMBERSET *set)
+{
+  int i;
+
+  for (i = 0; i < set->num_containers; i++)
+    OptimizeContainer(set->containers + i, set->tag);
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the bytes of memory a set takes.
+
+   ---------------------------------------------------------------------- */
+
+long MemberSetBytes(MEMBERSET *set)
+{
+  long bytes;
+  int i;
+
+  bytes = sizeof(MEMBERSET) + set->max_containers * sizeof(CONTAINER);
+  for (i = 0; i < set->num_containers; i++)
+    bytes += (set->containers[i].kind == CONTAINER_BITMAP) ? BITMAP_BYTES :
+      set->containers[i].max_elems * sizeof(unsigned short);
+
+  return bytes;
+}
+
+/* ......................................................................
+
+   Auxiliary functions of CountMemberBits().  Word "word" of a bit array
+   holds its bits 64 * word to 64 * word + 63, the lowest first, as a
+   bitmap container does.
+
+   ...................................................................... */
+
+static inline unsigned long long LoadBitWord(uchar *bits, long word)
+{
+  unsigned long long value;
+
+  memcpy(&value, bits + word * sizeof(value), sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64(value);
+#endif
+  return value;
+}
+
+static inline void CountWordBits(uchar *a, uchar *b, long word,
+				 unsigned long long mask, long counts[3])
+{
+  unsigned long long word_a, word_b;
+
+  word_a = LoadBitWord(a, word) & mask;
+  counts[0] += __builtin_popcountll(word_a);
+  if (b != NULL) {
+    word_b = LoadBitWord(b, word) & mask;
+    counts[1] += __builtin_popcountll(word_b);
+    counts[2] += __builtin_popcountll(word_a & word_b);
+  }
+}
+
+static void CountRangeBits(uchar *a, uchar *b, long first, long last,
+			   long counts[3])
+{
+  long word, first_word = first >> 6, last_word = last >> 6;
+  unsigned long long mask;
+
+  for (word = first_word; word <= last_word; word++) {
+    mask = ~0ULL;
+    if (word == first_word)
+      mask &= ~0ULL << (first & 63);
+    if (word == last_word)
+      mask &= ~0ULL >> (63 - (last & 63));
+    CountWordBits(a, b, word, mask, counts);
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Count the members of a set (all of rows 0 to "num_rows" - 1 if "set" is
+   NULL) whose bit is set in the bit array "a" (counts[0]), in the bit
+   array "b" (counts[1]), and in both (counts[2]); "b" may be NULL, for
+   counts[0] alone.  Runs and bitmap containers are counted a word of 64
+   rows at a time, so the bit arrays must be readable in whole words up to
+   that of row "num_rows" - 1, as the binary columns of a data set are
+   (see DT_COLUMN_ALIGN in auxi.h).
+
+   ---------------------------------------------------------------------- */
+
+void CountMemberBits(MEMBERSET *set, long num_rows, uchar *a, uchar *b,
+		     long counts[3])
+{
+  CONTAINER *container;
+  long base, row, first;
+  int i, bit_a, bit_b, num_words;
+
+  counts[0] = counts[1] = counts[2] = 0;
+  if (set == NULL) {
+    if (num_rows > 0)
+      CountRangeBits(a, b, 0, num_rows - 1, counts);
+    return;
+  }
+
+  for (container = set->containers;
+       container < set->containers + set->num_containers; container++) {
+    base = (long) container->key << MEMBERSET_CHUNK_BITS;
+    switch (container->kind) {
+    case CONTAINER_ARRAY:
+      for (i = 0; i < container->num_elems; i++) {
+	row = base + container->elems[i];
+	bit_a = READ_BITARRAY(a, row);
+	counts[0] += bit_a;
+	if (b != NULL) {
+	  bit_b = READ_BITARRAY(b, row);
+	  counts[1] += bit_b;
+	  counts[2] += bit_a & bit_b;
+	}
+      }
+      break;
+    case CONTAINER_BITMAP:
+      num_words = MIN(MEMBERSET_BITMAP_WORDS, (num_rows - base + 63) >> 6);
+      for (i = 0; i < num_words; i++)
+	if (container->bitmap[i] != 0)
+	  CountWordBits(a, b, (base >> 6) + i, container->bitmap[i], counts);
+      break;
+    default:
+      for (i = 0; i < container->num_elems; i++) {
+	first = base + container->elems[2 * i];
+	CountRangeBits(a, b, first, first + container->elems[2 * i + 1],
+		       counts);
+      }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Start a visit of the members of a set (see FOR_EACH_MEMBER()).
+
+   ---------------------------------------------------------------------- */
+
+void StartMembers(MEMBERITER *iter, MEMBERSET *set)
+{
+  iter->set = set;
+  iter->container = 0;
+  iter->word = 0;
+  iter->next = 1;
+  iter->last = 0;
+  EnterContainer(iter);
+}
+
+/**************************************************************************/
@@ -0,0 +1,171 @@
+/**************************************************************************
+ *
+ * memberset.h
+ *
+ * Header file to memberset.c
+ *
+ **************************************************************************/
+
+#ifndef MEMBERSET_H
+#define MEMBERSET_H 1
+
+#include "auxi.h"
+#include "bitarray.h"
+
+/* A set of examples (rows of a data set), such as the training set or the
+   members of a node, compressed after Roaring bitmaps.  The rows are cut
+   in chunks of MEMBERSET_CHUNK, and the members of every chunk that has
+   any are held by a container of the kind that suits them: a sorted array
+   of their offsets in the chunk while there are at most
+   MEMBERSET_ARRAY_MAX of them, a bitmap of the whole chunk when there are
+   more, or runs of consecutive rows, as for a set read from a file of its
+   own.  A set costs about two bytes per member when sparse, an eighth of a
+   byte per row when dense, and next to nothing when made of ranges,
+   instead of an eighth of a byte per row of the data set always.
+
+   Members are visited in increasing order with FOR_EACH_MEMBER(), at a
+   cost in the number of members rather than of rows.  Sets are built the
+   fastest by adding members in increasing order. */
+
+#define MEMBERSET_CHUNK_BITS 16
+#define MEMBERSET_CHUNK (1 << MEMBERSET_CHUNK_BITS)
+#define MEMBERSET_ARRAY_MAX 4096
+#define MEMBERSET_BITMAP_WORDS (MEMBERSET_CHUNK / 64)
+
+/* Kinds of containers. */
+#define CONTAINER_ARRAY  0
+#define CONTAINER_BITMAP 1
+#define CONTAINER_RUNS   2
+
+/* The members of one chunk.  Rows are longs, so that a set may hold rows
+   beyond 2^31; a chunk number still fits an int. */
+typedef struct container {
+  int key;                      /* The chunk: rows key * MEMBERSET_CHUNK
+				   and up. */
+  int kind;
+  int cardinality;
+  int num_elems;                /* Offsets of an array, or runs. */
+  int max_elems;                /* Room for elements in "elems". */
+  unsigned short *elems;        /* Sorted offsets of an array container,
+				   or the (first offset, length - 1) pair of
+				   every run, in increasing order. */
+  unsigned long long *bitmap;   /* Bitmap container, MEMBERSET_BITMAP_WORDS
+				   words. */
+} CONTAINER;
+
+typedef struct memberset {
+  int num_containers;           /* Containers, in increasing order of */
+  int max_containers;           /* their keys. */
+  CONTAINER *containers;
+  long cardinality;
+  int tag;                      /* Memory tag, see getmem_tag(). */
+} MEMBERSET;
+
+/* Position of a visit of the members of a set (see FOR_EACH_MEMBER()). */
+typedef struct memberiter {
+  MEMBERSET *set;
+  int container;                /* Index of the container visited. */
+  int pos;                      /* Next offset or run of an array or runs
+				   container, or word of a bitmap. */
+  long base;                    /* First row of the chunk. */
+  long next, last;              /* Rest of the run being visited. */
+  unsigned long long word;      /* Members left in the word of a bitmap. */
+} MEMBERITER;
+
+/* Visit the members of "set" in increasing order, setting "row" (a long)
+   to each; "iter" is a MEMBERITER of the caller.  The set must not change
+   during the visit. */
+#define FOR_EACH_MEMBER(iter, set, row)					\
+  for (StartMembers(&(iter), (set)); ((row) = NextMember(&(iter))) >= 0; )
+
+/* Function prototypes. */
+MEMBERSET *NewMemberSet(int tag);
+MEMBERSET *NewMemberRange(long first, long last, int tag);
+MEMBERSET *CopyMemberSet(MEMBERSET *set, int tag);
+MEMBERSET *MemberSetFromBitarray(uchar *bitarray, long num_data, int tag);
+void FreeMemberSet(MEMBERSET *set);
+void AddMember(MEMBERSET *set, long row);
+void AddMemberRange(MEMBERSET *set, long first, long last);
+int IsMember(MEMBERSET *set, long row);
+MEMBERSET *IntersectMemberSets(MEMBERSET *a, MEMBERSET *b, int tag);
+MEMBERSET *UnionMemberSets(MEMBERSET *a, MEMBERSET *b, int tag);
+void OptimizeMemberSet(MEMBERSET *set);
+long MemberSetBytes(MEMBERSET *set);
+void CountMemberBits(MEMBERSET *set, long num_rows, uchar *a, uchar *b,
+		     long counts[3]);
+void StartMembers(MEMBERITER *iter, MEMBERSET *set);
+
+/* Number of members of a set. */
+#define MEMBERSET_CARDINALITY(set) ((set)->cardinality)
+
+/* ......................................................................
+
+   Move a visit on to the next container, and set up the visit of its
+   members.
+
+   ...................................................................... */
+
+static inline void EnterContainer(MEMBERITER *iter)
+{
+  CONTAINER *container;
+
+  if (iter->container >= iter->set->num_containers)
+    return;
+  container = iter->set->containers + iter->container;
+  iter->base = (long) container->key << MEMBERSET_CHUNK_BITS;
+  iter->pos = 0;
+  if (container->kind == CONTAINER_BITMAP) {
+    iter->word = container->bitmap[0];
+  } else if (container->kind == CONTAINER_RUNS) {
+    iter->next = container->elems[0];
+    iter->last = container->elems[0] + container->elems[1];
+    iter->pos = 1;
+  }
+}
+
+/* ......................................................................
+
+   Return the next member of a visit, or -1 if there are no more.
+
+   ...................................................................... */
+
+static inline long NextMember(MEMBERITER *iter)
+{
+  CONTAINER *container;
+
+  while (iter->container < iter->set->num_containers) {
+    container = iter->set->containers + iter->container;
+    switch (container->kind) {
+    case CONTAINER_ARRAY:
+      if (iter->pos < container->num_elems)
+	return iter->base + container->elems[iter->pos++];
+      break;
+    case CONTAINER_BITMAP:
+      while (iter->word == 0 && ++iter->pos < MEMBERSET_BITMAP_WORDS)
+	iter->word = container->bitmap[iter->pos];
+      if (iter->word != 0) {
+	int bit = __builtin_ctzll(iter->word);
+
+	iter->word &= iter->word - 1;
+	return iter->base + (iter->pos << 6) + bit;
+      }
+      break;
+    default:
+      if (iter->next <= iter->last)
+	return iter->base + iter->next++;
+      if (iter->pos < container->num_elems) {
+	iter->next = container->elems[2 * iter->pos];
+	iter->last = iter->next + container->elems[2 * iter->pos + 1];
+	iter->pos++;
+	continue;
+      }
+    }
+    iter->container++;
+    EnterContainer(iter);
+  }
+
+  return -1;
+}
+
+#endif // MEMBERSET_H
+/**************************************************************************/
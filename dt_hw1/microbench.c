@@ -0,0 +1,432 @@
+/**************************************************************************
+ *
+ * microbench.c
+ *
+ * Micro-benchmarks of the hot primitives of the learner (bit arrays,
+ * entropy and split kernels, tree evaluation) on synthetic inputs of a
+ * controlled size.
+ *
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "auxi.h"
+#include "bitarray.h"
+#include "dt.h"
+#include "entropy.h"
+#include "grow.h"
+#include "prune-dt.h"
+#include "score-dt.h"
+#include "ssv.h"
+
+#define USAGE "\nTime the hot primitives of dt on synthetic data.\n\n"	\
+              "Usage: %s [-n <rows>] [-r <repetitions>] [-w <warmup>] "	\
+              "[-k <values>] [-c <bytes>] [-s <seed>] [<kernel> ...]\n\n" \
+              "  -n  rows of the synthetic data set (default 1000000)\n" \
+              "  -r  timed repetitions of every kernel (default 10)\n"	\
+              "  -w  untimed warmup repetitions (default 2)\n"		\
+              "  -k  values of the discrete attribute (default 16)\n"	\
+              "  -c  bytes per continuous value, 8 or 4 (default 8)\n" \
+              "  -s  random seed (default 1)\n\n"			\
+              "Without kernel names, all kernels are timed.\n\n"
+
+/* Columns of the synthetic data set. */
+#define COL_LABEL      0
+#define COL_BINARY     1
+#define COL_DISCRETE   2
+#define COL_CONTINUOUS 3
+#define NUM_COLUMNS    4
+
+/* Depth of the tree evaluated by the check_correctness and quick_score
+   kernels. */
+#define BENCH_TREE_DEPTH 10
+
+/* Everything a kernel needs. */
+typedef struct benchdata {
+  void **data;                  /* Synthetic data set. */
+  long num_data;
+  uchar *members;               /* About half of the examples. */
+  MEMBERSET *member_set;        /* The same, as a member set. */
+  long num_members;
+  uchar *scratch;               /* Bit array written by the kernels. */
+  DTNODE *tree;                 /* Tree for the check_correctness kernel. */
+  SCORER *scorer;               /* The same, compiled for quick_score. */
+  SSVINFO ssvinfo;
+} BENCHDATA;
+
+/* A kernel runs once over the data and returns a value depending on its
+   result, so that the work cannot be optimized away. */
+typedef double (*KERNEL)(BENCHDATA *bench);
+
+typedef struct benchmark {
+  char *name;
+  KERNEL kernel;
+  int per_row;                  /* Non-zero if one run handles num_data
+				   rows; otherwise one run is num_data
+				   calls. */
+} BENCHMARK;
+
+/* Sink for the kernel results. */
+static volatile double sink;
+
+/* ----------------------------------------------------------------------
+
+   The kernels.
+
+   ---------------------------------------------------------------------- */
+
+static double KernelReadBitarray(BENCHDATA *bench)
+{
+  long i, sum = 0;
+
+  for (i = 0; i < bench->num_data; i++)
+    sum += READ_BITARRAY(bench->members, i);
+  return sum;
+}
+
+static double KernelWriteBitarray(BENCHDATA *bench)
+{
+  long i;
+
+  for (i = 0; i < bench->num_data; i++)
+    WRITE_BITARRAY(bench->scratch, i, i & 1);
+  return bench->scratch[0];
+}
+
+static double KernelZeroBitarray(BENCHDATA *bench)
+{
+  ZERO_BITARRAY(bench->scratch, bench->num_data);
+  return bench->scratch[0];
+}
+
+static double KernelVisitMembers(BENCHDATA *bench)
+{
+  MEMBERITER iter;
+  long row, sum = 0;
+
+  FOR_EACH_MEMBER(iter, bench->member_set, row)
+    sum += row & 1;
+  return sum;
+}
+
+static double KernelCountExamples(BENCHDATA *bench)
+{
+  long num_pos, num_neg;
+
+  CountExamples(bench->data, bench->num_data,
+		bench->member_set, bench->num_members, &num_pos, &num_neg);
+  return num_pos;
+}
+
+static double KernelEntropy(BENCHDATA *bench)
+{
+  long i;
+  double sum = 0.0;
+
+  for (i = 0; i < bench->num_data; i++)
+    sum += Entropy((i & 1023) + 1, ((i >> 10) & 1023) + 1);
+  return sum;
+}
+
+static double KernelPartialBinary(BENCHDATA *bench)
+{
+  return PartialEntropyBinary(bench->data, bench->num_data,
+			      bench->member_set, bench->num_members,
+			      COL_BINARY, &bench->ssvinfo);
+}
+
+static double KernelPartialDiscrete(BENCHDATA *bench)
+{
+  return PartialEntropyDiscrete(bench->data, bench->num_data,
+				bench->member_set, bench->num_members,
+				COL_DISCRETE, &bench->ssvinfo);
+}
+
+static double KernelPartialSubset(BENCHDATA *bench)
+{
+  return PartialEntropySubset(bench->data, bench->num_data,
+			      bench->member_set, bench->num_members,
+			      COL_DISCRETE, bench->scratch, &bench->ssvinfo);
+}
+
+static double KernelPartialContinuous(BENCHDATA *bench)
+{
+  double threshold;
+
+  return PartialEntropyContinuous(bench->data, bench->num_data,
+				  bench->member_set, bench->num_members,
+				  COL_CONTINUOUS, &threshold);
+}
+
+static double KernelCheckCorrectness(BENCHDATA *bench)
+{
+  long example, num_correct = 0;
+
+  for (example = 0; example < bench->num_data; example++)
+    num_correct += CheckCorrectness(bench->tree, bench->data,
+				    bench->num_data, 0.5, example,
+				    &bench->ssvinfo, 0);
+  return num_correct;
+}
+
+static double KernelQuickScore(BENCHDATA *bench)
+{
+  long example, num_correct = 0;
+
+  for (example = 0; example < bench->num_data; example++)
+    num_correct += (ScoreExample(bench->scorer, bench->data, example) ==
+		    READ_BITARRAY(bench->data[COL_LABEL], example));
+  return num_correct;
+}
+
+static BENCHMARK benchmarks[] = {
+  { "read_bitarray",      KernelReadBitarray,      1 },
+  { "write_bitarray",     KernelWriteBitarray,     1 },
+  { "zero_bitarray",      KernelZeroBitarray,      1 },
+  { "visit_members",      KernelVisitMembers,      1 },
+  { "count_examples",     KernelCountExamples,     1 },
+  { "entropy",            KernelEntropy,           0 },
+  { "partial_binary",     KernelPartialBinary,     1 },
+  { "partial_discrete",   KernelPartialDiscrete,   1 },
+  { "partial_subset",     KernelPartialSubset,     1 },
+  { "partial_continuous", KernelPartialContinuous, 1 },
+  { "check_correctness",  KernelCheckCorrectness,  1 },
+  { "quick_score",        KernelQuickScore,        1 },
+  { NULL, NULL, 0 }
+};
+
+/* ----------------------------------------------------------------------
+
+   Store the discrete code and the continuous value of an example, in the
+   width of their columns (write_attrib_i() and write_attrib_c() are in
+   ssv.c, which is not linked in).
+
+   ---------------------------------------------------------------------- */
+
+static void WriteBenchRow(void **data, long example, int code, double value)
+{
+  switch (COLUMN_WIDTH(data[COL_DISCRETE])) {
+  case 1:
+    ((unsigned char *) data[COL_DISCRETE])[example] = code;
+    break;
+  case 2:
+    ((unsigned short *) data[COL_DISCRETE])[example] = code;
+    break;
+  default:
+    ((int *) data[COL_DISCRETE])[example] = code;
+  }
+  if (COLUMN_WIDTH(data[COL_CONTINUOUS]) == 4)
+    ((float *) data[COL_CONTINUOUS])[example] = value;
+  else
+    ((double *) data[COL_CONTINUOUS])[example] = value;
+}
+
+/* ----------------------------------------------------------------------
+
+   Create the synthetic data set: a label, and a binary, a discrete and a
+   continuous attribute, each of which predicts the label somewhat.
+
+   ---------------------------------------------------------------------- */
+
+static void CreateBenchData(BENCHDATA *bench, long num_data, int num_vals,
+			    int value_width)
+{
+  static char *names[NUM_COLUMNS] = { "label", "b", "d", "c" };
+  long example;
+  int label, val;
+  uchar *labels, *binary;
+
+  bench->data = (void **) getmem(NUM_COLUMNS * sizeof(void *));
+  bench->data[COL_LABEL] = labels =
+    getcolumn_tag(BITARRAY_BYTES(num_data), 1, MEM_MISC);
+  bench->data[COL_BINARY] = binary =
+    getcolumn_tag(BITARRAY_BYTES(num_data), 1, MEM_MISC);
+  bench->data[COL_DISCRETE] =
+    getcolumn_tag(num_data, DISCRETE_CODE_WIDTH(num_vals), MEM_MISC);
+  bench->data[COL_CONTINUOUS] =
+    getcolumn_tag(num_data, value_width, MEM_MISC);
+  bench->members = CREATE_BITARRAY(num_data);
+  bench->scratch = CREATE_BITARRAY(num_data);
+  bench->num_members = 0;
+
+  for (example = 0; example < num_data; example++) {
+    label = (random() & 1);
+    WRITE_BITARRAY(labels, example, label);
+    WRITE_BITARRAY(binary, example, (random() % 4 == 0) ? !label : label);
+    val = random() % num_vals;
+    val = (random() % 3 == 0) ? (val & ~1) | label : val;
+    WriteBenchRow(bench->data, example, val,
+		  label * 0.3 + (double) random() / RAND_MAX);
+    WRITE_BITARRAY(bench->members, example, random() & 1);
+    bench->num_members += READ_BITARRAY(bench->members, example);
+  }
+  bench->member_set = MemberSetFromBitarray(bench->members, num_data,
+					    MEM_MISC);
+
+  bench->num_data = num_data;
+
+  memset(&bench->ssvinfo, 0, sizeof(SSVINFO));
+  bench->ssvinfo.types = "bbdc";
+  bench->ssvinfo.feat_names = names;
+  bench->ssvinfo.num_discrete_vals =
+    (int *) getmem(NUM_COLUMNS * sizeof(int));
+  bench->ssvinfo.num_discrete_vals[COL_DISCRETE] = num_vals;
+  bench->ssvinfo.batch = 1;
+  bench->ssvinfo.grow_mode = GROW_LEVEL_WISE;
+  bench->ssvinfo.max_depth = BENCH_TREE_DEPTH;
+  bench->tree = CreateDecisionTreeLevelWise(bench->data, num_data,
+					    bench->member_set,
+					    bench->num_members,
+					    NUM_COLUMNS, &bench->ssvinfo);
+  bench->scorer = CompileDecisionTree(bench->tree, 0, 0.5, 0,
+				      &bench->ssvinfo, MEM_TREE);
+}
+
+/* ----------------------------------------------------------------------
+
+   Time "reps" runs of a kernel after "warmup" untimed ones, and print the
+   median and best time per operation and the median throughput.
+
+   ---------------------------------------------------------------------- */
+
+static double Seconds(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int CompareDoubles(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+
+  return (x > y) - (x < y);
+}
+
+static void RunBenchmark(BENCHMARK *benchmark, BENCHDATA *bench,
+			 int warmup, int reps)
+{
+  double *times, start, mean, stddev, median, ops;
+  int rep;
+
+  times = (double *) getmem(reps * sizeof(double));
+  for (rep = 0; rep < warmup; rep++)
+    sink = benchmark->kernel(bench);
+  for (rep = 0; rep < reps; rep++) {
+    start = Seconds();
+    sink = benchmark->kernel(bench);
+    times[rep] = Seconds() - start;
+  }
+
+  mean = stddev = 0.0;
+  for (rep = 0; rep < reps; rep++)
+    mean += times[rep];
+  mean /= reps;
+  for (rep = 0; rep < reps; rep++)
+    stddev += (times[rep] - mean) * (times[rep] - mean);
+  stddev = (reps > 1) ? sqrt(stddev / (reps - 1)) : 0.0;
+  qsort(times, reps, sizeof(double), CompareDoubles);
+  median = (reps % 2) ? times[reps / 2]
+    : (times[reps / 2 - 1] + times[reps / 2]) / 2;
+
+  ops = bench->num_data;
+  printf("%-20s %10.2f %10.2f %10.2f %7.1f%%", benchmark->name,
+	 1e9 * median / ops, 1e9 * times[0] / ops, 1e9 * mean / ops,
+	 (mean > 0.0) ? 100.0 * stddev / mean : 0.0);
+  if (benchmark->per_row)
+    printf(" %12.1f\n", ops / median / 1e6);
+  else
+    printf(" %12s\n", "-");
+  freemem(times);
+}
+
+/* ----------------------------------------------------------------------
+
+   Main function.
+
+   ---------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+  BENCHDATA bench;
+  BENCHMARK *benchmark;
+  long num_data = 1000000;
+  int reps = 10, warmup = 2, num_vals = 16;
+  int value_width = sizeof(double);
+  int i, first_name, selected;
+  unsigned long seed = 1;
+
+  progname = (char *) strrchr(argv[0], '/');
+  progname = (progname != NULL) ? (progname + 1) : argv[0];
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i += 2) {
+    if (i + 1 >= argc) {
+      fprintf(stderr, USAGE, progname);
+      exit(1);
+    }
+    if (!strcmp(argv[i], "-n"))
+      num_data = atol(argv[i + 1]);
+    else if (!strcmp(argv[i], "-r"))
+      reps = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-w"))
+      warmup = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-k"))
+      num_vals = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-c"))
+      value_width = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-s"))
+      seed = strtoul(argv[i + 1], NULL, 10);
+    else
+      num_data = 0;
+  }
+  if (num_data <= 0 || reps <= 0 || warmup < 0 || num_vals < 2 ||
+      (value_width != sizeof(float) && value_width != sizeof(double))) {
+    fprintf(stderr, USAGE, progname);
+    exit(1);
+  }
+  first_name = i;
+  for (; i < argc; i++) {
+    for (benchmark = benchmarks; benchmark->name != NULL; benchmark++)
+      if (!strcmp(argv[i], benchmark->name))
+	break;
+    if (benchmark->name == NULL)
+      USER_ERROR1("unknown kernel \"%s\"", argv[i]);
+  }
+
+  srandom(seed);
+  CreateBenchData(&bench, num_data, num_vals, value_width);
+
+  printf("%ld rows (%ld members), %d repetitions after %d warmup\n\n",
+	 num_data, bench.num_members, reps, warmup);
+  printf("%-20s %10s %10s %10s %8s %12s\n", "kernel", "ns/op med",
+	 "ns/op min", "ns/op mean", "stddev", "Mrows/s med");
+  printf("------------------------------------------------------------"
+	 "-------------------\n");
+  for (benchmark = benchmarks; benchmark->name != NULL; benchmark++) {
+    selected = (first_name == argc);
+    for (i = first_name; i < argc; i++)
+      if (!strcmp(argv[i], benchmark->name))
+	selected = 1;
+    if (selected)
+      RunBenchmark(benchmark, &bench, warmup, reps);
+  }
+
+  FreeScorer(bench.scorer);
+  FreeDecisionTree(bench.tree);
+  freecolumn(bench.data[COL_LABEL]);
+  freecolumn(bench.data[COL_BINARY]);
+  freecolumn(bench.data[COL_DISCRETE]);
+  freecolumn(bench.data[COL_CONTINUOUS]);
+  freemem(bench.data);
+  freemem(bench.members);
+  FreeMemberSet(bench.member_set);
+  freemem(bench.scratch);
+  freemem(bench.ssvinfo.num_discrete_vals);
+  exit(0);
+}
+
+/**************************************************************************/
@@ -16,6 +16,7 @@
 #include "ssv.h"
 #include "dt.h"
 #include "print-dt.h"
+#include "prune-dt.h"
 
 /* ----------------------------------------------------------------------
 
@@ -31,6 +32,40 @@ static void IndentPrint(int indent)
     printf(" ");
 }
 
+/* ----------------------------------------------------------------------
+
+   Return the values in the subset of a two-way discrete test as a string
+   of the form {"a", "b"}, to be freed by the caller.
+
+   ---------------------------------------------------------------------- */
+
+static char *SubsetString(DTNODE *node, SSVINFO *ssvinfo)
+{
+  int val, len;
+  int num_vals = ssvinfo->num_discrete_vals[node->test_attrib];
+  char **names = ssvinfo->discrete_vals[node->test_attrib];
+  char *str;
+
+  len = 3;
+  for (val = 0; val < num_vals; val++)
+    if (READ_BITARRAY(node->subset, val))
+      len += strlen(names[val]) + 4;
+  str = (char *) getmem(len);
+  strcpy(str, "{");
+  for (val = 0; val < num_vals; val++) {
+    if (READ_BITARRAY(node->subset, val)) {
+      if (str[1] != '\0')
+	strcat(str, ", ");
+      strcat(str, "\"");
+      strcat(str, names[val]);
+      strcat(str, "\"");
+    }
+  }
+  strcat(str, "}");
+
+  return str;
+}
+
 /* ----------------------------------------------------------------------
 
    Print a formatted section header
@@ -55,25 +90,28 @@ void PrintSection(char *section)
 
    ---------------------------------------------------------------------- */
 
-void PrintStats(DTNODE *tree, void **data, int num_data, uchar *train_members, 
-		       int num_train, uchar *test_members, int num_test, SSVINFO *ssvinfo)
+void PrintStats(DTNODE *tree, void **data, long num_data, MEMBERSET *train_members, 
+		       long num_train, MEMBERSET *test_members, long num_test, SSVINFO *ssvinfo)
 {
-  double train_accuracy, test_accuracy;
+  double train_accuracy = 0.0, test_accuracy = 0.0;
   int depth=1, count, prev_count = 0;
-  int num_negatives, num_false_negatives;
-  int num_positives, num_false_positives;
+  long num_negatives, num_false_negatives;
+  long num_positives, num_false_positives;
+  SCORER *scorer;
 
   CountDTPosNeg(tree, &num_positives, &num_negatives);
 
   printf("-------------------------------\n"
 	 "Max\t# of\tCorrect\tCorrect\n"
-	 "depth\tnodes\ttrain %\ttest %\n"
+	 "depth\tnodes\ttrain %%\ttest %%\n"
 	 "-------------------------------\n");
   
   count = CountNodesDepth(tree,depth);
     
   while (count != prev_count) {
-    DecisionTreeAccuracyBinary(tree, data, num_data,
+    /* One compiled tree for both sets. */
+    scorer = CompileAccuracyScorer(tree, depth, ssvinfo, MEM_TREE);
+    DecisionTreeAccuracyBinary(tree, scorer, data, num_data,
 			       train_members, num_train,
 			       train_members, num_train,
 			       &num_negatives, &num_false_negatives,
@@ -83,7 +121,7 @@ void PrintStats(DTNODE *tree, void **data, int num_data, uchar *train_members,
       (100.0 * (num_train - num_false_positives - num_false_negatives)) /
       num_train;
     if (num_test>0) {
-      DecisionTreeAccuracyBinary(tree, data, num_data,
+      DecisionTreeAccuracyBinary(tree, scorer, data, num_data,
 				 train_members, num_train,
 				 test_members, num_test,
 				 &num_negatives, &num_false_negatives,
@@ -96,6 +134,8 @@ void PrintStats(DTNODE *tree, void **data, int num_data, uchar *train_members,
     } else {
       printf("%d\t%d\t%.1f\n", depth, count, train_accuracy);
     }
+    if (scorer != NULL)
+      FreeScorer(scorer);
     prev_count = count;
     depth++;
     count = CountNodesDepth(tree,depth);
@@ -120,6 +160,7 @@ static void PrintDecisionTreeStructureAux(DTNODE *root, SSVINFO *ssvinfo,
 					  int indent)
 {
   int i, val;
+  char *subset;
 
   if (root == (DTNODE *) NULL) {
     IndentPrint(indent);
@@ -130,9 +171,9 @@ static void PrintDecisionTreeStructureAux(DTNODE *root, SSVINFO *ssvinfo,
   }
   if (root->num_children == 0) {   /* Leaf. */
     IndentPrint(indent);
-    printf("%s == NO : %d\n", ssvinfo->feat_names[0], root->num_neg);
+    printf("%s == NO : %ld\n", ssvinfo->feat_names[0], root->num_neg);
     IndentPrint(indent);
-    printf("%s == YES : %d\n", ssvinfo->feat_names[0], root->num_pos);
+    printf("%s == YES : %ld\n", ssvinfo->feat_names[0], root->num_pos);
   } else {   /* Internal node. */
     switch(ssvinfo->types[root->test_attrib]) {
     case 'b':  /* Binary attribute. */
@@ -143,15 +184,33 @@ static void PrintDecisionTreeStructureAux(DTNODE *root, SSVINFO *ssvinfo,
 				      indent + 4);
       }
       break;
-    case 'd':
-	for (val = 0;
-	     val < ssvinfo->num_discrete_vals[root->test_attrib]; val++) {
+    case 'd': /* Only the values present have a child. */
+	if (root->subset != NULL) {  /* Two-way test. */
+	  subset = SubsetString(root, ssvinfo);
+	  for (i = 0; i <= 1; i++) {
+	    IndentPrint(indent);
+	    printf("%s %s %s\n", ssvinfo->feat_names[root->test_attrib],
+		   (i == 0) ? "not in" : "in", subset);
+	    PrintDecisionTreeStructureAux(root->children[i], ssvinfo,
+					  indent + 4);
+	  }
+	  freemem(subset);
+	  break;
+	}
+	for (i = 0; i < root->num_children; i++) {
+	  val = root->child_vals[i];
 	  IndentPrint(indent);
 	  printf("%s == \"%s\"\n", ssvinfo->feat_names[root->test_attrib],
 		 ssvinfo->discrete_vals[root->test_attrib][val]);
-	  PrintDecisionTreeStructureAux(root->children[val], ssvinfo,
+	  PrintDecisionTreeStructureAux(root->children[i], ssvinfo,
 					indent + 4);
 	}
+	IndentPrint(indent);
+	printf("%s == other value\n", ssvinfo->feat_names[root->test_attrib]);
+	IndentPrint(indent + 4);
+	printf("%s == NO : %ld\n", ssvinfo->feat_names[0], root->num_neg);
+	IndentPrint(indent + 4);
+	printf("%s == YES : %ld\n", ssvinfo->feat_names[0], root->num_pos);
 	break;
     case 'c': /* Continuous attribute. */
       for (i = 0; i <= 1; i++) {
@@ -187,18 +246,19 @@ void PrintDecisionTreeStructure(DTNODE *root, SSVINFO *ssvinfo)
 static void PrintAllPathsAux(DTNODE *root, SSVINFO *ssvinfo,
 				 char **prefix)
 {
-  int val, num_branches;
+  int i, val;
+  char *subset;
 
   if (root == (DTNODE *) NULL)
     return;
   if (root->num_children == 0) {
     printf("%s : ", *prefix);
-    printf(" %s: YES %d, NO %d\n", (ssvinfo->feat_names)[0],
+    printf(" %s: YES %ld, NO %ld\n", (ssvinfo->feat_names)[0],
 	   root->num_pos, root->num_neg);
   } else {
     char *feat_name = (ssvinfo->feat_names)[root->test_attrib];
     int l = strlen(*prefix);
-    *prefix = (char *) realloc(*prefix, l + 100);
+    *prefix = (char *) regetmem(*prefix, l + 100);
     switch((ssvinfo->types)[root->test_attrib]) {
     case 'b':
       sprintf(*prefix + l, "( %s == 0 ) ? ", feat_name);
@@ -207,12 +267,30 @@ static void PrintAllPathsAux(DTNODE *root, SSVINFO *ssvinfo,
       PrintAllPathsAux(root->children[1], ssvinfo, prefix);
       break;
     case 'd':
-      num_branches = ssvinfo->num_discrete_vals[root->test_attrib];
-      for (val = 0; val < num_branches; val++) {
+      if (root->subset != NULL) {  /* Two-way test. */
+	subset = SubsetString(root, ssvinfo);
+	*prefix = (char *) regetmem(*prefix, l + 100 + strlen(feat_name) +
+				    strlen(subset));
+	sprintf(*prefix + l, "( %s not in %s ) ? ", feat_name, subset);
+	PrintAllPathsAux(root->children[0], ssvinfo, prefix);
+	sprintf(*prefix + l, "( %s in %s ) ? ", feat_name, subset);
+	PrintAllPathsAux(root->children[1], ssvinfo, prefix);
+	freemem(subset);
+	break;
+      }
+      for (i = 0; i < root->num_children; i++) {
+	val = root->child_vals[i];
+	*prefix = (char *) regetmem(*prefix, l + 100 + strlen(feat_name) +
+				    strlen(ssvinfo->discrete_vals[root->test_attrib][val]));
 	sprintf(*prefix + l, "( %s == \"%s\" ) ? ", feat_name,
 		ssvinfo->discrete_vals[root->test_attrib][val]);
-	PrintAllPathsAux(root->children[val], ssvinfo, prefix);
+	PrintAllPathsAux(root->children[i], ssvinfo, prefix);
       }
+      /* The default branch predicts as if the node were a leaf. */
+      sprintf(*prefix + l, "( %s == other ) ? ", feat_name);
+      printf("%s : ", *prefix);
+      printf(" %s: YES %ld, NO %ld\n", (ssvinfo->feat_names)[0],
+	     root->num_pos, root->num_neg);
       break;
     case 'c':
       sprintf(*prefix + l, "( %s < %g ) ? ", feat_name, root->threshold);
@@ -237,7 +315,7 @@ void PrintAllPaths(DTNODE *root, char *filename, SSVINFO *ssvinfo)
   strcpy(prefix, "");
   PrintAllPathsAux(root, ssvinfo, &prefix);
   printf("\nEND DECISION-TREE\n");
-  free(prefix);
+  freemem(prefix);
 }
 
 /**************************************************************************/
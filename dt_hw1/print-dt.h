@@ -16,8 +16,8 @@
 
 /* Function prototypes. */
 void PrintSection(char *section); 
-void PrintStats(DTNODE *tree, void **data, int num_data, uchar *train_members, 
-		       int num_train, uchar *test_members, int num_test, SSVINFO *ssvinfo);
+void PrintStats(DTNODE *tree, void **data, long num_data, MEMBERSET *train_members, 
+		       long num_train, MEMBERSET *test_members, long num_test, SSVINFO *ssvinfo);
 void PrintDecisionTreeStructure(DTNODE *root, SSVINFO *ssvinfo);
 void PrintAllPaths(DTNODE *root, char *filename, SSVINFO *ssvinfo);
 
@@ -0,0 +1,364 @@
+/**************************************************************************
+ *
+ * profile.c
+ *
+ * Source file containing routines related to timing the phases of a run
+ * and reporting them, together with the hot-path counters, as JSON, and
+ * to tracing the run as the Chrome trace events of its spans.
+ *
+ **************************************************************************/
+
+#include <stdarg.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "auxi.h"
+#include "profile.h"
+
+/* Global variables.  The counts are kept by every thread, so that the
+   calls of the library running at once do not share them. */
+int profiling = 0;
+__thread PROFILE profile;
+
+/* Totals of all reported iterations. */
+static __thread PROFILE profile_total;
+
+static char *phase_names[NUM_PHASES] = {
+  "parse", "partition", "grow", "split", "prune", "stats", "predict"
+};
+
+/* The trace: its file, shared by all threads, the time it was started
+   at, and the track of this thread (0 until it writes its first event). */
+int tracing = 0;
+static FILE *trace_file = NULL;
+static char *trace_filename = NULL;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static double trace_start;
+static int trace_num_tracks = 0;
+static __thread int trace_track = 0;
+
+/* Strings of TraceString() and TraceNumber(), used round robin so that several of
+   them can be passed to one event. */
+#define NUM_TRACE_STRINGS 4
+static __thread char trace_strings[NUM_TRACE_STRINGS][TRACE_STRING_SIZE];
+static __thread int trace_next_string = 0;
+
+/* ----------------------------------------------------------------------
+
+   Return the current wall-clock and CPU times, in seconds.
+
+   ---------------------------------------------------------------------- */
+
+static double WallSeconds(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double CpuSeconds(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ----------------------------------------------------------------------
+
+   Start and stop timing a phase.
+
+   ---------------------------------------------------------------------- */
+
+void ProfileBegin(int phase)
+{
+  TRACE_BEGIN(phase_names[phase], "%s", "");
+  profile.wall_start[phase] = WallSeconds();
+  profile.cpu_start[phase] = CpuSeconds();
+}
+
+void ProfileEnd(int phase)
+{
+  profile.wall[phase] += WallSeconds() - profile.wall_start[phase];
+  profile.cpu[phase] += CpuSeconds() - profile.cpu_start[phase];
+  TRACE_END("%s", "");
+}
+
+/* ----------------------------------------------------------------------
+
+   Print one JSON record on stderr, with the memory of the context of this
+   thread.
+
+   ---------------------------------------------------------------------- */
+
+static void ProfilePrint(PROFILE *p, char *scope, int iteration)
+{
+  DTCONTEXT *context = CurrentContext();
+  struct rusage usage;
+  int phase, tag;
+
+  getrusage(RUSAGE_SELF, &usage);
+  fprintf(stderr, "{\"scope\": \"%s\"", scope);
+  if (iteration > 0)
+    fprintf(stderr, ", \"iteration\": %d", iteration);
+  fprintf(stderr, ", \"phases\": {");
+  for (phase = 0; phase < NUM_PHASES; phase++)
+    fprintf(stderr, "%s\"%s\": {\"wall\": %.6f, \"cpu\": %.6f}",
+	    (phase == 0) ? "" : ", ", phase_names[phase],
+	    p->wall[phase], p->cpu[phase]);
+  fprintf(stderr, "}, \"counters\": {"
+	  "\"max_gain_calls\": %ld, \"attribs_evaluated\": %ld, "
+	  "\"rows_scanned\": %ld, \"sorts\": %ld, "
+	  "\"nodes_created\": %ld, \"nodes_pruned\": %ld, "
+	  "\"check_correctness\": %ld}",
+	  p->max_gain_calls, p->attribs_evaluated,
+	  p->rows_scanned, p->sorts,
+	  p->nodes_created, p->nodes_pruned,
+	  p->check_correctness);
+  fprintf(stderr, ", \"memory\": {");
+  for (tag = 0; tag < NUM_MEM_TAGS; tag++)
+    fprintf(stderr, "\"%s\": {\"current\": %ld, \"peak\": %ld, "
+	    "\"allocs\": %ld}, ", mem_tag_names[tag],
+	    context->mem_stats[tag].current, context->mem_stats[tag].peak,
+	    context->mem_stats[tag].count);
+  fprintf(stderr, "\"total\": {\"current\": %ld, \"peak\": %ld, "
+	  "\"allocs\": %ld}}", context->mem_total.current,
+	  context->mem_total.peak, context->mem_total.count);
+  fprintf(stderr, ", \"peak_rss_kb\": %ld}\n", usage.ru_maxrss);
+  fflush(stderr);
+}
+
+/* ----------------------------------------------------------------------
+
+   Add the counts since the last flush to the run totals, and start
+   counting from zero again.  If "iteration" is positive, the counts are
+   first reported as that (batch mode) iteration.
+
+   ---------------------------------------------------------------------- */
+
+void ProfileFlush(int iteration)
+{
+  int phase;
+
+  if (profiling && iteration > 0)
+    ProfilePrint(&profile, "iteration", iteration);
+
+  for (phase = 0; phase < NUM_PHASES; phase++) {
+    profile_total.wall[phase] += profile.wall[phase];
+    profile_total.cpu[phase] += profile.cpu[phase];
+    profile.wall[phase] = profile.cpu[phase] = 0.0;
+  }
+  profile_total.max_gain_calls += profile.max_gain_calls;
+  profile_total.attribs_evaluated += profile.attribs_evaluated;
+  profile_total.rows_scanned += profile.rows_scanned;
+  profile_total.sorts += profile.sorts;
+  profile_total.nodes_created += profile.nodes_created;
+  profile_total.nodes_pruned += profile.nodes_pruned;
+  profile_total.check_correctness += profile.check_correctness;
+  profile.max_gain_calls = profile.attribs_evaluated = 0;
+  profile.rows_scanned = profile.sorts = 0;
+  profile.nodes_created = profile.nodes_pruned = 0;
+  profile.check_correctness = 0;
+}
+
+/* ----------------------------------------------------------------------
+
+   Report the totals of the whole run; registered with atexit().
+
+   ---------------------------------------------------------------------- */
+
+static void ProfileReportRun(void)
+{
+  ProfileFlush(0);
+  ProfilePrint(&profile_total, "run", 0);
+}
+
+/* ----------------------------------------------------------------------
+
+   Turn profiling on.  The run totals are reported when the program exits.
+
+   ---------------------------------------------------------------------- */
+
+void ProfileStart(void)
+{
+  profiling = 1;
+  memset(&profile, 0, sizeof(PROFILE));
+  memset(&profile_total, 0, sizeof(PROFILE));
+  atexit(ProfileReportRun);
+}
+
+/* ......................................................................
+
+   Return the time since the trace was started, in microseconds.
+
+   ...................................................................... */
+
+static double TraceMicroseconds(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec + ts.tv_nsec / 1e9 - trace_start) * 1e6;
+}
+
+/* ......................................................................
+
+   Write an event of type "phase" ('B' or 'E') on the track of this
+   thread, with the arguments formatted from "args_format" (none if it
+   formats to the empty string).  A thread is given its track, and the
+   track its name, by its first event.
+
+   ...................................................................... */
+
+static void TraceEvent(char phase, char *name, char *args_format,
+		       va_list ap)
+{
+  char args[TRACE_ARGS_SIZE];
+  double ts;
+
+  vsnprintf(args, TRACE_ARGS_SIZE, args_format, ap);
+  pthread_mutex_lock(&trace_lock);
+  ts = TraceMicroseconds();
+  if (trace_file != NULL) {
+    if (trace_track == 0) {
+      trace_track = ++trace_num_tracks;
+      fprintf(trace_file, ",\n{\"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+	      "\"name\": \"thread_name\", \"args\": {\"name\": ", trace_track);
+      if (trace_track == 1)
+	fprintf(trace_file, "\"main\"}}");
+      else
+	fprintf(trace_file, "\"thread %d\"}}", trace_track);
+    }
+    fprintf(trace_file, ",\n{\"ph\": \"%c\", \"pid\": 1, \"tid\": %d, "
+	    "\"ts\": %.3f", phase, trace_track, ts);
+    if (name != NULL)
+      fprintf(trace_file, ", \"name\": \"%s\"", name);
+    if (args[0] != '\0')
+      fprintf(trace_file, ", \"args\": {%s}", args);
+    fprintf(trace_file, "}");
+  }
+  pthread_mutex_unlock(&trace_lock);
+}
+
+/* ----------------------------------------------------------------------
+
+   Open a span named "name" on the track of this thread, and close the
+   last one it opened.  The arguments of the span are the members of a
+   JSON object, formatted from "args_format" like printf() does, e.g.
+   "\"rows\": %ld"; strings among them are escaped with TraceString().
+
+   ---------------------------------------------------------------------- */
+
+void TraceBegin(char *name, char *args_format, ...)
+{
+  va_list ap;
+
+  va_start(ap, args_format);
+  TraceEvent('B', name, args_format, ap);
+  va_end(ap);
+}
+
+void TraceEnd(char *args_format, ...)
+{
+  va_list ap;
+
+  va_start(ap, args_format);
+  TraceEvent('E', (char *) NULL, args_format, ap);
+  va_end(ap);
+}
+
+/* ----------------------------------------------------------------------
+
+   Return a string quoted and escaped for the arguments of an event,
+   truncated to TRACE_STRING_SIZE bytes.  The string is overwritten by
+   the NUM_TRACE_STRINGS-th next call of this thread.
+
+   ---------------------------------------------------------------------- */
+
+char *TraceString(char *str)
+{
+  char *quoted = trace_strings[trace_next_string];
+  int len = 0;
+
+  trace_next_string = (trace_next_string + 1) % NUM_TRACE_STRINGS;
+  quoted[len++] = '"';
+  for (; *str != '\0' && len < TRACE_STRING_SIZE - 8; str++) {
+    if (*str == '"' || *str == '\\')
+      len += sprintf(quoted + len, "\\%c", *str);
+    else if ((unsigned char) *str < ' ')
+      len += sprintf(quoted + len, "\\u%04x", (unsigned char) *str);
+    else
+      quoted[len++] = *str;
+  }
+  quoted[len++] = '"';
+  quoted[len] = '\0';
+
+  return quoted;
+}
+
+/* ----------------------------------------------------------------------
+
+   Return a number formatted for the arguments of an event, or null if it
+   is not finite (JSON has no NaN or infinity).  The string is reused as
+   those of TraceString() are.
+
+   ---------------------------------------------------------------------- */
+
+char *TraceNumber(double x)
+{
+  char *str = trace_strings[trace_next_string];
+
+  trace_next_string = (trace_next_string + 1) % NUM_TRACE_STRINGS;
+  if (isfinite(x))
+    snprintf(str, TRACE_STRING_SIZE, "%.10g", x);
+  else
+    strcpy(str, "null");
+
+  return str;
+}
+
+/* ......................................................................
+
+   Close the trace; registered with atexit().
+
+   ...................................................................... */
+
+static void TraceStop(void)
+{
+  pthread_mutex_lock(&trace_lock);
+  fprintf(trace_file, "\n]\n");
+  if (fclose(trace_file) != 0)
+    fprintf(stderr, "Warning: could not write the trace \"%s\"\n",
+	    trace_filename);
+  trace_file = NULL;
+  pthread_mutex_unlock(&trace_lock);
+}
+
+/* ----------------------------------------------------------------------
+
+   Turn tracing on: the spans of all threads are written to "filename",
+   as a JSON array of Chrome trace events (which chrome://tracing and
+   Perfetto load).  The file is closed when the program exits.
+
+   ---------------------------------------------------------------------- */
+
+void TraceStart(char *filename)
+{
+  struct timespec ts;
+
+  if ((trace_file = fopen(filename, "w")) == NULL)
+    SYS_ERROR1("fopen(\"%s\", \"w\")", filename);
+  trace_filename = filename;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  trace_start = ts.tv_sec + ts.tv_nsec / 1e9;
+  fprintf(trace_file, "[\n{\"ph\": \"M\", \"pid\": 1, "
+	  "\"name\": \"process_name\", \"args\": {\"name\": \"dt\"}}");
+  tracing = 1;
+  atexit(TraceStop);
+}
+
+/**************************************************************************/
@@ -0,0 +1,81 @@
+/**************************************************************************
+ *
+ * profile.h
+ *
+ * Header file to profile.c
+ *
+ **************************************************************************/
+
+#ifndef PROFILE_H
+#define PROFILE_H 1
+
+/* Timed phases of a run.  PHASE_SPLIT (split search) is nested inside
+   PHASE_GROW.  PHASE_PREDICT is one classification pass of the test set
+   with the final tree, only made when profiling. */
+#define PHASE_PARSE     0
+#define PHASE_PARTITION 1
+#define PHASE_GROW      2
+#define PHASE_SPLIT     3
+#define PHASE_PRUNE     4
+#define PHASE_STATS     5
+#define PHASE_PREDICT   6
+#define NUM_PHASES      7
+
+/* Time spent in every phase and counts of the hot-path operations. */
+typedef struct profile {
+  double wall[NUM_PHASES];      /* Wall-clock seconds in each phase. */
+  double cpu[NUM_PHASES];       /* CPU seconds in each phase. */
+  double wall_start[NUM_PHASES];
+  double cpu_start[NUM_PHASES];
+  long max_gain_calls;          /* Searches for the best split of a node. */
+  long attribs_evaluated;       /* Attributes considered by those. */
+  long rows_scanned;            /* Examples visited by the split kernels. */
+  long sorts;                   /* Calls to qsort(). */
+  long nodes_created;           /* Tree nodes allocated. */
+  long nodes_pruned;            /* Tree nodes removed by pruning. */
+  long check_correctness;       /* Calls to CheckCorrectness(). */
+} PROFILE;
+
+/* Longest arguments of a trace event, and longest string in them (see
+   TraceString() and TraceNumber()). */
+#ifndef TRACE_ARGS_SIZE
+#define TRACE_ARGS_SIZE 512
+#endif
+#ifndef TRACE_STRING_SIZE
+#define TRACE_STRING_SIZE 128
+#endif
+
+/* Global variables. */
+extern int profiling;           /* Non-zero if --profile was given. */
+extern int tracing;             /* Non-zero if -trace was given. */
+extern __thread PROFILE profile; /* Counts since the last report, of
+				    this thread. */
+
+/* Count "n" occurrences of a hot-path operation.  The counters are cheap
+   enough to be always kept; they are only reported when profiling. */
+#define PROFILE_COUNT(counter, n) (profile.counter += (n))
+
+/* Start and stop timing a phase, which is also a span of the trace. */
+#define PROFILE_BEGIN(phase) { if (profiling || tracing) ProfileBegin(phase); }
+#define PROFILE_END(phase) { if (profiling || tracing) ProfileEnd(phase); }
+
+/* Open and close a span of the trace on the track of this thread (see
+   TraceBegin()).  Spans nest, and must be closed in the reverse order. */
+#define TRACE_BEGIN(...) { if (tracing) TraceBegin(__VA_ARGS__); }
+#define TRACE_END(...) { if (tracing) TraceEnd(__VA_ARGS__); }
+
+/* Function prototypes. */
+void ProfileStart(void);
+void ProfileBegin(int phase);
+void ProfileEnd(int phase);
+void ProfileFlush(int iteration);
+void TraceStart(char *filename);
+void TraceBegin(char *name, char *args_format, ...)
+  __attribute__ ((format (printf, 2, 3)));
+void TraceEnd(char *args_format, ...)
+  __attribute__ ((format (printf, 1, 2)));
+char *TraceString(char *str);
+char *TraceNumber(double x);
+
+#endif // PROFILE_H
+/**************************************************************************/
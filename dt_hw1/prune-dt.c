@@ -14,8 +14,10 @@
  **************************************************************************/
 
 #include "prune-dt.h"
+#include "score-dt.h"
 #include "bitarray.h"
 #include "ssv.h"
+#include "profile.h"
 #define CHILDREN_BEFORE 0
 #define CHILDREN_AFTER 1
 /* ----------------------------------------------------------------------
@@ -25,24 +27,26 @@
 
    ---------------------------------------------------------------------- */
 
-int CheckCorrectness(DTNODE *node, void **data, int num_data,
-		     double pos_prior, int example, SSVINFO *ssvinfo, int depth)
+int CheckCorrectness(DTNODE *node, void **data, long num_data,
+		     double pos_prior, long example, SSVINFO *ssvinfo, int depth)
 {
-  int correct, prediction;
-  int child;
+  int prediction;
+  int child, val;
 
+  PROFILE_COUNT(check_correctness, 1);
   if (node == NULL)
     return 0;
-  if ((node->num_children == 0) || (depth == 1)) {  /* Leaf, check what tree predicts. */
-    prediction = (node->num_pos >= (pos_prior * node->num_members));
-    correct = (READ_ATTRIB_B(data, example, 0) == prediction);
-  } else {    /* Internal node, check appropriate child. */
+  if ((node->num_children > 0) && (depth != 1)) {    /* Internal node, check appropriate child. */
     switch (ssvinfo->types[node->test_attrib]) {
       case 'b': /* Attrib tested is binary. */
 	child = READ_ATTRIB_B(data, example, node->test_attrib);
 	break;
-    case 'd':
-	child = READ_ATTRIB_I(data, example, node->test_attrib);
+    case 'd': /* Only the values present have a child. */
+      val = READ_ATTRIB_I(data, example, node->test_attrib);
+      if (val < ssvinfo->num_discrete_vals[node->test_attrib])
+	child = DiscreteChildIndex(node, val);
+      else /* Unknown to the tree, as in ClassifyExample(). */
+	child = (node->subset != NULL) ? 0 : -1;
       break;
     case 'c': /* Attribute tested at node is continuous. */
       child =
@@ -52,52 +56,138 @@ int CheckCorrectness(DTNODE *node, void **data, int num_data,
       USER_ERROR1("Unknown attribute type '%c'",
 		  ssvinfo->types[node->test_attrib]);
     }
-    correct = CheckCorrectness(node->children[ child ],
-			       data, num_data, pos_prior,
-			       example, ssvinfo, depth-1);
+    if (child >= 0)
+      return CheckCorrectness(node->children[ child ],
+			      data, num_data, pos_prior,
+			      example, ssvinfo, depth-1);
   }
 
-  return correct;
+  /* Leaf (or default branch of a discrete test), check what tree predicts. */
+  prediction = (node->num_pos >= (pos_prior * node->num_members));
+  return (READ_ATTRIB_B(data, example, 0) == prediction);
+}
+
+/* ----------------------------------------------------------------------
+
+   Classify an example with a decision tree, as CheckCorrectness() does
+   for the whole tree.  Returns the class predicted, or -1 if the example
+   reaches a missing subtree.  A value of a discrete attribute beyond those
+   known (ssvinfo->num_discrete_vals) takes the default branch, or the
+   first child of a two-way test.
+
+   ---------------------------------------------------------------------- */
+
+int ClassifyExample(DTNODE *node, void **data, long example, double pos_prior,
+		    SSVINFO *ssvinfo)
+{
+  int child, attrib, val;
+
+  while (node != NULL && node->num_children > 0) {
+    attrib = node->test_attrib;
+    switch (ssvinfo->types[attrib]) {
+    case 'b':
+      child = READ_ATTRIB_B(data, example, attrib);
+      break;
+    case 'd':
+      val = READ_ATTRIB_I(data, example, attrib);
+      if (val < ssvinfo->num_discrete_vals[attrib])
+	child = DiscreteChildIndex(node, val);
+      else
+	child = (node->subset != NULL) ? 0 : -1;
+      break;
+    case 'c':
+      child = (READ_ATTRIB_C(data, example, attrib) >= node->threshold);
+      break;
+    default:
+      USER_ERROR1("Unknown attribute type '%c'", ssvinfo->types[attrib]);
+    }
+    if (child < 0)
+      break;
+    node = node->children[child];
+  }
+
+  if (node == NULL)
+    return -1;
+  return (node->num_pos >= (pos_prior * node->num_members));
+}
+
+/* ......................................................................
+
+   Check whether the tree classifies an example correctly, with "scorer"
+   if it could be compiled, or else node by node.
+
+   ...................................................................... */
+
+static int ScoreCorrectness(SCORER *scorer, DTNODE *root, void **data,
+			    long num_data, double pos_prior, long example,
+			    SSVINFO *ssvinfo, int depth)
+{
+  if (scorer == NULL)
+    return CheckCorrectness(root, data, num_data, pos_prior, example,
+			    ssvinfo, depth);
+  return (ScoreExample(scorer, data, example) ==
+	  READ_ATTRIB_B(data, example, 0));
+}
+
+/* ----------------------------------------------------------------------
+
+   Compile a decision tree down to "depth" (0 for the whole tree) for
+   DecisionTreeAccuracy() and DecisionTreeAccuracyBinary().  Returns NULL
+   if the tree is too large to be worth compiling (see SCORE_MAX_LEAVES),
+   in which case they classify node by node.  The scorer stands for the
+   tree as it is, and is to be compiled again once the tree changes.  Its
+   memory is accounted to "tag".
+
+   ---------------------------------------------------------------------- */
+
+SCORER *CompileAccuracyScorer(DTNODE *root, int depth, SSVINFO *ssvinfo,
+			      int tag)
+{
+  return CompileDecisionTree(root, depth, ACCURACY_POS_PRIOR,
+			     SCORE_MAX_LEAVES, ssvinfo, tag);
 }
 
 /* ----------------------------------------------------------------------
 
    Compute classification accuracy over a set of examples of a decision
-   tree up to a certain depth for binary target attributes.  
+   tree up to a certain depth for binary target attributes, with "scorer"
+   compiled by CompileAccuracyScorer() for that depth (or NULL).
    Returns a number in [0.0, 1.0].
 
    ---------------------------------------------------------------------- */
 
-void DecisionTreeAccuracyBinary(DTNODE *root,
-				void **data, int num_data,
-				uchar *train_members, int num_train,
-				uchar *test_members, int num_test,
-				int *num_negatives, int *num_false_negatives,
-				int *num_positives, int *num_false_positives,
+void DecisionTreeAccuracyBinary(DTNODE *root, SCORER *scorer,
+				void **data, long num_data,
+				MEMBERSET *train_members, long num_train,
+				MEMBERSET *test_members, long num_test,
+				long *num_negatives, long *num_false_negatives,
+				long *num_positives, long *num_false_positives,
 				SSVINFO *ssvinfo, int depth)
 {
-  int example;
-  int num_all_pos, num_all_neg;
+  MEMBERITER iter;
+  long example;
   double pos_prior;
 
+  (void) train_members;
+  (void) num_train;
+  (void) num_test;
+
   /* Assume nothing is known about priors */
-  pos_prior = 0.5;
+  pos_prior = ACCURACY_POS_PRIOR;
 
   *num_false_positives = *num_false_negatives = 0;
   *num_positives = *num_negatives = 0;
-  for (example = 0; example < num_data; example++) {
-    if (READ_BITARRAY(test_members, example)) {
-      if (READ_ATTRIB_B(data, example, 0) == 0) {
-	(*num_negatives)++;
-	*num_false_negatives += (1 - CheckCorrectness(root, data, num_data,
-						      pos_prior,
-						      example, ssvinfo, depth));
-      } else {
-	(*num_positives)++;
-	*num_false_positives += (1 - CheckCorrectness(root, data, num_data,
-						      pos_prior,
-						      example, ssvinfo, depth));
-      }
+  FOR_EACH_MEMBER(iter, test_members, example) {
+    if (READ_ATTRIB_B(data, example, 0) == 0) {
+      (*num_negatives)++;
+      *num_false_negatives += (1 - ScoreCorrectness(scorer, root, data,
+						    num_data, pos_prior,
+						    example, ssvinfo, depth));
+    } else {
+      (*num_positives)++;
+      *num_false_positives += (1 - ScoreCorrectness(scorer, root, data,
+						    num_data, pos_prior,
+						    example, ssvinfo, depth));
     }
   }
 }
@@ -106,26 +196,27 @@ void DecisionTreeAccuracyBinary(DTNODE *root,
 /* ----------------------------------------------------------------------
 
    Compute classification accuracy over a set of examples of a decision
-   tree.  Returns a number in [0.0, 1.0].
+   tree, with "scorer" compiled by CompileAccuracyScorer() for the whole
+   tree (or NULL).  Returns a number in [0.0, 1.0].
 
    ---------------------------------------------------------------------- */
 
-double DecisionTreeAccuracy(DTNODE *root, void **data, int num_data,
-			    uchar *test_members, int num_test,
+double DecisionTreeAccuracy(DTNODE *root, SCORER *scorer,
+			    void **data, long num_data,
+			    MEMBERSET *test_members, long num_test,
 			    SSVINFO *ssvinfo)
 {
-  int num_correct, num_pos, num_neg;
-  int example;
-  double pos_prior = 0.5;
+  MEMBERITER iter;
+  long num_correct;
+  long example;
+  double pos_prior = ACCURACY_POS_PRIOR;
 
   //CountExamples(data, num_data, NULL, 0, &num_pos, &num_neg);
   //pos_prior = ((double) num_pos) / (num_pos + num_neg);
   num_correct = 0;
-  for (example = 0; example < num_data; example++) {
-    if (READ_BITARRAY(test_members, example)) {
-      num_correct += CheckCorrectness(root, data, num_data, pos_prior,
-				      example, ssvinfo, 0);
-    }
+  FOR_EACH_MEMBER(iter, test_members, example) {
+    num_correct += ScoreCorrectness(scorer, root, data, num_data,
+				    pos_prior, example, ssvinfo, 0);
   }
 
   return (double) num_correct / (double) num_test;
@@ -140,10 +231,10 @@ double DecisionTreeAccuracy(DTNODE *root, void **data, int num_data,
 
    ---------------------------------------------------------------------- */
 
-void CountDTPosNeg(DTNODE *root, int *num_pos, int *num_neg)
+void CountDTPosNeg(DTNODE *root, long *num_pos, long *num_neg)
 {
   int i;
-  int num_pos_child, num_neg_child;
+  long num_pos_child, num_neg_child;
   
   if (root == NULL) {
     *num_pos = *num_neg = 0;
@@ -164,7 +255,7 @@ void CountDTPosNeg(DTNODE *root, int *num_pos, int *num_neg)
   }
 }
 
-/* ----------------------------------------------------------------------
+/* ......................................................................
 
    Post-prune the decision tree by temporarily making the current node
    a leaf and comparing the accuracy with that of the unaltered tree.
@@ -189,7 +280,7 @@ void CountDTPosNeg(DTNODE *root, int *num_pos, int *num_neg)
 
    num_data is the number of examples in the dataset
 
-   *pruning_set is a bitmask (over **data) indicating which examples should
+   *pruning_set is the set of examples (rows of **data) that should
                 be used as the pruning dataset
 		
    num_prune is the number of examples that should be used for pruning
@@ -198,18 +289,21 @@ void CountDTPosNeg(DTNODE *root, int *num_pos, int *num_neg)
    *ssvinfo stores general information about the dataset, such as the names
             of the features.
 
-   ---------------------------------------------------------------------- */
+   *root_scorer is the tree compiled by CompileAccuracyScorer(), replaced
+                with the one of the pruned tree when a node is pruned.
 
-void PruneDecisionTree(DTNODE *root, DTNODE *node,
-			      void **data, int num_data,
-			      uchar *pruning_set, int num_prune,
-			      SSVINFO *ssvinfo)
+   ...................................................................... */
+
+static void PruneNode(DTNODE *root, DTNODE *node, SCORER **root_scorer,
+		      void **data, long num_data,
+		      MEMBERSET *pruning_set, long num_prune,
+		      SSVINFO *ssvinfo)
 {
-  DTNODE *temp_node;
   double acc_before;
   int i;
   int save_the_children;
-  double a,b,acc_after,acc_after2;
+  double acc_after;
+  SCORER *leaf_scorer;
 
   /* Do nothing if already a leaf. */
   if (node == NULL || node->num_children == 0)
@@ -222,12 +316,14 @@ void PruneDecisionTree(DTNODE *root, DTNODE *node,
  
 #if CHILDREN_BEFORE
   for(i = 0; i < node->num_children; i++){
-    PruneDecisionTree(root, node->children[i], data, num_data, pruning_set, num_prune, ssvinfo);
+    PruneNode(root, node->children[i], root_scorer, data, num_data, pruning_set, num_prune, ssvinfo);
   }
 #endif
 
   /* First, we check the accuracy of the tree assuming we keep the current node */
-  acc_before = DecisionTreeAccuracy(root, data, num_data, pruning_set, num_prune, ssvinfo);
+  TRACE_BEGIN("prune", "\"attribute\": %s",
+	      TraceString(ssvinfo->feat_names[node->test_attrib]));
+  acc_before = DecisionTreeAccuracy(root, *root_scorer, data, num_data, pruning_set, num_prune, ssvinfo);
 
   /* Then, we "hide" the children by temporarily setting num_children to 0... */
   CountDTPosNeg(node, &node->num_pos, &node->num_neg);
@@ -235,10 +331,14 @@ void PruneDecisionTree(DTNODE *root, DTNODE *node,
   node->num_children = 0;
 
   /* ... and compute the accuracy again, while this nodes pretends to be a leaf */
-  acc_after = DecisionTreeAccuracy(root, data, num_data, pruning_set, num_prune, ssvinfo);
+  leaf_scorer = CompileAccuracyScorer(root, 0, ssvinfo, MEM_PRUNE);
+  acc_after = DecisionTreeAccuracy(root, leaf_scorer, data, num_data, pruning_set, num_prune, ssvinfo);
 
   /* Restore the value of num_children*/
   node->num_children = save_the_children;
+  TRACE_END("\"before\": %g, \"after\": %g, \"pruned\": %s",
+	    acc_before, acc_after,
+	    ((acc_after-acc_before)>EPSILON) ? "true" : "false");
 
   /* If the new accuracy exceeds the old one by more than EPSILON, we'll prune */
   if ((acc_after-acc_before)>EPSILON) {
@@ -250,10 +350,19 @@ void PruneDecisionTree(DTNODE *root, DTNODE *node,
     }
     
     /* Actually remove the children to make this a leaf node */
+    PROFILE_COUNT(nodes_pruned, CountNodes(node) - 1);
     FreeDecisionTreeChildren(node);
 
+    /* The tree now classifies as it did with the node hidden. */
+    if (*root_scorer != NULL)
+      FreeScorer(*root_scorer);
+    *root_scorer = leaf_scorer;
+
   } else { 
 
+    if (leaf_scorer != NULL)
+      FreeScorer(leaf_scorer);
+
     /* Only print intermediate results if not in batch mode */
     if (ssvinfo->batch == 0) {
       printf("Not pruning: %s (accuracy: %g -> %g)\n",
@@ -267,7 +376,7 @@ void PruneDecisionTree(DTNODE *root, DTNODE *node,
 
 #if CHILDREN_AFTER
     for(i = 0; i < node->num_children; i++){
-      PruneDecisionTree(root, node->children[i], data, num_data, pruning_set, num_prune, ssvinfo);
+      PruneNode(root, node->children[i], root_scorer, data, num_data, pruning_set, num_prune, ssvinfo);
     }
 #endif
   
@@ -278,4 +387,25 @@ void PruneDecisionTree(DTNODE *root, DTNODE *node,
 
 }
 
+/* ----------------------------------------------------------------------
+
+   Post-prune the subtree of "node" of the decision tree "root" (see
+   PruneNode()), compiling the tree once and then once per node checked.
+
+   ---------------------------------------------------------------------- */
+
+void PruneDecisionTree(DTNODE *root, DTNODE *node,
+			      void **data, long num_data,
+			      MEMBERSET *pruning_set, long num_prune,
+			      SSVINFO *ssvinfo)
+{
+  SCORER *root_scorer;
+
+  root_scorer = CompileAccuracyScorer(root, 0, ssvinfo, MEM_PRUNE);
+  PruneNode(root, node, &root_scorer, data, num_data, pruning_set,
+	    num_prune, ssvinfo);
+  if (root_scorer != NULL)
+    FreeScorer(root_scorer);
+}
+
 /**************************************************************************/
@@ -17,24 +17,34 @@
 #include "dt.h"
 #include "ssv.h"
 #include "bitarray.h"
+#include "score-dt.h"
+
+/* Prior of the positive class of DecisionTreeAccuracy() and
+   DecisionTreeAccuracyBinary(). */
+#define ACCURACY_POS_PRIOR 0.5
 
 /* Function prototypes. */
-int CheckCorrectness(DTNODE *node, void **data, int num_data,
-		     double pos_prior, int example, SSVINFO *ssvinfo, int depth);
-void DecisionTreeAccuracyBinary(DTNODE *root,
-				void **data, int num_data,
-				uchar *train_members, int num_train,
-				uchar *test_members, int num_test,
-				int *num_negatives, int *num_false_negatives,
-				int *num_positives, int *num_false_positives,
+int CheckCorrectness(DTNODE *node, void **data, long num_data,
+		     double pos_prior, long example, SSVINFO *ssvinfo, int depth);
+int ClassifyExample(DTNODE *node, void **data, long example, double pos_prior,
+		    SSVINFO *ssvinfo);
+SCORER *CompileAccuracyScorer(DTNODE *root, int depth, SSVINFO *ssvinfo,
+			      int tag);
+void DecisionTreeAccuracyBinary(DTNODE *root, SCORER *scorer,
+				void **data, long num_data,
+				MEMBERSET *train_members, long num_train,
+				MEMBERSET *test_members, long num_test,
+				long *num_negatives, long *num_false_negatives,
+				long *num_positives, long *num_false_positives,
 				SSVINFO *ssvinfo, int depth);
-double DecisionTreeAccuracy(DTNODE *root, void **data, int num_data,
-			    uchar *test_members, int num_test,
+double DecisionTreeAccuracy(DTNODE *root, SCORER *scorer,
+			    void **data, long num_data,
+			    MEMBERSET *test_members, long num_test,
 			    SSVINFO *ssvinfo);
-void CountDTPosNeg(DTNODE *root, int *num_pos, int *num_neg);
+void CountDTPosNeg(DTNODE *root, long *num_pos, long *num_neg);
 void PruneDecisionTree(DTNODE *root, DTNODE *node,
-			      void **data, int num_data,
-			      uchar *pruning_set, int num_prune,
+			      void **data, long num_data,
+			      MEMBERSET *pruning_set, long num_prune,
 			      SSVINFO *ssvinfo);
 
 #endif // PRUNE_DT_H
@@ -0,0 +1,286 @@
+/**************************************************************************
+ *
+ * roc.c
+ *
+ * Source file containing routines to sweep the decision threshold of a
+ * tree over a set of examples: ROC and precision-recall curves, the areas
+ * under them, and the confusion matrix at any threshold (see roc.h).
+ *
+ **************************************************************************/
+
+#include "roc.h"
+#include "profile.h"
+
+/* Score and class of an example. */
+typedef struct exscore {
+  double score;
+  int label;
+} EXSCORE;
+
+/* ......................................................................
+
+   Auxiliary function used by qsort to sort examples by decreasing score.
+
+   ...................................................................... */
+
+static int comp_exscores(const void *a, const void *b)
+{
+  const EXSCORE *ea = (const EXSCORE *) a, *eb = (const EXSCORE *) b;
+
+  return (ea->score == eb->score) ? 0 : ((ea->score > eb->score) ? -1 : 1);
+}
+
+/* ......................................................................
+
+   Score an example: the fraction of positive examples of the leaf (or
+   default branch of a discrete test) it reaches, or of the node whose
+   child it would take if that child is missing.  Unknown discrete values
+   are handled as ClassifyExample() does.
+
+   ...................................................................... */
+
+static double ExampleScore(DTNODE *node, void **data, long example,
+			   SSVINFO *ssvinfo)
+{
+  int child, val;
+
+  while (node->num_children > 0) {
+    switch (ssvinfo->types[node->test_attrib]) {
+    case 'b':
+      child = READ_ATTRIB_B(data, example, node->test_attrib);
+      break;
+    case 'd':
+      val = READ_ATTRIB_I(data, example, node->test_attrib);
+      if (val < ssvinfo->num_discrete_vals[node->test_attrib])
+	child = DiscreteChildIndex(node, val);
+      else
+	child = (node->subset != NULL) ? 0 : -1;
+      break;
+    case 'c':
+      child =
+	(READ_ATTRIB_C(data, example, node->test_attrib) >= node->threshold);
+      break;
+    default:
+      USER_ERROR1("Unknown attribute type '%c'",
+		  ssvinfo->types[node->test_attrib]);
+    }
+    if (child < 0 || node->children[child] == NULL)
+      break;
+    node = node->children[child];
+  }
+
+  return (double) node->num_pos / node->num_members;
+}
+
+/* ----------------------------------------------------------------------
+
+   Parse a comma-separated list of thresholds in [0, 1] into "thresholds",
+   if not NULL.  Returns the number of thresholds, or -1 if the list is
+   not valid.
+
+   ---------------------------------------------------------------------- */
+
+int ParseThresholds(char *list, double *thresholds)
+{
+  char *end;
+  double threshold;
+  int num_thresholds = 0;
+
+  do {
+    threshold = strtod(list, &end);
+    if (end == list || (*end != ',' && *end != '\0') ||
+	threshold < 0.0 || threshold > 1.0)
+      return -1;
+    if (thresholds != NULL)
+      thresholds[num_thresholds] = threshold;
+    num_thresholds++;
+    list = end + 1;
+  } while (*end == ',');
+
+  return num_thresholds;
+}
+
+/* ......................................................................
+
+   Classify the "members" with the tree once and build the points of
+   their curves, in order of decreasing threshold.  Returns the number of
+   points.
+
+   ...................................................................... */
+
+static long ComputeROCPoints(DTNODE *root, void **data, MEMBERSET *members,
+			     long num_members, ROCPOINT **points_ptr,
+			     SSVINFO *ssvinfo)
+{
+  MEMBERITER iter;
+  EXSCORE *scores;
+  ROCPOINT *points;
+  long example, i, num_scored = 0, num_points = 0;
+
+  scores = (EXSCORE *) getmem(MAX(num_members, 1) * sizeof(EXSCORE));
+  FOR_EACH_MEMBER(iter, members, example) {
+    scores[num_scored].score = ExampleScore(root, data, example, ssvinfo);
+    scores[num_scored++].label = READ_ATTRIB_B(data, example, 0);
+  }
+  qsort(scores, num_scored, sizeof(EXSCORE), comp_exscores);
+  PROFILE_COUNT(sorts, 1);
+
+  /* Every point counts the examples of the points before it. */
+  points = (ROCPOINT *) getmem(MAX(num_scored, 1) * sizeof(ROCPOINT));
+  for (i = 0; i < num_scored; i++) {
+    if (i == 0 || scores[i].score != scores[i - 1].score) {
+      points[num_points].threshold = scores[i].score;
+      points[num_points].true_pos =
+	(num_points > 0) ? points[num_points - 1].true_pos : 0;
+      points[num_points].false_pos =
+	(num_points > 0) ? points[num_points - 1].false_pos : 0;
+      num_points++;
+    }
+    if (scores[i].label)
+      points[num_points - 1].true_pos++;
+    else
+      points[num_points - 1].false_pos++;
+  }
+  freemem(scores);
+
+  *points_ptr = points;
+  return num_points;
+}
+
+/* ......................................................................
+
+   Find the point of the curves at a threshold: the last one whose
+   threshold is at least "threshold", or NULL if the tree predicts no
+   example positive.
+
+   ...................................................................... */
+
+static ROCPOINT *FindROCPoint(ROCPOINT *points, long num_points,
+			      double threshold)
+{
+  long lo = 0, hi = num_points, mid;
+
+  /* Points [0, lo) are at least "threshold", [hi, num_points) below. */
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (points[mid].threshold >= threshold)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return (lo > 0) ? (points + lo - 1) : (ROCPOINT *) NULL;
+}
+
+/* ......................................................................
+
+   Write the curves to a file, one line per point.
+
+   ...................................................................... */
+
+static void WriteROCPoints(char *filename, ROCPOINT *points, long num_points,
+			   long num_pos, long num_neg)
+{
+  FILE *fptr;
+  long i, tp, fp;
+
+  if ((fptr = fopen(filename, "w")) == NULL)
+    SYS_ERROR1("fopen(\"%s\", \"w\")", filename);
+  fprintf(fptr, "# threshold true_pos false_pos true_neg false_neg "
+	  "tpr fpr precision\n");
+  for (i = 0; i < num_points; i++) {
+    tp = points[i].true_pos;
+    fp = points[i].false_pos;
+    fprintf(fptr, "%.10g %ld %ld %ld %ld %.6f %.6f %.6f\n",
+	    points[i].threshold,
+	    tp, fp, num_neg - fp, num_pos - tp,
+	    (num_pos > 0) ? (double) tp / num_pos : 0.0,
+	    (num_neg > 0) ? (double) fp / num_neg : 0.0,
+	    (double) tp / (tp + fp));
+  }
+  if (fclose(fptr) != 0)
+    SYS_ERROR1("fclose(\"%s\")", filename);
+}
+
+/* ----------------------------------------------------------------------
+
+   Print the area under the ROC curve of the tree over a set of examples,
+   the average precision (the area under the precision-recall curve), and
+   the confusion matrix at every threshold of ssvinfo->thresholds (0.5 if
+   none).  The examples are classified only once, whatever the number of
+   thresholds.  The curves are written to ssvinfo->roc_filename, if set.
+
+   ---------------------------------------------------------------------- */
+
+void PrintROC(DTNODE *root, void **data, long num_data,
+	      MEMBERSET *members, long num_members, SSVINFO *ssvinfo)
+{
+  ROCPOINT *points, *point;
+  double *thresholds, default_threshold = 0.5;
+  double roc_auc = 0.0, avg_precision = 0.0;
+  long num_points, num_pos, num_neg, i;
+  int num_thresholds;
+  long tp, fp, prev_tp, prev_fp;
+
+  (void) num_data;
+  num_points = ComputeROCPoints(root, data, members, num_members, &points,
+				ssvinfo);
+  num_pos = (num_points > 0) ? points[num_points - 1].true_pos : 0;
+  num_neg = (num_points > 0) ? points[num_points - 1].false_pos : 0;
+
+  /* Trapezoids under the ROC curve, and precision at every step of
+     recall. */
+  for (i = 0, prev_tp = prev_fp = 0; i < num_points; i++) {
+    tp = points[i].true_pos;
+    fp = points[i].false_pos;
+    roc_auc += (fp - prev_fp) * (double) (tp + prev_tp) / 2.0;
+    avg_precision += (tp - prev_tp) * ((double) tp / (tp + fp));
+    prev_tp = tp;
+    prev_fp = fp;
+  }
+  roc_auc = (num_pos > 0 && num_neg > 0) ?
+    roc_auc / ((double) num_pos * num_neg) : 0.0;
+  avg_precision = (num_pos > 0) ? avg_precision / num_pos : 0.0;
+
+  printf("Examples:           %ld (%ld positive, %ld negative)\n",
+	 num_pos + num_neg, num_pos, num_neg);
+  printf("Distinct scores:    %ld\n", num_points);
+  printf("ROC AUC:            %.4f\n", roc_auc);
+  printf("Average precision:  %.4f\n\n", avg_precision);
+
+  if (ssvinfo->thresholds != NULL) {
+    num_thresholds = ParseThresholds(ssvinfo->thresholds, (double *) NULL);
+    thresholds = (double *) getmem(num_thresholds * sizeof(double));
+    ParseThresholds(ssvinfo->thresholds, thresholds);
+  } else {
+    num_thresholds = 1;
+    thresholds = &default_threshold;
+  }
+  printf("---------------------------------------------------------------\n"
+	 "Thresh.\tTrue\tFalse\tTrue\tFalse\tCorrect\tPrec.\tRecall\n"
+	 "\tpos.\tpos.\tneg.\tneg.\t%%\t%%\t%%\n"
+	 "---------------------------------------------------------------\n");
+  for (i = 0; i < num_thresholds; i++) {
+    point = FindROCPoint(points, num_points, thresholds[i]);
+    tp = (point != NULL) ? point->true_pos : 0;
+    fp = (point != NULL) ? point->false_pos : 0;
+    printf("%g\t%ld\t%ld\t%ld\t%ld\t%.1f\t%.1f\t%.1f\n", thresholds[i],
+	   tp, fp, num_neg - fp, num_pos - tp,
+	   (100.0 * (tp + num_neg - fp)) / MAX(num_pos + num_neg, 1),
+	   (tp + fp > 0) ? (100.0 * tp) / (tp + fp) : 0.0,
+	   (num_pos > 0) ? (100.0 * tp) / num_pos : 0.0);
+  }
+  printf("---------------------------------------------------------------\n");
+
+  if (ssvinfo->roc_filename != NULL) {
+    WriteROCPoints(ssvinfo->roc_filename, points, num_points,
+		   num_pos, num_neg);
+    printf("\nCurves written to \"%s\"\n", ssvinfo->roc_filename);
+  }
+
+  if (thresholds != &default_threshold)
+    freemem(thresholds);
+  freemem(points);
+}
+
+/**************************************************************************/
@@ -0,0 +1,32 @@
+/**************************************************************************
+ *
+ * roc.h
+ *
+ * Header file to roc.c
+ *
+ **************************************************************************/
+
+#ifndef ROC_H
+#define ROC_H 1
+
+#include "dt.h"
+#include "ssv.h"
+
+/* The score of an example is the fraction of positive examples in the leaf
+   it reaches, and the tree predicts it positive at threshold t if its
+   score is at least t (0.5 is the threshold CheckCorrectness() uses).  An
+   example that reaches a missing subtree is scored by the node whose child
+   is missing.  Every distinct score of a set of examples is a point of its
+   ROC and precision-recall curves. */
+typedef struct rocpoint {
+  double threshold;             /* Score of the point. */
+  long true_pos, false_pos;     /* Examples scored at least "threshold". */
+} ROCPOINT;
+
+/* Function prototypes. */
+int ParseThresholds(char *list, double *thresholds);
+void PrintROC(DTNODE *root, void **data, long num_data,
+	      MEMBERSET *members, long num_members, SSVINFO *ssvinfo);
+
+#endif // ROC_H
+/**************************************************************************/
@@ -0,0 +1,465 @@
+/**************************************************************************
+ *
+ * score-dt.c
+ *
+ * Source file containing routines to classify examples with a decision
+ * tree compiled into bitvectors of its leaves (see score-dt.h).
+ *
+ **************************************************************************/
+
+#include "score-dt.h"
+#include "bitarray.h"
+
+#define ALL_LEAVES (~0ULL)
+
+/* A test on a continuous attribute, found while compiling. */
+typedef struct conttest {
+  int attrib;
+  double threshold;
+  int lo, hi;                   /* Leaves ruled out by failing it. */
+} CONTTEST;
+
+/* State of the compilation of a tree. */
+typedef struct scorebuild {
+  int next_leaf;
+  unsigned long long **value_masks;  /* Masks (as whole bitvectors) of
+					every value of every binary or
+					discrete attribute tested; NULL for
+					the others. */
+  int *lo_leaf, *hi_leaf;       /* Range of the leaves some test on every
+				   attribute rules out. */
+  CONTTEST *tests;              /* Tests on continuous attributes. */
+  int num_tests, max_tests;
+  int tag;                      /* Subsystem the memory is accounted to. */
+} SCOREBUILD;
+
+/* ......................................................................
+
+   Count the leaves of a tree, as CheckCorrectness() sees it down to
+   "depth", and find the highest attribute tested.
+
+   ...................................................................... */
+
+static int CountScorerLeaves(DTNODE *node, int depth, SSVINFO *ssvinfo,
+			     int *max_attrib)
+{
+  int child, num_leaves = 0;
+
+  if (node == NULL || node->num_children == 0 || depth == 1)
+    return 1;
+  *max_attrib = MAX(*max_attrib, node->test_attrib);
+  for (child = 0; child < node->num_children; child++)
+    num_leaves += CountScorerLeaves(node->children[child], depth - 1,
+				    ssvinfo, max_attrib);
+  if (ssvinfo->types[node->test_attrib] == 'd' && node->subset == NULL)
+    num_leaves++;               /* The default branch. */
+  return num_leaves;
+}
+
+/* ......................................................................
+
+   Clear leaves "lo" to "hi" - 1 of a bitvector whose first word holds
+   leaves 64 * "first_word" on.
+
+   ...................................................................... */
+
+static void ClearLeaves(unsigned long long *mask, int first_word,
+			int lo, int hi)
+{
+  int word;
+
+  for (word = lo >> 6; lo < hi; word++, lo = word << 6)
+    mask[word - first_word] &=
+      ~((ALL_LEAVES << (lo & 63)) &
+	((hi - (word << 6) >= 64) ? ALL_LEAVES :
+	 ~(ALL_LEAVES << (hi - (word << 6)))));
+}
+
+/* ......................................................................
+
+   Return the masks of the values of a binary or discrete attribute,
+   "num_vals" of them, creating them (keeping all leaves) if needed.
+
+   ...................................................................... */
+
+static unsigned long long *ValueMasks(SCOREBUILD *build, int attrib,
+				      int num_vals, int num_words)
+{
+  if (build->value_masks[attrib] == NULL) {
+    build->value_masks[attrib] = (unsigned long long *)
+      getmem_tag(num_vals * num_words * sizeof(unsigned long long),
+		 build->tag);
+    memset(build->value_masks[attrib], 0xff,
+	   num_vals * num_words * sizeof(unsigned long long));
+  }
+  return build->value_masks[attrib];
+}
+
+/* ......................................................................
+
+   Number the leaves of a subtree from build->next_leaf on, and record
+   which leaves each of its tests rules out.
+
+   ...................................................................... */
+
+static void CompileNode(SCORER *scorer, SCOREBUILD *build, DTNODE *node,
+			int depth, double pos_prior, SSVINFO *ssvinfo)
+{
+  int lo = build->next_leaf, default_leaf, child, val, num_vals;
+  int attrib, num_words = scorer->num_words;
+  int *starts;
+  unsigned long long *masks;
+
+  if (node == NULL) {
+    scorer->leaf_class[build->next_leaf++] = -1;
+    return;
+  }
+  if (node->num_children == 0 || depth == 1) {
+    scorer->leaf_class[build->next_leaf++] =
+      (node->num_pos >= (pos_prior * node->num_members));
+    return;
+  }
+
+  attrib = node->test_attrib;
+  starts = (int *)
+    getmem_tag((node->num_children + 1) * sizeof(int), build->tag);
+  for (child = 0; child < node->num_children; child++) {
+    starts[child] = build->next_leaf;
+    CompileNode(scorer, build, node->children[child], depth - 1,
+		pos_prior, ssvinfo);
+  }
+  default_leaf = starts[node->num_children] = build->next_leaf;
+  if (ssvinfo->types[attrib] == 'd' && node->subset == NULL)
+    scorer->leaf_class[build->next_leaf++] =
+      (node->num_pos >= (pos_prior * node->num_members));
+  build->lo_leaf[attrib] = MIN(build->lo_leaf[attrib], lo);
+  build->hi_leaf[attrib] = MAX(build->hi_leaf[attrib], build->next_leaf);
+
+  switch (ssvinfo->types[attrib]) {
+  case 'b':  /* Value v takes child v. */
+    masks = ValueMasks(build, attrib, 2, num_words);
+    for (val = 0; val < 2; val++)
+      ClearLeaves(masks + val * num_words, 0, lo, starts[val]);
+    break;
+  case 'd':  /* One more mask, for the values beyond those known. */
+    num_vals = ssvinfo->num_discrete_vals[attrib];
+    masks = ValueMasks(build, attrib, num_vals + 1, num_words);
+    for (val = 0; val <= num_vals; val++) {
+      if (val < num_vals)
+	child = DiscreteChildIndex(node, val);
+      else
+	child = (node->subset != NULL) ? 0 : -1;
+      ClearLeaves(masks + val * num_words, 0, lo,
+		  (child >= 0) ? starts[child] : default_leaf);
+    }
+    break;
+  case 'c':  /* Failing the test (value >= threshold) takes child 1. */
+    if (build->num_tests == build->max_tests) {
+      build->max_tests *= 2;
+      build->tests = (CONTTEST *)
+	regetmem(build->tests, build->max_tests * sizeof(CONTTEST));
+    }
+    build->tests[build->num_tests].attrib = attrib;
+    build->tests[build->num_tests].threshold = node->threshold;
+    build->tests[build->num_tests].lo = lo;
+    build->tests[build->num_tests].hi = starts[1];
+    build->num_tests++;
+    break;
+  default:
+    USER_ERROR1("Unknown attribute type '%c'", ssvinfo->types[attrib]);
+  }
+  freemem(starts);
+}
+
+/* Order of tests by attribute, then threshold, for qsort(). */
+static int CompareContTests(const void *a, const void *b)
+{
+  const CONTTEST *test_a = (const CONTTEST *) a, *test_b = (const CONTTEST *) b;
+
+  if (test_a->attrib != test_b->attrib)
+    return test_a->attrib - test_b->attrib;
+  return (test_a->threshold > test_b->threshold) -
+    (test_a->threshold < test_b->threshold);
+}
+
+/* ......................................................................
+
+   Free the state of the compilation of a tree.
+
+   ...................................................................... */
+
+static void FreeScoreBuild(SCOREBUILD *build, int num_features)
+{
+  int attrib;
+
+  for (attrib = 0; attrib < num_features; attrib++)
+    if (build->value_masks[attrib] != NULL)
+      freemem(build->value_masks[attrib]);
+  freemem(build->value_masks);
+  freemem(build->lo_leaf);
+  freemem(build->hi_leaf);
+  freemem(build->tests);
+}
+
+/* ----------------------------------------------------------------------
+
+   Compile a decision tree, as CheckCorrectness() evaluates it down to
+   "depth" (0 for the whole tree) with prior "pos_prior", into a SCORER.
+   The tree is not needed afterwards.  Returns NULL if it has more than
+   "max_leaves" leaves (0 = no limit).  The masks take about a bit per
+   leaf for every value of a binary or discrete attribute and every
+   threshold of a continuous one; their memory, and that of compiling
+   them, is accounted to "tag" (see getmem_tag()).
+
+   ---------------------------------------------------------------------- */
+
+SCORER *CompileDecisionTree(DTNODE *root, int depth, double pos_prior,
+			    int max_leaves, SSVINFO *ssvinfo, int tag)
+{
+  SCORER *scorer;
+  SCOREBUILD build;
+  int num_features, attrib, val, num_masks, test, first_test, num_tests;
+  int num_leaves, span_words;
+  long num_mask_words;
+  unsigned long long *masks;
+
+  num_features = 0;
+  num_leaves = CountScorerLeaves(root, depth, ssvinfo, &num_features);
+  num_features++;
+  if (max_leaves > 0 && num_leaves > max_leaves)
+    return NULL;
+
+  scorer = (SCORER *) getmem_tag(sizeof(SCORER), tag);
+  scorer->num_leaves = num_leaves;
+  scorer->num_words = (scorer->num_leaves + 63) / 64;
+  scorer->leaf_class = (signed char *)
+    getmem_tag(scorer->num_leaves * sizeof(signed char), tag);
+  scorer->leaves = (unsigned long long *)
+    getmem_tag(scorer->num_words * sizeof(unsigned long long), tag);
+
+  /* Number the leaves and find the leaves every test rules out. */
+  build.next_leaf = 0;
+  build.value_masks = (unsigned long long **)
+    getmem_tag(num_features * sizeof(unsigned long long *), tag);
+  bzero(build.value_masks, num_features * sizeof(unsigned long long *));
+  build.lo_leaf = (int *) getmem_tag(num_features * sizeof(int), tag);
+  build.hi_leaf = (int *) getmem_tag(num_features * sizeof(int), tag);
+  for (attrib = 0; attrib < num_features; attrib++) {
+    build.lo_leaf[attrib] = scorer->num_leaves;
+    build.hi_leaf[attrib] = 0;
+  }
+  build.num_tests = 0;
+  build.max_tests = 64;
+  build.tests = (CONTTEST *)
+    getmem_tag(build.max_tests * sizeof(CONTTEST), tag);
+  build.tag = tag;
+  CompileNode(scorer, &build, root, depth, pos_prior, ssvinfo);
+  qsort(build.tests, build.num_tests, sizeof(CONTTEST), CompareContTests);
+
+  /* Lay the masks out, attribute by attribute, each over the words of the
+     leaves its tests rule out. */
+  scorer->types = ssvinfo->types;
+  scorer->tested = (int *) getmem_tag(num_features * sizeof(int), tag);
+  scorer->num_vals = (int *) getmem_tag(num_features * sizeof(int), tag);
+  scorer->num_thresholds = (int *)
+    getmem_tag(num_features * sizeof(int), tag);
+  scorer->first_threshold = (int *)
+    getmem_tag(num_features * sizeof(int), tag);
+  scorer->first_word = (int *)
+    getmem_tag(num_features * sizeof(int), tag);
+  scorer->span_words = (int *)
+    getmem_tag(num_features * sizeof(int), tag);
+  scorer->first_mask = (long *)
+    getmem_tag(num_features * sizeof(long), tag);
+  scorer->num_tested = 0;
+  num_mask_words = 0;
+  test = 0;
+  for (attrib = 0; attrib < num_features; attrib++) {
+    scorer->num_vals[attrib] = ssvinfo->num_discrete_vals[attrib];
+    scorer->first_threshold[attrib] = test;
+    while (test < build.num_tests && build.tests[test].attrib == attrib)
+      test++;
+    scorer->num_thresholds[attrib] = test - scorer->first_threshold[attrib];
+    if (build.lo_leaf[attrib] >= build.hi_leaf[attrib])
+      continue;
+    scorer->first_word[attrib] = build.lo_leaf[attrib] >> 6;
+    scorer->span_words[attrib] = ((build.hi_leaf[attrib] + 63) >> 6) -
+      scorer->first_word[attrib];
+    scorer->first_mask[attrib] = num_mask_words;
+    switch (ssvinfo->types[attrib]) {
+    case 'b': num_masks = 2; break;
+    case 'd': num_masks = scorer->num_vals[attrib] + 1; break;
+    default:  num_masks = scorer->num_thresholds[attrib] + 1; break;
+    }
+    num_mask_words += (long) num_masks * scorer->span_words[attrib];
+    scorer->tested[scorer->num_tested++] = attrib;
+  }
+
+  scorer->masks = (unsigned long long *)
+    getmem_tag(MAX(num_mask_words, 1) * sizeof(unsigned long long), tag);
+  scorer->thresholds = (double *)
+    getmem_tag(MAX(build.num_tests, 1) * sizeof(double), tag);
+  for (test = 0; test < build.num_tests; test++)
+    scorer->thresholds[test] = build.tests[test].threshold;
+  for (test = 0; test < scorer->num_tested; test++) {
+    attrib = scorer->tested[test];
+    masks = scorer->masks + scorer->first_mask[attrib];
+    span_words = scorer->span_words[attrib];
+    if (build.value_masks[attrib] != NULL) {
+      num_masks = (ssvinfo->types[attrib] == 'b') ? 2 :
+	scorer->num_vals[attrib] + 1;
+      for (val = 0; val < num_masks; val++)
+	memcpy(masks + val * span_words,
+	       build.value_masks[attrib] + val * scorer->num_words +
+	       scorer->first_word[attrib],
+	       span_words * sizeof(unsigned long long));
+      continue;
+    }
+
+    /* The mask of the values from threshold t on is that of the values
+       below it, less the leaves the test at t rules out. */
+    first_test = scorer->first_threshold[attrib];
+    num_tests = scorer->num_thresholds[attrib];
+    memset(masks, 0xff, span_words * sizeof(unsigned long long));
+    for (val = 1; val <= num_tests; val++) {
+      memcpy(masks + val * span_words, masks + (val - 1) * span_words,
+	     span_words * sizeof(unsigned long long));
+      ClearLeaves(masks + val * span_words, scorer->first_word[attrib],
+		  build.tests[first_test + val - 1].lo,
+		  build.tests[first_test + val - 1].hi);
+    }
+  }
+  FreeScoreBuild(&build, num_features);
+
+  return scorer;
+}
+
+/* ......................................................................
+
+   Return the index of the mask of attribute "attrib" for an example:
+   its value for a binary or discrete attribute (the number of values for
+   those beyond), or the number of thresholds up to its value for a
+   continuous one.
+
+   ...................................................................... */
+
+static inline int MaskIndex(SCORER *scorer, void **data, long example,
+			    int attrib)
+{
+  double *thresholds, *first, value;
+  int val, num, half;
+
+  switch (scorer->types[attrib]) {
+  case 'b':
+    return READ_ATTRIB_B(data, example, attrib);
+  case 'd':
+    val = READ_ATTRIB_I(data, example, attrib);
+    return MIN(val, scorer->num_vals[attrib]);
+  default:
+    value = READ_ATTRIB_C(data, example, attrib);
+    thresholds = scorer->thresholds + scorer->first_threshold[attrib];
+    first = thresholds;
+    for (num = scorer->num_thresholds[attrib]; num > 1; num -= half) {
+      half = num / 2;           /* Without a branch to mispredict. */
+      first = (first[half] <= value) ? first + half : first;
+    }
+    return (first - thresholds) + (num == 1 && first[0] <= value);
+  }
+}
+
+/* Clear, in the bitvector "leaves", the leaves that mask "mask" of
+   attribute "attrib" rules out. */
+#define AND_MASK(scorer, leaves, attrib, mask) {			\
+  unsigned long long *mask_word = (scorer)->masks +			\
+    (scorer)->first_mask[attrib] + (long) (mask) * (scorer)->span_words[attrib]; \
+  unsigned long long *leaf_word = (leaves) + (scorer)->first_word[attrib]; \
+  int word;								\
+  for (word = 0; word < (scorer)->span_words[attrib]; word++)		\
+    leaf_word[word] &= mask_word[word];					\
+}
+
+/* Class of the first leaf left in the bitvector "leaves". */
+static inline int FirstLeafClass(SCORER *scorer, unsigned long long *leaves)
+{
+  int word;
+
+  for (word = 0; leaves[word] == 0; word++)
+    ;
+  return scorer->leaf_class[64 * word + __builtin_ctzll(leaves[word])];
+}
+
+/* ----------------------------------------------------------------------
+
+   Classify an example of "data" with a compiled tree.  Returns the class
+   predicted, or -1 if the example reaches a missing subtree (which
+   CheckCorrectness() counts as wrong).
+
+   ---------------------------------------------------------------------- */
+
+int ScoreExample(SCORER *scorer, void **data, long example)
+{
+  unsigned long long *leaves = scorer->leaves;
+  int tested, attrib;
+
+  memset(leaves, 0xff, scorer->num_words * sizeof(unsigned long long));
+  for (tested = 0; tested < scorer->num_tested; tested++) {
+    attrib = scorer->tested[tested];
+    AND_MASK(scorer, leaves, attrib,
+	     MaskIndex(scorer, data, example, attrib));
+  }
+  return FirstLeafClass(scorer, leaves);
+}
+
+/* ----------------------------------------------------------------------
+
+   Classify examples "first" to "first" + "num_examples" - 1 of "data"
+   together, into "classes" (as ScoreExample() does).  The masks of every
+   attribute are applied to all the examples in turn, so that they stay
+   in cache.
+
+   ---------------------------------------------------------------------- */
+
+void ScoreExamples(SCORER *scorer, void **data, long first,
+		   long num_examples, signed char *classes)
+{
+  unsigned long long *leaves;
+  long example;
+  int tested, attrib, num_words = scorer->num_words;
+
+  leaves = (unsigned long long *)
+    getmem(MAX(num_examples, 1) * num_words * sizeof(unsigned long long));
+  memset(leaves, 0xff, num_examples * num_words * sizeof(unsigned long long));
+  for (tested = 0; tested < scorer->num_tested; tested++) {
+    attrib = scorer->tested[tested];
+    for (example = 0; example < num_examples; example++)
+      AND_MASK(scorer, leaves + example * num_words, attrib,
+	       MaskIndex(scorer, data, first + example, attrib));
+  }
+  for (example = 0; example < num_examples; example++)
+    classes[example] =
+      FirstLeafClass(scorer, leaves + example * num_words);
+  freemem(leaves);
+}
+
+/* ----------------------------------------------------------------------
+
+   Release a compiled tree.
+
+   ---------------------------------------------------------------------- */
+
+void FreeScorer(SCORER *scorer)
+{
+  freemem(scorer->leaf_class);
+  freemem(scorer->leaves);
+  freemem(scorer->tested);
+  freemem(scorer->num_vals);
+  freemem(scorer->num_thresholds);
+  freemem(scorer->first_threshold);
+  freemem(scorer->first_word);
+  freemem(scorer->span_words);
+  freemem(scorer->first_mask);
+  freemem(scorer->masks);
+  freemem(scorer->thresholds);
+  freemem(scorer);
+}
+/**************************************************************************/
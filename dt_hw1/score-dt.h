@@ -0,0 +1,73 @@
+/**************************************************************************
+ *
+ * score-dt.h
+ *
+ * Header file to score-dt.c
+ *
+ **************************************************************************/
+
+#ifndef SCORE_DT_H
+#define SCORE_DT_H 1
+
+#include "dt.h"
+#include "ssv.h"
+
+/* Most leaves of a tree that DecisionTreeAccuracy() and
+   DecisionTreeAccuracyBinary() compile; as an example costs a pass over
+   a word of 64 leaves per attribute tested, larger trees are faster to
+   evaluate node by node (see the quick_score kernel of microbench). */
+#ifndef SCORE_MAX_LEAVES
+#define SCORE_MAX_LEAVES 128
+#endif
+
+/* A decision tree compiled for fast classification (after QuickScorer).
+   The leaves are numbered from left to right, the leaf of the default
+   branch of a discrete test coming after those of its children, and every
+   test an example takes to child j rules out the leaves of the children
+   (and the default branch) before j.  Whatever the path, the leftmost
+   leaf that no test of the tree rules out is the one the example reaches,
+   so an example is classified by clearing, in a bitvector of the leaves,
+   the leaves every test rules out, and finding the first bit still set.
+   No test depends on another, so there is no branch to mispredict and no
+   pointer to chase.
+
+   The tests on one attribute rule out the same leaves for all the values
+   that take the same children everywhere: one per value of a binary or
+   discrete attribute, and one per interval between the sorted thresholds
+   of a continuous one.  Their union is precomputed as a mask for each
+   value or interval, so an example costs a single pass over the mask of
+   each attribute tested, whatever the number of tests.  A mask only
+   covers the words of leaves that some test on its attribute can rule
+   out. */
+
+typedef struct scorer {
+  int num_leaves;
+  int num_words;                /* Words of a bitvector of the leaves. */
+  signed char *leaf_class;      /* Class each leaf predicts: 0, 1, or -1
+				   for a missing subtree (never correct). */
+  int num_tested;               /* Number of attributes tested. */
+  int *tested;                  /* The attributes tested. */
+  char *types;                  /* Types of the attributes. */
+  int *num_vals;                /* Values of every discrete attribute
+				   (those beyond take the default branch). */
+  int *num_thresholds;          /* Thresholds of every continuous
+				   attribute, in increasing order from */
+  int *first_threshold;         /* thresholds[first_threshold[attrib]]. */
+  double *thresholds;
+  int *first_word;              /* First word, and number of words, of */
+  int *span_words;              /* the masks of every attribute, which */
+  long *first_mask;             /* start at masks[first_mask[attrib]]. */
+  unsigned long long *masks;
+  unsigned long long *leaves;   /* Scratch bitvector of the leaves. */
+} SCORER;
+
+/* Function prototypes. */
+SCORER *CompileDecisionTree(DTNODE *root, int depth, double pos_prior,
+			    int max_leaves, SSVINFO *ssvinfo, int tag);
+int ScoreExample(SCORER *scorer, void **data, long example);
+void ScoreExamples(SCORER *scorer, void **data, long first,
+		   long num_examples, signed char *classes);
+void FreeScorer(SCORER *scorer);
+
+#endif // SCORE_DT_H
+/**************************************************************************/
@@ -0,0 +1,597 @@
+/**************************************************************************
+ *
+ * serve.c
+ *
+ * Source file containing routines to serve a saved decision tree: a
+ * long-running process answers classification requests on a Unix domain
+ * socket (see serve.h), and picks up new versions of the model file.
+ *
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "serve.h"
+#include "libdt.h"
+#include "dt.h"
+#include "prune-dt.h"
+#include "score-dt.h"
+#include "update.h"
+#include "ssv.h"
+#include "bitarray.h"
+
+/* Prior of the positive class, as in DecisionTreeAccuracy(). */
+#define SERVE_POS_PRIOR 0.5
+
+/* A model being served. */
+typedef struct servedmodel {
+  DTCONTEXT context;            /* Of all the memory of the model but this
+				   structure. */
+  DTNODE *tree;
+  SCORER *scorer;               /* The tree compiled, or NULL if it has more
+				   than SCORE_MAX_LEAVES leaves. */
+  int num_features;
+  SSVINFO ssvinfo;
+  VALDICT dict;                 /* Its discrete values. */
+  void **batch;                 /* Data set of SERVE_MAX_BATCH examples
+				   that a batch of requests is read into. */
+  struct stat file_stat;        /* Of the file it was loaded from. */
+} SERVEDMODEL;
+
+/* A connection of a client. */
+typedef struct serveclient {
+  int fd;
+  char *in;                     /* Bytes read and not yet answered. */
+  int in_len, in_size;
+  char *out;                    /* Answers not yet sent. */
+  int out_len, out_size;
+  int done;                     /* Nothing more is to be read: close the
+				   connection once answered. */
+  int skipping;                 /* Skipping the rest of a line too long. */
+} SERVECLIENT;
+
+/* A request of a batch. */
+typedef struct serverequest {
+  int client;
+  int row;                      /* Row of the example in the batch, or -1
+				   if the request is bad. */
+  char *error;                  /* Why, if it is. */
+} SERVEREQUEST;
+
+static volatile sig_atomic_t serve_stop = 0, serve_reload = 0;
+
+/* ......................................................................
+
+   Signal handler: SIGHUP checks the model file at once, SIGINT and
+   SIGTERM stop the server.
+
+   ...................................................................... */
+
+static void ServeSignal(int sig)
+{
+  if (sig == SIGHUP)
+    serve_reload = 1;
+  else
+    serve_stop = 1;
+}
+
+/* ......................................................................
+
+   Load a model file into "model", in its context, and compile its tree
+   if it is small enough.  Returns DT_OK or the status of the error.
+
+   ...................................................................... */
+
+static int LoadModelFile(SERVEDMODEL *model, char *filename)
+{
+  int feature;
+  char type;
+
+  DT_ENTER(&model->context);
+
+  if (stat(filename, &model->file_stat) < 0)
+    SYS_ERROR1("stat(\"%s\")", filename);
+  model->tree = LoadModel(filename, &model->num_features, &model->ssvinfo);
+  model->scorer = CompileDecisionTree(model->tree, 0, SERVE_POS_PRIOR,
+				      SCORE_MAX_LEAVES, &model->ssvinfo,
+				      MEM_TREE);
+  BuildValueDict(&model->dict, model->num_features, &model->ssvinfo);
+
+  /* Values beyond those of a discrete attribute (unknown to the model)
+     are read as its number of values, so the codes are ints. */
+  model->batch = (void **)
+    getmem_tag(model->num_features * sizeof(void *), MEM_DATASET);
+  for (feature = 0; feature < model->num_features; feature++) {
+    type = model->ssvinfo.types[feature];
+    model->batch[feature] =
+      NewDataColumn(SERVE_MAX_BATCH, type,
+		    (type == 'd') ? sizeof(int) : sizeof(double));
+  }
+
+  DT_LEAVE(&model->context);
+}
+
+/* ......................................................................
+
+   Load a model file in a context of its own, which reports errors and
+   caps memory as the server's does.  Returns NULL if it does not load,
+   having reported why.
+
+   ...................................................................... */
+
+static SERVEDMODEL *LoadServedModel(char *filename)
+{
+  DTCONTEXT *server = CurrentContext();
+  SERVEDMODEL *model;
+
+  model = (SERVEDMODEL *) getmem_tag(sizeof(SERVEDMODEL), MEM_TREE);
+  DTInitContext(&model->context);
+  model->context.name = server->name;
+  model->context.error = server->error;
+  model->context.error_arg = server->error_arg;
+  model->context.mem_cap = server->mem_cap;
+  if (LoadModelFile(model, filename) != DT_OK) {
+    DTFreeContext(&model->context);
+    freemem(model);
+    return (SERVEDMODEL *) NULL;
+  }
+
+  return model;
+}
+
+/* Release a model from LoadServedModel(), with all of its memory. */
+static void FreeServedModel(SERVEDMODEL *model)
+{
+  DTFreeContext(&model->context);
+  freemem(model);
+}
+
+/* ......................................................................
+
+   Return the model to serve: a new one if the model file changed since
+   "model" was loaded and loads, or else "model" itself.  The file is
+   read once, so what is served is what was checked.  The model file
+   should be replaced with rename(), so that it is never seen half
+   written.
+
+   ...................................................................... */
+
+static SERVEDMODEL *ReloadServedModel(SERVEDMODEL *model, char *filename)
+{
+  SERVEDMODEL *new_model;
+  struct stat file_stat;
+
+  if (stat(filename, &file_stat) < 0)
+    return model;               /* Being replaced, perhaps. */
+  if (file_stat.st_dev == model->file_stat.st_dev &&
+      file_stat.st_ino == model->file_stat.st_ino &&
+      file_stat.st_size == model->file_stat.st_size &&
+      file_stat.st_mtim.tv_sec == model->file_stat.st_mtim.tv_sec &&
+      file_stat.st_mtim.tv_nsec == model->file_stat.st_mtim.tv_nsec)
+    return model;
+
+  if ((new_model = LoadServedModel(filename)) == NULL) {
+    fprintf(stderr, "%s: \"%s\" does not load, still serving the previous "
+	    "version\n", progname, filename);
+    model->file_stat = file_stat;  /* Not tried again until it changes. */
+    return model;
+  }
+  FreeServedModel(model);
+  printf("Loaded a new version of \"%s\"\n", filename);
+  fflush(stdout);
+
+  return new_model;
+}
+
+/* Make reads and writes of a file descriptor return at once. */
+static void SetNonBlocking(int fd)
+{
+  int flags;
+
+  if ((flags = fcntl(fd, F_GETFL)) < 0 ||
+      fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    SYS_ERROR1("fcntl(%d)", fd);
+}
+
+/* ......................................................................
+
+   Create the socket of the server, replacing a socket left by another.
+
+   ...................................................................... */
+
+static int OpenServerSocket(char *filename)
+{
+  struct sockaddr_un addr;
+  struct stat file_stat;
+  int fd;
+
+  if (strlen(filename) >= sizeof(addr.sun_path))
+    USER_ERROR1("socket name \"%s\" is too long", filename);
+  if (lstat(filename, &file_stat) == 0) {
+    if (!S_ISSOCK(file_stat.st_mode))
+      USER_ERROR1("\"%s\" exists and is not a socket", filename);
+    unlink(filename);
+  }
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+    SYS_ERROR1("socket(\"%s\")", filename);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, filename);
+  if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    SYS_ERROR1("bind(\"%s\")", filename);
+  if (listen(fd, SOMAXCONN) < 0)
+    SYS_ERROR1("listen(\"%s\")", filename);
+  SetNonBlocking(fd);
+
+  return fd;
+}
+
+/* ......................................................................
+
+   Read what a client sent, as long as there is room for it.  The buffer
+   grows up to SERVE_MAX_LINE bytes, always leaving room for a final NUL.
+
+   ...................................................................... */
+
+static void ReadClient(SERVECLIENT *client)
+{
+  ssize_t num_read;
+
+  while (!client->done) {
+    if (client->in_len + 1 == client->in_size) {
+      if (client->in_size >= SERVE_MAX_LINE)
+	break;
+      client->in_size = MIN(2 * client->in_size, SERVE_MAX_LINE);
+      client->in = (char *) regetmem(client->in, client->in_size);
+    }
+    num_read = read(client->fd, client->in + client->in_len,
+		    client->in_size - 1 - client->in_len);
+    if (num_read > 0)
+      client->in_len += num_read;
+    else if (num_read == 0)
+      client->done = 1;
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+      break;
+    else if (errno != EINTR)
+      client->done = 1;
+  }
+}
+
+/* Append an answer to the output of a client. */
+static void AppendAnswer(SERVECLIENT *client, char *answer)
+{
+  int len = strlen(answer);
+
+  if (client->out_len + len > client->out_size) {
+    client->out_size = MAX(2 * client->out_size, client->out_len + len);
+    client->out = (char *) regetmem(client->out, client->out_size);
+  }
+  memcpy(client->out + client->out_len, answer, len);
+  client->out_len += len;
+}
+
+/* ......................................................................
+
+   Send as much of the output of a client as it takes.  A client that
+   cannot be written to is done with, whatever is left.
+
+   ...................................................................... */
+
+static void WriteClient(SERVECLIENT *client)
+{
+  ssize_t num_written;
+  int sent = 0;
+
+  while (sent < client->out_len) {
+    num_written = write(client->fd, client->out + sent,
+			client->out_len - sent);
+    if (num_written > 0)
+      sent += num_written;
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+      break;
+    else if (errno != EINTR) {
+      client->done = 1;
+      client->in_len = 0;
+      sent = client->out_len;
+    }
+  }
+  memmove(client->out, client->out + sent, client->out_len - sent);
+  client->out_len -= sent;
+}
+
+/* ......................................................................
+
+   Read the example of a request (a NUL-terminated line) into row "row"
+   of the batch of a model.  Returns NULL, or why the request is bad.
+
+   ...................................................................... */
+
+#define IS_BLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\r')
+
+static char *ParseRequest(SERVEDMODEL *model, char *line, int row)
+{
+  SSVINFO *ssvinfo = &model->ssvinfo;
+  int feature, val;
+  char *word, *end;
+  double value;
+
+  for (feature = 1; feature < model->num_features; feature++) {
+    while (IS_BLANK(*line))
+      line++;
+    if (*line == '\0')
+      return "too few values";
+    for (word = line; *line != '\0' && !IS_BLANK(*line); line++)
+      ;
+    switch (ssvinfo->types[feature]) {
+    case 'b':
+      if (line - word != 1 || (*word != '0' && *word != '1'))
+	return "a binary value is not 0 or 1";
+      write_attrib_b(model->batch, row, feature, *word - '0');
+      break;
+    case 'd':
+      val = FindDiscreteValue(&model->dict, feature, word, line - word,
+			      ssvinfo);
+      write_attrib_i(model->batch, row, feature,
+		     (val >= 0) ? val : ssvinfo->num_discrete_vals[feature]);
+      break;
+    case 'c':
+      value = strtod(word, &end);
+      if (end != line)
+	return "a continuous value is not a number";
+      write_attrib_c(model->batch, row, feature, value);
+      break;
+    }
+  }
+  while (IS_BLANK(*line))
+    line++;
+
+  return (*line == '\0') ? NULL : "too many values";
+}
+
+/* ......................................................................
+
+   Classify the examples of a batch of requests, and append the answers
+   to the output of their clients, in order.
+
+   ...................................................................... */
+
+static void ClassifyBatch(SERVEDMODEL *model, SERVECLIENT *clients,
+			  SERVEREQUEST *requests, int num_requests,
+			  int num_rows, signed char *classes)
+{
+  SERVEREQUEST *request;
+  SERVECLIENT *client;
+  int row;
+
+  if (model->scorer != NULL)
+    ScoreExamples(model->scorer, model->batch, 0, num_rows, classes);
+  else
+    for (row = 0; row < num_rows; row++)
+      classes[row] = ClassifyExample(model->tree, model->batch, row,
+				     SERVE_POS_PRIOR, &model->ssvinfo);
+
+  for (request = requests; request < requests + num_requests; request++) {
+    client = clients + request->client;
+    if (request->row < 0) {
+      AppendAnswer(client, "error: ");
+      AppendAnswer(client, request->error);
+      AppendAnswer(client, "\n");
+    } else
+      AppendAnswer(client, (classes[request->row] < 0) ? "?\n" :
+		   (classes[request->row] > 0) ? "1\n" : "0\n");
+  }
+}
+
+/* ......................................................................
+
+   Answer all the complete requests the clients sent, in batches of up to
+   SERVE_MAX_BATCH requests.  The last line of a client that is done needs
+   no newline; a line that does not fit the buffer is answered with an
+   error, and its rest skipped.
+
+   ...................................................................... */
+
+static void AnswerRequests(SERVEDMODEL *model, SERVECLIENT *clients,
+			   int num_clients, SERVEREQUEST *requests,
+			   signed char *classes)
+{
+  SERVECLIENT *client;
+  SERVEREQUEST *request;
+  char *line, *end, *in_end;
+  int num_requests = 0, num_rows = 0, index, too_long;
+
+  for (index = 0; index < num_clients; index++) {
+    client = clients + index;
+    line = client->in;
+    in_end = client->in + client->in_len;
+    if (client->skipping) {
+      if ((end = memchr(line, '\n', in_end - line)) == NULL)
+	line = in_end;
+      else {
+	line = end + 1;
+	client->skipping = 0;
+      }
+    }
+    while (line < in_end) {
+      too_long = 0;
+      if ((end = memchr(line, '\n', in_end - line)) == NULL) {
+	if (line == client->in && client->in_len + 1 == SERVE_MAX_LINE)
+	  too_long = client->skipping = 1;
+	else if (!client->done)
+	  break;
+	end = in_end;
+      }
+      *end = '\0';
+
+      request = requests + num_requests++;
+      request->client = index;
+      request->error = (too_long) ? "request too long" :
+	ParseRequest(model, line, num_rows);
+      request->row = (request->error == NULL) ? num_rows++ : -1;
+      if (num_requests == SERVE_MAX_BATCH) {
+	ClassifyBatch(model, clients, requests, num_requests, num_rows,
+		      classes);
+	num_requests = num_rows = 0;
+      }
+      line = (end < in_end) ? end + 1 : in_end;
+    }
+    client->in_len = in_end - line;
+    memmove(client->in, line, client->in_len);
+  }
+
+  if (num_requests > 0)
+    ClassifyBatch(model, clients, requests, num_requests, num_rows, classes);
+}
+
+/* ----------------------------------------------------------------------
+
+   Serve a model saved with -save (see SaveDecisionTree()) on the Unix
+   domain socket "socket_filename" (by default the name of the model file
+   followed by ".sock"), until SIGINT or SIGTERM.  The model file is
+   checked for a new version every SERVE_RELOAD_MSEC milliseconds, and on
+   SIGHUP; a new version that loads replaces the old one between two
+   batches, so that every request is answered by one version or the
+   other.
+
+   ---------------------------------------------------------------------- */
+
+void ServeModel(char *model_filename, char *socket_filename)
+{
+  SERVEDMODEL *model;
+  SERVECLIENT *clients, *client;
+  SERVEREQUEST *requests;
+  signed char *classes;
+  struct pollfd *fds;
+  struct sigaction action;
+  struct timeval now, last_check;
+  char *default_filename = NULL;
+  int listen_fd, fd, num_clients, max_clients, index, num_ready;
+
+  if (socket_filename == NULL) {
+    socket_filename = default_filename =
+      (char *) getmem(strlen(model_filename) + 6);
+    sprintf(socket_filename, "%s.sock", model_filename);
+  }
+  if ((model = LoadServedModel(model_filename)) == NULL)
+    exit(1);
+  listen_fd = OpenServerSocket(socket_filename);
+
+  /* Signals interrupt poll(), to be acted on at once. */
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = ServeSignal;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  sigaction(SIGHUP, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  printf("Serving \"%s\" on \"%s\"\n", model_filename, socket_filename);
+  fflush(stdout);
+
+  max_clients = 16;
+  num_clients = 0;
+  clients = (SERVECLIENT *) getmem(max_clients * sizeof(SERVECLIENT));
+  fds = (struct pollfd *) getmem((max_clients + 1) * sizeof(struct pollfd));
+  requests = (SERVEREQUEST *) getmem(SERVE_MAX_BATCH * sizeof(SERVEREQUEST));
+  classes = (signed char *) getmem(SERVE_MAX_BATCH * sizeof(signed char));
+  gettimeofday(&last_check, NULL);
+
+  while (!serve_stop) {
+    /* Wait for requests, for room to send answers, or for new clients.
+       A client is not read from while many of its answers are waiting. */
+    fds[0].fd = listen_fd;
+    fds[0].events = POLLIN;
+    for (index = 0; index < num_clients; index++) {
+      client = clients + index;
+      fds[index + 1].fd = client->fd;
+      fds[index + 1].events =
+	((client->out_len < SERVE_MAX_LINE) ? POLLIN : 0) |
+	((client->out_len > 0) ? POLLOUT : 0);
+      fds[index + 1].revents = 0;
+    }
+    fds[0].revents = 0;
+    num_ready = poll(fds, num_clients + 1, SERVE_RELOAD_MSEC);
+    if (num_ready < 0 && errno != EINTR)
+      SYS_ERROR1("poll(\"%s\")", socket_filename);
+
+    gettimeofday(&now, NULL);
+    if (serve_reload ||
+	(now.tv_sec - last_check.tv_sec) * 1000 +
+	(now.tv_usec - last_check.tv_usec) / 1000 >= SERVE_RELOAD_MSEC) {
+      serve_reload = 0;
+      last_check = now;
+      model = ReloadServedModel(model, model_filename);
+    }
+
+    /* Every request read in this round goes in the same batches. */
+    for (index = 0; index < num_clients; index++)
+      if (fds[index + 1].revents & (POLLIN | POLLHUP | POLLERR))
+	ReadClient(clients + index);
+    AnswerRequests(model, clients, num_clients, requests, classes);
+    for (index = 0; index < num_clients; index++)
+      if (clients[index].out_len > 0)
+	WriteClient(clients + index);
+
+    /* Close the connections that are done with. */
+    for (index = fd = 0; index < num_clients; index++) {
+      client = clients + index;
+      if (client->done && client->out_len == 0) {
+	close(client->fd);
+	freemem(client->in);
+	freemem(client->out);
+      } else
+	clients[fd++] = *client;
+    }
+    num_clients = fd;
+
+    if (fds[0].revents & POLLIN)
+      while ((fd = accept(listen_fd, NULL, NULL)) >= 0) {
+	SetNonBlocking(fd);
+	if (num_clients == max_clients) {
+	  max_clients *= 2;
+	  clients = (SERVECLIENT *)
+	    regetmem(clients, max_clients * sizeof(SERVECLIENT));
+	  fds = (struct pollfd *)
+	    regetmem(fds, (max_clients + 1) * sizeof(struct pollfd));
+	}
+	client = clients + num_clients++;
+	client->fd = fd;
+	client->in_size = 4096;
+	client->in = (char *) getmem(client->in_size);
+	client->in_len = 0;
+	client->out_size = 4096;
+	client->out = (char *) getmem(client->out_size);
+	client->out_len = 0;
+	client->done = 0;
+	client->skipping = 0;
+      }
+  }
+
+  for (index = 0; index < num_clients; index++) {
+    close(clients[index].fd);
+    freemem(clients[index].in);
+    freemem(clients[index].out);
+  }
+  close(listen_fd);
+  unlink(socket_filename);
+  printf("Stopped serving \"%s\"\n", model_filename);
+
+  freemem(clients);
+  freemem(fds);
+  freemem(requests);
+  freemem(classes);
+  freemem(default_filename);
+  FreeServedModel(model);
+}
+/**************************************************************************/
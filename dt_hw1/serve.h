@@ -0,0 +1,39 @@
+/**************************************************************************
+ *
+ * serve.h
+ *
+ * Header file to serve.c
+ *
+ **************************************************************************/
+
+#ifndef SERVE_H
+#define SERVE_H 1
+
+/* A model is served on a Unix domain (stream) socket.  A request is a
+   line with the values of the attributes of an example, in the order of
+   the model and without the label, as in an SSV file; the answer is a
+   line with the class predicted ("0" or "1"), "?" if the example reaches
+   a missing subtree, or "error: " and the reason.  Requests can be
+   pipelined: the answers come in the same order.  The requests read from
+   all the clients at once are classified together, as a batch. */
+
+/* Most requests classified in one batch. */
+#ifndef SERVE_MAX_BATCH
+#define SERVE_MAX_BATCH 1024
+#endif
+
+/* Longest request line, in bytes. */
+#ifndef SERVE_MAX_LINE
+#define SERVE_MAX_LINE (64 * 1024)
+#endif
+
+/* Milliseconds between checks of the model file for a new version. */
+#ifndef SERVE_RELOAD_MSEC
+#define SERVE_RELOAD_MSEC 1000
+#endif
+
+/* Function prototypes. */
+void ServeModel(char *model_filename, char *socket_filename);
+
+#endif // SERVE_H
+/**************************************************************************/
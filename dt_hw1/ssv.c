@@ -14,12 +14,20 @@
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <stdio.h>
 #include <ctype.h>
-#include <search.h>
 #include <malloc.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include "ssv.h"
-#include "main.h"
+#include "profile.h"
 
 /* ----------------------------------------------------------------------
 
@@ -28,41 +36,56 @@
    ---------------------------------------------------------------------- */
 
 /* Read a binary (0/1) value. */
-unsigned char read_attrib_b(void **data, int example, int feature)
+unsigned char read_attrib_b(void **data, long example, int feature)
 {
   return READ_BITARRAY(data[feature], example);
 }
 /* Write a binary (0/1) value. */
-void write_attrib_b(void **data, int example, int feature, unsigned char val)
+void write_attrib_b(void **data, long example, int feature, unsigned char val)
 {
   WRITE_BITARRAY(data[feature], example, val);
 }
 
 /* Read an integer. */
-int read_attrib_i(void **data, int example, int feature)
+int read_attrib_i(void **data, long example, int feature)
 {
-  return ((int *) data[feature])[example];
+  return READ_ATTRIB_I(data, example, feature);
 }
-/* Write an integer. */
-void write_attrib_i(void **data, int example, int feature, int val)
+/* Write an integer, in the width of the column. */
+void write_attrib_i(void **data, long example, int feature, int val)
 {
-  ((int *) data[feature])[example] = val;
+  switch (COLUMN_WIDTH(data[feature])) {
+  case 1:
+    ((unsigned char *) data[feature])[example] = val;
+    break;
+  case 2:
+    ((unsigned short *) data[feature])[example] = val;
+    break;
+  default:
+    ((int *) data[feature])[example] = val;
+  }
 }
 
 /* Read a double. */
-double read_attrib_c(void **data, int example, int feature)
+double read_attrib_c(void **data, long example, int feature)
 {
-  return ((double *) data[feature])[example];
+  return READ_ATTRIB_C(data, example, feature);
 }
-/* Write a double. */
-void write_attrib_c(void **data, int example, int feature, double val)
+/* Write a double, in the width of the column.  Sparse columns are only
+   built whole (see ReadLIBSVMFile()). */
+void write_attrib_c(void **data, long example, int feature, double val)
 {
-  ((double *) data[feature])[example] = val;
+  if (COLUMN_WIDTH(data[feature]) == 4)
+    ((float *) data[feature])[example] = val;
+  else if (COLUMN_WIDTH(data[feature]) == 8)
+    ((double *) data[feature])[example] = val;
+  else
+    USER_ERROR1("attribute %d is sparse and cannot be written", feature);
 }
 
 /* Read of any type.  Check the feature's type and make the appropriate
    call. */
-void read_attrib(void **data, int example, int feature, char *types,
+void read_attrib(void **data, long example, int feature, char *types,
 		 void *result)
 {
   switch (types[feature]) {
@@ -81,7 +104,7 @@ void read_attrib(void **data, int example, int feature, char *types,
 }
 /* Write of any type.  Check the feature's type and make the appropriate
    call. */
-void write_attrib(void **data, int example, int feature, char *types,
+void write_attrib(void **data, long example, int feature, char *types,
 		  void *val)
 {
   switch (types[feature]) {
@@ -99,6 +122,98 @@ void write_attrib(void **data, int example, int feature, char *types,
   }
 }
 
+/* ----------------------------------------------------------------------
+
+   Allocate the column of "num_data" examples of an attribute of type
+   "type": a bitarray if it is binary (of bytes, and "width" is ignored),
+   else elements of "width" bytes (see READ_CODE() and READ_VALUE()).
+   Either way the column has a header (see COLUMN_TYPE()), and is aligned
+   and padded to DT_COLUMN_ALIGN bytes.  Release it with FreeDataColumn().
+
+   ---------------------------------------------------------------------- */
+
+void *NewDataColumn(long num_data, char type, int width)
+{
+  void *column;
+
+  switch (type) {
+  case 'b':  /* Binary, use packed bits. */
+    column = getcolumn_tag(BITARRAY_BYTES(num_data), 1, MEM_DATASET);
+    break;
+  case 'd':  /* Discrete, use codes. */
+  case 'c':  /* Continuous, use doubles or floats. */
+    column = getcolumn_tag(num_data, width, MEM_DATASET);
+    break;
+  default:
+    USER_ERROR1("unknown type '%c' encountered", type);
+  }
+  COLUMN_TYPE(column) = type;
+
+  return column;
+}
+
+/* Release a column from NewDataColumn() or NewSparseColumn(). */
+void FreeDataColumn(void *column)
+{
+  freecolumn(column);
+}
+
+/* ----------------------------------------------------------------------
+
+   Allocate a sparse continuous column (see SPARSECOLUMN in ssv.h) of
+   "num_nonzero" examples, with room for their values if "with_vals" is
+   set.  Its rows and values are to be filled in by the caller.  Release
+   it with FreeDataColumn().
+
+   ---------------------------------------------------------------------- */
+
+void *NewSparseColumn(long num_nonzero, int with_vals)
+{
+  SPARSECOLUMN *column;
+  size_t size;
+
+  size = sizeof(SPARSECOLUMN) + num_nonzero * sizeof(long) +
+    (with_vals ? num_nonzero * sizeof(double) : 0);
+  column = (SPARSECOLUMN *) getcolumn_tag(size, 1, MEM_DATASET);
+  COLUMN_TYPE(column) = 'c';
+  COLUMN_WIDTH(column) = COLUMN_SPARSE;
+  column->num_nonzero = num_nonzero;
+  column->rows = (long *) (column + 1);
+  column->vals = with_vals ? (double *) (column->rows + num_nonzero) :
+    (double *) NULL;
+
+  return column;
+}
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary function.  Copy the first "num_data" elements of a discrete or
+   continuous column of data set "data" to a new column of elements
+   "width" bytes wide, unless it already is, and release the old one.
+
+   ---------------------------------------------------------------------- */
+
+static void NarrowDataColumn(void **data, long num_data, int feature,
+			     char type, int width)
+{
+  void *new_data[1];
+  long example;
+
+  if (COLUMN_WIDTH(data[feature]) == width)
+    return;
+  new_data[0] = NewDataColumn(num_data, type, width);
+  for (example = 0; example < num_data; example++) {
+    if (type == 'd')
+      write_attrib_i(new_data, example, 0,
+		     READ_ATTRIB_I(data, example, feature));
+    else
+      write_attrib_c(new_data, example, 0,
+		     READ_ATTRIB_C(data, example, feature));
+  }
+  FreeDataColumn(data[feature]);
+  data[feature] = new_data[0];
+}
+
 /* ----------------------------------------------------------------------
 
    Partition the input data into three sets.  Split the set of examples in
@@ -109,76 +224,82 @@ void write_attrib(void **data, int example, int feature, char *types,
 
    ---------------------------------------------------------------------- */
 
-void PartitionExamples(void **data, int *num_data_ptr, int num_features,
-		       uchar **train_members_ptr, int *num_train_ptr,
-		       uchar **test_members_ptr, int *num_test_ptr,
-		       uchar **prune_members_ptr, int *num_prune_ptr,
+void PartitionExamples(void **data, long *num_data_ptr, int num_features,
+		       MEMBERSET **train_members_ptr, long *num_train_ptr,
+		       MEMBERSET **test_members_ptr, long *num_test_ptr,
+		       MEMBERSET **prune_members_ptr, long *num_prune_ptr,
 		       double train_pct, double prune_pct, double test_pct,
 		       SSVINFO *ssvinfo)
 {
-  uchar *train_members, *test_members, *prune_members;
-  uchar *assigned;
-  int num_train, num_test, num_prune;
-  int example, num_data = *num_data_ptr;
-  int i, j, idx, num_not_assigned;
+  uchar *assigned, *chosen;
+  long num_train, num_test, num_prune;
+  long example, num_data = *num_data_ptr;
+  long i, j, idx, num_not_assigned;
+
+  (void) data;
+  (void) num_features;
+  (void) ssvinfo;
 
   /* Keep track of the examples that are assinged to one of the sets: train,
-     prune and test. */
-  assigned = CREATE_BITARRAY(num_data);
+     prune and test.  The examples of the set being picked are marked in
+     "chosen", compressed into a member set once all are picked. */
+  assigned = CREATE_BITARRAY_TAG(num_data, MEM_DATASET);
   ZERO_BITARRAY(assigned, num_data);
+  chosen = CREATE_BITARRAY_TAG(num_data, MEM_DATASET);
   num_not_assigned = num_data;
 
   /* --- Training examples. --- */
-  num_train = (int) rint(num_data * train_pct);
-  train_members = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(train_members, num_data);
+  num_train = (long) rint(num_data * train_pct);
+  ZERO_BITARRAY(chosen, num_data);
   for (example = 0; (example < num_train) && (num_not_assigned>0); example++) {
     /* Assign one of the unassigned examples. */
-    idx = (int) uniform(0.0, (double) num_not_assigned);
+    idx = (long) uniform(0.0, (double) num_not_assigned);
     for (i = j = 0; j < idx || READ_BITARRAY(assigned, i); i++) 
       if (!READ_BITARRAY(assigned, i))
 	j++;
-    WRITE_BITARRAY(train_members, i, 1);
+    WRITE_BITARRAY(chosen, i, 1);
     WRITE_BITARRAY(assigned, i, 1);
     num_not_assigned--;
   }
   num_train = example;
+  *train_members_ptr = MemberSetFromBitarray(chosen, num_data, MEM_DATASET);
   /* --- Test examples. --- */
-  num_test = (int) rint(num_data * test_pct);
-  test_members = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(test_members, num_data);
+  num_test = (long) rint(num_data * test_pct);
+  ZERO_BITARRAY(chosen, num_data);
   for (example = 0; (example < num_test) && (num_not_assigned>0); example++) {
     /* Assign one of the unassigned examples. */
-    idx = (int) uniform(0.0, (double) num_not_assigned);
+    idx = (long) uniform(0.0, (double) num_not_assigned);
     for (i = j = 0; j < idx || READ_BITARRAY(assigned, i); i++)
       if (!READ_BITARRAY(assigned, i))
 	j++;
-    WRITE_BITARRAY(test_members, i, 1);
+    WRITE_BITARRAY(chosen, i, 1);
     WRITE_BITARRAY(assigned, i, 1);
     num_not_assigned--;
   }
   num_test = example;
+  *test_members_ptr = MemberSetFromBitarray(chosen, num_data, MEM_DATASET);
   /* --- Pruning examples. --- */
-  num_prune = (int) rint(num_data * prune_pct);
-  prune_members = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(prune_members, num_data);
+  num_prune = (long) rint(num_data * prune_pct);
+  ZERO_BITARRAY(chosen, num_data);
   for (example = 0; (example < num_prune) && (num_not_assigned>0); example++) {
     /* Assign one of the unassigned examples. */
-    idx = (int) uniform(0.0, (double) num_not_assigned);
+    idx = (long) uniform(0.0, (double) num_not_assigned);
     for (i = j = 0; j < idx || READ_BITARRAY(assigned, i); i++)
       if (!READ_BITARRAY(assigned, i))
 	j++;
-    WRITE_BITARRAY(prune_members, i, 1);
+    WRITE_BITARRAY(chosen, i, 1);
     WRITE_BITARRAY(assigned, i, 1);
     num_not_assigned--;
   }
   num_prune = example;
+  *prune_members_ptr = MemberSetFromBitarray(chosen, num_data, MEM_DATASET);
 
-  free(assigned);
+  freemem(assigned);
+  freemem(chosen);
 
-  *train_members_ptr = train_members; *num_train_ptr = num_train;
-  *test_members_ptr = test_members; *num_test_ptr = num_test;
-  *prune_members_ptr = prune_members; *num_prune_ptr = num_prune;
+  *num_train_ptr = num_train;
+  *num_test_ptr = num_test;
+  *num_prune_ptr = num_prune;
   
 }
 
@@ -270,46 +391,368 @@ char *next_word(char **str) {
   return ret_str;
 }
 
-void **ReadTPT(char *train_filename, char *prune_filename, char *test_filename,
-               uchar **train_members_ptr, uchar **prune_members_ptr, uchar **test_members_ptr,
-               int *num_train_ptr, int *num_prune_ptr, int *num_test_ptr,
-               int *num_data_ptr, int *num_features_ptr, SSVINFO *ssvinfo){
-  SSVINFO ssvinfo_train, ssvinfo_prune, ssvinfo_test, ssvinfo_temp;
-  void **data_train, **data_prune, **data_test, **data_temp, **data_result;
-  uchar *train_members, *prune_members, *test_members;
-
-  int num_train, num_prune, num_test, num_temp, num_data;
-  int num_features;
+/* ----------------------------------------------------------------------
+
+   Auxiliary functions of LIBSVM files.  Every line of such a file is an
+   example: its class, positive (1) if the number is above 0 and negative
+   (0) otherwise, then "index:value" for the attributes whose value is
+   not zero, by increasing index from 1.  Attribute "index" is column
+   "index" of the data set, named "f<index>"; column 0 is the class.  All
+   attributes are continuous, and those that are zero in most examples
+   are held in sparse columns (see SSV_SPARSE_FRACTION).
+
+   ---------------------------------------------------------------------- */
+
+/* The nonzero values of an attribute, as they are read. */
+typedef struct sparsebuild {
+  long num_nonzero;
+  long num_alloc;
+  long *rows;
+  double *vals;
+  int all_ones;                 /* All the values read are 1. */
+} SPARSEBUILD;
+
+/* ......................................................................
+
+   Set up the attributes "num_features" to "new_num_features" - 1 of a
+   LIBSVM data set in "ssvinfo", and give them empty sparse columns in
+   "*data_ptr" (but for the class, which is left to the caller).  The
+   arrays of the data set and "ssvinfo" are allocated if "num_features" is
+   0, and grown otherwise.
+
+   ...................................................................... */
+
+static void AddLIBSVMAttributes(void ***data_ptr, int num_features,
+				int new_num_features, SSVINFO *ssvinfo)
+{
+  void **data = *data_ptr;
+  char name[32];
+  int feature;
+
+  if (num_features == 0) {
+    data = (void **) getmem_tag(new_num_features * sizeof(void *),
+				MEM_DATASET);
+    ssvinfo->types = (char *) getmem_tag(new_num_features + 1, MEM_DICT);
+    ssvinfo->feat_names = (char **)
+      getmem_tag(new_num_features * sizeof(char *), MEM_DICT);
+    ssvinfo->discrete_vals = (char ***)
+      getmem_tag(new_num_features * sizeof(char **), MEM_DICT);
+    ssvinfo->num_discrete_vals = (int *)
+      getmem_tag(new_num_features * sizeof(int), MEM_DICT);
+  } else {
+    data = (void **) regetmem(data, new_num_features * sizeof(void *));
+    ssvinfo->types = (char *) regetmem(ssvinfo->types, new_num_features + 1);
+    ssvinfo->feat_names = (char **)
+      regetmem(ssvinfo->feat_names, new_num_features * sizeof(char *));
+    ssvinfo->discrete_vals = (char ***)
+      regetmem(ssvinfo->discrete_vals, new_num_features * sizeof(char **));
+    ssvinfo->num_discrete_vals = (int *)
+      regetmem(ssvinfo->num_discrete_vals, new_num_features * sizeof(int));
+  }
+
+  for (feature = num_features; feature < new_num_features; feature++) {
+    if (feature == 0) {
+      strcpy(name, "class");
+      ssvinfo->types[feature] = 'b';
+      data[feature] = NULL;
+    } else {
+      sprintf(name, "f%d", feature);
+      ssvinfo->types[feature] = 'c';
+      data[feature] = NewSparseColumn(0, 0);
+    }
+    ssvinfo->feat_names[feature] =
+      strcpy((char *) getmem_tag(strlen(name) + 1, MEM_DICT), name);
+    ssvinfo->discrete_vals[feature] = NULL;
+    ssvinfo->num_discrete_vals[feature] = 0;
+  }
+  ssvinfo->types[new_num_features] = '\0';
+
+  *data_ptr = data;
+}
+
+/* ......................................................................
+
+   Read a line of any length into "*buf_ptr", a buffer of "*size_ptr"
+   bytes grown as needed.  Returns NULL at the end of the file.
+
+   ...................................................................... */
+
+static char *ReadLongLine(FILE *fptr, char **buf_ptr, size_t *size_ptr)
+{
+  size_t len = 0;
+
+  while (fgets(*buf_ptr + len, *size_ptr - len, fptr) != NULL) {
+    len += strlen(*buf_ptr + len);
+    if ((*buf_ptr)[len - 1] == '\n')
+      return *buf_ptr;
+    if (len == *size_ptr - 1) {
+      *size_ptr *= 2;
+      *buf_ptr = (char *) regetmem(*buf_ptr, *size_ptr);
+    }
+  }
+  if (ferror(fptr))
+    SYS_ERROR1("fgets()%s", "");
+  return (len > 0) ? *buf_ptr : (char *) NULL;
+}
+
+/* ......................................................................
+
+   Read the examples of a LIBSVM file, and set up the attributes of
+   "ssvinfo".  The number of examples and attributes (the largest index
+   read, and the class) go to "num_data_ptr" and "num_features_ptr".
+
+   ...................................................................... */
+
+static void **ReadLIBSVMFile(FILE *fptr, char *filename, long *num_data_ptr,
+			     int *num_features_ptr, SSVINFO *ssvinfo)
+{
+  SPARSEBUILD *builds, *build;
+  SPARSECOLUMN *column;
+  void **data = NULL;
+  uchar *labels;
+  char *line, *p, *end;
+  size_t line_size = TEMP_STR_SIZE;
+  long example = 0, line_num = 0, num_labels_alloc = DEFAULT_DATA_SIZE;
+  long index, prev_index;
+  int feature, num_features = 1, num_builds_alloc = 256;
+  double value;
+
+  builds = (SPARSEBUILD *)
+    getmem_tag(num_builds_alloc * sizeof(SPARSEBUILD), MEM_DATASET);
+  bzero(builds, num_builds_alloc * sizeof(SPARSEBUILD));
+  labels = CREATE_BITARRAY_TAG(num_labels_alloc, MEM_DATASET);
+  line = (char *) getmem(line_size);
+
+  while (ReadLongLine(fptr, &line, &line_size) != NULL) {
+    line_num++;
+    for (p = line; isspace((unsigned char) *p); p++)
+      ;
+    if (*p == '\0' || *p == '#')
+      continue;
+
+    /* The class. */
+    value = strtod(p, &end);
+    if (end == p || (*end != '\0' && !isspace((unsigned char) *end)))
+      USER_ERROR2("\"%s\", line %ld: the class is not a number",
+		  filename, line_num);
+    if (example == num_labels_alloc) {
+      num_labels_alloc *= 2;
+      REALLOC_BITARRAY(labels, num_labels_alloc);
+    }
+    WRITE_BITARRAY(labels, example, value > 0.0);
+
+    /* The nonzero attributes. */
+    for (prev_index = 0, p = end; ; prev_index = index) {
+      while (isspace((unsigned char) *p))
+	p++;
+      if (*p == '\0' || *p == '#')
+	break;
+      if (!strncmp(p, "qid:", 4)) {
+	while (*p != '\0' && !isspace((unsigned char) *p))
+	  p++;
+	index = prev_index;
+	continue;
+      }
+      index = strtol(p, &end, 10);
+      if (end == p || *end != ':' || index <= prev_index || index >= INT_MAX)
+	USER_ERROR2("\"%s\", line %ld: bad attribute index (indices must "
+		    "increase from 1)", filename, line_num);
+      p = end + 1;
+      value = strtod(p, &end);
+      if (end == p || (*end != '\0' && !isspace((unsigned char) *end)))
+	USER_ERROR3("\"%s\", line %ld: bad value of attribute %ld",
+		    filename, line_num, index);
+      p = end;
+      if (value == 0.0)
+	continue;
+
+      if (index >= num_builds_alloc) {
+	feature = num_builds_alloc;
+	while (num_builds_alloc <= index)
+	  num_builds_alloc *= 2;
+	builds = (SPARSEBUILD *)
+	  regetmem(builds, num_builds_alloc * sizeof(SPARSEBUILD));
+	bzero(builds + feature,
+	      (num_builds_alloc - feature) * sizeof(SPARSEBUILD));
+      }
+      num_features = MAX(num_features, (int) index + 1);
+      build = builds + index;
+      if (build->num_nonzero == build->num_alloc) {
+	if (build->num_alloc == 0) {
+	  build->num_alloc = 16;
+	  build->rows = (long *)
+	    getmem_tag(build->num_alloc * sizeof(long), MEM_DATASET);
+	  build->vals = (double *)
+	    getmem_tag(build->num_alloc * sizeof(double), MEM_DATASET);
+	  build->all_ones = 1;
+	} else {
+	  build->num_alloc *= 2;
+	  build->rows = (long *)
+	    regetmem(build->rows, build->num_alloc * sizeof(long));
+	  build->vals = (double *)
+	    regetmem(build->vals, build->num_alloc * sizeof(double));
+	}
+      }
+      build->rows[build->num_nonzero] = example;
+      build->vals[build->num_nonzero++] = value;
+      build->all_ones &= (value == 1.0);
+    }
+    example++;
+  }
+  freemem(line);
+
+  /* The columns: dense if the attribute is nonzero often enough. */
+  AddLIBSVMAttributes(&data, 0, num_features, ssvinfo);
+  data[0] = NewDataColumn(example, 'b', 0);
+  COPY_BITARRAY(data[0], labels, example);
+  freemem(labels);
+  for (feature = 1; feature < num_features; feature++) {
+    build = builds + feature;
+    if (build->num_nonzero == 0)
+      continue;
+    FreeDataColumn(data[feature]);
+    if (build->num_nonzero > SSV_SPARSE_FRACTION * example) {
+      data[feature] = NewDataColumn(example, 'c',
+				    (ssvinfo->float_columns) ? sizeof(float) :
+				    sizeof(double));
+      memset(data[feature], 0, example * COLUMN_WIDTH(data[feature]));
+      for (index = 0; index < build->num_nonzero; index++)
+	write_attrib_c(data, build->rows[index], feature, build->vals[index]);
+    } else {
+      data[feature] = NewSparseColumn(build->num_nonzero, !build->all_ones);
+      column = SPARSE_COLUMN(data[feature]);
+      memcpy(column->rows, build->rows, build->num_nonzero * sizeof(long));
+      if (column->vals != NULL)
+	memcpy(column->vals, build->vals,
+	       build->num_nonzero * sizeof(double));
+    }
+    freemem(build->rows);
+    freemem(build->vals);
+  }
+  freemem(builds);
+
+  *num_data_ptr = example;
+  *num_features_ptr = num_features;
+  return data;
+}
+
+/* ......................................................................
+
+   Read the files of "reads" with ReadSSVFile(), each on its own thread
+   unless SSV_THREADS is 0, or the DT_THREADS environment variable or the
+   context allow fewer threads than files, in which case they are read
+   one after the other.  ReadSSVFile() keeps all its state in its own
+   SSVINFO, except for the memory accounting, which getmem_tag()
+   serializes.  This thread only waits for the readers, and fails after
+   all of them have stopped, so that the failure of one of them does not
+   release what the others still use.
+
+   ...................................................................... */
+
+static void *ReadSSVThread(void *arg)
+{
+  SSVREAD *ssvread = (SSVREAD *) arg;
+
+  ssvread->ssvinfo.float_columns = ssvread->float_columns;
+  ssvread->ssvinfo.libsvm = ssvread->libsvm;
+  ssvread->data = ReadSSVFile(ssvread->filename, &ssvread->num_data,
+			      &ssvread->num_features, &ssvread->ssvinfo);
+  return NULL;
+}
+
+static void ReadSSVFiles(SSVREAD *reads, int num_files)
+{
+  pthread_t *threads;
+  char *env;
+  int file, num_threads = SSV_THREADS ? num_files : 1;
+  int max_features, num_started, err = 0;
+
+  if ((env = getenv("DT_THREADS")) != NULL && atoi(env) > 0)
+    num_threads = MIN(num_threads, atoi(env));
+  if (CurrentContext()->num_threads > 0)
+    num_threads = MIN(num_threads, CurrentContext()->num_threads);
+  if (num_threads < num_files) {
+    for (file = 0; file < num_files; file++)
+      ReadSSVThread(reads + file);
+  } else {
+    threads = (pthread_t *) getmem(num_files * sizeof(pthread_t));
+    for (num_started = 0; num_started < num_files; num_started++)
+      if ((err = CreateThread(threads + num_started, ReadSSVThread,
+			      reads + num_started)) != 0)
+	break;
+    for (file = 0; file < num_started; file++)
+      pthread_join(threads[file], NULL);
+    freemem(threads);
+    if (err != 0) {
+      errno = err;
+      SYS_ERROR1("pthread_create() for \"%s\"",
+		 reads[num_started].filename);
+    }
+    CheckContext();
+  }
+  max_features = reads[0].num_features;
+
+  /* The files are merged column by column.  LIBSVM files have as many
+     attributes as their largest index, so all get those of the widest. */
+  if (reads[0].libsvm) {
+    for (file = 1; file < num_files; file++)
+      max_features = MAX(max_features, reads[file].num_features);
+    for (file = 0; file < num_files; file++)
+      if (reads[file].num_features < max_features) {
+	AddLIBSVMAttributes(&reads[file].data, reads[file].num_features,
+			    max_features, &reads[file].ssvinfo);
+	reads[file].num_features = max_features;
+      }
+  }
+  for (file = 1; file < num_files; file++)
+    if (reads[file].num_features != reads[0].num_features ||
+	memcmp(reads[file].ssvinfo.types, reads[0].ssvinfo.types,
+	       reads[0].num_features))
+      USER_ERROR2("\"%s\" does not have the attributes of \"%s\"",
+		  reads[file].filename, reads[0].filename);
+}
 
-  /* Read in the data files */
-  data_train = ReadSSVFile(train_filename, &num_train, &num_features, &ssvinfo_train);
-  data_prune = ReadSSVFile(prune_filename, &num_prune, &num_features, &ssvinfo_prune);
-  data_test = ReadSSVFile(test_filename, &num_test, &num_features, &ssvinfo_test);
+void **ReadTPT(char *train_filename, char *prune_filename, char *test_filename,
+               MEMBERSET **train_members_ptr, MEMBERSET **prune_members_ptr,
+               MEMBERSET **test_members_ptr,
+               long *num_train_ptr, long *num_prune_ptr, long *num_test_ptr,
+               long *num_data_ptr, int *num_features_ptr, SSVINFO *ssvinfo){
+  SSVREAD reads[3];
+  SSVINFO ssvinfo_temp;
+  void **data_temp, **data_result;
+
+  long num_train, num_prune, num_test, num_temp, num_data;
+  int num_features, file;
+
+  /* Read in the data files, all at once */
+  reads[0].filename = train_filename;
+  reads[1].filename = prune_filename;
+  reads[2].filename = test_filename;
+  for (file = 0; file < 3; file++) {
+    reads[file].float_columns = ssvinfo->float_columns;
+    reads[file].libsvm = ssvinfo->libsvm;
+  }
+  ReadSSVFiles(reads, 3);
+  num_train = reads[0].num_data;
+  num_prune = reads[1].num_data;
+  num_test = reads[2].num_data;
+  num_features = reads[0].num_features;
 
   /* Merge them */
-  data_temp = MergeSSVFile(num_train, num_prune, &ssvinfo_train, &ssvinfo_prune, 
-                           data_train, data_prune, &ssvinfo_temp, num_features);
+  data_temp = MergeSSVFile(num_train, num_prune, &reads[0].ssvinfo,
+			   &reads[1].ssvinfo, reads[0].data, reads[1].data,
+			   &ssvinfo_temp, num_features);
   num_temp = num_train + num_prune;
-  data_result = MergeSSVFile(num_temp, num_test, &ssvinfo_temp, &ssvinfo_test,
-                             data_temp, data_test, ssvinfo, num_features);
+  data_result = MergeSSVFile(num_temp, num_test, &ssvinfo_temp,
+			     &reads[2].ssvinfo, data_temp, reads[2].data,
+			     ssvinfo, num_features);
   num_data = num_temp + num_test;
   *num_data_ptr = num_data;
 
-  /* Assign members properly */
-  train_members = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(train_members,num_data);
-  SET_BITARRAY_RANGE(train_members,0,num_train-1);
-  *train_members_ptr = train_members;
-
-  prune_members = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(prune_members,num_data);
-  SET_BITARRAY_RANGE(prune_members,num_train,num_train+num_prune-1);
-  *prune_members_ptr = prune_members;
-
-  test_members = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(test_members,num_data);
-  SET_BITARRAY_RANGE(test_members,num_temp,num_temp+num_test-1);
-  *test_members_ptr = test_members;
+  /* Assign members properly: every file is a range of the examples. */
+  *train_members_ptr = NewMemberRange(0, num_train - 1, MEM_DATASET);
+  *prune_members_ptr = NewMemberRange(num_train, num_temp - 1, MEM_DATASET);
+  *test_members_ptr = NewMemberRange(num_temp, num_data - 1, MEM_DATASET);
 
   *num_train_ptr = num_train;
   *num_prune_ptr = num_prune;
@@ -318,37 +761,36 @@ void **ReadTPT(char *train_filename, char *prune_filename, char *test_filename,
   return data_result;
 }
 void **ReadTwo(char *train_filename, char *prune_filename,
-               uchar **train_members_ptr, uchar **prune_members_ptr, 
-               int *num_train_ptr, int *num_prune_ptr,
-               int *num_data_ptr, int *num_features_ptr, SSVINFO *ssvinfo){
-  SSVINFO ssvinfo_train, ssvinfo_prune;
-  void **data_train, **data_prune, **data_result;
-  uchar *train_members, *prune_members;
-
-  int num_train, num_prune, num_data;
+               MEMBERSET **train_members_ptr, MEMBERSET **prune_members_ptr,
+               long *num_train_ptr, long *num_prune_ptr,
+               long *num_data_ptr, int *num_features_ptr, SSVINFO *ssvinfo){
+  SSVREAD reads[2];
+  void **data_result;
+
+  long num_train, num_prune, num_data;
   int num_features;
 
 
-  /* Read in the data files */
-  data_train = ReadSSVFile(train_filename, &num_train, &num_features, &ssvinfo_train);
-  data_prune = ReadSSVFile(prune_filename, &num_prune, &num_features, &ssvinfo_prune);
+  /* Read in the data files, both at once */
+  reads[0].filename = train_filename;
+  reads[1].filename = prune_filename;
+  reads[0].float_columns = reads[1].float_columns = ssvinfo->float_columns;
+  reads[0].libsvm = reads[1].libsvm = ssvinfo->libsvm;
+  ReadSSVFiles(reads, 2);
+  num_train = reads[0].num_data;
+  num_prune = reads[1].num_data;
+  num_features = reads[0].num_features;
 
   /* Merge them */
-  data_result = MergeSSVFile(num_train, num_prune, &ssvinfo_train, &ssvinfo_prune, 
-                             data_train, data_prune, ssvinfo, num_features);
+  data_result = MergeSSVFile(num_train, num_prune, &reads[0].ssvinfo,
+			     &reads[1].ssvinfo, reads[0].data, reads[1].data,
+			     ssvinfo, num_features);
   num_data = num_train + num_prune;
   *num_data_ptr = num_data;
 
-  /* Assign members properly */
-  train_members = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(train_members,num_data);
-  SET_BITARRAY_RANGE(train_members,0,num_train-1);
-  *train_members_ptr = train_members;
-
-  prune_members = CREATE_BITARRAY(num_data);
-  ZERO_BITARRAY(prune_members,num_data);
-  SET_BITARRAY_RANGE(prune_members,num_train,num_train+num_prune-1);
-  *prune_members_ptr = prune_members;
+  /* Assign members properly: every file is a range of the examples. */
+  *train_members_ptr = NewMemberRange(0, num_train - 1, MEM_DATASET);
+  *prune_members_ptr = NewMemberRange(num_train, num_data - 1, MEM_DATASET);
 
   *num_train_ptr = num_train;
   *num_prune_ptr = num_prune;
@@ -358,14 +800,42 @@ void **ReadTwo(char *train_filename, char *prune_filename,
 
 
 
+/* ......................................................................
+
+   Auxiliary function.  Join two sparse columns, the rows of "column_B"
+   following the "num_data_A" rows of "column_A".
+
+   ...................................................................... */
+
+static void *MergeSparseColumns(SPARSECOLUMN *column_A,
+				SPARSECOLUMN *column_B, long num_data_A)
+{
+  SPARSECOLUMN *column;
+  long num_A = column_A->num_nonzero, i;
+
+  column = (SPARSECOLUMN *)
+    NewSparseColumn(num_A + column_B->num_nonzero,
+		    column_A->vals != NULL || column_B->vals != NULL);
+  memcpy(column->rows, column_A->rows, num_A * sizeof(long));
+  for (i = 0; i < column_B->num_nonzero; i++)
+    column->rows[num_A + i] = column_B->rows[i] + num_data_A;
+  if (column->vals != NULL)
+    for (i = 0; i < column->num_nonzero; i++)
+      column->vals[i] = (i < num_A) ?
+	((column_A->vals != NULL) ? column_A->vals[i] : 1.0) :
+	((column_B->vals != NULL) ? column_B->vals[i - num_A] : 1.0);
+
+  return column;
+}
+
 /* Destructively merges ssvinfo_A and ssvinfo_B into ssvinfo_result */
-void **MergeSSVFile(int num_data_A, int num_data_B, 
+void **MergeSSVFile(long num_data_A, long num_data_B, 
                     SSVINFO *ssvinfo_A, SSVINFO *ssvinfo_B,
                     void **data_A, void **data_B,
                     SSVINFO *ssvinfo_result,
                     int num_features)
 {
-  int num_data_alloc = num_data_A + num_data_B;
+  long num_data_alloc = num_data_A + num_data_B;
   int feature, j, valA, valB;
   int num_discrete_vals_A, num_discrete_vals_B;
   int max_discrete_vals, total_discrete_vals;
@@ -373,17 +843,19 @@ void **MergeSSVFile(int num_data_A, int num_data_B,
   void **data;
 
   ssvinfo_result->types = ssvinfo_A->types;
-  free(ssvinfo_B->types);
+  freemem(ssvinfo_B->types);
   ssvinfo_result->feat_names = ssvinfo_A->feat_names;
-  ssvinfo_result->discrete_vals = (char ***) getmem(num_features * sizeof(char **));
-  ssvinfo_result->num_discrete_vals = (int *) getmem(num_features * sizeof(int));
-  data = (void **)getmem(num_features * sizeof(void *));
+  ssvinfo_result->discrete_vals = (char ***) getmem_tag(num_features * sizeof(char **), MEM_DICT);
+  bzero(ssvinfo_result->discrete_vals, num_features * sizeof(char **));
+  ssvinfo_result->num_discrete_vals = (int *) getmem_tag(num_features * sizeof(int), MEM_DICT);
+  bzero(ssvinfo_result->num_discrete_vals, num_features * sizeof(int));
+  data = (void **)getmem_tag(num_features * sizeof(void *), MEM_DATASET);
 
   for (feature = 0; feature < num_features; feature++) {
-    free(ssvinfo_B->feat_names[feature]);
+    freemem(ssvinfo_B->feat_names[feature]);
     switch (ssvinfo_result->types[feature]) {
     case 'b':  /* Binary, use packed bits. */
-      data[feature] = CREATE_BITARRAY(num_data_alloc);
+      data[feature] = NewDataColumn(num_data_alloc, 'b', 0);
       COPY_BITARRAY(data[feature],data_A[feature],num_data_A);
       COPY_BITARRAY_RANGE(data[feature],num_data_A,
                           data_B[feature],0,num_data_B);
@@ -394,7 +866,7 @@ void **MergeSSVFile(int num_data_A, int num_data_B,
       max_discrete_vals = num_discrete_vals_A
 	                + num_discrete_vals_B;
       total_discrete_vals = num_discrete_vals_A;
-      ssvinfo_result->discrete_vals[feature] = (char **) getmem(max_discrete_vals * sizeof(char *));
+      ssvinfo_result->discrete_vals[feature] = (char **) getmem_tag(max_discrete_vals * sizeof(char *), MEM_DICT);
       for(valA=0;valA<num_discrete_vals_A;valA++)
         ssvinfo_result->discrete_vals[feature][valA] = ssvinfo_A->discrete_vals[feature][valA];
 	/* memcpy(ssvinfo_result->discrete_vals[feature],
@@ -416,194 +888,1082 @@ void **MergeSSVFile(int num_data_A, int num_data_B,
           discrete_mapping[valB]=total_discrete_vals;
           total_discrete_vals++;
         } else {
-          free(ssvinfo_B->discrete_vals[feature][valB]);
+          freemem(ssvinfo_B->discrete_vals[feature][valB]);
 	}
       }
-      free(ssvinfo_A->discrete_vals[feature]);
-      free(ssvinfo_B->discrete_vals[feature]);
+      freemem(ssvinfo_A->discrete_vals[feature]);
+      freemem(ssvinfo_B->discrete_vals[feature]);
       ssvinfo_result->num_discrete_vals[feature] = total_discrete_vals;
-      data[feature] = (int *) getmem(num_data_alloc * sizeof(int));
-      memcpy(data[feature],data_A[feature],num_data_A * sizeof(int));
+      data[feature] = NewDataColumn(num_data_alloc, 'd',
+				    DISCRETE_CODE_WIDTH(total_discrete_vals));
+      for(j=0;j<num_data_A;j++)
+        write_attrib_i(data,j,feature,read_attrib_i(data_A,j,feature));
       for(j=0;j<num_data_B;j++)
         write_attrib_i(data,num_data_A+j,feature,
                           discrete_mapping[read_attrib_i(data_B,j,feature)]);
-      free(discrete_mapping);
+      freemem(discrete_mapping);
       break;
-    case 'c':  /* Continuous, use doubles. */
-      data[feature] = (double *) getmem(num_data_alloc * sizeof(double));
-      memcpy(data[feature],data_A[feature],num_data_A * sizeof(double));
-      memcpy((double *)(data[feature])+num_data_A,
-             data_B[feature],num_data_B * sizeof(double));
+    case 'c':  /* Continuous, use doubles or floats, as A does. */
+      if (COLUMN_WIDTH(data_A[feature]) == COLUMN_SPARSE &&
+	  COLUMN_WIDTH(data_B[feature]) == COLUMN_SPARSE) {
+	data[feature] = MergeSparseColumns(data_A[feature], data_B[feature],
+					   num_data_A);
+	break;
+      }
+      data[feature] =
+	NewDataColumn(num_data_alloc, 'c',
+		      (COLUMN_WIDTH(data_A[feature]) != COLUMN_SPARSE) ?
+		      COLUMN_WIDTH(data_A[feature]) :
+		      COLUMN_WIDTH(data_B[feature]));
+      for(j=0;j<num_data_A;j++)
+        write_attrib_c(data,j,feature,read_attrib_c(data_A,j,feature));
+      for(j=0;j<num_data_B;j++)
+        write_attrib_c(data,num_data_A+j,feature,
+                       read_attrib_c(data_B,j,feature));
       break;
     }
-    free(data_A[feature]);
-    free(data_B[feature]);
-    /* WHY CAN'T WE FREE THIS WITHOUT IT CRASHING??? */
-    /* free(ssvinfo_B->feat_names[feature]); */
-  }
-  free(ssvinfo_B->feat_names);
-  free(ssvinfo_A->discrete_vals);
-  free(ssvinfo_B->discrete_vals);
-  free(ssvinfo_A->num_discrete_vals);
-  free(ssvinfo_B->num_discrete_vals);
-  free(data_A);
-  free(data_B);
+    FreeDataColumn(data_A[feature]);
+    FreeDataColumn(data_B[feature]);
+  }
+  freemem(ssvinfo_B->feat_names);
+  freemem(ssvinfo_A->discrete_vals);
+  freemem(ssvinfo_B->discrete_vals);
+  freemem(ssvinfo_A->num_discrete_vals);
+  freemem(ssvinfo_B->num_discrete_vals);
+  freemem(data_A);
+  freemem(data_B);
   return data;
 } 
 
-void **ReadSSVFile(char *filename, int *num_data_ptr,
-		   int *num_features_ptr, SSVINFO *ssvinfo)
-{ 
-  int example, feature;
-  unsigned char value_b;
-  void **data;
-  int num_data, num_data_alloc, num_features;
-/*   static ENTRY hentry = { NULL, NULL }; */
-  ENTRY *hentry;
-  ENTRY *result;
-  int val, attr_name_len;
-  FILE *fptr;
-  char *temp_str = getmem(TEMP_STR_SIZE);
-  char *data_str, *word_str;
+/* ----------------------------------------------------------------------
 
-#define feat_names (ssvinfo->feat_names)
-#define types (ssvinfo->types)
+   Read the three header lines of an SSV file (the numbers of features and
+   examples, the names and the types of the features) into "ssvinfo", and
+   set up its empty dictionaries of discrete values.  Returns the number of
+   features; the number of examples in the header (0 if unknown) goes to
+   "num_data_ptr".
 
-  if ((fptr = fopen(filename, "r")) == NULL)
-    SYS_ERROR1("fopen(\"%s\", \"r\")", filename);
+   ---------------------------------------------------------------------- */
+
+static int ReadSSVHeader(FILE *fptr, char *temp_str, long *num_data_ptr,
+			 SSVINFO *ssvinfo)
+{
+  int feature, num_features, feat_name_len;
+  char *data_str, *word_str;
 
   /* get number of features and data */
   data_str = fgets_clean(temp_str, fptr);
   num_features = atoi(next_word(&data_str));
-  num_data     = atoi(next_word(&data_str));
-  if (num_data == 0) 
-    num_data_alloc = DEFAULT_DATA_SIZE;
-  else
-    num_data_alloc = num_data;
-
+  *num_data_ptr = atol(next_word(&data_str));
 
   /* Skip over names of features, after duplicating them. */
-  feat_names = (char **) getmem(num_features * sizeof(char *));
+  ssvinfo->feat_names = (char **) getmem_tag(num_features * sizeof(char *), MEM_DICT);
   data_str = fgets_clean(temp_str, fptr);
   for (feature = 0; feature < num_features; feature++) {
-    int feat_name_len;
     word_str = next_word(&data_str);
     feat_name_len = strlen (word_str);
-    feat_names[feature] = (char *) getmem((feat_name_len + 1) * sizeof(char));
-    strcpy(feat_names[feature], word_str);
+    ssvinfo->feat_names[feature] = (char *) getmem_tag((feat_name_len + 1) * sizeof(char), MEM_DICT);
+    strcpy(ssvinfo->feat_names[feature], word_str);
   }
   /* Skip over types string. */
   data_str = fgets_clean(temp_str, fptr);
-  types = (char *) getmem((strlen(data_str)+1) * sizeof(char));
-  strcpy(types, data_str);
+  ssvinfo->types = (char *) getmem_tag((strlen(data_str)+1) * sizeof(char), MEM_DICT);
+  strcpy(ssvinfo->types, data_str);
 
-  /* Record all data in an array of pointers to arrays of the data
-     elements.  Each array may be of different type (that's why we have an
-     array of (void *)) as per the types string. */
-  data = (void **) getmem(num_features * sizeof(void *));
-  ssvinfo->num_discrete_vals = (int *) getmem(num_features * sizeof(int));
+  ssvinfo->num_discrete_vals = (int *) getmem_tag(num_features * sizeof(int), MEM_DICT);
   bzero(ssvinfo->num_discrete_vals, num_features * sizeof(int));
-  ssvinfo->discrete_vals = (char ***) getmem(num_features * sizeof(char **));
+  ssvinfo->discrete_vals = (char ***) getmem_tag(num_features * sizeof(char **), MEM_DICT);
   bzero(ssvinfo->discrete_vals, num_features * sizeof(char **));
-  (void) hcreate(num_data_alloc * num_features);
-  for (feature = 0; feature < num_features; feature++) {
-    switch (types[feature]) {
-    case 'b':  /* Binary, use packed bits. */
-      data[feature] = CREATE_BITARRAY(num_data_alloc);
-      break;
-    case 'd':  /* Discrete, use integers. */
-      data[feature] = (int *) getmem(num_data_alloc * sizeof(int));
-      break;
-    case 'c':  /* Continuous, use doubles. */
-      data[feature] = (double *) getmem(num_data_alloc * sizeof(double));
-      break;
+
+  return num_features;
+}
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary functions of a dictionary of discrete values (see VALDICT): an
+   open-addressing hash table of (feature, value) pairs, keyed by the
+   feature and the value's name in ssvinfo->discrete_vals.  Unlike an
+   hsearch() table it grows, since the number of values is not known in
+   advance, is private to the file being read, so that several files can
+   be read at once, and names need not be NUL-terminated, so that tokens
+   can be looked up where they were read.
+
+   ---------------------------------------------------------------------- */
+
+static unsigned int ValueHash(int feature, char *name, int len)
+{
+  unsigned int hash = 2166136261u ^ (unsigned int) feature;
+
+  while (len-- > 0)
+    hash = (hash ^ (unsigned char) *name++) * 16777619u;
+  return hash;
+}
+
+static VALSLOT *FindValueSlot(VALDICT *dict, int feature, char *name,
+			      int len, SSVINFO *ssvinfo)
+{
+  VALSLOT *slot;
+  char *slot_name;
+  unsigned int i;
+
+  i = ValueHash(feature, name, len) & (dict->num_slots - 1);
+  for (;;) {
+    slot = dict->slots + i;
+    if (slot->val < 0)
+      return slot;
+    if (slot->feature == feature) {
+      slot_name = ssvinfo->discrete_vals[feature][slot->val];
+      if (!strncmp(slot_name, name, len) && slot_name[len] == '\0')
+	return slot;
     }
+    i = (i + 1) & (dict->num_slots - 1);
   }
+}
+
+static void GrowValueSlots(VALDICT *dict, SSVINFO *ssvinfo)
+{
+  VALSLOT *old_slots = dict->slots, *slot;
+  int i, num_old_slots = dict->num_slots;
+  char *name;
+
+  dict->num_slots *= 2;
+  dict->slots = (VALSLOT *)
+    getmem_tag(dict->num_slots * sizeof(VALSLOT), MEM_DICT);
+  for (i = 0; i < dict->num_slots; i++)
+    dict->slots[i].val = -1;
+  for (i = 0; i < num_old_slots; i++) {
+    if (old_slots[i].val < 0)
+      continue;
+    name = ssvinfo->discrete_vals[old_slots[i].feature][old_slots[i].val];
+    slot = FindValueSlot(dict, old_slots[i].feature, name, strlen(name),
+			 ssvinfo);
+    *slot = old_slots[i];
+  }
+  freemem(old_slots);
+}
+
+static void InitValueDict(VALDICT *dict)
+{
+  int i;
+
+  dict->num_slots = 1024;
+  dict->num_values = 0;
+  dict->known_only = 0;
+  dict->slots = (VALSLOT *)
+    getmem_tag(dict->num_slots * sizeof(VALSLOT), MEM_DICT);
+  for (i = 0; i < dict->num_slots; i++)
+    dict->slots[i].val = -1;
+}
+
+/* Return the index of the value of "feature" named by the "len" characters
+   at "name", adding it to ssvinfo->discrete_vals if it is new (unless
+   dict->known_only). */
+static int DictValue(VALDICT *dict, int feature, char *name, int len,
+		     SSVINFO *ssvinfo)
+{
+  VALSLOT *slot;
+  int val;
+
+  slot = FindValueSlot(dict, feature, name, len, ssvinfo);
+  if (slot->val >= 0)
+    return slot->val;
+  if (dict->known_only)
+    return ssvinfo->num_discrete_vals[feature];
+  val = ssvinfo->num_discrete_vals[feature]++;
+  ssvinfo->discrete_vals[feature] = (char **)
+    regetmem(ssvinfo->discrete_vals[feature], (val+1)*sizeof(char *));
+  ssvinfo->discrete_vals[feature][val] = my_strndup(name, len);
+  slot->feature = feature;
+  slot->val = val;
+  if (2 * ++dict->num_values >= dict->num_slots)
+    GrowValueSlots(dict, ssvinfo);
+  return val;
+}
+
+/* ----------------------------------------------------------------------
+
+   Set up a dictionary of the discrete values already in "ssvinfo", such
+   as those of a model (see LoadModel()), to look them up with
+   FindDiscreteValue().  Release it with freemem(dict->slots).
+
+   ---------------------------------------------------------------------- */
+
+void BuildValueDict(VALDICT *dict, int num_features, SSVINFO *ssvinfo)
+{
+  VALSLOT *slot;
+  char *name;
+  int feature, val;
+
+  InitValueDict(dict);
+  for (feature = 0; feature < num_features; feature++)
+    for (val = 0; val < ssvinfo->num_discrete_vals[feature]; val++) {
+      name = ssvinfo->discrete_vals[feature][val];
+      slot = FindValueSlot(dict, feature, name, strlen(name), ssvinfo);
+      slot->feature = feature;
+      slot->val = val;
+      if (2 * ++dict->num_values >= dict->num_slots)
+	GrowValueSlots(dict, ssvinfo);
+    }
+}
+
+/* ----------------------------------------------------------------------
+
+   Return the index of the value of "feature" named by the "len" characters
+   at "name", or -1 if the dictionary does not have it.
+
+   ---------------------------------------------------------------------- */
+
+int FindDiscreteValue(VALDICT *dict, int feature, char *name, int len,
+		      SSVINFO *ssvinfo)
+{
+  return FindValueSlot(dict, feature, name, len, ssvinfo)->val;
+}
+
+/* ......................................................................
+
+   Allocate the (empty) columns of a data set of "num_data" examples, of
+   the "types" of the attributes.  Discrete columns are of integers, since
+   the number of values is not known yet; they are narrowed once the data
+   set is read.  An attribute of type '-' is not read, and has no column.
+
+   ...................................................................... */
+
+static void **NewDataSet(long num_data, int num_features, char *types,
+			 SSVINFO *ssvinfo)
+{
+  void **data;
+  int feature;
+  char type;
+
+  data = (void **) getmem_tag(num_features * sizeof(void *), MEM_DATASET);
+  for (feature = 0; feature < num_features; feature++) {
+    type = types[feature];
+    data[feature] = (type == '-') ? NULL :
+      NewDataColumn(num_data, type,
+		    (type == 'd') ? sizeof(int) :
+		    (ssvinfo->float_columns) ? sizeof(float) :
+		    sizeof(double));
+  }
+  return data;
+}
+
+/* Number of the leading attributes of "types" that hold all those read
+   (see NewDataSet()): the tokens after them need not even be found. */
+static int NumColumnsRead(int num_features, char *types)
+{
+  while (num_features > 0 && types[num_features - 1] == '-')
+    num_features--;
+  return num_features;
+}
+
+/* ......................................................................
+
+   Read the examples of an SSV file line by line through stdio, after its
+   header, into columns of the "types" of the attributes (see NewDataSet()),
+   looking discrete values up in "dict".  "num_data_ptr" holds the number
+   of examples of the header (0 if unknown, in which case the columns start
+   with room for DEFAULT_DATA_SIZE examples and double as needed) and gets
+   the number read.
+
+   ...................................................................... */
+
+static void **ReadSSVLines(FILE *fptr, char *filename, char *temp_str,
+			   long *num_data_ptr, int num_features, char *types,
+			   VALDICT *dict, SSVINFO *ssvinfo)
+{ 
+  long example;
+  int feature, num_read;
+  unsigned char value_b;
+  void **data;
+  long num_data = *num_data_ptr, num_data_alloc;
+  char *data_str, *word_str;
+
+  if (num_data == 0) 
+    num_data_alloc = DEFAULT_DATA_SIZE;
+  else
+    num_data_alloc = num_data;
+
+  /* Record all data in an array of pointers to arrays of the data
+     elements.  Each array may be of different type (that's why we have an
+     array of (void *)) as per the types string. */
+  data = NewDataSet(num_data_alloc, num_features, types, ssvinfo);
+  num_read = NumColumnsRead(num_features, types);
 
   /* Now read the data into the arrays. */
-  for (example = 0; example < num_data_alloc; example++) {
+  for (example = 0; num_data == 0 || example < num_data; example++) {
     if (num_data == 0) {
       if ((data_str = fgets_clean_eof(temp_str, fptr)) == NULL)
 	break;
+      if (example == num_data_alloc) {
+	num_data_alloc *= 2;
+	for (feature = 0; feature < num_features; feature++)
+	  if (types[feature] == 'b')
+	    data[feature] = regetcolumn(data[feature],
+					BITARRAY_BYTES(num_data_alloc));
+	  else if (types[feature] != '-')
+	    data[feature] = regetcolumn(data[feature], num_data_alloc);
+      }
     }
     else {
       data_str = fgets_clean(temp_str, fptr);
     }
-    for (feature = 0; feature < num_features; feature++) {
+    for (feature = 0; feature < num_read; feature++) {
       word_str = next_word(&data_str);
       switch(types[feature]) {
       case 'b':
 	value_b = *word_str - '0';
 	if (value_b != 0 && value_b != 1)
-	  USER_ERROR3("ReadSSVFile(): example %d, feature %d "
+	  USER_ERROR3("ReadSSVFile(): example %ld, feature %d "
 		      "is not binary (value = %d)\n", example, feature,
 		      value_b);
 	write_attrib_b(data, example, feature, value_b);
 	break;
       case 'd':
-	attr_name_len = strlen(word_str);
-	hentry = (ENTRY *) getmem(sizeof(ENTRY));
-	hentry->key = getmem(attr_name_len + strlen(feat_names[feature]) + 1);
-	strcpy(hentry->key, feat_names[feature]);
-	strncpy(hentry->key + strlen(feat_names[feature]),
-		word_str, attr_name_len);
-	(hentry->key)[strlen(feat_names[feature]) + attr_name_len] = '\0';
-	/* Check whether we've seen this name before, and assign it an
-           integer. */
-	if ((result = (ENTRY *) hsearch(*hentry, FIND)) == NULL) {
-	  val = ssvinfo->num_discrete_vals[feature]++;
-	  if (ssvinfo->discrete_vals[feature] == NULL)
-	    ssvinfo->discrete_vals[feature] = (char **)
-	      getmem(sizeof(char *));
-	  else
-	    ssvinfo->discrete_vals[feature] = (char **)
-	      realloc((char *) ssvinfo->discrete_vals[feature],
-		      (val+1)*sizeof(char *));
-	  if (ssvinfo->discrete_vals[feature] == NULL)
-	    SYS_ERROR1("realloc(%d)", (val+1)*sizeof(char *));
-
-          /* Seems to not work right: trying different approach */
-	  ssvinfo->discrete_vals[feature][val] =
-	    my_strndup(word_str, attr_name_len);
-	  /* my_strdup(word_str); Different approach didn't work either */
-	  hentry->data = (char *) getmem(sizeof(int));
-	  *((int *) hentry->data) = val;
-	  if (hsearch(*hentry, ENTER) == NULL)
-	    USER_ERROR1("%s", "cannot insert entry in hash table");
-	} else {
-	  val = *((int *) (result->data));
-	}
-	write_attrib_i(data, example, feature, val);
+	write_attrib_i(data, example, feature,
+		       DictValue(dict, feature, word_str, strlen(word_str),
+				 ssvinfo));
 	break;
       case 'c':
 	write_attrib_c(data, example, feature, atof(word_str));
 	break;
-      default:
-	USER_ERROR1("unknown type '%c' encountered", types[feature]);
       }
     }
   }
 
-  hdestroy();
+  if (num_data > 0 && fgets_clean_eof(temp_str, fptr) != NULL)
+    USER_ERROR1("additional data at end of file \"%s\"", filename);
 
-  if (fgets_clean_eof(temp_str, fptr) != NULL) {
-    if (num_data == 0) {
-      USER_ERROR1("data set larger than max default size in file \"%s\"", filename);
+  *num_data_ptr = example;
+  return data;
+}
+
+#if SSV_MMAP
+
+/* Whitespace as isspace() has it in the C locale. */
+#define IS_SPACE(c)							\
+  ((c) == ' ' || (unsigned char) ((c) - '\t') < 5)
+#define IS_DIGIT(c)	((unsigned char) ((c) - '0') < 10)
+
+/* Powers of ten exactly represented by doubles. */
+static const double exact_powers[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+  1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* ......................................................................
+
+   Parse the "len" characters at "str" as atof() does.  A decimal number
+   of at most 19 significant digits, whose digits make an integer below
+   2^53 and whose exponent is at most 22 in magnitude, is the product or
+   quotient of two exactly represented doubles, so one correctly rounded
+   operation gives the double strtod() would (Clinger's fast path).  Any
+   other token is copied and given to strtod().
+
+   ...................................................................... */
+
+static double ParseDouble(char *str, int len)
+{
+  char *p = str, *end = str + len;
+  char buf[64], *copy;
+  unsigned long long mantissa = 0;
+  int negative = 0, num_digits = 0, seen_digit = 0;
+  int exponent = 0, exp_value = 0, exp_negative = 0;
+  double value;
+
+  if (p < end && (*p == '-' || *p == '+'))
+    negative = (*p++ == '-');
+  for (; p < end && IS_DIGIT(*p); p++) {
+    seen_digit = 1;
+    if (mantissa == 0 && *p == '0')
+      continue;
+    if (++num_digits > 19)
+      goto slow;
+    mantissa = 10 * mantissa + (*p - '0');
+  }
+  if (p < end && *p == '.')
+    for (p++; p < end && IS_DIGIT(*p); p++) {
+      seen_digit = 1;
+      exponent--;
+      if (mantissa == 0 && *p == '0')
+	continue;
+      if (++num_digits > 19)
+	goto slow;
+      mantissa = 10 * mantissa + (*p - '0');
     }
-    else {
+  if (!seen_digit)
+    goto slow;
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    if (p < end && (*p == '-' || *p == '+'))
+      exp_negative = (*p++ == '-');
+    if (p == end || !IS_DIGIT(*p))
+      goto slow;
+    for (; p < end && IS_DIGIT(*p); p++)
+      if ((exp_value = 10 * exp_value + (*p - '0')) > 1000)
+	goto slow;
+    exponent += exp_negative ? -exp_value : exp_value;
+  }
+  if (p != end || mantissa > (1ULL << 53))
+    goto slow;
+
+  if (mantissa == 0)
+    value = 0.0;
+  else if (exponent < -22 || exponent > 22)
+    goto slow;
+  else if (exponent < 0)
+    value = (double) mantissa / exact_powers[-exponent];
+  else
+    value = (double) mantissa * exact_powers[exponent];
+  return negative ? -value : value;
+
+ slow:
+  copy = (len < (int) sizeof(buf)) ? buf : getmem(len + 1);
+  memcpy(copy, str, len);
+  copy[len] = '\0';
+  value = strtod(copy, NULL);
+  if (copy != buf)
+    freemem(copy);
+  return value;
+}
+
+/* A file mapped by ReadSSVMapped(). */
+typedef struct ssvmap {
+  char *map;
+  size_t size;
+} SSVMAP;
+
+/* Unmap a file; also called if the call reading it fails. */
+static void UnmapSSVFile(void *arg)
+{
+  munmap(((SSVMAP *) arg)->map, ((SSVMAP *) arg)->size);
+}
+
+/* ......................................................................
+
+   Read the examples of an SSV file after its header, which has been read
+   from "fptr", by mapping the file in memory and parsing it in place:
+   lines are found with memchr(), which the C library vectorizes, tokens
+   are neither copied nor terminated, and discrete values are looked up in
+   a VALDICT.  Gives the same data set, and the same errors, as
+   ReadSSVLines(), but the columns are allocated once, to the number of
+   lines of the file.  Returns NULL if the file cannot be mapped
+   (e.g. it is a pipe, or has no examples), to be read with ReadSSVLines()
+   instead.
+
+   ...................................................................... */
+
+static void **ReadSSVMapped(FILE *fptr, char *filename, long *num_data_ptr,
+			    int num_features, char *types, VALDICT *dict,
+			    SSVINFO *ssvinfo)
+{
+  struct stat st;
+  long offset;
+  SSVMAP *mapped;
+  CLEANUP *cleanup;
+  char *map, *text, *end, *line, *eol, *p, *word;
+  long num_data = *num_data_ptr, num_lines, num_data_alloc;
+  long example;
+  int feature, num_read;
+  unsigned char value_b;
+  void **data;
+
+  if ((offset = ftell(fptr)) < 0 || fstat(fileno(fptr), &st) < 0 ||
+      !S_ISREG(st.st_mode) || st.st_size <= offset)
+    return NULL;
+  mapped = (SSVMAP *) getmem(sizeof(SSVMAP));
+  map = (char *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+		      fileno(fptr), 0);
+  if (map == (char *) MAP_FAILED) {
+    freemem(mapped);
+    return NULL;
+  }
+  mapped->map = map;
+  mapped->size = st.st_size;
+  cleanup = PushCleanup(UnmapSSVFile, mapped);
+  (void) madvise(map, st.st_size, MADV_SEQUENTIAL);
+  text = map + offset;
+  end = map + st.st_size;
+
+  /* Every example takes a line. */
+  num_lines = 1;
+  for (p = text; (p = memchr(p, '\n', end - p)) != NULL; p++)
+    num_lines++;
+  num_data_alloc = (num_data > 0 && num_data < num_lines) ?
+    num_data : num_lines;
+  data = NewDataSet(num_data_alloc, num_features, types, ssvinfo);
+  num_read = NumColumnsRead(num_features, types);
+
+  example = 0;
+  for (line = text; line < end; line = eol + 1) {
+    if ((eol = memchr(line, '\n', end - line)) == NULL)
+      eol = end;
+    if (*line == '#')
+      continue;
+    for (p = line; p < eol && IS_SPACE(*p); p++)
+      ;
+    if (p == eol)
+      continue;
+    if (example == num_data_alloc)
       USER_ERROR1("additional data at end of file \"%s\"", filename);
+    for (feature = 0; feature < num_read; feature++) {
+      while (p < eol && IS_SPACE(*p))
+	p++;
+      if (p == eol)
+	USER_ERROR1("incorrect input file format%s", "");
+      for (word = p; p < eol && !IS_SPACE(*p); p++)
+	;
+      switch (types[feature]) {
+      case 'b':
+	value_b = *word - '0';
+	if (value_b != 0 && value_b != 1)
+	  USER_ERROR3("ReadSSVFile(): example %ld, feature %d "
+		      "is not binary (value = %d)\n", example, feature,
+		      value_b);
+	write_attrib_b(data, example, feature, value_b);
+	break;
+      case 'd':
+	write_attrib_i(data, example, feature,
+		       DictValue(dict, feature, word, p - word, ssvinfo));
+	break;
+      case 'c':
+	write_attrib_c(data, example, feature, ParseDouble(word, p - word));
+	break;
+      }
+    }
+    example++;
+  }
+  if (example < num_data)
+    USER_ERROR1("input file terminated permaturely%s", "");
+
+  PopCleanup(cleanup);
+  UnmapSSVFile(mapped);
+  freemem(mapped);
+  *num_data_ptr = example;
+  return data;
+}
+
+#undef IS_SPACE
+#undef IS_DIGIT
+
+#endif // SSV_MMAP
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary functions of compressed input.  An SSV file compressed with
+   gzip (or, if compiled with HAVE_ZSTD, zstd) is recognized by its first
+   bytes and decompressed by a thread of its own into a pipe, which is
+   read like an uncompressed file while the thread keeps decompressing.
+   The uncompressed text is never written anywhere.
+
+   ---------------------------------------------------------------------- */
+
+/* Formats of the files read by OpenSSVInput(). */
+#define SSV_PLAIN	0
+#define SSV_GZIP	1
+#define SSV_ZSTD	2
+
+/* Bytes decompressed at a time. */
+#define INFLATE_SIZE	(1 << 17)
+
+/* An SSV file opened by OpenSSVInput(). */
+struct ssvinput {
+  FILE *fptr;                   /* The (uncompressed) text of the file. */
+  FILE *compressed;             /* The file itself if it is compressed,
+				   else NULL. */
+  char *filename;
+  int format;                   /* SSV_GZIP or SSV_ZSTD, if compressed. */
+  int write_fd;                 /* The end of the pipe the thread writes
+				   the text to. */
+  pthread_t thread;
+  CLEANUP *cleanup;             /* Closes the file if the call fails. */
+};
+
+static void WriteText(SSVINPUT *input, char *buf, size_t len)
+{
+  ssize_t written;
+
+  while (len > 0) {
+    if ((written = write(input->write_fd, buf, len)) < 0) {
+      if (errno == EINTR)
+	continue;
+      SYS_ERROR1("write() of the text of \"%s\"", input->filename);
     }
+    buf += written;
+    len -= written;
   }
+}
 
-  if (num_data == 0)
-    num_data = example;
+static void InflateGzip(SSVINPUT *input, char *buf)
+{
+  z_stream strm;
+  unsigned char *in_buf = (unsigned char *) getmem(INFLATE_SIZE);
+  ssize_t len;
+  int ret = Z_OK;
+
+  bzero(&strm, sizeof(strm));
+  if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK)
+    USER_ERROR1("cannot read gzip file \"%s\"", input->filename);
+  while ((len = read(fileno(input->compressed), in_buf, INFLATE_SIZE)) != 0) {
+    if (len < 0) {
+      if (errno == EINTR)
+	continue;
+      SYS_ERROR1("read(\"%s\")", input->filename);
+    }
+    strm.next_in = in_buf;
+    strm.avail_in = len;
+    /* A full output buffer may leave text in the decoder. */
+    do {
+      if (ret == Z_STREAM_END)  /* Another member follows. */
+	(void) inflateReset(&strm);
+      strm.next_out = (unsigned char *) buf;
+      strm.avail_out = INFLATE_SIZE;
+      ret = inflate(&strm, Z_NO_FLUSH);
+      if (ret == Z_BUF_ERROR)   /* Nothing more without more input. */
+	ret = Z_OK;
+      else if (ret != Z_OK && ret != Z_STREAM_END)
+	USER_ERROR2("gzip file \"%s\": %s", input->filename,
+		    (strm.msg != NULL) ? strm.msg : "corrupt input");
+      WriteText(input, buf, INFLATE_SIZE - strm.avail_out);
+    } while (strm.avail_in > 0 ||
+	     (strm.avail_out == 0 && ret != Z_STREAM_END));
+  }
+  if (ret != Z_STREAM_END)
+    USER_ERROR1("gzip file \"%s\": truncated input", input->filename);
+  (void) inflateEnd(&strm);
+  freemem(in_buf);
+}
+
+#ifdef HAVE_ZSTD
+static void DecompressZstd(SSVINPUT *input, char *buf)
+{
+  ZSTD_DStream *zds;
+  ZSTD_inBuffer in;
+  ZSTD_outBuffer out;
+  size_t in_size = ZSTD_DStreamInSize(), ret = 0;
+  char *in_buf = getmem(in_size);
+  ssize_t len;
+
+  if ((zds = ZSTD_createDStream()) == NULL)
+    USER_ERROR1("cannot read zstd file \"%s\"", input->filename);
+  (void) ZSTD_initDStream(zds);
+  while ((len = read(fileno(input->compressed), in_buf, in_size)) != 0) {
+    if (len < 0) {
+      if (errno == EINTR)
+	continue;
+      SYS_ERROR1("read(\"%s\")", input->filename);
+    }
+    in.src = in_buf;
+    in.size = len;
+    in.pos = 0;
+    /* A full output buffer may leave text in the decoder. */
+    do {
+      out.dst = buf;
+      out.size = INFLATE_SIZE;
+      out.pos = 0;
+      ret = ZSTD_decompressStream(zds, &out, &in);
+      if (ZSTD_isError(ret))
+	USER_ERROR2("zstd file \"%s\": %s", input->filename,
+		    ZSTD_getErrorName(ret));
+      WriteText(input, buf, out.pos);
+    } while (in.pos < in.size || out.pos == out.size);
+  }
+  if (ret != 0)
+    USER_ERROR1("zstd file \"%s\": truncated input", input->filename);
+  ZSTD_freeDStream(zds);
+  freemem(in_buf);
+}
+#endif // HAVE_ZSTD
+
+static void CloseWriteEnd(void *arg)
+{
+  close(((SSVINPUT *) arg)->write_fd);
+}
+
+static void *DecompressThread(void *arg)
+{
+  SSVINPUT *input = (SSVINPUT *) arg;
+  char *buf;
+
+  /* The parser sees the end of the text even if this thread fails. */
+  pthread_cleanup_push(CloseWriteEnd, input);
+  buf = getmem(INFLATE_SIZE);
+#ifdef HAVE_ZSTD
+  if (input->format == SSV_ZSTD)
+    DecompressZstd(input, buf);
+  else
+#endif
+    InflateGzip(input, buf);
+  freemem(buf);
+  pthread_cleanup_pop(1);
+  return NULL;
+}
+
+/* ......................................................................
+
+   Close an SSV file opened by OpenSSVInput(), without releasing its
+   memory.  The rest of a compressed file is read first, so that its
+   thread can finish writing it.  Also called if the call reading the
+   file fails (see PushCleanup()).
+
+   ...................................................................... */
+
+static void ReleaseSSVInput(void *arg)
+{
+  SSVINPUT *input = (SSVINPUT *) arg;
+  char buf[4096];
+
+  if (input->compressed != NULL) {
+    while (fread(buf, 1, sizeof(buf), input->fptr) > 0)
+      ;
+    pthread_join(input->thread, NULL);
+    fclose(input->compressed);
+  }
+  fclose(input->fptr);
+}
+
+/* ......................................................................
+
+   Open an SSV file ("-" for the standard input) for reading its text from
+   the "fptr" of the result, decompressing it on a thread of its own if it
+   is compressed.  Only files can be recognized as compressed, not the
+   standard input.  Close it with CloseSSVInput().
+
+   ...................................................................... */
+
+static SSVINPUT *OpenSSVInput(char *filename)
+{
+  SSVINPUT *input;
+  FILE *text;
+  unsigned char magic[4];
+  ssize_t len;
+  int fds[2], err;
+
+  input = (SSVINPUT *) getmem_tag(sizeof(SSVINPUT), MEM_DATASET);
+  input->filename = filename;
+  input->compressed = NULL;
+  input->format = SSV_PLAIN;
+  input->cleanup = NULL;
+  if (!strcmp(filename, "-")) {
+    input->fptr = stdin;
+    return input;
+  }
+  if ((input->fptr = fopen(filename, "r")) == NULL)
+    SYS_ERROR1("fopen(\"%s\", \"r\")", filename);
+  input->cleanup = PushCleanup(ReleaseSSVInput, input);
+
+  len = pread(fileno(input->fptr), magic, sizeof(magic), 0);
+  if (len >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+    input->format = SSV_GZIP;
+  else if (len == 4 && magic[0] == 0x28 && magic[1] == 0xb5 &&
+	   magic[2] == 0x2f && magic[3] == 0xfd)
+    input->format = SSV_ZSTD;
+  else
+    return input;
+#ifndef HAVE_ZSTD
+  if (input->format == SSV_ZSTD)
+    USER_ERROR1("\"%s\" is compressed with zstd, but dt was compiled "
+		"without HAVE_ZSTD", filename);
+#endif
+
+  if (pipe(fds) < 0)
+    SYS_ERROR1("pipe() for \"%s\"", filename);
+#ifdef F_SETPIPE_SZ
+  /* A larger pipe lets the thread run further ahead of the parser. */
+  (void) fcntl(fds[1], F_SETPIPE_SZ, 1 << 20);
+#endif
+  if ((text = fdopen(fds[0], "r")) == NULL) {
+    err = errno;
+    close(fds[0]);
+    close(fds[1]);
+    errno = err;
+    SYS_ERROR1("fdopen() for \"%s\"", filename);
+  }
+  input->compressed = input->fptr;
+  input->fptr = text;
+  input->write_fd = fds[1];
+  if ((err = CreateThread(&input->thread, DecompressThread, input)) != 0) {
+    close(input->write_fd);
+    fclose(text);
+    input->fptr = input->compressed;
+    input->compressed = NULL;
+    errno = err;
+    SYS_ERROR1("pthread_create() for \"%s\"", filename);
+  }
+  return input;
+}
+
+/* ......................................................................
+
+   Close an SSV file opened by OpenSSVInput(), and release it.  Fails if
+   its thread failed.
+
+   ...................................................................... */
+
+static void CloseSSVInput(SSVINPUT *input)
+{
+  if (input->cleanup != NULL) {
+    PopCleanup(input->cleanup);
+    ReleaseSSVInput(input);
+  }
+  freemem(input);
+  CheckContext();
+}
+
+void **ReadSSVFile(char *filename, long *num_data_ptr,
+		   int *num_features_ptr, SSVINFO *ssvinfo)
+{ 
+  long num_data;
+  int feature, num_features;
+  void **data = NULL;
+  SSVINPUT *input;
+  FILE *fptr;
+  VALDICT dict;
+  char *temp_str = getmem(TEMP_STR_SIZE);
+
+  TRACE_BEGIN("read", "\"file\": %s", TraceString(filename));
+  input = OpenSSVInput(filename);
+  fptr = input->fptr;
+  if (ssvinfo->libsvm) {
+    data = ReadLIBSVMFile(fptr, filename, num_data_ptr, num_features_ptr,
+			  ssvinfo);
+    CloseSSVInput(input);
+    freemem(temp_str);
+    TRACE_END("\"rows\": %ld", *num_data_ptr);
+    return data;
+  }
+  num_features = ReadSSVHeader(fptr, temp_str, &num_data, ssvinfo);
+  InitValueDict(&dict);
+#if SSV_MMAP
+  data = ReadSSVMapped(fptr, filename, &num_data, num_features,
+		       ssvinfo->types, &dict, ssvinfo);
+#endif
+  if (data == NULL)
+    data = ReadSSVLines(fptr, filename, temp_str, &num_data, num_features,
+			ssvinfo->types, &dict, ssvinfo);
+  freemem(dict.slots);
+
+  for (feature = 0; feature < num_features; feature++)
+    if (ssvinfo->types[feature] == 'd')
+      NarrowDataColumn(data, num_data, feature, 'd',
+		       DISCRETE_CODE_WIDTH(ssvinfo->num_discrete_vals[feature]));
   *num_data_ptr = num_data;
   *num_features_ptr = num_features;
-  fclose (fptr);
-  free (temp_str);
+  CloseSSVInput(input);
+  freemem(temp_str);
+  TRACE_END("\"rows\": %ld", num_data);
   return data;
+}
+
+/* ----------------------------------------------------------------------
+
+   Read only some of the attributes of an SSV file: those with
+   columns[feature] set.  The attributes and values are those of a model
+   (see LoadModel()), already in "ssvinfo", which the file must have too;
+   the tokens of the other attributes are skipped without being parsed,
+   or even found past the last attribute read, and their columns are NULL.
+   Values the model does not know are read as the number of values of
+   their attribute, and take the default branch (see ClassifyExample()).
+   Returns the data set as ReadSSVFile() does.
+
+   ---------------------------------------------------------------------- */
+
+void **ReadSSVColumns(char *filename, long *num_data_ptr, int num_features,
+		      uchar *columns, SSVINFO *ssvinfo)
+{
+  long num_data;
+  int feature;
+  void **data = NULL;
+  SSVINPUT *input;
+  FILE *fptr;
+  SSVINFO header;
+  VALDICT dict;
+  char *types;
+  char *temp_str = getmem(TEMP_STR_SIZE);
+
+  if (ssvinfo->libsvm)
+    USER_ERROR1("\"%s\" cannot be read by column: LIBSVM files are read "
+		"whole", filename);
+  TRACE_BEGIN("read", "\"file\": %s", TraceString(filename));
+  input = OpenSSVInput(filename);
+  fptr = input->fptr;
+  if (ReadSSVHeader(fptr, temp_str, &num_data, &header) != num_features ||
+      strcmp(header.types, ssvinfo->types))
+    USER_ERROR1("\"%s\" does not have the attributes of the model",
+		filename);
+  for (feature = 0; feature < num_features; feature++)
+    if (strcmp(header.feat_names[feature], ssvinfo->feat_names[feature]))
+      USER_ERROR1("\"%s\" does not have the attributes of the model",
+		  filename);
+  FreeSSVInfo(num_features, &header);
+
+  types = (char *) getmem(num_features + 1);
+  for (feature = 0; feature < num_features; feature++)
+    types[feature] = columns[feature] ? ssvinfo->types[feature] : '-';
+  types[num_features] = '\0';
+  BuildValueDict(&dict, num_features, ssvinfo);
+  dict.known_only = 1;
+#if SSV_MMAP
+  data = ReadSSVMapped(fptr, filename, &num_data, num_features, types,
+		       &dict, ssvinfo);
+#endif
+  if (data == NULL)
+    data = ReadSSVLines(fptr, filename, temp_str, &num_data, num_features,
+			types, &dict, ssvinfo);
+  freemem(dict.slots);
+
+  /* Leave a code for the unknown values. */
+  for (feature = 0; feature < num_features; feature++)
+    if (types[feature] == 'd')
+      NarrowDataColumn(data, num_data, feature, 'd',
+		       DISCRETE_CODE_WIDTH(ssvinfo->num_discrete_vals[feature]
+					   + 1));
+  *num_data_ptr = num_data;
+  CloseSSVInput(input);
+  freemem(types);
+  freemem(temp_str);
+  TRACE_END("\"rows\": %ld", num_data);
+  return data;
+}
+
+/* ----------------------------------------------------------------------
 
-#undef feat_names
-#undef types
+   Release the attribute and value names of an SSV file.
+
+   ---------------------------------------------------------------------- */
+
+void FreeSSVInfo(int num_features, SSVINFO *ssvinfo)
+{
+  int feature, val;
+
+  for (feature = 0; feature < num_features; feature++) {
+    freemem(ssvinfo->feat_names[feature]);
+    for (val = 0; val < ssvinfo->num_discrete_vals[feature]; val++)
+      freemem(ssvinfo->discrete_vals[feature][val]);
+    freemem(ssvinfo->discrete_vals[feature]);
+  }
+  freemem(ssvinfo->feat_names);
+  freemem(ssvinfo->types);
+  freemem(ssvinfo->discrete_vals);
+  freemem(ssvinfo->num_discrete_vals);
+}
+
+/* ----------------------------------------------------------------------
+
+   Release a data set and its attribute and value names, as returned by
+   ReadSSVFile(), ReadTwo() or ReadTPT().
+
+   ---------------------------------------------------------------------- */
+
+void FreeSSVFile(void **data, int num_features, SSVINFO *ssvinfo)
+{
+  int feature;
+
+  for (feature = 0; feature < num_features; feature++)
+    FreeDataColumn(data[feature]);
+  freemem(data);
+  FreeSSVInfo(num_features, ssvinfo);
+}
+
+/* ----------------------------------------------------------------------
+
+   Open an SSV file ("-" for the standard input) to be read one example at
+   a time with ReadSSVStream(), and read its header into "ssvinfo".  The
+   number of examples in the header is ignored: the stream is read until
+   its end.  The dictionaries of discrete values grow as new values are
+   read, and belong to "ssvinfo" (see FreeSSVInfo()).
+
+   ---------------------------------------------------------------------- */
+
+SSVSTREAM *OpenSSVStream(char *filename, int *num_features_ptr,
+			 SSVINFO *ssvinfo)
+{
+  SSVSTREAM *stream;
+  long num_data;
+  int feature;
+
+  if (ssvinfo->libsvm)
+    USER_ERROR1("\"%s\" cannot be streamed: LIBSVM files are read whole",
+		filename);
+  stream = (SSVSTREAM *) getmem_tag(sizeof(SSVSTREAM), MEM_DATASET);
+  stream->input = OpenSSVInput(filename);
+  stream->fptr = stream->input->fptr;
+  stream->temp_str = getmem_tag(TEMP_STR_SIZE, MEM_DATASET);
+  stream->num_features =
+    ReadSSVHeader(stream->fptr, stream->temp_str, &num_data, ssvinfo);
+  stream->num_read = 0;
+
+  stream->row = (void **)
+    getmem_tag(stream->num_features * sizeof(void *), MEM_DATASET);
+  for (feature = 0; feature < stream->num_features; feature++)
+    stream->row[feature] =
+      NewDataColumn(1, ssvinfo->types[feature],
+		    (ssvinfo->types[feature] == 'd') ? sizeof(int) :
+		    sizeof(double));
+
+  InitValueDict(&stream->dict);
+
+  *num_features_ptr = stream->num_features;
+  return stream;
+}
+
+/* ----------------------------------------------------------------------
+
+   Read the next example of a stream into stream->row, a data set of one
+   example (example 0).  Returns 0 at the end of the stream, 1 otherwise.
+
+   ---------------------------------------------------------------------- */
+
+int ReadSSVStream(SSVSTREAM *stream, SSVINFO *ssvinfo)
+{
+  int feature;
+  unsigned char value_b;
+  char *data_str, *word_str;
+
+  if ((data_str = fgets_clean_eof(stream->temp_str, stream->fptr)) == NULL)
+    return 0;
+  for (feature = 0; feature < stream->num_features; feature++) {
+    word_str = next_word(&data_str);
+    switch (ssvinfo->types[feature]) {
+    case 'b':
+      value_b = *word_str - '0';
+      if (value_b != 0 && value_b != 1)
+	USER_ERROR3("ReadSSVStream(): example %ld, feature %d "
+		    "is not binary (value = %d)\n", stream->num_read,
+		    feature, value_b);
+      write_attrib_b(stream->row, 0, feature, value_b);
+      break;
+    case 'd':
+      write_attrib_i(stream->row, 0, feature,
+		     DictValue(&stream->dict, feature, word_str,
+			       strlen(word_str), ssvinfo));
+      break;
+    case 'c':
+      write_attrib_c(stream->row, 0, feature, atof(word_str));
+      break;
+    }
+  }
+  stream->num_read++;
+
+  return 1;
+}
+
+/* ----------------------------------------------------------------------
+
+   Close a stream.  The attribute and value names stay in "ssvinfo".
+
+   ---------------------------------------------------------------------- */
+
+void CloseSSVStream(SSVSTREAM *stream, SSVINFO *ssvinfo)
+{
+  int feature;
+
+  (void) ssvinfo;
+  CloseSSVInput(stream->input);
+  for (feature = 0; feature < stream->num_features; feature++)
+    FreeDataColumn(stream->row[feature]);
+  freemem(stream->row);
+  freemem(stream->dict.slots);
+  freemem(stream->temp_str);
+  freemem(stream);
 }
 /**************************************************************************/
@@ -14,6 +14,29 @@
 #ifndef SSV_H
 #define SSV_H 1
 
+#include <stdio.h>
+
+/* Read SSV files by mapping them in memory and parsing them in place (1),
+   or through stdio only (0).  Files that cannot be mapped, such as pipes,
+   are always read through stdio. */
+#ifndef SSV_MMAP
+#define SSV_MMAP 1
+#endif
+
+/* Read the files of ReadTPT() and ReadTwo() each on its own thread (1), or
+   one after the other (0).  At run time, a DT_THREADS environment variable
+   smaller than the number of files also reads them one after the other. */
+#ifndef SSV_THREADS
+#define SSV_THREADS 1
+#endif
+
+/* Attributes of a LIBSVM file nonzero in at most this fraction of the
+   examples are held as sparse columns (see SPARSECOLUMN), the others as
+   dense continuous columns. */
+#ifndef SSV_SPARSE_FRACTION
+#define SSV_SPARSE_FRACTION 0.1
+#endif
+
 #define SKIPSPACE(ptr) {					\
   while (*(ptr) == ' ' || *(ptr) == '\t' || *(ptr) == '\n')	\
     (ptr)++;							\
@@ -25,17 +48,89 @@
   SKIPSPACE(ptr)						\
 }
 
+/* A data set is an array of columns, one per attribute, the class (a
+   binary attribute) first.  Every column has a header giving the type of
+   its attribute and the width of its elements (see COLUMN_TYPE() and
+   COLUMN_WIDTH() in auxi.h), and is aligned and padded to DT_COLUMN_ALIGN
+   bytes, so that its bits or elements can be loaded a word or a vector at
+   a time (see CountMemberBits() in memberset.h).  Binary columns are bit
+   arrays. */
+
+/* The column of the class. */
+#define LABEL_COLUMN(data) ((uchar *) (data)[0])
+
 /* Read a binary (0/1) value. */
 #define READ_ATTRIB_B(data, example, feature)	\
   READ_BITARRAY(data[feature], example)
 
+/* Discrete columns hold the code (index) of every value in 1, 2 or 4
+   bytes, the fewest that fit the attribute's values (see
+   DISCRETE_CODE_WIDTH()), and continuous columns hold doubles, or floats if
+   SSVINFO.float_columns is set.  Loops over a whole column should test
+   the width once and use the element type directly. */
+
+/* Width in bytes of the codes of a discrete attribute with "num_vals"
+   values. */
+#define DISCRETE_CODE_WIDTH(num_vals)					\
+  (((num_vals) <= (1 << 8)) ? 1 : ((num_vals) <= (1 << 16)) ? 2 :	\
+   (int) sizeof(int))
+
+/* Read the code of a discrete value from a column. */
+#define READ_CODE(column, example)					\
+  ((COLUMN_WIDTH(column) == 1) ?					\
+   (int) ((unsigned char *) (column))[example] :			\
+   (COLUMN_WIDTH(column) == 2) ?					\
+   (int) ((unsigned short *) (column))[example] :			\
+   ((int *) (column))[example])
+
+/* A continuous column of a LIBSVM file may instead be sparse, its header
+   then giving COLUMN_SPARSE as its width: it holds only the examples
+   whose value is not zero, in increasing order, and their values, or no
+   values if they are all 1.  Reading an example of it takes a binary
+   search (see ReadSparseValue()); loops over examples should walk the
+   nonzero rows instead, and get the counts of the zero examples by
+   subtraction. */
+#define COLUMN_SPARSE 0
+
+typedef struct sparsecolumn {
+  long num_nonzero;
+  long *rows;                   /* Examples whose value is not zero. */
+  double *vals;                 /* Their values, or NULL if all are 1. */
+} SPARSECOLUMN;
+
+#define SPARSE_COLUMN(column) ((SPARSECOLUMN *) (column))
+
+/* Read the value of an example from a sparse column: 0 unless it is one
+   of the rows of the column. */
+static inline double ReadSparseValue(SPARSECOLUMN *column, long example)
+{
+  long lo = 0, hi = column->num_nonzero, mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (column->rows[mid] < example)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo == column->num_nonzero || column->rows[lo] != example)
+    return 0.0;
+  return (column->vals != NULL) ? column->vals[lo] : 1.0;
+}
+
+/* Read a continuous value from a column. */
+#define READ_VALUE(column, example)					\
+  ((COLUMN_WIDTH(column) == 4) ? (double) ((float *) (column))[example] :	\
+   (COLUMN_WIDTH(column) == 8) ? ((double *) (column))[example] :	\
+   ReadSparseValue(SPARSE_COLUMN(column), example))
+
 /* Read a double. */
 #define READ_ATTRIB_C(data, example, feature)	\
-  (((double *) (data)[feature])[example])
+  READ_VALUE((data)[feature], example)
 
 /* Read an integer. */
 #define READ_ATTRIB_I(data, example, feature)	\
-  (((int *) (data)[feature])[example])
+  READ_CODE((data)[feature], example)
 
 /* Structure holding information about the SSV file. */
 typedef struct ssvinfo {
@@ -62,38 +157,134 @@ typedef struct ssvinfo {
 			      discrete_vals[i].  0 fir binary and continuous
 			      attributes. */
   int batch;               /* the number of times to repeat the dt learner */
+  int boost_rounds;        /* Number of gradient boosting rounds; 0 grows a
+			      single (unboosted) decision tree. */
+  int grow_mode;           /* How to grow a tree, see grow.h. */
+  int subset_splits;       /* Split discrete attributes two ways, on the
+			      best subset of their values, instead of one
+			      way per value. */
+  int max_depth;           /* Maximum number of tests on a path from the
+			      root to a leaf; 0 means use the default for
+			      the learner in use. */
+  int max_leaves;          /* Maximum number of leaves of a tree grown
+			      best-first (0 = unlimited). */
+  double min_gain;         /* Smallest gain of a split worth making when
+			      growing best-first. */
+  double time_limit;       /* Wall-clock budget (seconds) for growing a
+			      tree best-first (0 = unlimited). */
+  double learning_rate;    /* Shrinkage applied to boosted leaf outputs. */
+  double stream_delta;     /* Hoeffding bound confidence parameter of trees
+			      grown from a stream, see hoeffding.h. */
+  int stream_grace;        /* Examples between split attempts at a leaf. */
+  double stream_tie;       /* Bound below which near-ties are split. */
+  int stream_report;       /* Examples between progress reports. */
+  int float_columns;       /* Store continuous columns as floats rather
+			      than doubles. */
+  int libsvm;              /* Read the data files in the sparse LIBSVM
+			      format rather than as SSV files. */
+  char *model_filename;    /* File to save the grown (or updated) tree
+			      to, see update.h; NULL if not saved. */
+  char *roc_filename;      /* File to write the ROC and precision-recall
+			      curves of the test set to, see roc.h; NULL
+			      if not written. */
+  char *thresholds;        /* Comma-separated decision thresholds to
+			      report the test set's confusion matrix at;
+			      NULL if not given. */
 } SSVINFO;
 
+/* An entry of a dictionary of discrete values. */
+typedef struct valslot {
+  int feature;
+  int val;                      /* Index in discrete_vals[feature], or -1
+				   for an empty slot. */
+} VALSLOT;
+
+/* A dictionary of the discrete values read from an SSV file, mapping each
+   (feature, name) pair to its index in ssvinfo->discrete_vals[feature]. */
+typedef struct valdict {
+  VALSLOT *slots;               /* Hash table, a power of two in size. */
+  int num_slots;
+  int num_values;               /* Number of slots in use. */
+  int known_only;               /* Whether a value not in the dictionary
+				   is read as the number of values of its
+				   feature (unknown to a model, see
+				   ReadSSVColumns()) rather than added. */
+} VALDICT;
+
+/* An SSV file, possibly compressed, being read (see OpenSSVInput() in
+   ssv.c). */
+typedef struct ssvinput SSVINPUT;
+
+/* An SSV file read one example at a time, see OpenSSVStream(). */
+typedef struct ssvstream {
+  SSVINPUT *input;
+  FILE *fptr;                   /* The text of the file. */
+  int num_features;
+  long num_read;                 /* Number of examples read so far. */
+  void **row;                   /* The last example read, as a data set of
+				   a single example. */
+  char *temp_str;               /* Line buffer. */
+  VALDICT dict;                 /* The discrete values seen. */
+} SSVSTREAM;
+
+/* A file read by ReadTPT() or ReadTwo(), possibly on a thread of its
+   own. */
+typedef struct ssvread {
+  char *filename;
+  int float_columns;            /* As in SSVINFO. */
+  int libsvm;
+  void **data;                  /* The file as read by ReadSSVFile(). */
+  long num_data;
+  int num_features;
+  SSVINFO ssvinfo;
+} SSVREAD;
+
 #include "auxi.h"
+#include "memberset.h"
 #include "dt.h"
 
 /* Function prototypes. */
 void **ReadTPT(char *train_filename, char *prune_filename, char *test_filename,
-               uchar **train_members_ptr, uchar **prune_members_ptr, uchar **test_members_ptr,
-               int *num_train_ptr, int *num_prune_ptr, int *num_test_ptr,
-               int *num_data_ptr, int *num_features_ptr, SSVINFO *ssvinfo);
+               MEMBERSET **train_members_ptr, MEMBERSET **prune_members_ptr,
+               MEMBERSET **test_members_ptr,
+               long *num_train_ptr, long *num_prune_ptr, long *num_test_ptr,
+               long *num_data_ptr, int *num_features_ptr, SSVINFO *ssvinfo);
 void **ReadTwo(char *train_filename, char *prune_filename,
-               uchar **train_members_ptr, uchar **prune_members_ptr,
-               int *num_train_ptr, int *num_prune_ptr,
-               int *num_data_ptr, int *num_features_ptr, SSVINFO *ssvinfo);
-void **MergeSSVFile(int num_data_A, int num_data_B, 
+               MEMBERSET **train_members_ptr, MEMBERSET **prune_members_ptr,
+               long *num_train_ptr, long *num_prune_ptr,
+               long *num_data_ptr, int *num_features_ptr, SSVINFO *ssvinfo);
+void **MergeSSVFile(long num_data_A, long num_data_B, 
                     SSVINFO *ssvinfo_A, SSVINFO *ssvinfo_B,
                     void **data_A, void **data_B,
                     SSVINFO *ssvinfo_result,
                     int num_features);
-void **ReadSSVFile(char *filename, int *num_data_ptr,
+void **ReadSSVFile(char *filename, long *num_data_ptr,
 		   int *num_features_ptr, SSVINFO *ssvinfo);
-unsigned char read_attrib_b(void **data, int example, int feature);
-void write_attrib_b(void **data, int example, int feature,
+void **ReadSSVColumns(char *filename, long *num_data_ptr, int num_features,
+		      uchar *columns, SSVINFO *ssvinfo);
+void FreeSSVFile(void **data, int num_features, SSVINFO *ssvinfo);
+void *NewDataColumn(long num_data, char type, int width);
+void *NewSparseColumn(long num_nonzero, int with_vals);
+void FreeDataColumn(void *column);
+void FreeSSVInfo(int num_features, SSVINFO *ssvinfo);
+SSVSTREAM *OpenSSVStream(char *filename, int *num_features_ptr,
+			 SSVINFO *ssvinfo);
+int ReadSSVStream(SSVSTREAM *stream, SSVINFO *ssvinfo);
+void CloseSSVStream(SSVSTREAM *stream, SSVINFO *ssvinfo);
+void BuildValueDict(VALDICT *dict, int num_features, SSVINFO *ssvinfo);
+int FindDiscreteValue(VALDICT *dict, int feature, char *name, int len,
+		      SSVINFO *ssvinfo);
+unsigned char read_attrib_b(void **data, long example, int feature);
+void write_attrib_b(void **data, long example, int feature,
 		    unsigned char val);
-int read_attrib_i(void **data, int example, int feature);
-void write_attrib_i(void **data, int example, int feature, int val);
-double read_attrib_c(void **data, int example, int feature);
-void write_attrib_c(void **data, int example, int feature, double val);
-void PartitionExamples(void **data, int *num_data_ptr, int num_features,
-		       uchar **train_members_ptr, int *num_train_ptr,
-		       uchar **test_members_ptr, int *num_test_ptr,
-		       uchar **prune_members_ptr, int *num_prune_ptr,
+int read_attrib_i(void **data, long example, int feature);
+void write_attrib_i(void **data, long example, int feature, int val);
+double read_attrib_c(void **data, long example, int feature);
+void write_attrib_c(void **data, long example, int feature, double val);
+void PartitionExamples(void **data, long *num_data_ptr, int num_features,
+		       MEMBERSET **train_members_ptr, long *num_train_ptr,
+		       MEMBERSET **test_members_ptr, long *num_test_ptr,
+		       MEMBERSET **prune_members_ptr, long *num_prune_ptr,
 		       double train_pct, double prune_pct, double test_pct,
 		       SSVINFO *ssvinfo);
 #endif // SSV_H
@@ -0,0 +1,871 @@
+/**************************************************************************
+ *
+ * update.c
+ *
+ * Source file containing routines to save a decision tree along with the
+ * statistics of its nodes, and to bring a saved tree up to date when new
+ * examples are appended to its training set.  The new examples are routed
+ * down the tree, the count tables of the nodes they reach are updated, and
+ * a node is grown again only if its best split changes, so the result is
+ * the tree that growing it from all the examples would give.
+ *
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "auxi.h"
+#include "dt.h"
+#include "entropy.h"
+#include "update.h"
+#include "ssv.h"
+#include "bitarray.h"
+#include "profile.h"
+
+/* Work of an update, see UpdateDecisionTree(). */
+typedef struct updatework {
+  int *offsets;                 /* offsets[attr] is the first entry of
+				   attribute "attr" in the count tables of
+				   the nodes; offsets[num_features] their
+				   size. */
+  int nodes_checked;            /* Internal nodes whose split was found
+				   again. */
+  int subtrees_grown;           /* Subtrees grown again, or new. */
+  int nodes_grown;              /* Nodes in those subtrees. */
+  long examples_grown;          /* Examples they were grown from. */
+} UPDATEWORK;
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary function.  Return the offset of the count table of every
+   attribute within the "stats" of a node, to be freed by the caller.
+
+   ---------------------------------------------------------------------- */
+
+static int *StatsOffsets(int num_features, SSVINFO *ssvinfo)
+{
+  int *offsets, attr;
+
+  offsets = (int *) getmem_tag((num_features + 1) * sizeof(int), MEM_MISC);
+  offsets[0] = offsets[1] = 0;  /* The target has no table. */
+  for (attr = 1; attr < num_features; attr++) {
+    offsets[attr + 1] = offsets[attr];
+    if (ssvinfo->types[attr] == 'b')
+      offsets[attr + 1] += 2;
+    else if (ssvinfo->types[attr] == 'd')
+      offsets[attr + 1] += ssvinfo->num_discrete_vals[attr];
+  }
+
+  return offsets;
+}
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary function.  Return the index of the child of an internal node
+   that an example takes, or -1 for the default branch of a discrete test.
+
+   ---------------------------------------------------------------------- */
+
+static int TestChildIndex(DTNODE *node, void **data, long example,
+			  SSVINFO *ssvinfo)
+{
+  switch (ssvinfo->types[node->test_attrib]) {
+  case 'b':
+    return READ_ATTRIB_B(data, example, node->test_attrib);
+  case 'd':
+    return DiscreteChildIndex(node,
+			      READ_ATTRIB_I(data, example, node->test_attrib));
+  case 'c':
+    return (READ_ATTRIB_C(data, example, node->test_attrib) >=
+	    node->threshold);
+  default:
+    USER_ERROR1("Unknown attribute type '%c'",
+		ssvinfo->types[node->test_attrib]);
+  }
+
+  return -1;
+}
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary function.  Add an example to the count tables of an internal
+   node, allocating them if needed.
+
+   ---------------------------------------------------------------------- */
+
+static void AddNodeStats(DTNODE *node, void **data, long example,
+			 int *offsets, int num_features, SSVINFO *ssvinfo)
+{
+  int attr, label;
+
+  if (node->stats == NULL) {
+    node->stats = (long (*)[2])
+      getmem_tag(offsets[num_features] * sizeof(*node->stats), MEM_TREE);
+    memset(node->stats, 0, offsets[num_features] * sizeof(*node->stats));
+  }
+  label = READ_ATTRIB_B(data, example, 0);
+  for (attr = 1; attr < num_features; attr++) {
+    if (ssvinfo->types[attr] == 'b')
+      node->stats[offsets[attr] + READ_ATTRIB_B(data, example, attr)]
+	[label]++;
+    else if (ssvinfo->types[attr] == 'd')
+      node->stats[offsets[attr] + READ_ATTRIB_I(data, example, attr)]
+	[label]++;
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Auxiliary function.  Add the members to the count tables of every
+   internal node of a subtree they reach.
+
+   ---------------------------------------------------------------------- */
+
+static void CountSubTreeStats(DTNODE *root, void **data, MEMBERSET *members,
+			      int *offsets, int num_features, SSVINFO *ssvinfo)
+{
+  MEMBERITER iter;
+  DTNODE *node;
+  long example;
+  int child;
+
+  PROFILE_COUNT(rows_scanned, MEMBERSET_CARDINALITY(members));
+  FOR_EACH_MEMBER(iter, members, example) {
+    for (node = root; node != NULL && node->num_children > 0;
+	 node = (child >= 0) ? node->children[child] : (DTNODE *) NULL) {
+      AddNodeStats(node, data, example, offsets, num_features, ssvinfo);
+      child = TestChildIndex(node, data, example, ssvinfo);
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+
+   Count the members (normally the training set the tree was grown from)
+   in the count tables of every internal node of a tree, which must not
+   have any yet, so that the tree can be saved and updated later.
+
+   ---------------------------------------------------------------------- */
+
+void CountDecisionTreeStats(DTNODE *root, void **data, long num_data,
+			    MEMBERSET *members, int num_features,
+			    SSVINFO *ssvinfo)
+{
+  int *offsets;
+
+  (void) num_data;
+  offsets = StatsOffsets(num_features, ssvinfo);
+  CountSubTreeStats(root, data, members, offsets, num_features, ssvinfo);
+  freemem(offsets);
+}
+
+/* ......................................................................
+
+   Write a node of a tree and its subtree, depth-first.  Values of
+   discrete attributes are written as their index in the dictionary at the
+   top of the file.
+
+   ...................................................................... */
+
+static void SaveNode(FILE *fptr, DTNODE *node, int *offsets,
+		     int num_features, SSVINFO *ssvinfo)
+{
+  int attr, val, i, num_stats;
+
+  if (node == NULL) {
+    fprintf(fptr, "null\n");
+    return;
+  }
+  fprintf(fptr, "node %ld %ld %ld ", node->num_members, node->num_pos,
+	  node->num_neg);
+  if (node->num_children == 0) {
+    fprintf(fptr, "leaf\n");
+    return;
+  }
+
+  attr = node->test_attrib;
+  switch (ssvinfo->types[attr]) {
+  case 'b':
+    fprintf(fptr, "binary %d\n", attr);
+    break;
+  case 'c':
+    fprintf(fptr, "continuous %d %.17g\n", attr, node->threshold);
+    break;
+  case 'd':
+    if (node->subset != NULL) {
+      for (val = i = 0; val < ssvinfo->num_discrete_vals[attr]; val++)
+	i += READ_BITARRAY(node->subset, val);
+      fprintf(fptr, "subset %d %d", attr, i);
+      for (val = 0; val < ssvinfo->num_discrete_vals[attr]; val++)
+	if (READ_BITARRAY(node->subset, val))
+	  fprintf(fptr, " %d", val);
+    } else {
+      fprintf(fptr, "discrete %d %d", attr, node->num_children);
+      for (i = 0; i < node->num_children; i++)
+	fprintf(fptr, " %d", node->child_vals[i]);
+    }
+    fprintf(fptr, "\n");
+    break;
+  default:
+    USER_ERROR1("Unknown attribute type '%c'", ssvinfo->types[attr]);
+  }
+
+  /* The count tables, as "attribute value negatives positives" for every
+     entry that is not empty. */
+  num_stats = 0;
+  if (node->stats != NULL)
+    for (i = 0; i < offsets[num_features]; i++)
+      num_stats += (node->stats[i][0] + node->stats[i][1] > 0);
+  fprintf(fptr, "stats %d", num_stats);
+  for (attr = 1; attr < num_features && num_stats > 0; attr++)
+    for (i = offsets[attr]; i < offsets[attr + 1]; i++)
+      if (node->stats[i][0] + node->stats[i][1] > 0)
+	fprintf(fptr, " %d %d %ld %ld", attr, i - offsets[attr],
+		node->stats[i][0], node->stats[i][1]);
+  fprintf(fptr, "\n");
+
+  for (i = 0; i < node->num_children; i++)
+    SaveNode(fptr, node->children[i], offsets, num_features, ssvinfo);
+}
+
+/* ----------------------------------------------------------------------
+
+   Save a decision tree grown depth-first, with the count tables of its
+   internal nodes (see CountDecisionTreeStats()), to a text file that
+   LoadDecisionTree() reads back.  The attributes and the names of their
+   values are saved too, so that the tree can be loaded along with a data
+   set whose values are numbered differently.
+
+   ---------------------------------------------------------------------- */
+
+void SaveDecisionTree(char *filename, DTNODE *root, int num_features,
+		      SSVINFO *ssvinfo)
+{
+  FILE *fptr;
+  CLEANUP *cleanup;
+  int *offsets;
+  int feature, val;
+
+  if ((fptr = fopen(filename, "w")) == NULL)
+    SYS_ERROR1("fopen(\"%s\", \"w\")", filename);
+  cleanup = PushCleanup(CloseFileCleanup, fptr);
+
+  fprintf(fptr, "dt-model %d\n", MODEL_VERSION);
+  fprintf(fptr, "features %d subsets %d\n", num_features,
+	  ssvinfo->subset_splits);
+  for (feature = 0; feature < num_features; feature++) {
+    fprintf(fptr, "%s %c %d", ssvinfo->feat_names[feature],
+	    ssvinfo->types[feature], ssvinfo->num_discrete_vals[feature]);
+    for (val = 0; val < ssvinfo->num_discrete_vals[feature]; val++)
+      fprintf(fptr, " %s", ssvinfo->discrete_vals[feature][val]);
+    fprintf(fptr, "\n");
+  }
+
+  offsets = StatsOffsets(num_features, ssvinfo);
+  SaveNode(fptr, root, offsets, num_features, ssvinfo);
+  freemem(offsets);
+
+  PopCleanup(cleanup);
+  if (fclose(fptr) != 0)
+    SYS_ERROR1("fclose(\"%s\")", filename);
+}
+
+/* ......................................................................
+
+   Read the next word of a model file into "word" (MAX_STRING_LEN long),
+   and return it.
+
+   ...................................................................... */
+
+static char *ReadModelWord(FILE *fptr, char *word, char *filename)
+{
+  if (fscanf(fptr, "%1023s", word) != 1)
+    USER_ERROR1("model file \"%s\" ends unexpectedly", filename);
+
+  return word;
+}
+
+/* ......................................................................
+
+   Read the next word of a model file as the index of a value of the
+   discrete attribute "attr" in the file's dictionary, and return the
+   index of the same value in the data set.
+
+   ...................................................................... */
+
+static int ReadModelValue(FILE *fptr, char *word, char *filename,
+			  int **val_maps, int *num_saved_vals, int attr)
+{
+  int val;
+
+  val = atoi(ReadModelWord(fptr, word, filename));
+  if (val < 0 || val >= num_saved_vals[attr])
+    USER_ERROR1("model file \"%s\" has a value out of range", filename);
+
+  return val_maps[attr][val];
+}
+
+/* ......................................................................
+
+   Read a node of a tree and its subtree, as written by SaveNode().
+
+   ...................................................................... */
+
+static DTNODE *LoadNode(FILE *fptr, char *word, char *filename,
+			int **val_maps, int *num_saved_vals, int *offsets,
+			int num_features, SSVINFO *ssvinfo)
+{
+  DTNODE *node, *child;
+  int attr, val, i, j, num_stats;
+  char type;
+
+  if (!strcmp(ReadModelWord(fptr, word, filename), "null"))
+    return (DTNODE *) NULL;
+  if (strcmp(word, "node"))
+    USER_ERROR2("model file \"%s\": expected a node, found \"%s\"",
+		filename, word);
+
+  node = NewDecisionTreeNode();
+  node->num_members = atol(ReadModelWord(fptr, word, filename));
+  node->num_pos = atol(ReadModelWord(fptr, word, filename));
+  node->num_neg = atol(ReadModelWord(fptr, word, filename));
+  if (!strcmp(ReadModelWord(fptr, word, filename), "leaf"))
+    return node;
+
+  /* The test.  A discrete one is two-way on a subset ('s'), or has a
+     child per value. */
+  if (!strcmp(word, "binary"))
+    type = 'b';
+  else if (!strcmp(word, "continuous"))
+    type = 'c';
+  else if (!strcmp(word, "discrete"))
+    type = 'd';
+  else if (!strcmp(word, "subset"))
+    type = 's';
+  else
+    type = '?';
+  attr = atoi(ReadModelWord(fptr, word, filename));
+  if (type == '?' || attr < 1 || attr >= num_features ||
+      ssvinfo->types[attr] != ((type == 's') ? 'd' : type))
+    USER_ERROR1("model file \"%s\" has a test that does not fit the data",
+		filename);
+  node->test_attrib = attr;
+  switch (type) {
+  case 'c':
+    node->threshold = atof(ReadModelWord(fptr, word, filename));
+    /* Fall through. */
+  case 'b':
+    node->num_children = 2;
+    break;
+  case 's':
+    node->num_children = 2;
+    node->subset = CREATE_BITARRAY_TAG(ssvinfo->num_discrete_vals[attr],
+				       MEM_TREE);
+    ZERO_BITARRAY(node->subset, ssvinfo->num_discrete_vals[attr]);
+    for (i = atoi(ReadModelWord(fptr, word, filename)); i > 0; i--) {
+      val = ReadModelValue(fptr, word, filename, val_maps, num_saved_vals,
+			   attr);
+      WRITE_BITARRAY(node->subset, val, 1);
+    }
+    break;
+  case 'd':
+    node->num_children = atoi(ReadModelWord(fptr, word, filename));
+    if (node->num_children < 1)
+      USER_ERROR1("model file \"%s\" has a test without children",
+		  filename);
+    node->child_vals =
+      (int *) getmem_tag(node->num_children * sizeof(int), MEM_TREE);
+    for (i = 0; i < node->num_children; i++)
+      node->child_vals[i] = ReadModelValue(fptr, word, filename, val_maps,
+					   num_saved_vals, attr);
+    break;
+  }
+  node->children =
+    (DTNODE **) getmem_tag(node->num_children * sizeof(DTNODE *), MEM_TREE);
+
+  /* The count tables. */
+  if (strcmp(ReadModelWord(fptr, word, filename), "stats"))
+    USER_ERROR2("model file \"%s\": expected stats, found \"%s\"",
+		filename, word);
+  node->stats = (long (*)[2])
+    getmem_tag(offsets[num_features] * sizeof(*node->stats), MEM_TREE);
+  memset(node->stats, 0, offsets[num_features] * sizeof(*node->stats));
+  for (num_stats = atoi(ReadModelWord(fptr, word, filename));
+       num_stats > 0; num_stats--) {
+    attr = atoi(ReadModelWord(fptr, word, filename));
+    if (attr < 1 || attr >= num_features || ssvinfo->types[attr] == 'c')
+      USER_ERROR1("model file \"%s\" has stats that do not fit the data",
+		  filename);
+    if (ssvinfo->types[attr] == 'd')
+      val = ReadModelValue(fptr, word, filename, val_maps, num_saved_vals,
+			   attr);
+    else
+      val = atoi(ReadModelWord(fptr, word, filename)) & 1;
+    node->stats[offsets[attr] + val][0] =
+      atol(ReadModelWord(fptr, word, filename));
+    node->stats[offsets[attr] + val][1] =
+      atol(ReadModelWord(fptr, word, filename));
+  }
+
+  for (i = 0; i < node->num_children; i++)
+    node->children[i] = LoadNode(fptr, word, filename, val_maps,
+				 num_saved_vals, offsets, num_features,
+				 ssvinfo);
+
+  /* The values of the data set may be numbered in another order than
+     those of the file: keep the children sorted by value. */
+  for (i = 1; node->child_vals != NULL && i < node->num_children; i++) {
+    val = node->child_vals[i];
+    child = node->children[i];
+    for (j = i; j > 0 && node->child_vals[j - 1] > val; j--) {
+      node->child_vals[j] = node->child_vals[j - 1];
+      node->children[j] = node->children[j - 1];
+    }
+    node->child_vals[j] = val;
+    node->children[j] = child;
+  }
+
+  return node;
+}
+
+/* ----------------------------------------------------------------------
+
+   Load a decision tree saved by SaveDecisionTree(), to be used with a data
+   set that was already read (in "ssvinfo"): the attributes must be the
+   same, and every value the file names must occur in the data.  Also take
+   the way discrete attributes are split (ssvinfo->subset_splits) from the
+   file.
+
+   ---------------------------------------------------------------------- */
+
+DTNODE *LoadDecisionTree(char *filename, int num_features, SSVINFO *ssvinfo)
+{
+  FILE *fptr;
+  CLEANUP *cleanup;
+  DTNODE *root;
+  char *word;
+  int **val_maps;               /* val_maps[attr][file value] is the index
+				   of the value in the data set. */
+  int *num_saved_vals;
+  int *offsets;
+  int feature, val, i;
+
+  if ((fptr = fopen(filename, "r")) == NULL)
+    SYS_ERROR1("fopen(\"%s\", \"r\")", filename);
+  cleanup = PushCleanup(CloseFileCleanup, fptr);
+  word = (char *) getmem(MAX_STRING_LEN);
+
+  if (strcmp(ReadModelWord(fptr, word, filename), "dt-model") ||
+      atoi(ReadModelWord(fptr, word, filename)) != MODEL_VERSION)
+    USER_ERROR1("\"%s\" is not a model file of this version", filename);
+  ReadModelWord(fptr, word, filename);
+  if (atoi(ReadModelWord(fptr, word, filename)) != num_features)
+    USER_ERROR1("model file \"%s\" does not have the attributes of the data",
+		filename);
+  ReadModelWord(fptr, word, filename);
+  ssvinfo->subset_splits = atoi(ReadModelWord(fptr, word, filename));
+
+  /* Match the attributes, and the values by name. */
+  val_maps = (int **) getmem(num_features * sizeof(int *));
+  num_saved_vals = (int *) getmem(num_features * sizeof(int));
+  for (feature = 0; feature < num_features; feature++) {
+    if (strcmp(ReadModelWord(fptr, word, filename),
+	       ssvinfo->feat_names[feature]) ||
+	ReadModelWord(fptr, word, filename)[0] != ssvinfo->types[feature])
+      USER_ERROR2("model file \"%s\" does not match attribute \"%s\" of "
+		  "the data", filename, ssvinfo->feat_names[feature]);
+    num_saved_vals[feature] = atoi(ReadModelWord(fptr, word, filename));
+    val_maps[feature] = (int *) getmem(num_saved_vals[feature] * sizeof(int));
+    for (val = 0; val < num_saved_vals[feature]; val++) {
+      ReadModelWord(fptr, word, filename);
+      for (i = 0; i < ssvinfo->num_discrete_vals[feature] &&
+	     strcmp(word, ssvinfo->discrete_vals[feature][i]); i++)
+	;
+      if (i == ssvinfo->num_discrete_vals[feature])
+	USER_ERROR2("value \"%s\" of model file \"%s\" is not in the data",
+		    word, filename);
+      val_maps[feature][val] = i;
+    }
+  }
+
+  offsets = StatsOffsets(num_features, ssvinfo);
+  root = LoadNode(fptr, word, filename, val_maps, num_saved_vals, offsets,
+		  num_features, ssvinfo);
+  freemem(offsets);
+
+  for (feature = 0; feature < num_features; feature++)
+    freemem(val_maps[feature]);
+  freemem(val_maps);
+  freemem(num_saved_vals);
+  freemem(word);
+  PopCleanup(cleanup);
+  fclose(fptr);
+
+  return root;
+}
+
+/* Copy of a word of a model file, as dictionary memory. */
+static char *CopyModelWord(char *word)
+{
+  return strcpy((char *) getmem_tag(strlen(word) + 1, MEM_DICT), word);
+}
+
+/* ----------------------------------------------------------------------
+
+   Load a decision tree saved by SaveDecisionTree() without a data set:
+   the attributes and the names of their values are taken from the file
+   into "ssvinfo" (to be released with FreeSSVInfo()), and their number
+   goes to "num_features_ptr".
+
+   ---------------------------------------------------------------------- */
+
+DTNODE *LoadModel(char *filename, int *num_features_ptr, SSVINFO *ssvinfo)
+{
+  FILE *fptr;
+  CLEANUP *cleanup;
+  char *word;
+  int num_features, feature, val;
+
+  if ((fptr = fopen(filename, "r")) == NULL)
+    SYS_ERROR1("fopen(\"%s\", \"r\")", filename);
+  cleanup = PushCleanup(CloseFileCleanup, fptr);
+  word = (char *) getmem(MAX_STRING_LEN);
+
+  if (strcmp(ReadModelWord(fptr, word, filename), "dt-model") ||
+      atoi(ReadModelWord(fptr, word, filename)) != MODEL_VERSION)
+    USER_ERROR1("\"%s\" is not a model file of this version", filename);
+  ReadModelWord(fptr, word, filename);
+  num_features = atoi(ReadModelWord(fptr, word, filename));
+  if (num_features < 1)
+    USER_ERROR1("model file \"%s\" has no attributes", filename);
+  ReadModelWord(fptr, word, filename);
+  ReadModelWord(fptr, word, filename);
+
+  ssvinfo->feat_names = (char **)
+    getmem_tag(num_features * sizeof(char *), MEM_DICT);
+  ssvinfo->types = (char *) getmem_tag(num_features + 1, MEM_DICT);
+  ssvinfo->types[num_features] = '\0';
+  ssvinfo->num_discrete_vals = (int *)
+    getmem_tag(num_features * sizeof(int), MEM_DICT);
+  ssvinfo->discrete_vals = (char ***)
+    getmem_tag(num_features * sizeof(char **), MEM_DICT);
+  for (feature = 0; feature < num_features; feature++) {
+    ssvinfo->feat_names[feature] =
+      CopyModelWord(ReadModelWord(fptr, word, filename));
+    ssvinfo->types[feature] = ReadModelWord(fptr, word, filename)[0];
+    ssvinfo->num_discrete_vals[feature] =
+      atoi(ReadModelWord(fptr, word, filename));
+    if (strchr("bdc", ssvinfo->types[feature]) == NULL ||
+	ssvinfo->num_discrete_vals[feature] < 0)
+      USER_ERROR2("model file \"%s\" has a bad attribute \"%s\"", filename,
+		  ssvinfo->feat_names[feature]);
+    ssvinfo->discrete_vals[feature] = (char **)
+      getmem_tag(ssvinfo->num_discrete_vals[feature] * sizeof(char *),
+		 MEM_DICT);
+    for (val = 0; val < ssvinfo->num_discrete_vals[feature]; val++)
+      ssvinfo->discrete_vals[feature][val] =
+	CopyModelWord(ReadModelWord(fptr, word, filename));
+  }
+  freemem(word);
+  PopCleanup(cleanup);
+  fclose(fptr);
+
+  /* The tree, now with the same attributes and values as the file. */
+  *num_features_ptr = num_features;
+  return LoadDecisionTree(filename, num_features, ssvinfo);
+}
+
+/* ......................................................................
+
+   Find the best split of the members of an internal node as
+   FindBestSplit() does, but from the node's count tables, which must
+   include all the members, for every attribute but the continuous ones.
+
+   ...................................................................... */
+
+static void FindUpdatedSplit(DTNODE *node, void **data, long num_data,
+			     MEMBERSET *members, long num_members,
+			     int num_features, UPDATEWORK *work,
+			     SPLIT *split, SSVINFO *ssvinfo)
+{
+  double entropy_orig, new_entropy;
+  double gain, threshold = 0.0;
+  int attr;
+  uchar *subset;
+
+  PROFILE_BEGIN(PHASE_SPLIT);
+  PROFILE_COUNT(max_gain_calls, 1);
+  PROFILE_COUNT(attribs_evaluated, num_features - 1);
+
+  entropy_orig = DataEntropy(data, num_data, members, num_members, ssvinfo);
+
+  split->attr = -1;
+  split->gain = 0.0;
+  split->threshold = 0.0;
+  split->subset = (uchar *) NULL;
+  for (attr = 1; attr < num_features; attr++) {
+    subset = (uchar *) NULL;
+    switch (ssvinfo->types[attr]) {
+    case 'b':
+      new_entropy = PartialEntropyCounts(node->stats + work->offsets[attr],
+					 2, num_members);
+      break;
+    case 'd':
+      if (ssvinfo->subset_splits) {
+	subset = CREATE_BITARRAY_TAG(ssvinfo->num_discrete_vals[attr],
+				     MEM_SPLIT);
+	new_entropy =
+	  PartialEntropySubsetCounts(node->stats + work->offsets[attr],
+				     ssvinfo->num_discrete_vals[attr],
+				     num_members, subset);
+      } else {
+	new_entropy =
+	  PartialEntropyCounts(node->stats + work->offsets[attr],
+			       ssvinfo->num_discrete_vals[attr], num_members);
+      }
+      break;
+    case 'c':
+      new_entropy = PartialEntropyContinuous(data, num_data,
+					     members, num_members,
+					     attr, &threshold);
+      break;
+    default:
+      USER_ERROR1("Unknown attribute type '%c'", ssvinfo->types[attr]);
+    }
+    gain = entropy_orig - new_entropy;
+    if (gain > split->gain) {
+      split->gain = gain;
+      split->attr = attr;
+      split->threshold = threshold;
+      freemem(split->subset);
+      split->subset = subset;
+      subset = (uchar *) NULL;
+    }
+    freemem(subset);
+  }
+
+  PROFILE_END(PHASE_SPLIT);
+}
+
+/* ......................................................................
+
+   Return 1 if an internal node already has the test of "split", and the
+   subtree grown from the members would test it the same way, i.e. with
+   at least two branches that are not empty.
+
+   ...................................................................... */
+
+static int SameTest(DTNODE *node, SPLIT *split, UPDATEWORK *work,
+		    SSVINFO *ssvinfo)
+{
+  int attr = split->attr;
+  int val, num_present;
+  long (*counts)[2];
+
+  if (attr != node->test_attrib)
+    return 0;
+  counts = node->stats + work->offsets[attr];
+  switch (ssvinfo->types[attr]) {
+  case 'b':
+    return (counts[0][0] + counts[0][1] > 0 &&
+	    counts[1][0] + counts[1][1] > 0);
+  case 'c':
+    return (split->threshold == node->threshold);
+  case 'd':
+    if ((split->subset == NULL) != (node->subset == NULL))
+      return 0;
+    for (val = num_present = 0; val < ssvinfo->num_discrete_vals[attr];
+	 val++) {
+      if (split->subset != NULL &&
+	  READ_BITARRAY(split->subset, val) != READ_BITARRAY(node->subset, val))
+	return 0;
+      num_present += (counts[val][0] + counts[val][1] > 0);
+    }
+    return (num_present > 1);
+  }
+
+  return 0;
+}
+
+/* ......................................................................
+
+   Give a node testing a discrete attribute one way per value a child for
+   every value now present in its count table, keeping the children it
+   had.
+
+   ...................................................................... */
+
+static void UpdateDiscreteChildren(DTNODE *node, UPDATEWORK *work,
+				   SSVINFO *ssvinfo)
+{
+  DTNODE **old_children = node->children;
+  int *old_vals = node->child_vals;
+  int num_old_children = node->num_children;
+  int attr = node->test_attrib;
+  int i, j;
+
+  SetDiscreteChildren(node, node->stats + work->offsets[attr],
+		      ssvinfo->num_discrete_vals[attr]);
+  for (i = j = 0; i < node->num_children; i++) {
+    while (j < num_old_children && old_vals[j] < node->child_vals[i])
+      j++;
+    if (j < num_old_children && old_vals[j] == node->child_vals[i])
+      node->children[i] = old_children[j];
+  }
+  freemem(old_children);
+  freemem(old_vals);
+}
+
+/* ......................................................................
+
+   Grow the subtree of the members again, from scratch.
+
+   ...................................................................... */
+
+static DTNODE *GrowSubTree(DTNODE *node, void **data, long num_data,
+			   MEMBERSET *members, long num_members,
+			   int num_features, UPDATEWORK *work,
+			   SSVINFO *ssvinfo)
+{
+  FreeDecisionTree(node);
+  node = CreateDecisionTreeAux(data, num_data, members, num_members,
+			       num_features, ssvinfo);
+  CountSubTreeStats(node, data, members, work->offsets, num_features,
+		    ssvinfo);
+  work->subtrees_grown++;
+  work->nodes_grown += CountNodes(node);
+  work->examples_grown += num_members;
+
+  return node;
+}
+
+/* ......................................................................
+
+   Bring the subtree grown from the "old_members" up to date with the
+   "new_members" too, and return it (it may be a new one).
+
+   ...................................................................... */
+
+static DTNODE *UpdateSubTree(DTNODE *node, void **data, long num_data,
+			     MEMBERSET *old_members, long num_old,
+			     MEMBERSET *new_members, long num_new,
+			     int num_features, UPDATEWORK *work,
+			     SSVINFO *ssvinfo)
+{
+  MEMBERITER iter;
+  MEMBERSET *members, **old_child, **new_child;
+  long num_members, memb;
+  int i;
+  SPLIT split;
+
+  if (num_new == 0)
+    return node;
+
+  members = UnionMemberSets(old_members, new_members, MEM_SPLIT);
+  num_members = num_old + num_new;
+
+  /* A leaf may now be split, and a new child has no subtree yet. */
+  if (node == NULL || node->num_children == 0) {
+    node = GrowSubTree(node, data, num_data, members, num_members,
+		       num_features, work, ssvinfo);
+    FreeMemberSet(members);
+    return node;
+  }
+
+  PROFILE_COUNT(rows_scanned, num_new);
+  FOR_EACH_MEMBER(iter, new_members, memb)
+    AddNodeStats(node, data, memb, work->offsets, num_features, ssvinfo);
+  node->num_members = num_members;
+  work->nodes_checked++;
+
+  FindUpdatedSplit(node, data, num_data, members, num_members, num_features,
+		   work, &split, ssvinfo);
+  if (split.attr == -1 || !SameTest(node, &split, work, ssvinfo)) {
+    node = GrowSubTree(node, data, num_data, members, num_members,
+		       num_features, work, ssvinfo);
+    freemem(split.subset);
+    FreeMemberSet(members);
+    return node;
+  }
+  freemem(split.subset);
+  FreeMemberSet(members);
+
+  if (ssvinfo->types[node->test_attrib] == 'd' && node->subset == NULL)
+    UpdateDiscreteChildren(node, work, ssvinfo);
+
+  /* The test stays: update every child from its share of the examples,
+     dealt out in a single pass over them. */
+  old_child = (MEMBERSET **)
+    getmem_tag(node->num_children * sizeof(MEMBERSET *), MEM_SPLIT);
+  new_child = (MEMBERSET **)
+    getmem_tag(node->num_children * sizeof(MEMBERSET *), MEM_SPLIT);
+  for (i = 0; i < node->num_children; i++) {
+    old_child[i] = NewMemberSet(MEM_SPLIT);
+    new_child[i] = NewMemberSet(MEM_SPLIT);
+  }
+  PROFILE_COUNT(rows_scanned, num_members);
+  FOR_EACH_MEMBER(iter, new_members, memb) {
+    if ((i = TestChildIndex(node, data, memb, ssvinfo)) >= 0)
+      AddMember(new_child[i], memb);
+  }
+  FOR_EACH_MEMBER(iter, old_members, memb) {
+    if (!IsMember(new_members, memb) &&
+	(i = TestChildIndex(node, data, memb, ssvinfo)) >= 0)
+      AddMember(old_child[i], memb);
+  }
+  for (i = 0; i < node->num_children; i++) {
+    node->children[i] =
+      UpdateSubTree(node->children[i], data, num_data,
+		    old_child[i], MEMBERSET_CARDINALITY(old_child[i]),
+		    new_child[i], MEMBERSET_CARDINALITY(new_child[i]),
+		    num_features, work, ssvinfo);
+    FreeMemberSet(old_child[i]);
+    FreeMemberSet(new_child[i]);
+  }
+  freemem(old_child);
+  freemem(new_child);
+
+  return node;
+}
+
+/* ----------------------------------------------------------------------
+
+   Bring a tree grown depth-first from the "old_members", with the count
+   tables of its internal nodes, up to date with the "new_members" too.
+   Subtrees that no new example reaches are kept as they are; the split of
+   every internal node the new examples reach is found again, and if it
+   changes, the subtree is grown again from all its members.  The result
+   is the tree CreateDecisionTreeAux() would grow from all the members,
+   and it keeps count tables to be updated again.
+
+   ---------------------------------------------------------------------- */
+
+DTNODE *UpdateDecisionTree(DTNODE *root, void **data, long num_data,
+			   MEMBERSET *old_members, long num_old,
+			   MEMBERSET *new_members, long num_new,
+			   int num_features, SSVINFO *ssvinfo)
+{
+  UPDATEWORK work;
+
+  if ((root == NULL) ? (num_old > 0) : (root->num_members != num_old))
+    USER_ERROR2("the tree was grown from %ld examples, not %ld",
+		(root == NULL) ? 0 : root->num_members, num_old);
+
+  memset(&work, 0, sizeof(work));
+  work.offsets = StatsOffsets(num_features, ssvinfo);
+  root = UpdateSubTree(root, data, num_data, old_members, num_old,
+		       new_members, num_new, num_features, &work, ssvinfo);
+  freemem(work.offsets);
+
+  /* Only print intermediate results if not in batch mode */
+  if (ssvinfo->batch == 0) {
+    printf("Added %ld examples to %ld; checked %d splits, grew %d subtrees "
+	   "(%d nodes) from %ld examples\n", num_new, num_old,
+	   work.nodes_checked, work.subtrees_grown, work.nodes_grown,
+	   work.examples_grown);
+  }
+
+  return root;
+}
+
+/**************************************************************************/
@@ -0,0 +1,39 @@
+/**************************************************************************
+ *
+ * update.h
+ *
+ * Header file to update.c
+ *
+ **************************************************************************/
+
+#ifndef UPDATE_H
+#define UPDATE_H 1
+
+#include "dt.h"
+#include "ssv.h"
+
+/* Every internal node of a tree that is to be updated keeps, in its
+   "stats" field, the count table of every binary and discrete attribute
+   over its members (see PartialEntropyCounts()), one after the other in
+   the order of the attributes: two entries for a binary attribute and one
+   per value for a discrete one.  With these, the best split of a node can
+   be found again from the new examples alone, except on continuous
+   attributes, whose thresholds still need all the members. */
+
+#define MODEL_VERSION 1
+
+/* Function prototypes. */
+void CountDecisionTreeStats(DTNODE *root, void **data, long num_data,
+			    MEMBERSET *members, int num_features,
+			    SSVINFO *ssvinfo);
+void SaveDecisionTree(char *filename, DTNODE *root, int num_features,
+		      SSVINFO *ssvinfo);
+DTNODE *LoadDecisionTree(char *filename, int num_features, SSVINFO *ssvinfo);
+DTNODE *LoadModel(char *filename, int *num_features_ptr, SSVINFO *ssvinfo);
+DTNODE *UpdateDecisionTree(DTNODE *root, void **data, long num_data,
+			   MEMBERSET *old_members, long num_old,
+			   MEMBERSET *new_members, long num_new,
+			   int num_features, SSVINFO *ssvinfo);
+
+#endif // UPDATE_H
+/**************************************************************************/